@@ -350,6 +350,7 @@ if (tensorflow_BUILD_CC_TESTS)
   set(tf_src_testlib
     "${tensorflow_source_dir}/tensorflow/cc/framework/testutil.cc"
     "${tensorflow_source_dir}/tensorflow/cc/gradients/grad_testutil.cc"
+    "${tensorflow_source_dir}/tensorflow/core/common_runtime/collective_test_util.cc"
     "${tensorflow_source_dir}/tensorflow/core/common_runtime/kernel_benchmark_testlib.cc"
     "${tensorflow_source_dir}/tensorflow/core/framework/function_testlib.cc"
     "${tensorflow_source_dir}/tensorflow/core/framework/shape_inference_testutil.cc"
@@ -33,9 +33,11 @@ See @{$guide/datasets$Importing Data} for an overview.
 @@assert_element_shape
 @@batch_and_drop_remainder
 @@bucket_by_sequence_length
+@@bucket_by_token_count
 @@choose_from_datasets
 @@copy_to_device
 @@dense_to_sparse_batch
+@@distribute_by_file_shard
 @@enumerate_dataset
 
 @@get_single_element
@@ -53,11 +55,14 @@ See @{$guide/datasets$Importing Data} for an overview.
 @@read_batch_features
 @@rejection_resample
 @@reduce_dataset
+@@remote_dataset
 @@sample_from_datasets
 @@scan
 @@shuffle_and_repeat
 @@sliding_window_batch
 @@sloppy_interleave
+@@snapshot
+@@spilling_shuffle
 @@unbatch
 @@unique
 """
@@ -75,11 +80,14 @@ from tensorflow.contrib.data.python.ops.batching import map_and_batch
 from tensorflow.contrib.data.python.ops.batching import padded_batch_and_drop_remainder
 from tensorflow.contrib.data.python.ops.batching import unbatch
 from tensorflow.contrib.data.python.ops.counter import Counter
+from tensorflow.contrib.data.python.ops.data_service_ops import distribute_by_file_shard
+from tensorflow.contrib.data.python.ops.data_service_ops import remote_dataset
 from tensorflow.contrib.data.python.ops.enumerate_ops import enumerate_dataset
 from tensorflow.contrib.data.python.ops.error_ops import ignore_errors
 from tensorflow.contrib.data.python.ops.get_single_element import get_single_element
 from tensorflow.contrib.data.python.ops.get_single_element import reduce_dataset
 from tensorflow.contrib.data.python.ops.grouping import bucket_by_sequence_length
+from tensorflow.contrib.data.python.ops.grouping import bucket_by_token_count
 from tensorflow.contrib.data.python.ops.grouping import group_by_reducer
 from tensorflow.contrib.data.python.ops.grouping import group_by_window
 from tensorflow.contrib.data.python.ops.grouping import Reducer
@@ -100,7 +108,9 @@ from tensorflow.contrib.data.python.ops.readers import SqlDataset
 from tensorflow.contrib.data.python.ops.resampling import rejection_resample
 from tensorflow.contrib.data.python.ops.scan_ops import scan
 from tensorflow.contrib.data.python.ops.shuffle_ops import shuffle_and_repeat
+from tensorflow.contrib.data.python.ops.shuffle_ops import spilling_shuffle
 from tensorflow.contrib.data.python.ops.sliding import sliding_window_batch
+from tensorflow.contrib.data.python.ops.snapshot import snapshot
 from tensorflow.contrib.data.python.ops.unique import unique
 from tensorflow.contrib.data.python.ops.writers import TFRecordWriter
 # pylint: enable=unused-import
@@ -681,5 +681,98 @@ class BucketBySequenceLength(test.TestCase):
     self.assertEqual([None], shapes[1].as_list())
 
 
+class BucketByTokenCountTest(test.TestCase):
+
+  def _lengths_dataset(self, lengths):
+
+    def element_gen():
+      for length in lengths:
+        yield ([1] * length,)
+
+    return dataset_ops.Dataset.from_generator(
+        element_gen, (dtypes.int64,), ([None],))
+
+  def _gen_batches(self, dataset):
+    batch, = dataset.make_one_shot_iterator().get_next()
+    batches = []
+    with self.test_session() as sess:
+      while True:
+        try:
+          batches.append(sess.run(batch))
+        except errors.OutOfRangeError:
+          break
+    return batches
+
+  def testTokenBudget(self):
+    element_len = lambda element: array_ops.shape(element)[0]
+    dataset = self._lengths_dataset(range(1, 11)).apply(
+        grouping.bucket_by_token_count(
+            element_len, bucket_boundaries=[3, 6], max_tokens=12))
+    self.assertEqual([None, None], dataset.output_shapes[0].as_list())
+    batches = self._gen_batches(dataset)
+
+    # A bucket is emitted when the next element would make the padded batch
+    # exceed 12 tokens, and the remaining buckets are emitted in order at the
+    # end of the input.
+    self.assertAllEqual(
+        [[[1, 1, 1, 0], [1, 1, 1, 1]],
+         [[1] * 6], [[1] * 7], [[1] * 8], [[1] * 9],
+         [[1, 0], [1, 1]], [[1] * 5], [[1] * 10]],
+        [batch.tolist() for batch in batches])
+
+  def testFullBucketIsEmittedImmediately(self):
+    element_len = lambda element: array_ops.shape(element)[0]
+    dataset = self._lengths_dataset([2] * 5).apply(
+        grouping.bucket_by_token_count(
+            element_len, bucket_boundaries=[10], max_tokens=4))
+    batches = self._gen_batches(dataset)
+    self.assertEqual([(2, 2), (2, 2), (1, 2)], [b.shape for b in batches])
+
+  def testTupleElementsAndPaddingValues(self):
+
+    def elements_gen():
+      text = [[1, 2, 3], [3, 4, 5, 6, 7], [1, 2], [8, 9, 0, 2, 3]]
+      label = ["a", "b", "c", "d"]
+      for x, y in zip(text, label):
+        yield (x, y)
+
+    def element_length_fn(x, y):
+      del y
+      return array_ops.shape(x)[0]
+
+    dataset = dataset_ops.Dataset.from_generator(
+        generator=elements_gen,
+        output_shapes=(tensor_shape.TensorShape([None]),
+                       tensor_shape.TensorShape([])),
+        output_types=(dtypes.int32, dtypes.string))
+    dataset = dataset.apply(
+        grouping.bucket_by_token_count(
+            element_length_func=element_length_fn,
+            bucket_boundaries=[4],
+            max_tokens=10,
+            padding_values=(-1, "")))
+    self.assertEqual([None, None], dataset.output_shapes[0].as_list())
+    self.assertEqual([None], dataset.output_shapes[1].as_list())
+    text, label = dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      long_text, long_label = sess.run([text, label])
+      self.assertAllEqual([[3, 4, 5, 6, 7], [8, 9, 0, 2, 3]], long_text)
+      self.assertAllEqual([b"b", b"d"], long_label)
+      short_text, short_label = sess.run([text, label])
+      self.assertAllEqual([[1, 2, 3], [1, 2, -1]], short_text)
+      self.assertAllEqual([b"a", b"c"], short_label)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(text)
+
+  def testInvalidBoundaries(self):
+    element_len = lambda element: array_ops.shape(element)[0]
+    dataset = self._lengths_dataset([1, 2]).apply(
+        grouping.bucket_by_token_count(
+            element_len, bucket_boundaries=[5, 3], max_tokens=4))
+    with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                 "strictly increasing"):
+      self._gen_batches(dataset)
+
 if __name__ == "__main__":
   test.main()
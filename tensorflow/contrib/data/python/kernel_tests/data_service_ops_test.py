@@ -0,0 +1,154 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import subprocess
+import sys
+
+import portpicker
+
+from tensorflow.contrib.data.python.ops import data_service_ops
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import string_ops
+from tensorflow.python.platform import test
+from tensorflow.python.training import server_lib
+
+# FLAGS defined at the bottom:
+# server_port (int) set if we are running in the server process.
+FLAGS = None
+
+
+def _to_number(filename):
+  return string_ops.string_to_number(filename, out_type=dtypes.int64)
+
+
+class DataServiceOpsTest(test.TestCase):
+
+  def _assertElements(self, expected, get_next):
+    with self.test_session() as sess:
+      for value in expected:
+        self.assertAllEqual(value, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testRemoteDataset(self):
+    server = server_lib.Server.create_local_server()
+    dataset = data_service_ops.remote_dataset(
+        server.target,
+        dataset_ops.Dataset.range(10).map(lambda x: x * x),
+        max_elements_per_request=3)
+    get_next = dataset.make_one_shot_iterator().get_next()
+    self._assertElements([x * x for x in range(10)], get_next)
+
+  def testRemoteDatasetStructure(self):
+    server = server_lib.Server.create_local_server()
+    dataset = data_service_ops.remote_dataset(
+        server.target,
+        dataset_ops.Dataset.range(4).map(lambda x: {"a": x, "b": (x, [x, x])}))
+    self.assertEqual(dtypes.int64, dataset.output_types["a"])
+    self.assertEqual([2], dataset.output_shapes["b"][1].as_list())
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      for i in range(4):
+        element = sess.run(get_next)
+        self.assertEqual(i, element["a"])
+        self.assertEqual(i, element["b"][0])
+        self.assertAllEqual([i, i], element["b"][1])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testRemoteDatasetError(self):
+    server = server_lib.Server.create_local_server()
+    dataset = data_service_ops.remote_dataset(
+        server.target,
+        dataset_ops.Dataset.from_tensor_slices(["1", "2", "x", "4"]).map(
+            _to_number),
+        max_elements_per_request=10)
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      self.assertEqual(1, sess.run(get_next))
+      self.assertEqual(2, sess.run(get_next))
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      self.assertEqual(4, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testDistributeByFileShard(self):
+    servers = [server_lib.Server.create_local_server() for _ in range(2)]
+    dataset = data_service_ops.distribute_by_file_shard(
+        [server.target for server in servers],
+        lambda files: files.map(_to_number),
+        [str(i) for i in range(10)],
+        max_elements_per_request=2)
+    get_next = dataset.make_one_shot_iterator().get_next()
+    self._assertElements(range(10), get_next)
+
+  def testDistributeByFileShardSloppy(self):
+    servers = [server_lib.Server.create_local_server() for _ in range(3)]
+    dataset = data_service_ops.distribute_by_file_shard(
+        [server.target for server in servers],
+        lambda files: files.map(_to_number).batch(2),
+        [str(i) for i in range(12)],
+        sloppy=True)
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      values = []
+      for _ in range(6):
+        values.extend(sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+    self.assertEqual(list(range(12)), sorted(values))
+
+  def testServerInAnotherProcess(self):
+    port = portpicker.pick_unused_port()
+    server_process = subprocess.Popen(
+        [sys.executable, sys.argv[0], "--server_port=%d" % port])
+    try:
+      # The first request waits until the server is listening.
+      dataset = data_service_ops.remote_dataset(
+          "grpc://localhost:%d" % port,
+          dataset_ops.Dataset.range(100).map(lambda x: x + 1).batch(10),
+          max_elements_per_request=4)
+      get_next = dataset.make_one_shot_iterator().get_next()
+      self._assertElements(
+          [list(range(i + 1, i + 11)) for i in range(0, 100, 10)], get_next)
+    finally:
+      server_process.kill()
+      server_process.wait()
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--server_port", type=int, default=0,
+      help="If set, run a server on this port instead of the tests.")
+  FLAGS, unparsed = parser.parse_known_args()
+
+  if FLAGS.server_port:
+    server_lib.Server(
+        {"worker": ["localhost:%d" % FLAGS.server_port]},
+        job_name="worker",
+        task_index=0).join()
+  else:
+    # Now update argv, so that unittest library does not get confused.
+    sys.argv = [sys.argv[0]] + unparsed
+    test.main()
@@ -777,6 +777,57 @@ class ParallelInterleaveDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(self.next_element)
 
+  def testMaxBufferOutputElements(self):
+    # The first element of the first nested dataset is slow, so the iterator
+    # waits for it in its turn and doubles the buffer of that dataset.
+    produced = []
+
+    def straggler_py_fn(x):
+      if x == 0:
+        time.sleep(0.5)
+      if x < 10:
+        produced.append(x)
+      return x
+
+    def interleave_fn(x):
+      return dataset_ops.Dataset.range(10 * x, 10 * x + 6).map(
+          lambda y: script_ops.py_func(straggler_py_fn, [y], dtypes.int64))
+
+    dataset = dataset_ops.Dataset.range(2).apply(
+        interleave_ops.parallel_interleave(
+            interleave_fn,
+            cycle_length=2,
+            buffer_output_elements=1,
+            max_buffer_output_elements=4))
+    get_next = dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      self.assertEqual(0, sess.run(get_next))
+      # Two elements of the first dataset are buffered, and a third one waits
+      # for space in the buffer.
+      deadline = time.time() + 10
+      while len(produced) < 4 and time.time() < deadline:
+        time.sleep(0.01)
+      self.assertEqual([0, 1, 2, 3], produced)
+      # The order is the deterministic one.
+      for expected in [10, 1, 11, 2, 12, 3, 13, 4, 14, 5, 15]:
+        self.assertEqual(expected, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testMaxBufferOutputElementsTooSmall(self):
+    dataset = dataset_ops.Dataset.range(2).apply(
+        interleave_ops.parallel_interleave(
+            dataset_ops.Dataset.range,
+            cycle_length=2,
+            buffer_output_elements=2,
+            max_buffer_output_elements=1))
+    get_next = dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "max_buffer_output_elements"):
+        sess.run(get_next)
 
 if __name__ == "__main__":
   test.main()
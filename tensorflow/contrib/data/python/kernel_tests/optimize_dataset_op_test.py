@@ -20,6 +20,7 @@ from __future__ import print_function
 from tensorflow.contrib.data.python.ops import optimization
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import test
 
 
@@ -99,6 +100,32 @@ class OptimizeDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  def testMapVectorization(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        optimization.assert_next(
+            ["Batch", "Map"])).map(lambda x: x * x + 1).batch(5).apply(
+                optimization.optimize(["map_vectorization"]))
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      self.assertAllEqual([x * x + 1 for x in range(5)], sess.run(get_next))
+      self.assertAllEqual([x * x + 1 for x in range(5, 10)],
+                          sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testMapVectorizationUnsupportedOp(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        optimization.assert_next(["Map", "Batch"])).map(
+            lambda x: array_ops.fill([2], x)).batch(5).apply(
+                optimization.optimize(["map_vectorization"]))
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      self.assertAllEqual([[x, x] for x in range(5)], sess.run(get_next))
+
   def testFunctionLibraryDefinitionModification(self):
     dataset = dataset_ops.Dataset.from_tensors(0).map(lambda x: x).apply(
         optimization.optimize(["_test_only_function_rename"]))
@@ -35,12 +35,14 @@ class ParallelInterleaveDatasetSerializationTest(
     self.num_repeats = 2
     self.num_outputs = np.sum(self.input_values) * 2
 
-  def _build_ds(self, cycle_length, block_length, sloppy=False):
+  def _build_ds(self, cycle_length, block_length, sloppy=False,
+                max_buffer_output_elements=None):
     return (dataset_ops.Dataset.from_tensor_slices(
         self.input_values).repeat(self.num_repeats).apply(
             interleave_ops.parallel_interleave(
                 lambda x: dataset_ops.Dataset.range(10 * x, 11 * x),
-                cycle_length, block_length, sloppy)))
+                cycle_length, block_length, sloppy,
+                max_buffer_output_elements=max_buffer_output_elements)))
 
   def testSerializationCore(self):
     # cycle_length > 1, block_length > 1
@@ -80,6 +82,16 @@ class ParallelInterleaveDatasetSerializationTest(
     # block_length = 1
     run_test(2, 1)
 
+  def testSerializationWithMaxBufferOutputElements(self):
+    # cycle_length > 1, block_length > 1
+    self.run_core_tests(
+        lambda: self._build_ds(2, 3, max_buffer_output_elements=24), None,
+        self.num_outputs)
+    # block_length = 1
+    self.run_core_tests(
+        lambda: self._build_ds(2, 1, max_buffer_output_elements=8), None,
+        self.num_outputs)
+
   def testSparseCore(self):
 
     def _map_fn(i):
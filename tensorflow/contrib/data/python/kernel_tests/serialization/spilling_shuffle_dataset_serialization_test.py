@@ -0,0 +1,78 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the SpillingShuffleDataset serialization."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.contrib.data.python.kernel_tests.serialization import dataset_serialization_test_base
+from tensorflow.contrib.data.python.ops import shuffle_ops
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.ops import random_ops
+from tensorflow.python.platform import test
+
+
+class SpillingShuffleSerializationTest(
+    dataset_serialization_test_base.DatasetSerializationTestBase):
+
+  def _build_ds(self, seed):
+    return dataset_ops.Dataset.range(100).apply(
+        shuffle_ops.spilling_shuffle(
+            buffer_size=40,
+            spill_directory=self.get_temp_dir(),
+            block_size=4,
+            seed=seed)).repeat(2)
+
+  def testCore(self):
+    self.run_core_tests(lambda: self._build_ds(10), lambda: self._build_ds(20),
+                        200)
+
+  def testCheckpointRefersToSpillFiles(self):
+    spill_directory = os.path.join(self.get_temp_dir(), "spill")
+
+    def ds_fn():
+      # Random elements, so that the spilled blocks do not compress well.
+      return dataset_ops.Dataset.range(1000).map(
+          lambda x: (x, random_ops.random_uniform([256]))).apply(
+              shuffle_ops.spilling_shuffle(
+                  buffer_size=400,
+                  spill_directory=spill_directory,
+                  block_size=10,
+                  seed=10))
+
+    outputs = self.gen_outputs(ds_fn, [], 10, verify_exhausted=False)
+    # The iterator has been destroyed, but the blocks that the checkpoint
+    # refers to are still there.
+    spill_size = sum(
+        os.path.getsize(os.path.join(spill_directory, f))
+        for f in os.listdir(spill_directory))
+    ckpt_size = sum(
+        os.path.getsize(os.path.join(self.get_temp_dir(), f))
+        for f in os.listdir(self.get_temp_dir())
+        if f.startswith("iterator.data"))
+    self.assertLess(ckpt_size, spill_size / 2)
+
+    # Restoring twice from the same checkpoint produces the same elements.
+    for _ in range(2):
+      remaining = self.gen_outputs(
+          ds_fn, [], 990, ckpt_saved=True, save_checkpoint_at_end=False)
+      self.assertSequenceEqual(
+          sorted(x for x, _ in outputs + remaining), range(1000))
+
+
+if __name__ == "__main__":
+  test.main()
@@ -35,7 +35,8 @@ class TFRecordDatasetSerializationTest(
                             num_epochs,
                             batch_size=1,
                             compression_type=None,
-                            buffer_size=None):
+                            buffer_size=None,
+                            num_readahead_blocks=None):
     filenames = self._createFiles()
     if compression_type == "ZLIB":
       zlib_files = []
@@ -59,8 +60,9 @@ class TFRecordDatasetSerializationTest(
       filenames = gzip_files
 
     return core_readers.TFRecordDataset(
-        filenames, compression_type,
-        buffer_size=buffer_size).repeat(num_epochs).batch(batch_size)
+        filenames, compression_type, buffer_size=buffer_size,
+        num_readahead_blocks=num_readahead_blocks).repeat(num_epochs).batch(
+            batch_size)
 
   def testTFRecordWithoutBufferCore(self):
     num_epochs = 5
@@ -84,6 +86,18 @@ class TFRecordDatasetSerializationTest(
                         lambda: self._build_iterator_graph(num_epochs * 2),
                         num_outputs)
 
+  def testTFRecordWithReadaheadCore(self):
+    num_epochs = 5
+    num_outputs = num_epochs * self._num_files * self._num_records
+    # Use blocks smaller than a record, so that the reads are still in flight
+    # when the iterator is saved.
+    # pylint: disable=g-long-lambda
+    self.run_core_tests(
+        lambda: self._build_iterator_graph(num_epochs, buffer_size=10,
+                                           num_readahead_blocks=4),
+        lambda: self._build_iterator_graph(num_epochs * 2), num_outputs)
+    # pylint: enable=g-long-lambda
+
   def testTFRecordWithCompressionCore(self):
     num_epochs = 5
     num_outputs = num_epochs * self._num_files * self._num_records
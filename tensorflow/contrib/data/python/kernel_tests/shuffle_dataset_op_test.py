@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import shuffle_ops
@@ -110,5 +112,67 @@ class ShuffleAndRepeatTest(test.TestCase):
         sess.run(get_next_op)
 
 
+class SpillingShuffleTest(test.TestCase):
+
+  def _build_ds(self, seed, num_elements=1000, buffer_size=400, block_size=10,
+                compression="ZLIB"):
+    return dataset_ops.Dataset.range(num_elements).apply(
+        shuffle_ops.spilling_shuffle(
+            buffer_size=buffer_size,
+            spill_directory=self.get_temp_dir(),
+            block_size=block_size,
+            compression=compression,
+            seed=seed))
+
+  def _gen_outputs(self, ds_fn, num_epochs=1):
+    get_next = ds_fn().repeat(num_epochs).make_one_shot_iterator().get_next()
+    outputs = []
+    with self.test_session() as sess:
+      while True:
+        try:
+          outputs.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          break
+    return outputs
+
+  def testCorrectOutput(self):
+    for buffer_size, block_size in [(1, 1), (400, 10), (5000, 1000)]:
+      output = self._gen_outputs(
+          lambda bs=buffer_size, bl=block_size: self._build_ds(
+              10, buffer_size=bs, block_size=bl))
+      self.assertSequenceEqual(sorted(output), range(1000))
+      if buffer_size > 1:
+        self.assertNotEqual(output, list(range(1000)))
+
+  def testShufflesAcrossBlocks(self):
+    output = self._gen_outputs(lambda: self._build_ds(10))
+    # The first 100 outputs come from more than a few input blocks.
+    self.assertGreater(len(set(x // 10 for x in output[:100])), 8)
+
+  def testReshuffling(self):
+    output = self._gen_outputs(lambda: self._build_ds(10), num_epochs=2)
+    self.assertSequenceEqual(sorted(output[:1000]), range(1000))
+    self.assertSequenceEqual(sorted(output[1000:]), range(1000))
+    self.assertNotEqual(output[:1000], output[1000:])
+
+  def testSameOrderForSameSeeds(self):
+    output1 = self._gen_outputs(lambda: self._build_ds(10))
+    output2 = self._gen_outputs(lambda: self._build_ds(10))
+    self.assertEqual(output1, output2)
+
+  def testSpillFilesAreDeleted(self):
+    self._gen_outputs(lambda: self._build_ds(10))
+    self.assertEqual([], [
+        f for f in os.listdir(self.get_temp_dir()) if f.startswith("shuffle_")
+    ])
+
+  def testInvalidArguments(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      self._gen_outputs(lambda: self._build_ds(10, block_size=500,
+                                               buffer_size=100))
+    with self.assertRaises(errors.InvalidArgumentError):
+      self._gen_outputs(lambda: self._build_ds(10, compression="GZIP"))
+
+
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,142 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.contrib.data.python.ops import snapshot
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import readers
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import string_ops
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import test
+
+
+class SnapshotDatasetTest(test.TestCase):
+
+  def setUp(self):
+    super(SnapshotDatasetTest, self).setUp()
+    self._snapshot_dir = os.path.join(self.get_temp_dir(), "snapshots")
+    self._input_file = os.path.join(self.get_temp_dir(), "input.txt")
+
+  def _write_input(self, lines):
+    with open(self._input_file, "w") as f:
+      f.write("".join("%s\n" % line for line in lines))
+
+  def _build_ds(self, num_shards=3, shuffle_shards=False, seed=None):
+    return readers.TextLineDataset(self._input_file).map(
+        string_ops.string_to_number).apply(
+            snapshot.snapshot(
+                self._snapshot_dir,
+                num_shards=num_shards,
+                shuffle_shards=shuffle_shards,
+                seed=seed))
+
+  def _gen_outputs(self, ds, num_elements=None):
+    get_next = ds.make_one_shot_iterator().get_next()
+    outputs = []
+    with self.test_session() as sess:
+      while num_elements is None or len(outputs) < num_elements:
+        try:
+          outputs.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          break
+    return outputs
+
+  def _metadata_files(self):
+    return gfile.Glob(
+        os.path.join(self._snapshot_dir, "*", "snapshot.metadata"))
+
+  def testWriteThenRead(self):
+    self._write_input(range(100))
+    self.assertAllEqual(range(100), self._gen_outputs(self._build_ds()))
+    self.assertEqual(1, len(self._metadata_files()))
+
+    # The input pipeline is unchanged, so the second run reads the snapshot
+    # rather than the modified input file.
+    self._write_input(range(100, 200))
+    self.assertAllEqual(range(100), self._gen_outputs(self._build_ds()))
+
+  def testIncompleteIterationIsNotCommitted(self):
+    self._write_input(range(100))
+    self.assertAllEqual(range(10), self._gen_outputs(self._build_ds(), 10))
+    self.assertEqual(0, len(self._metadata_files()))
+    self.assertEqual(0,
+                     len(gfile.Glob(os.path.join(self._snapshot_dir, "*",
+                                                 "*.snapshot"))))
+
+  def testDifferentPipelinesUseDifferentSnapshots(self):
+    self._write_input(range(100))
+    self.assertAllEqual(range(100), self._gen_outputs(self._build_ds()))
+    self.assertAllEqual(
+        [2 * x for x in range(100)],
+        self._gen_outputs(self._build_ds().map(lambda x: 2 * x)))
+    self.assertAllEqual(
+        range(0, 100, 2),
+        self._gen_outputs(
+            readers.TextLineDataset(self._input_file).map(
+                string_ops.string_to_number).filter(
+                    lambda x: x % 2 < 1).apply(
+                        snapshot.snapshot(self._snapshot_dir))))
+    self.assertEqual(3, len(self._metadata_files()))
+
+  def testUnseededShuffleReusesSnapshot(self):
+    self._write_input(range(100))
+
+    def build_ds():
+      return readers.TextLineDataset(self._input_file).map(
+          string_ops.string_to_number).shuffle(100).apply(
+              snapshot.snapshot(self._snapshot_dir))
+
+    output = self._gen_outputs(build_ds())
+    self.assertAllEqual(range(100), sorted(output))
+    # The second shuffle has a different seed, but the order that was written
+    # is read back.
+    self.assertAllEqual(output, self._gen_outputs(build_ds()))
+    self.assertEqual(1, len(self._metadata_files()))
+
+  def testEmptyInput(self):
+    self._write_input([])
+    self.assertEqual([], self._gen_outputs(self._build_ds()))
+    self.assertEqual([], self._gen_outputs(self._build_ds()))
+    self.assertEqual(1, len(self._metadata_files()))
+
+  def testShuffleShards(self):
+    self._write_input(range(1000))
+    self.assertAllEqual(
+        range(1000), self._gen_outputs(self._build_ds(num_shards=10)))
+    output = self._gen_outputs(
+        self._build_ds(num_shards=10, shuffle_shards=True, seed=7))
+    self.assertAllEqual(range(1000), sorted(output))
+    self.assertNotEqual(list(range(1000)), output)
+
+  def testInvalidArguments(self):
+    self._write_input(range(10))
+    with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                 "num_shards must be greater than zero"):
+      self._gen_outputs(self._build_ds(num_shards=0))
+    with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                 "Unsupported cache compression"):
+      self._gen_outputs(
+          dataset_ops.Dataset.range(10).apply(
+              snapshot.snapshot(self._snapshot_dir, compression="LZ4")))
+
+
+if __name__ == "__main__":
+  test.main()
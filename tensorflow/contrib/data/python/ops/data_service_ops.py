@@ -0,0 +1,155 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Datasets whose input pipelines run on remote servers."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.data.python.ops import interleave_ops
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import sparse
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_dataset_ops
+
+
+class _RemoteDataset(dataset_ops.Dataset):
+  """A `Dataset` whose elements are produced by a server."""
+
+  def __init__(self, target, dataset_graph, max_elements_per_request,
+               output_types, output_shapes, output_classes):
+    super(_RemoteDataset, self).__init__()
+    self._target = ops.convert_to_tensor(
+        target, dtype=dtypes.string, name="target")
+    self._dataset_graph = ops.convert_to_tensor(
+        dataset_graph, dtype=dtypes.string, name="dataset_graph")
+    self._max_elements_per_request = ops.convert_to_tensor(
+        max_elements_per_request,
+        dtype=dtypes.int64,
+        name="max_elements_per_request")
+    self._output_types = output_types
+    self._output_shapes = output_shapes
+    self._output_classes = output_classes
+
+  def _as_variant_tensor(self):
+    return gen_dataset_ops.remote_dataset(
+        self._target,
+        self._dataset_graph,
+        self._max_elements_per_request,
+        output_types=nest.flatten(
+            sparse.as_dense_types(self.output_types, self.output_classes)),
+        output_shapes=nest.flatten(
+            sparse.as_dense_shapes(self.output_shapes, self.output_classes)))
+
+  @property
+  def output_classes(self):
+    return self._output_classes
+
+  @property
+  def output_shapes(self):
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    return self._output_types
+
+
+def remote_dataset(target, dataset, max_elements_per_request=16):
+  """Runs the input pipeline of `dataset` on the server at `target`.
+
+  The graph of `dataset` is sent to the server, which builds the dataset and
+  an iterator over it on its own CPU. The elements of the returned dataset are
+  fetched from that iterator, `max_elements_per_request` at a time, and the
+  next batch is requested while the current one is consumed.
+
+  The server can be any `tf.train.Server` (e.g. the one of a `worker` task),
+  or a `tf.train.Server` in the same process, which is then called directly.
+
+  NOTE: `dataset` must not capture stateful resources (such as variables or
+  lookup tables) of the local process, and an iterator over the returned
+  dataset cannot be saved in a checkpoint.
+
+  Args:
+    target: A `tf.string` scalar `tf.Tensor` with the target of a
+      `tf.train.Server`, e.g. "grpc://localhost:2222".
+    dataset: A `tf.data.Dataset`.
+    max_elements_per_request: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+      the maximum number of elements returned by one request to the server.
+
+  Returns:
+    A `Dataset` with the same elements as `dataset`.
+  """
+  # pylint: disable=protected-access
+  return _RemoteDataset(target, dataset._as_serialized_graph(),
+                        max_elements_per_request, dataset.output_types,
+                        dataset.output_shapes, dataset.output_classes)
+
+
+def distribute_by_file_shard(targets,
+                             dataset_fn,
+                             filenames,
+                             max_elements_per_request=16,
+                             sloppy=False):
+  """Splits an input pipeline over files between several servers.
+
+  The `i`th server in `targets` runs `dataset_fn` on the `i`th shard of
+  `filenames`, and the elements of all servers are interleaved, one element
+  from each server at a time:
+
+  ```python
+  dataset = tf.contrib.data.distribute_by_file_shard(
+      ["grpc://input0:2222", "grpc://input1:2222"],
+      lambda files: files.apply(tf.contrib.data.parallel_interleave(
+          tf.data.TFRecordDataset, cycle_length=4)).map(parse_fn).batch(32),
+      filenames)
+  ```
+
+  Args:
+    targets: A list of strings with the targets of `tf.train.Server`s.
+    dataset_fn: A function that maps a `Dataset` of `tf.string` filenames to
+      the `Dataset` to run on a server.
+    filenames: A `tf.string` vector `tf.Tensor` of filenames.
+    max_elements_per_request: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+      the maximum number of elements returned by one request to a server.
+    sloppy: (Optional.) If `True`, the elements are produced in the order in
+      which the servers return them, rather than in round-robin order, so
+      that a slow server does not hold up the others.
+
+  Returns:
+    A `Dataset` with the elements of all servers.
+
+  Raises:
+    ValueError: If `targets` is empty.
+  """
+  if not targets:
+    raise ValueError("At least one target must be given.")
+  num_servers = len(targets)
+  files = dataset_ops.Dataset.from_tensor_slices(filenames)
+  shards = [dataset_fn(files.shard(num_servers, i)) for i in range(num_servers)]
+  # pylint: disable=protected-access
+  graphs = array_ops.stack([shard._as_serialized_graph() for shard in shards])
+  # pylint: enable=protected-access
+  structure = shards[0]
+
+  def _remote_shard(target, dataset_graph):
+    return _RemoteDataset(target, dataset_graph, max_elements_per_request,
+                          structure.output_types, structure.output_shapes,
+                          structure.output_classes)
+
+  return dataset_ops.Dataset.from_tensor_slices((targets, graphs)).apply(
+      interleave_ops.parallel_interleave(
+          _remote_shard, cycle_length=num_servers, sloppy=sloppy))
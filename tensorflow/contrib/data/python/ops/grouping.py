@@ -21,6 +21,7 @@ import numpy as np
 
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import nest
+from tensorflow.python.data.util import sparse
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
@@ -227,6 +228,115 @@ def bucket_by_sequence_length(element_length_func,
     return _apply_fn
 
 
+def bucket_by_token_count(element_length_func,
+                          bucket_boundaries,
+                          max_tokens,
+                          padding_values=None):
+  """A transformation that batches elements of similar length by token count.
+
+  Like `bucket_by_sequence_length()`, elements are grouped into buckets by
+  the length returned by `element_length_func`, and then padded and batched.
+  However, a bucket is emitted as soon as its padded size would exceed
+  `max_tokens` tokens, which is the number of elements in the batch times
+  the greatest length among them, so that long sequences make small batches
+  and short sequences make large ones. Every dimension of a batch component
+  is padded exactly to the largest size among the elements of the batch, and
+  batches whose elements all have the same shape are not padded at all.
+
+  If the pipeline has a `tf.contrib.data.StatsAggregator`, the size, the
+  number of tokens, and the fraction of padding tokens of each batch are
+  recorded in histograms.
+
+  Args:
+    element_length_func: function from element in `Dataset` to `tf.int32` or
+      `tf.int64`, determines the length of the element, which will determine
+      the bucket it goes into.
+    bucket_boundaries: `list<int>`, upper length boundaries of the buckets,
+      in increasing order.
+    max_tokens: A `tf.int64` scalar `tf.Tensor`, representing the maximum
+      number of tokens in a batch. A batch contains at least one element,
+      even if that element is longer than `max_tokens`.
+    padding_values: (Optional.) A nested structure of scalar-shaped
+      `tf.Tensor`, representing the padding values to use for the
+      respective components. Defaults are `0` for numeric types and the
+      empty string for string types.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+
+  def _apply_fn(dataset):
+    return _BucketByTokenCountDataset(dataset, element_length_func,
+                                      bucket_boundaries, max_tokens,
+                                      padding_values)
+
+  return _apply_fn
+
+
+class _BucketByTokenCountDataset(dataset_ops.Dataset):
+  """A `Dataset` that batches elements of similar length by token count."""
+
+  def __init__(self, input_dataset, element_length_func, bucket_boundaries,
+               max_tokens, padding_values):
+    """See `bucket_by_token_count()` for details."""
+    super(_BucketByTokenCountDataset, self).__init__()
+    if sparse.any_sparse(input_dataset.output_classes):
+      raise TypeError(
+          "Batching of padded sparse tensors is not currently supported")
+    self._input_dataset = input_dataset
+    self._bucket_boundaries = ops.convert_to_tensor(
+        bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries")
+    self._max_tokens = ops.convert_to_tensor(
+        max_tokens, dtype=dtypes.int64, name="max_tokens")
+    # pylint: disable=protected-access
+    padding_values = (
+        padding_values if padding_values is not None else
+        dataset_ops._default_padding(input_dataset))
+    self._padding_values = nest.map_structure_up_to(
+        input_dataset.output_shapes, dataset_ops._padding_value_to_tensor,
+        padding_values, input_dataset.output_types)
+    # pylint: enable=protected-access
+    self._make_element_length_func(element_length_func, input_dataset)
+
+  def _make_element_length_func(self, element_length_func, input_dataset):
+    """Make wrapping Defun for element_length_func."""
+    def element_length_func_wrapper(*args):
+      return math_ops.to_int64(element_length_func(*args))
+    wrapped_func = dataset_ops.StructuredFunctionWrapper(
+        element_length_func_wrapper, "tf.contrib.data.bucket_by_token_count()",
+        input_dataset)
+    if not (
+        wrapped_func.output_types == dtypes.int64 and
+        wrapped_func.output_shapes.is_compatible_with(tensor_shape.scalar())):
+      raise ValueError(
+          "`element_length_func` must return a single scalar tensor.")
+    self._element_length_func = wrapped_func.function
+
+  def _as_variant_tensor(self):
+    return gen_dataset_ops.bucket_by_sequence_length_dataset(
+        self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
+        bucket_boundaries=self._bucket_boundaries,
+        max_tokens=self._max_tokens,
+        padding_values=nest.flatten(self._padding_values),
+        other_arguments=self._element_length_func.captured_inputs,
+        element_length_func=self._element_length_func,
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_classes(self):
+    return self._input_dataset.output_classes
+
+  @property
+  def output_shapes(self):
+    return nest.map_structure(
+        lambda s: tensor_shape.vector(None).concatenate(s),
+        self._input_dataset.output_shapes)
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
 def _map_x_dataset(map_func):
   """A transformation that maps `map_func` across its input.
 
@@ -37,7 +37,8 @@ def parallel_interleave(map_func,
                         block_length=1,
                         sloppy=False,
                         buffer_output_elements=None,
-                        prefetch_input_elements=None):
+                        prefetch_input_elements=None,
+                        max_buffer_output_elements=None):
   """A parallel version of the `Dataset.interleave()` transformation.
 
   `parallel_interleave()` maps `map_func` across its input to produce nested
@@ -76,6 +77,12 @@ def parallel_interleave(map_func,
       each interleaved iterator).
     prefetch_input_elements: The number of input elements to transform to
       iterators before they are needed for interleaving.
+    max_buffer_output_elements: (Optional.) If `sloppy` is `False`, the number
+      of elements up to which the buffer of a straggling iterator grows. When
+      the iterator whose turn it is has no element buffered, its buffer is
+      doubled, up to this size, so it can get further ahead before it stalls
+      the cycle again. The order of the elements is not affected. Defaults to
+      `buffer_output_elements`.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -84,7 +91,8 @@ def parallel_interleave(map_func,
   def _apply_fn(dataset):
     return readers.ParallelInterleaveDataset(
         dataset, map_func, cycle_length, block_length, sloppy,
-        buffer_output_elements, prefetch_input_elements)
+        buffer_output_elements, prefetch_input_elements,
+        max_buffer_output_elements)
 
   return _apply_fn
 
@@ -70,6 +70,50 @@ class _ShuffleAndRepeatDataset(dataset_ops.Dataset):
     return self._input_dataset.output_types
 
 
+class _SpillingShuffleDataset(dataset_ops.Dataset):
+  """A `Dataset` that shuffles its input using a buffer on disk."""
+
+  def __init__(self, input_dataset, buffer_size, block_size, spill_directory,
+               compression, seed):
+    """See `spilling_shuffle()` for details."""
+    super(_SpillingShuffleDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+    self._block_size = ops.convert_to_tensor(
+        block_size, dtype=dtypes.int64, name="block_size")
+    self._spill_directory = ops.convert_to_tensor(
+        spill_directory, dtype=dtypes.string, name="spill_directory")
+    self._compression = compression
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+
+  def _as_variant_tensor(self):
+    # pylint: disable=protected-access
+    input_resource = self._input_dataset._as_variant_tensor()
+    return gen_dataset_ops.spilling_shuffle_dataset(
+        input_resource,
+        buffer_size=self._buffer_size,
+        block_size=self._block_size,
+        spill_directory=self._spill_directory,
+        seed=self._seed,
+        seed2=self._seed2,
+        compression=self._compression,
+        **dataset_ops.flat_structure(self))
+    # pylint: enable=protected-access
+
+  @property
+  def output_classes(self):
+    return self._input_dataset.output_classes
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
 def shuffle_and_repeat(buffer_size, count=None, seed=None):
   """Shuffles and repeats a Dataset returning a new permutation for each epoch.
 
@@ -103,3 +147,48 @@ def shuffle_and_repeat(buffer_size, count=None, seed=None):
     return _ShuffleAndRepeatDataset(dataset, buffer_size, count, seed)
 
   return _apply_fn
+
+
+def spilling_shuffle(buffer_size,
+                     spill_directory,
+                     block_size=1024,
+                     compression="ZLIB",
+                     seed=None):
+  """Shuffles a Dataset using a shuffle buffer that is spilled to disk.
+
+  This is similar to `dataset.shuffle(buffer_size)`, but only about
+  `8 * block_size` elements are held in memory, so `buffer_size` can be much
+  larger than would fit in memory. The input is read in blocks of
+  `block_size` elements, which are shuffled, compressed, and written to files
+  in `spill_directory`. The output is produced from a few blocks at a time,
+  which are loaded from the spilled blocks in a uniformly random order.
+
+  Each iterator over the resulting dataset shuffles differently, and the
+  iterators can be checkpointed. A checkpoint refers to the spilled blocks by
+  file name instead of containing them. The files that a checkpoint refers to
+  are not deleted, and `spill_directory` must be kept for as long as the
+  checkpoint may be restored.
+
+  Args:
+    buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+      elements to shuffle among.
+    spill_directory: A `tf.string` scalar `tf.Tensor`, representing a local
+      directory for the spilled blocks.
+    block_size: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      number of elements in each spilled block. Must be at most `buffer_size`.
+    compression: (Optional.) The compression of the spilled blocks: `"ZLIB"`
+      or `"SNAPPY"`.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      random seed that will be used to create the distribution. See
+      @{tf.set_random_seed} for behavior.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+
+  def _apply_fn(dataset):  # pylint: disable=missing-docstring
+    return _SpillingShuffleDataset(dataset, buffer_size, block_size,
+                                   spill_directory, compression, seed)
+
+  return _apply_fn
@@ -0,0 +1,117 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Dataset snapshot ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import random_seed
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_dataset_ops
+
+
+class _SnapshotDataset(dataset_ops.Dataset):
+  """A `Dataset` that materializes its input in files, and reuses them."""
+
+  def __init__(self, input_dataset, path, num_shards, compression,
+               shuffle_shards, seed):
+    """See `snapshot()` for details."""
+    super(_SnapshotDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
+    self._num_shards = ops.convert_to_tensor(
+        num_shards, dtype=dtypes.int64, name="num_shards")
+    self._compression = compression
+    self._shuffle_shards = shuffle_shards
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+
+  def _as_variant_tensor(self):
+    # pylint: disable=protected-access
+    input_resource = self._input_dataset._as_variant_tensor()
+    return gen_dataset_ops.snapshot_dataset(
+        input_resource,
+        path=self._path,
+        num_shards=self._num_shards,
+        seed=self._seed,
+        seed2=self._seed2,
+        compression=self._compression,
+        shuffle_shards=self._shuffle_shards,
+        **dataset_ops.flat_structure(self))
+    # pylint: enable=protected-access
+
+  @property
+  def output_classes(self):
+    return self._input_dataset.output_classes
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+def snapshot(path,
+             num_shards=8,
+             compression="ZLIB",
+             shuffle_shards=False,
+             seed=None):
+  """Materializes a Dataset in files, and reads them back on later runs.
+
+  The snapshot of the input is kept in a subdirectory of `path` that is named
+  after a fingerprint of the input pipeline's graph. The first iterator that
+  finds no complete snapshot there produces the input as usual, and writes
+  its elements to `num_shards` files with one background thread per file.
+  The snapshot is committed only once the input is exhausted, so an iteration
+  that stops early leaves nothing to reuse. Later iterators, including those
+  of later jobs, read the committed snapshot instead of running the input
+  pipeline.
+
+  Anything that changes the graph of the input pipeline leads to a different
+  fingerprint and a new snapshot. Random seeds are left out of the
+  fingerprint, since unset seeds differ on every run, so a snapshot of a
+  shuffled input replays the order in which it was written. The code of
+  a `py_func` is not part of the graph either: changing it does not lead to
+  a new snapshot, and a warning is logged when the input calls one.
+  Failing to write a snapshot is not an error, and only logs a warning.
+
+  Args:
+    path: A `tf.string` scalar `tf.Tensor`, representing the directory in
+      which snapshots are kept.
+    num_shards: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      number of files, and therefore of writer and reader threads, of a new
+      snapshot.
+    compression: (Optional.) The compression of the snapshot files: `"ZLIB"`
+      or `"SNAPPY"`.
+    shuffle_shards: (Optional.) A `tf.bool`. If true, each iterator that
+      reads a snapshot visits its files in a random order, rather than in the
+      order of the input.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      random seed that will be used to order the files. See
+      @{tf.set_random_seed} for behavior.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+
+  def _apply_fn(dataset):  # pylint: disable=missing-docstring
+    return _SnapshotDataset(dataset, path, num_shards, compression,
+                            shuffle_shards, seed)
+
+  return _apply_fn
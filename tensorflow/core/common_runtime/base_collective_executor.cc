@@ -18,7 +18,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/ring_gather_scatter.h"
 #include "tensorflow/core/common_runtime/ring_reducer.h"
 #include "tensorflow/core/lib/core/notification.h"
 
@@ -215,9 +217,9 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   switch (col_params.instance.type) {
     case REDUCTION_COLLECTIVE: {
       // TODO(tucker): support other reduction algorithms,
-      // e.g. tree-reduce, hybrid tree/ring, delegate-to-NCCL, etc.
+      // e.g. hybrid tree/ring, delegate-to-NCCL, etc.
       const Tensor* input = &ctx->input(0);
-      RingReducer* reducer =
+      CollectiveImplementationInterface* reducer =
           CreateReducer(ctx, CtxParams(ctx), col_params, exec_key, step_id_,
                         input, output, &error);
       if (!reducer) {
@@ -252,13 +254,32 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
       });
     } break;
 
+    case GATHER_COLLECTIVE:
+    case REDUCE_SCATTER_COLLECTIVE: {
+      const Tensor* input = &ctx->input(0);
+      CollectiveImplementationInterface* impl =
+          CreateGatherScatter(ctx, CtxParams(ctx), col_params, exec_key,
+                              step_id_, input, output, &error);
+      if (!impl) {
+        done_safe(errors::Internal(error));
+        return;
+      }
+      // Run in an I/O thread, so as not to starve the executor threads.
+      SchedClosure([impl, done_safe]() {
+        impl->Run([impl, done_safe](const Status& s) {
+          done_safe(s);
+          delete impl;
+        });
+      });
+    } break;
+
     default:
       done_safe(errors::Internal("Unimplemented CollectiveType ",
                                  col_params.instance.type));
   }
 }
 
-RingReducer* BaseCollectiveExecutor::CreateReducer(
+CollectiveImplementationInterface* BaseCollectiveExecutor::CreateReducer(
     OpKernelContext* ctx, OpKernelContext::Params* params,
     const CollectiveParams& col_params, const string& exec_key, int64 step_id,
     const Tensor* input, Tensor* output, string* error) {
@@ -273,10 +294,18 @@ RingReducer* BaseCollectiveExecutor::CreateReducer(
       TF_FALLTHROUGH_INTENDED;
     case DT_FLOAT:
     case DT_DOUBLE:
-    case DT_INT64:
+    case DT_INT64: {
+      const string& name = col_params.instance.impl_details.collective_name;
+      if (name == kHalvingDoublingReduceName ||
+          name == kHierarchicalReduceName) {
+        return new HalvingDoublingReducer(
+            this, dev_mgr_, ctx, params, col_params, exec_key, step_id, input,
+            output, name == kHierarchicalReduceName /*hierarchical*/);
+      }
+      // The ring is the default when no other algorithm was selected.
       return new RingReducer(this, dev_mgr_, ctx, params, col_params, exec_key,
                              step_id, input, output);
-      break;
+    } break;
     default:
       *error = strings::StrCat("Collective Reduce does not support datatype ",
                                col_params.instance.data_type);
@@ -311,4 +340,37 @@ Broadcaster* BaseCollectiveExecutor::CreateBroadcaster(
   }
 }
 
+CollectiveImplementationInterface* BaseCollectiveExecutor::CreateGatherScatter(
+    OpKernelContext* ctx, OpKernelContext::Params* params,
+    const CollectiveParams& col_params, const string& exec_key, int64 step_id,
+    const Tensor* input, Tensor* output, string* error) {
+  const char* op_name = (col_params.instance.type == GATHER_COLLECTIVE)
+                            ? "Collective Gather"
+                            : "Collective ReduceScatter";
+  switch (col_params.instance.data_type) {
+    case DT_INT32:
+      if (col_params.group.device_type == DEVICE_GPU) {
+        *error = strings::StrCat(op_name,
+                                 " does not support datatype DT_INT32 on "
+                                 "DEVICE_GPU");
+        return nullptr;
+      }
+      TF_FALLTHROUGH_INTENDED;
+    case DT_FLOAT:
+    case DT_DOUBLE:
+    case DT_INT64: {
+      if (col_params.instance.type == GATHER_COLLECTIVE) {
+        return new RingGatherer(this, dev_mgr_, ctx, params, col_params,
+                                exec_key, step_id, input, output);
+      }
+      return new RingReduceScatterer(this, dev_mgr_, ctx, params, col_params,
+                                     exec_key, step_id, input, output);
+    } break;
+    default:
+      *error = strings::StrCat(op_name, " does not support datatype ",
+                               DataTypeString(col_params.instance.data_type));
+      return nullptr;
+  }
+}
+
 }  // namespace tensorflow
@@ -23,7 +23,6 @@ limitations under the License.
 namespace tensorflow {
 class Broadcaster;
 class DeviceMgr;
-class RingReducer;
 
 // Helper interface that aliases regular subfields of a Tensor as separate
 // Tensors for in-place update.
@@ -133,12 +132,17 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   std::unique_ptr<PerStepCollectiveRemoteAccess> remote_access_;
 
  private:
-  RingReducer* CreateReducer(OpKernelContext* ctx,
-                             OpKernelContext::Params* params,
-                             const CollectiveParams& col_params,
-                             const string& exec_key, int64 step_id,
-                             const Tensor* input, Tensor* output,
-                             string* error);
+  CollectiveImplementationInterface* CreateReducer(
+      OpKernelContext* ctx, OpKernelContext::Params* params,
+      const CollectiveParams& col_params, const string& exec_key,
+      int64 step_id, const Tensor* input, Tensor* output, string* error);
+
+  // Returns a RingGatherer or RingReduceScatterer, according to
+  // col_params.instance.type.
+  CollectiveImplementationInterface* CreateGatherScatter(
+      OpKernelContext* ctx, OpKernelContext::Params* params,
+      const CollectiveParams& col_params, const string& exec_key,
+      int64 step_id, const Tensor* input, Tensor* output, string* error);
 
   Broadcaster* CreateBroadcaster(OpKernelContext* ctx,
                                  OpKernelContext::Params* params,
@@ -497,6 +497,7 @@ void CollectiveParamResolverLocal::InitInstanceSharedParams(
             ir->out_cv.notify_all();
             if (s.ok()) {
               CompleteDefaultRanking(gr, cp, ir, *localities);
+              SelectCollectiveImplementation(&ir->shared);
               done(Status::OK());
             } else {
               done(s);
@@ -537,6 +538,42 @@ void CollectiveParamResolverLocal::CompleteDefaultRanking(
   }
 }
 
+namespace {
+// Reductions of at most this many bytes are considered latency bound, so
+// an algorithm with a logarithmic number of steps is preferred to the
+// bandwidth-optimal ring.
+constexpr int64 kLatencyBoundReduceBytes = 256 * 1024;
+}  // namespace
+
+/*static*/
+void CollectiveParamResolverLocal::SelectCollectiveImplementation(
+    CollectiveParams* cp) {
+  string* name = &cp->instance.impl_details.collective_name;
+  if (!name->empty() && *name != kAutoSelectName) return;
+  switch (cp->instance.type) {
+    case REDUCTION_COLLECTIVE: {
+      const int64 num_bytes = cp->instance.shape.num_elements() *
+                              DataTypeSize(cp->instance.data_type);
+      if (cp->group.group_size <= 2 || num_bytes > kLatencyBoundReduceBytes) {
+        // With two devices every algorithm degenerates to a single
+        // exchange, and large values are bandwidth bound.
+        *name = kRingReduceName;
+      } else if (cp->group.num_tasks > 1 &&
+                 cp->group.group_size > cp->group.num_tasks) {
+        // Keep all but one device per task off the network.
+        *name = kHierarchicalReduceName;
+      } else {
+        *name = kHalvingDoublingReduceName;
+      }
+    } break;
+    default:
+      // Only one implementation is available.
+      name->clear();
+  }
+  VLOG(1) << "Selected collective implementation \"" << *name
+          << "\" for instance " << cp->instance.instance_key;
+}
+
 void CollectiveParamResolverLocal::CallbackWithStatus(
     const InstanceRecCallback& done, InstanceRec* irec) {
   Status s;
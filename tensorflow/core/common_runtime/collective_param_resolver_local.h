@@ -216,6 +216,13 @@ class CollectiveParamResolverLocal : public ParamResolverInterface {
   static void GenerateSubdivPerms(const string& device, int source_rank,
                                   CollectiveParams* cp);
 
+  // If cp->instance.impl_details.collective_name is empty or
+  // kAutoSelectName, replaces it with the name of the algorithm best
+  // suited to the shape, data type and device group of the instance.
+  // Depends only on fields that are identical across all members of
+  // the instance so every member makes the same choice.
+  static void SelectCollectiveImplementation(CollectiveParams* cp);
+
   const DeviceMgr* dev_mgr_;
   DeviceResolverInterface* dev_resolver_;  // Not owned.
   string task_name_;
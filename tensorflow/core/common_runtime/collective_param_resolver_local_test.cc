@@ -49,6 +49,10 @@ class CollectiveParamResolverLocalTest : public ::testing::Test {
     CollectiveParamResolverLocal::GenerateSubdivPerms(device, source_rank, cp);
   }
 
+  void SelectCollectiveImplementation(CollectiveParams* cp) {
+    CollectiveParamResolverLocal::SelectCollectiveImplementation(cp);
+  }
+
   std::vector<Device*> devices_;
   std::unique_ptr<DeviceMgr> device_mgr_;
   std::unique_ptr<DeviceResolverLocal> drl_;
@@ -99,7 +103,91 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
     EXPECT_FALSE(cps[i].is_source);
     EXPECT_EQ(cps[i].default_rank, i);
     EXPECT_TRUE(cps[i].instance.same_num_devices_per_task);
+    // A tiny reduction among 3 devices is latency bound.
+    EXPECT_EQ(kHalvingDoublingReduceName,
+              cps[i].instance.impl_details.collective_name);
+  }
+}
+
+TEST_F(CollectiveParamResolverLocalTest, CompleteParamsLargeReduction1Task) {
+  CollectiveParams cps[NUM_DEVS];
+  Status statuses[NUM_DEVS];
+  Notification note[NUM_DEVS];
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    CollectiveParams* cp = &cps[i];
+    cp->group.group_key = 2;
+    cp->group.group_size = 3;
+    cp->group.device_type = DeviceType("CPU");
+    cp->group.num_tasks = 1;
+    cp->instance.instance_key = 8;
+    cp->instance.type = REDUCTION_COLLECTIVE;
+    cp->instance.data_type = DataType(DT_FLOAT);
+    // The shape recorded by the kernel from its input, 4MB of floats.
+    cp->instance.shape = TensorShape({1 << 20});
+    cp->instance.device_names.push_back(
+        strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i));
+    cp->instance.impl_details.subdiv_offsets.push_back(0);
+    cp->is_source = false;
+    Env::Default()->SchedClosure([this, i, cp, &note, &statuses]() {
+      prl_->CompleteParamsAsync(cp->instance.device_names[0], cp,
+                                nullptr /*CancellationManager*/,
+                                [this, &statuses, &note, i](const Status& s) {
+                                  statuses[i] = s;
+                                  note[i].Notify();
+                                });
+    });
   }
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    note[i].WaitForNotification();
+  }
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    TF_ASSERT_OK(statuses[i]);
+    // A large reduction is bandwidth bound, so the ring is selected.
+    EXPECT_EQ(kRingReduceName, cps[i].instance.impl_details.collective_name);
+  }
+}
+
+TEST_F(CollectiveParamResolverLocalTest, SelectCollectiveImplementation) {
+  CollectiveParams cp;
+  cp.group.group_size = 8;
+  cp.group.num_tasks = 1;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.shape = TensorShape({1024});
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ(kHalvingDoublingReduceName,
+            cp.instance.impl_details.collective_name);
+
+  // Multiple devices per task keep inter-task traffic to the leaders.
+  cp.group.num_tasks = 2;
+  cp.instance.impl_details.collective_name = kAutoSelectName;
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ(kHierarchicalReduceName, cp.instance.impl_details.collective_name);
+
+  // Large values are bandwidth bound.
+  cp.instance.shape = TensorShape({1 << 20});
+  cp.instance.impl_details.collective_name.clear();
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ(kRingReduceName, cp.instance.impl_details.collective_name);
+
+  // Two devices are always served by the ring.
+  cp.group.group_size = 2;
+  cp.instance.shape = TensorShape({16});
+  cp.instance.impl_details.collective_name.clear();
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ(kRingReduceName, cp.instance.impl_details.collective_name);
+
+  // An explicit request is never overridden.
+  cp.group.group_size = 8;
+  cp.instance.impl_details.collective_name = kRingReduceName;
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ(kRingReduceName, cp.instance.impl_details.collective_name);
+
+  // Broadcast has a single implementation.
+  cp.instance.type = BROADCAST_COLLECTIVE;
+  cp.instance.impl_details.collective_name = kAutoSelectName;
+  SelectCollectiveImplementation(&cp);
+  EXPECT_EQ("", cp.instance.impl_details.collective_name);
 }
 
 TEST_F(CollectiveParamResolverLocalTest, CompleteParamsBroadcast1Task) {
@@ -0,0 +1,231 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace test {
+
+bool FailTestRMA::MaybeFail(const StatusCallback& done) {
+  bool fail_now = false;
+  {
+    mutex_lock l(mu_);
+    if (fail_after_ > 0) {
+      fail_now = (--fail_after_ == 0);
+    }
+  }
+  if (fail_now) {
+    done(errors::Internal("Deliberate failure"));
+    return true;
+  }
+  return false;
+}
+
+void FailTestRMA::RecvFromPeer(const string& peer_device,
+                               const string& peer_task, bool peer_is_local,
+                               const string& key, Device* to_device,
+                               DeviceContext* to_device_ctx,
+                               const AllocatorAttributes& to_alloc_attr,
+                               Tensor* to_tensor,
+                               const DeviceLocality& client_locality,
+                               int dev_to_dev_stream_index,
+                               const StatusCallback& done) {
+  if (MaybeFail(done)) return;
+  CollectiveRemoteAccessLocal::RecvFromPeer(
+      peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
+      to_alloc_attr, to_tensor, client_locality, dev_to_dev_stream_index,
+      done);
+}
+
+void FailTestRMA::PostToPeer(const string& peer_device,
+                             const string& peer_task, const string& key,
+                             Device* from_device,
+                             DeviceContext* from_device_ctx,
+                             const AllocatorAttributes& from_alloc_attr,
+                             const Tensor* from_tensor,
+                             const DeviceLocality& client_locality,
+                             const StatusCallback& done) {
+  if (MaybeFail(done)) return;
+  CollectiveRemoteAccessLocal::PostToPeer(
+      peer_device, peer_task, key, from_device, from_device_ctx,
+      from_alloc_attr, from_tensor, client_locality, done);
+}
+
+std::unique_ptr<OpKernel> GetCollectiveKernel(const string& op_name,
+                                              DataType dtype,
+                                              DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op_name, "_node"), op_name);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+CollectiveTestEnv::CollectiveTestEnv(int num_workers, int num_devices,
+                                     int64 step_id, int fail_after)
+    : num_workers_(num_workers),
+      num_devices_(num_devices),
+      step_id_(step_id),
+      col_exec_(nullptr) {
+  std::vector<Device*> local_devices;
+  SessionOptions sess_opts;
+  sess_opts.env = Env::Default();
+  Bytes mem_limit(4 << 20);
+  DeviceLocality dev_locality;
+  for (int wi = 0; wi < num_workers; ++wi) {
+    for (int di = 0; di < num_devices; ++di) {
+      string dev_name =
+          strings::StrCat("/job:worker/replica:0/task:", wi, "/cpu:", di);
+      local_devices.push_back(new ThreadPoolDevice(
+          sess_opts, dev_name, mem_limit, dev_locality, cpu_allocator()));
+    }
+  }
+  dev_mgr_.reset(new DeviceMgr(local_devices));
+  dev_resolver_.reset(new DeviceResolverLocal(dev_mgr_.get()));
+  CollectiveRemoteAccessLocal* rma =
+      new FailTestRMA(dev_mgr_.get(), dev_resolver_.get(), step_id, fail_after);
+  col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma, step_id,
+                                         dev_mgr_.get());
+}
+
+CollectiveTestEnv::~CollectiveTestEnv() { col_exec_->Unref(); }
+
+void CollectiveTestEnv::InitParams(CollectiveType type, DataType dtype,
+                                   CollectiveParams* cp) const {
+  cp->name = "test_collective";
+  cp->group.group_key = 5;
+  cp->group.device_type = DEVICE_CPU;
+  cp->group.group_size = num_workers_ * num_devices_;
+  cp->group.num_tasks = num_workers_;
+  cp->instance.instance_key = 17;
+  cp->instance.type = type;
+  cp->instance.data_type = dtype;
+  cp->instance.impl_details.subdiv_offsets = {0};
+  cp->instance.impl_details.subdiv_permutations.resize(1);
+  for (int wi = 0; wi < num_workers_; ++wi) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", wi);
+    for (int di = 0; di < num_devices_; ++di) {
+      int rank = wi * num_devices_ + di;
+      cp->instance.device_names.push_back(
+          strings::StrCat(task_name, "/cpu:", di));
+      cp->instance.task_names.push_back(task_name);
+      // This test runs in a single process so is_local is always true.
+      cp->task.is_local.push_back(true);
+      cp->instance.impl_details.subdiv_permutations[0].push_back(rank);
+    }
+  }
+}
+
+Device* CollectiveTestEnv::InitDeviceParams(const CollectiveParams& shared,
+                                            int rank,
+                                            CollectiveParams* cp) const {
+  cp->name = shared.name;
+  cp->group = shared.group;
+  cp->instance = shared.instance;
+  cp->task.is_local = shared.task.is_local;
+  cp->default_rank = rank;
+  cp->subdiv_rank = {rank};
+  Device* device = nullptr;
+  TF_CHECK_OK(
+      dev_mgr_->LookupDevice(cp->instance.device_names[rank], &device));
+  if (cp->instance.type == REDUCTION_COLLECTIVE ||
+      cp->instance.type == REDUCE_SCATTER_COLLECTIVE) {
+    cp->merge_op = GetCollectiveKernel("Add", cp->instance.data_type, device);
+    cp->final_op = GetCollectiveKernel("Div", cp->instance.data_type, device);
+  }
+  return device;
+}
+
+Status CollectiveTestEnv::RunCollective(Device* device, OpKernel* op_kernel,
+                                        Tensor* input,
+                                        const TensorShape& output_shape,
+                                        bool forward_input,
+                                        const ImplFactory& create,
+                                        Tensor* output) const {
+  // Prepare an OpKernelContext.
+  OpKernelContext::Params op_params;
+  op_params.step_id = step_id_;
+  op_params.device = device;
+  gtl::InlinedVector<TensorValue, 4> inputs;
+  inputs.push_back(TensorValue(input));
+  op_params.inputs = &inputs;
+  gtl::InlinedVector<AllocatorAttributes, 4> input_aa({AllocatorAttributes()});
+  op_params.input_alloc_attrs = &input_aa;
+  DeviceContext* dev_ctx = new DeviceContext;
+  gtl::InlinedVector<DeviceContext*, 4> input_dc({dev_ctx});
+  op_params.input_device_contexts = &input_dc;
+  op_params.op_device_context = dev_ctx;
+  int forward_from = 0;
+  op_params.forward_from_array = &forward_from;
+  AllocatorAttributes generic_alloc_attr;
+  op_params.output_attr_array = &generic_alloc_attr;
+  op_params.op_kernel = op_kernel;
+  OpKernelContext ctx(&op_params, 1);
+  Tensor* out = nullptr;
+  if (forward_input) {
+    TF_CHECK_OK(ctx.forward_input_or_allocate_output({0}, 0, output_shape,
+                                                     &out));
+  } else {
+    TF_CHECK_OK(ctx.allocate_output(0, output_shape, &out));
+  }
+
+  std::unique_ptr<CollectiveImplementationInterface> impl(
+      create(&ctx, &op_params, out));
+  Status status;
+  Notification note;
+  impl->Run([&status, &note](const Status& s) {
+    status = s;
+    note.Notify();
+  });
+  note.WaitForNotification();
+  *output = *ctx.mutable_output(0);
+  dev_ctx->Unref();
+  return status;
+}
+
+/*static*/
+void CollectiveTestEnv::RunOnAllRanks(
+    int group_size, const std::function<void(int rank)>& fn) {
+  BlockingCounter counter(group_size);
+  for (int rank = 0; rank < group_size; ++rank) {
+    SchedClosure([rank, &fn, &counter] {
+      fn(rank);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+}  // namespace test
+}  // namespace tensorflow
@@ -0,0 +1,129 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_TEST_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_TEST_UTIL_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace test {
+
+// Wraps CollectiveRemoteAccessLocal with the ability to return an
+// error status to the N'th action.
+class FailTestRMA : public CollectiveRemoteAccessLocal {
+ public:
+  FailTestRMA(const DeviceMgr* dev_mgr, DeviceResolverInterface* dev_resolver,
+              int64 step_id, int fail_after)
+      : CollectiveRemoteAccessLocal(dev_mgr, dev_resolver, step_id),
+        fail_after_(fail_after) {}
+
+  bool MaybeFail(const StatusCallback& done);
+
+  void RecvFromPeer(const string& peer_device, const string& peer_task,
+                    bool peer_is_local, const string& key, Device* to_device,
+                    DeviceContext* to_device_ctx,
+                    const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+                    const DeviceLocality& client_locality,
+                    int dev_to_dev_stream_index,
+                    const StatusCallback& done) override;
+
+  void PostToPeer(const string& peer_device, const string& peer_task,
+                  const string& key, Device* from_device,
+                  DeviceContext* from_device_ctx,
+                  const AllocatorAttributes& from_alloc_attr,
+                  const Tensor* from_tensor,
+                  const DeviceLocality& client_locality,
+                  const StatusCallback& done) override;
+
+ private:
+  mutex mu_;
+  int fail_after_ GUARDED_BY(mu_);
+};
+
+// Returns a CPU kernel for the binary op 'op_name' on 'dtype', as used for
+// the merge_op and final_op of reductions.
+std::unique_ptr<OpKernel> GetCollectiveKernel(const string& op_name,
+                                              DataType dtype,
+                                              DeviceBase* device);
+
+// Runs collectives among num_workers * num_devices virtual CPU devices in a
+// single process, with each worker simulated as a distinct task.
+class CollectiveTestEnv {
+ public:
+  // Creates an implementation of the collective to run with 'ctx' and
+  // 'params', writing to 'output'.
+  typedef std::function<CollectiveImplementationInterface*(
+      OpKernelContext* ctx, OpKernelContext::Params* params, Tensor* output)>
+      ImplFactory;
+
+  // Transfers fail from the 'fail_after'th one on if it is positive.
+  CollectiveTestEnv(int num_workers, int num_devices, int64 step_id,
+                    int fail_after);
+  ~CollectiveTestEnv();
+
+  // Sets the group and instance of 'cp' for a collective of 'type' among
+  // all the devices, with ranks in worker-major order.
+  void InitParams(CollectiveType type, DataType dtype,
+                  CollectiveParams* cp) const;
+
+  // Sets 'cp' to the parameters of 'shared' for the device of 'rank' and
+  // returns that device.  Reductions get Add and Div kernels as their
+  // merge_op and final_op.
+  Device* InitDeviceParams(const CollectiveParams& shared, int rank,
+                           CollectiveParams* cp) const;
+
+  // Runs the collective made by 'create' on 'device', with 'input' as
+  // input 0 of its OpKernelContext and an output of 'output_shape', which
+  // is forwarded from the input if 'forward_input'.  Returns the status of
+  // the collective and sets 'output' to its output.
+  Status RunCollective(Device* device, OpKernel* op_kernel, Tensor* input,
+                       const TensorShape& output_shape, bool forward_input,
+                       const ImplFactory& create, Tensor* output) const;
+
+  // Calls 'fn' for every rank of 'group_size' in parallel and blocks until
+  // all the calls return.
+  static void RunOnAllRanks(int group_size,
+                            const std::function<void(int rank)>& fn);
+
+  CollectiveExecutor* col_exec() const { return col_exec_; }
+  const DeviceMgr* dev_mgr() const { return dev_mgr_.get(); }
+  int64 step_id() const { return step_id_; }
+
+ private:
+  const int num_workers_;
+  const int num_devices_;
+  const int64 step_id_;
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  CollectiveExecutor* col_exec_;
+};
+
+}  // namespace test
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_TEST_UTIL_H_
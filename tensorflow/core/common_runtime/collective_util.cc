@@ -0,0 +1,93 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_util.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+
+namespace tensorflow {
+namespace collective_util {
+
+SubContext::SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
+                       OpKernel* op, Tensor* output, Tensor* input)
+    : sub_params_(*params),
+      sub_inputs_({output, input}),
+      sub_input_attr_({ctx->input_alloc_attr(0), ctx->input_alloc_attr(0)}),
+      sub_input_dc_(
+          {ctx->input_device_context(0), ctx->input_device_context(0)}) {
+  sub_params_.op_kernel = op;
+  sub_params_.inputs = &sub_inputs_;
+  sub_params_.input_alloc_attrs = &sub_input_attr_;
+  sub_params_.input_device_contexts = &sub_input_dc_;
+  sub_params_.eigen_gpu_device = nullptr;
+  sub_params_.ensure_eigen_gpu_device();
+  sub_params_.forward_from_array = &forward_from_;
+  sub_ctx_ = new OpKernelContext(&sub_params_, 1);
+}
+
+Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                    Device* device, OpKernel* op, Tensor* output,
+                    Tensor* input) {
+  // Prepare an OpKernelContext that is identical to that of the original Op
+  // (i.e. the collective), except for the input output sizes and identities and
+  // the Op itself.
+  // TODO(tucker): Is it possible to cache and reuse these objects?  They're
+  // mostly identical inside one device execution.
+  std::unique_ptr<SubContext> sub_ctx(
+      new SubContext(op_ctx, params, op, output, input));
+  device->Compute(op, sub_ctx->sub_ctx_);
+  return sub_ctx->sub_ctx_->status();
+}
+
+Tensor MakeScalar(DataType dtype, int value) {
+  Tensor t(dtype, TensorShape({}));
+  switch (dtype) {
+    case DT_FLOAT:
+      t.scalar<float>()() = value;
+      break;
+    case DT_DOUBLE:
+      t.scalar<double>()() = value;
+      break;
+    case DT_INT32:
+      t.scalar<int32>()() = value;
+      break;
+    case DT_INT64:
+      t.scalar<int64>()() = value;
+      break;
+    default:
+      LOG(FATAL) << "Unsupported type " << DataTypeString(dtype)
+                 << " for collective scalar";
+  }
+  return t;
+}
+
+StatusCallback PendingTransfers::Callback() {
+  return [this](const Status& s) {
+    if (!s.ok()) abort_(s);
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    counter_.DecrementCount();
+  };
+}
+
+Status PendingTransfers::Wait() {
+  counter_.Wait();
+  mutex_lock l(mu_);
+  return status_;
+}
+
+}  // namespace collective_util
+}  // namespace tensorflow
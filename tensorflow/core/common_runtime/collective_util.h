@@ -0,0 +1,83 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
+
+#include <functional>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+class Device;
+
+namespace collective_util {
+
+// Used for executing a sub-operation, e.g. a merge_op instance, with
+// an OpKernelContext based on the one passed into a collective Op.
+class SubContext {
+ public:
+  OpKernelContext::Params sub_params_;
+  gtl::InlinedVector<TensorValue, 4> sub_inputs_;
+  gtl::InlinedVector<AllocatorAttributes, 4> sub_input_attr_;
+  gtl::InlinedVector<DeviceContext*, 4> sub_input_dc_;
+  // Used only for Binary and Unary Ops for which we require
+  // the calculation to be in-place on the first input.
+  int forward_from_ = 0;
+  OpKernelContext* sub_ctx_;
+  SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
+             OpKernel* op, Tensor* output, Tensor* input);
+  ~SubContext() { delete sub_ctx_; }
+};
+
+// Computes 'op' on 'device' in-place over 'output' with 'input' as the
+// second operand, i.e. output = op(output, input).  The OpKernelContext
+// is identical to that of 'op_ctx' except for the inputs and the Op.
+Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
+                    Device* device, OpKernel* op, Tensor* output,
+                    Tensor* input);
+
+// Returns a CPU RAM scalar tensor of type dtype with the given value.
+// dtype must be one of the numeric types supported by collective ops.
+Tensor MakeScalar(DataType dtype, int value);
+
+// Accumulates the Status of several concurrent transfers.  The first
+// failure is reported to 'abort' immediately, so that peers blocked on
+// this device are released before Wait returns.
+class PendingTransfers {
+ public:
+  PendingTransfers(int count, std::function<void(const Status&)> abort)
+      : counter_(count), abort_(std::move(abort)) {}
+
+  // Returns a callback to be passed as the done callback of one transfer.
+  StatusCallback Callback();
+
+  // Blocks until every transfer has called back, then returns the first
+  // error, if any.
+  Status Wait();
+
+ private:
+  BlockingCounter counter_;
+  const std::function<void(const Status&)> abort_;
+  mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+};
+
+}  // namespace collective_util
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
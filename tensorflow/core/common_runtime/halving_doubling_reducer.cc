@@ -0,0 +1,395 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
+
+#include <set>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+// Set true for greater intelligibility of debug mode log messages.
+#define READABLE_KEYS false
+
+namespace tensorflow {
+namespace {
+// Key to be used for BufRendezvous by HalvingDoublingReducer.
+string HalvingDoublingBufKey(const string& exec_key, const string& phase,
+                             int step, int src_idx, int dst_idx) {
+  if (READABLE_KEYS) {
+    return strings::StrCat("hdred(", exec_key, "):phase(", phase, "):step(",
+                           step, "):src(", src_idx, "):dst(", dst_idx, ")");
+  } else {
+    return strings::StrCat(exec_key, ":", phase, ":", step, ":", src_idx, ":",
+                           dst_idx);
+  }
+}
+}  // namespace
+
+HalvingDoublingReducer::HalvingDoublingReducer(
+    CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+    OpKernelContext* ctx, OpKernelContext::Params* op_params,
+    const CollectiveParams& col_params, const string& exec_key, int64 step_id,
+    const Tensor* input, Tensor* output, bool hierarchical)
+    : col_exec_(col_exec),
+      dev_mgr_(dev_mgr),
+      ctx_(ctx),
+      op_params_(op_params),
+      col_params_(col_params),
+      exec_key_(exec_key),
+      input_(input),
+      output_(output),
+      step_id_(step_id),
+      hierarchical_(hierarchical),
+      my_dev_idx_(col_params.default_rank),
+      device_(nullptr) {
+  CHECK_GT(col_params_.group.group_size, 0);
+  CHECK_GE(my_dev_idx_, 0);
+}
+
+/*static*/
+int HalvingDoublingReducer::LargestPowerOfTwo(int n) {
+  DCHECK_GT(n, 0);
+  int p = 1;
+  while ((p << 1) <= n) p <<= 1;
+  return p;
+}
+
+void HalvingDoublingReducer::Run(StatusCallback done) {
+  Status status = dev_mgr_->LookupDevice(
+      col_params_.instance.device_names[my_dev_idx_], &device_);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  CHECK(device_);
+  device_locality_ = device_->attributes().locality();
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((input_ != output_) &&
+      (DMAHelper::base(input_) != DMAHelper::base(output_))) {
+    // We are running in a blockable thread and the callback can't block so
+    // just wait here on the copy.
+    Notification note;
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        ctx_->input_device_context(0), ctx_->op_device_context(), device_,
+        device_, ctx_->input_alloc_attr(0), ctx_->output_alloc_attr(0), input_,
+        output_, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+  // All transfers and reductions operate on a flat alias of the output.
+  CHECK(value_.CopyFrom(*output_, TensorShape({output_->NumElements()})));
+
+  if (col_params_.final_op) {
+    Tensor group_size_val = collective_util::MakeScalar(
+        col_params_.instance.data_type, col_params_.group.group_size);
+    if (col_params_.group.device_type != "CPU") {
+      group_size_tensor_ =
+          Tensor(device_->GetAllocator(ctx_->input_alloc_attr(0)),
+                 col_params_.instance.data_type, TensorShape({}));
+      Notification note;
+      ctx_->op_device_context()->CopyCPUTensorToDevice(
+          &group_size_val, device_, &group_size_tensor_,
+          [&note, &status](const Status& s) {
+            status.Update(s);
+            note.Notify();
+          });
+      note.WaitForNotification();
+    } else {
+      group_size_tensor_ = group_size_val;
+    }
+  }
+
+  if (status.ok()) {
+    status = hierarchical_ ? RunHierarchical() : RunFlat();
+  }
+  if (!status.ok()) {
+    StartAbort(status);
+  }
+  value_ = Tensor();
+  done(status);
+}
+
+void HalvingDoublingReducer::StartAbort(const Status& s) {
+  {
+    mutex_lock l(abort_mu_);
+    if (aborted_) return;
+    aborted_ = true;
+  }
+  // Unblock any peers still waiting on transfers with this device.
+  LOG(ERROR) << "Aborting HalvingDoublingReduce with " << s;
+  col_exec_->StartAbort(s);
+}
+
+Status HalvingDoublingReducer::RunFlat() {
+  std::vector<int> dev_indices(col_params_.group.group_size);
+  for (int i = 0; i < dev_indices.size(); ++i) {
+    dev_indices[i] = i;
+  }
+  return AllReduceAmong(dev_indices, my_dev_idx_, "flat");
+}
+
+Status HalvingDoublingReducer::RunHierarchical() {
+  // Partition the devices by task, preserving the default rank order.
+  // The first device of each task acts as its leader.
+  const std::vector<string>& task_names = col_params_.instance.task_names;
+  const string& my_task = task_names[my_dev_idx_];
+  std::vector<int> leaders;
+  std::vector<int> local_devs;
+  std::set<string> seen_tasks;
+  for (int i = 0; i < col_params_.group.group_size; ++i) {
+    if (seen_tasks.insert(task_names[i]).second) {
+      leaders.push_back(i);
+    }
+    if (task_names[i] == my_task) {
+      local_devs.push_back(i);
+    }
+  }
+  const int leader = local_devs[0];
+  if (my_dev_idx_ != leader) {
+    TF_RETURN_IF_ERROR(Send("up", 0, leader, value_));
+    return Recv("down", 0, leader, &value_);
+  }
+
+  // Reduce the values of all local devices into the leader.
+  const int num_local_peers = static_cast<int>(local_devs.size()) - 1;
+  if (num_local_peers > 0) {
+    std::vector<Tensor> peer_values;
+    peer_values.reserve(num_local_peers);
+    collective_util::PendingTransfers pending(num_local_peers, AbortCallback());
+    for (int i = 0; i < num_local_peers; ++i) {
+      peer_values.push_back(TempTensor(value_.NumElements()));
+      DispatchRecv("up", 0, local_devs[i + 1], &peer_values.back(),
+                   pending.Callback());
+    }
+    TF_RETURN_IF_ERROR(pending.Wait());
+    for (Tensor& peer_value : peer_values) {
+      TF_RETURN_IF_ERROR(Reduce(&value_, &peer_value));
+    }
+  }
+
+  // Reduce across tasks, one leader per task.
+  int my_leader_pos = -1;
+  for (int i = 0; i < leaders.size(); ++i) {
+    if (leaders[i] == my_dev_idx_) my_leader_pos = i;
+  }
+  CHECK_GE(my_leader_pos, 0);
+  TF_RETURN_IF_ERROR(AllReduceAmong(leaders, my_leader_pos, "inter"));
+
+  // Return the final value to the local devices.
+  if (num_local_peers > 0) {
+    collective_util::PendingTransfers pending(num_local_peers, AbortCallback());
+    for (int i = 0; i < num_local_peers; ++i) {
+      DispatchSend("down", 0, local_devs[i + 1], &value_, pending.Callback());
+    }
+    TF_RETURN_IF_ERROR(pending.Wait());
+  }
+  return Status::OK();
+}
+
+Status HalvingDoublingReducer::AllReduceAmong(
+    const std::vector<int>& dev_indices, int my_pos, const string& phase) {
+  const int n = static_cast<int>(dev_indices.size());
+  if (n == 1) {
+    return Finalize(&value_);
+  }
+  // Only a power-of-two number of devices, p, can take part in recursive
+  // halving.  Each of the first 2*(n-p) devices with odd position
+  // contributes its value to its even neighbor and then waits to
+  // receive the final result from it.
+  const int p = LargestPowerOfTwo(n);
+  const int excess = n - p;
+  int vrank;
+  if (my_pos < 2 * excess) {
+    if (my_pos % 2 == 1) {
+      const int neighbor = dev_indices[my_pos - 1];
+      TF_RETURN_IF_ERROR(Send(strings::StrCat(phase, "pre"), 0, neighbor,
+                              value_));
+      return Recv(strings::StrCat(phase, "post"), 0, neighbor, &value_);
+    }
+    Tensor neighbor_value = TempTensor(value_.NumElements());
+    TF_RETURN_IF_ERROR(Recv(strings::StrCat(phase, "pre"), 0,
+                            dev_indices[my_pos + 1], &neighbor_value));
+    TF_RETURN_IF_ERROR(Reduce(&value_, &neighbor_value));
+    vrank = my_pos / 2;
+  } else {
+    vrank = my_pos - excess;
+  }
+  auto vrank_to_dev = [&dev_indices, excess](int v) {
+    return dev_indices[(v < excess) ? (2 * v) : (v + excess)];
+  };
+
+  // Reduce-scatter by recursive halving.  At each step this device keeps
+  // half of the chunks it is currently responsible for, sending the other
+  // half to its partner and reducing the partner's copy of the kept half
+  // into its own.  Afterwards it holds the full reduction of exactly one
+  // chunk, which is finalized in place.
+  int lo = 0;
+  int hi = p;
+  int step = 0;
+  for (int mask = p / 2; mask > 0; mask >>= 1, ++step) {
+    const int partner = vrank_to_dev(vrank ^ mask);
+    const int mid = (lo + hi) / 2;
+    const bool keep_low = (vrank & mask) == 0;
+    Tensor send_t = keep_low ? ChunkRange(mid, hi, p) : ChunkRange(lo, mid, p);
+    Tensor keep_t = keep_low ? ChunkRange(lo, mid, p) : ChunkRange(mid, hi, p);
+    Tensor recv_t = TempTensor(keep_t.NumElements());
+    TF_RETURN_IF_ERROR(SendRecv(strings::StrCat(phase, "rs"), step, partner,
+                                send_t, partner, &recv_t));
+    if (keep_t.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(Reduce(&keep_t, &recv_t));
+    }
+    if (keep_low) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+  }
+  Tensor own_t = ChunkRange(lo, hi, p);
+  if (own_t.NumElements() > 0) {
+    TF_RETURN_IF_ERROR(Finalize(&own_t));
+  }
+
+  // All-gather by recursive doubling, retracing the halving steps in
+  // reverse.  Each step exchanges the reduced range held so far for the
+  // partner's adjacent range of equal chunk count.
+  step = 0;
+  for (int mask = 1; mask < p; mask <<= 1, ++step) {
+    const int partner = vrank_to_dev(vrank ^ mask);
+    const int width = hi - lo;
+    const bool have_low = (vrank & mask) == 0;
+    const int partner_lo = have_low ? hi : (lo - width);
+    Tensor send_t = ChunkRange(lo, hi, p);
+    Tensor recv_t = ChunkRange(partner_lo, partner_lo + width, p);
+    TF_RETURN_IF_ERROR(SendRecv(strings::StrCat(phase, "ag"), step, partner,
+                                send_t, partner, &recv_t));
+    lo = std::min(lo, partner_lo);
+    hi = lo + 2 * width;
+  }
+  DCHECK_EQ(lo, 0);
+  DCHECK_EQ(hi, p);
+
+  if (my_pos < 2 * excess) {
+    // Return the result to the neighbor folded in above.
+    TF_RETURN_IF_ERROR(Send(strings::StrCat(phase, "post"), 0,
+                            dev_indices[my_pos + 1], value_));
+  }
+  return Status::OK();
+}
+
+Status HalvingDoublingReducer::Send(const string& phase, int step,
+                                    int dev_idx, const Tensor& t) {
+  collective_util::PendingTransfers pending(1, AbortCallback());
+  DispatchSend(phase, step, dev_idx, &t, pending.Callback());
+  return pending.Wait();
+}
+
+Status HalvingDoublingReducer::Recv(const string& phase, int step, int dev_idx,
+                                    Tensor* t) {
+  collective_util::PendingTransfers pending(1, AbortCallback());
+  DispatchRecv(phase, step, dev_idx, t, pending.Callback());
+  return pending.Wait();
+}
+
+Status HalvingDoublingReducer::SendRecv(const string& phase, int step,
+                                        int send_dev_idx, const Tensor& send_t,
+                                        int recv_dev_idx, Tensor* recv_t) {
+  // Empty ranges are skipped by both parties, since the sender's send
+  // range is always the receiver's receive range.
+  const bool do_send = send_t.NumElements() > 0;
+  const bool do_recv = recv_t->NumElements() > 0;
+  collective_util::PendingTransfers pending(
+      static_cast<int>(do_send) + static_cast<int>(do_recv), AbortCallback());
+  if (do_send) {
+    DispatchSend(phase, step, send_dev_idx, &send_t, pending.Callback());
+  }
+  if (do_recv) {
+    DispatchRecv(phase, step, recv_dev_idx, recv_t, pending.Callback());
+  }
+  return pending.Wait();
+}
+
+void HalvingDoublingReducer::DispatchSend(const string& phase, int step,
+                                          int dev_idx, const Tensor* t,
+                                          const StatusCallback& done) {
+  string send_buf_key =
+      HalvingDoublingBufKey(exec_key_, phase, step, my_dev_idx_, dev_idx);
+  VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
+          << device_->name();
+  col_exec_->PostToPeer(col_params_.instance.device_names[dev_idx],
+                        col_params_.instance.task_names[dev_idx], send_buf_key,
+                        device_, ctx_->op_device_context(),
+                        ctx_->output_alloc_attr(0), t, device_locality_, done);
+}
+
+void HalvingDoublingReducer::DispatchRecv(const string& phase, int step,
+                                          int dev_idx, Tensor* t,
+                                          const StatusCallback& done) {
+  string recv_buf_key =
+      HalvingDoublingBufKey(exec_key_, phase, step, dev_idx, my_dev_idx_);
+  VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
+          << col_params_.instance.device_names[dev_idx];
+  col_exec_->RecvFromPeer(col_params_.instance.device_names[dev_idx],
+                          col_params_.instance.task_names[dev_idx],
+                          col_params_.task.is_local[dev_idx], recv_buf_key,
+                          device_, ctx_->op_device_context(),
+                          ctx_->output_alloc_attr(0), t, device_locality_,
+                          0 /*stream_index*/, done);
+}
+
+Status HalvingDoublingReducer::Reduce(Tensor* accum, Tensor* input) {
+  return collective_util::ComputeBinOp(ctx_, op_params_, device_,
+                                       col_params_.merge_op.get(), accum,
+                                       input);
+}
+
+Status HalvingDoublingReducer::Finalize(Tensor* t) {
+  if (!col_params_.final_op) return Status::OK();
+  return collective_util::ComputeBinOp(ctx_, op_params_, device_,
+                                       col_params_.final_op.get(), t,
+                                       &group_size_tensor_);
+}
+
+Tensor HalvingDoublingReducer::ChunkRange(int first, int limit,
+                                          int num_chunks) const {
+  const int64 total_elts = value_.NumElements();
+  const int64 chunk_elts = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(value_.dtype()), total_elts, num_chunks);
+  const int64 start = std::min(total_elts, first * chunk_elts);
+  const int64 end = std::min(total_elts, limit * chunk_elts);
+  // As in CollectiveAdapter::ChunkAlias, always take an empty slice from
+  // the front of the tensor to avoid an illegal offset.
+  return (end > start) ? value_.Slice(start, end) : value_.Slice(0, 0);
+}
+
+Tensor HalvingDoublingReducer::TempTensor(int64 num_elts) const {
+  AllocationAttributes empty;
+  return Tensor(device_->GetAllocator(ctx_->output_alloc_attr(0)),
+                value_.dtype(), TensorShape({num_elts}), empty);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,121 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+class DeviceMgr;
+
+// Latency-optimized implementations of collective all-reduce.
+//
+// In flat mode all devices of the group run a recursive-halving
+// reduce-scatter followed by a recursive-doubling all-gather.  This
+// takes 2*log2(group_size) exchange steps, versus 2*(group_size-1) for
+// the ring, while moving the same total number of bytes per device.
+// Group sizes that are not a power of two are handled by first folding
+// the excess devices into a neighbor.
+//
+// In hierarchical mode the reduction has two levels: the devices of each
+// task first reduce into a task-local leader, the leaders then run the
+// flat algorithm among themselves, and finally each leader sends the
+// result back to its local devices.  Only one device per task
+// exchanges data over the network.
+class HalvingDoublingReducer : public CollectiveImplementationInterface {
+ public:
+  HalvingDoublingReducer(CollectiveExecutor* col_exec,
+                         const DeviceMgr* dev_mgr, OpKernelContext* ctx,
+                         OpKernelContext::Params* op_params,
+                         const CollectiveParams& col_params,
+                         const string& exec_key, int64 step_id,
+                         const Tensor* input, Tensor* output,
+                         bool hierarchical);
+
+  ~HalvingDoublingReducer() override {}
+
+  void Run(StatusCallback done) override;
+
+  // Returns the largest power of 2 that is <= n, for n > 0.
+  static int LargestPowerOfTwo(int n);
+
+ private:
+  Status RunFlat();
+  Status RunHierarchical();
+
+  // Called when a bad status is received that implies we should terminate
+  // execution and return a bad status.
+  void StartAbort(const Status& s);
+  std::function<void(const Status&)> AbortCallback() {
+    return [this](const Status& s) { StartAbort(s); };
+  }
+
+  // Reduces value_ among the devices at 'dev_indices' (indices into
+  // col_params_.instance.device_names) of which this device is at
+  // position 'my_pos', then applies the final_op.  'phase'
+  // distinguishes the buffer keys of separate invocations.
+  Status AllReduceAmong(const std::vector<int>& dev_indices, int my_pos,
+                        const string& phase);
+
+  // Blocking point-to-point transfers with the device at 'dev_idx'.
+  Status Send(const string& phase, int step, int dev_idx, const Tensor& t);
+  Status Recv(const string& phase, int step, int dev_idx, Tensor* t);
+  Status SendRecv(const string& phase, int step, int send_dev_idx,
+                  const Tensor& send_t, int recv_dev_idx, Tensor* recv_t);
+  void DispatchSend(const string& phase, int step, int dev_idx,
+                    const Tensor* t, const StatusCallback& done);
+  void DispatchRecv(const string& phase, int step, int dev_idx, Tensor* t,
+                    const StatusCallback& done);
+
+  // Computes accum = merge_op(accum, input).
+  Status Reduce(Tensor* accum, Tensor* input);
+  // Computes t = final_op(t, group_size), if there is a final_op.
+  Status Finalize(Tensor* t);
+
+  // Returns a Tensor aliasing chunks [first, limit) of value_ when it is
+  // divided into num_chunks aligned chunks.
+  Tensor ChunkRange(int first, int limit, int num_chunks) const;
+  // Returns a temporary Tensor with num_elts elements on this device.
+  Tensor TempTensor(int64 num_elts) const;
+
+  CollectiveExecutor* col_exec_;        // Not owned
+  const DeviceMgr* dev_mgr_;            // Not owned
+  OpKernelContext* ctx_;                // Not owned
+  OpKernelContext::Params* op_params_;  // Not owned
+  const CollectiveParams& col_params_;
+  const string exec_key_;
+  const Tensor* input_;  // Not owned
+  Tensor* output_;       // Not owned
+  const int64 step_id_;
+  const bool hierarchical_;
+  const int my_dev_idx_;
+  Tensor value_;  // Flattened alias of *output_.
+  Tensor group_size_tensor_;
+  Device* device_;  // The device for which this instance labors
+  DeviceLocality device_locality_;
+
+  mutex abort_mu_;
+  bool aborted_ GUARDED_BY(abort_mu_) = false;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
@@ -0,0 +1,229 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
+
+#include <algorithm>
+#include <cmath>
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/ring_reducer.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+// Runs an all-reduce on every device of a test::CollectiveTestEnv.
+class ReducerHarness {
+ public:
+  ReducerHarness(int num_workers, int num_devices, DataType dtype,
+                 const string& collective_name, int fail_after)
+      : env_(num_workers, num_devices, kStepId, fail_after) {
+    env_.InitParams(REDUCTION_COLLECTIVE, dtype, &col_params_);
+    col_params_.instance.impl_details.collective_name = collective_name;
+    for (int rank = 0; rank < col_params_.group.group_size; ++rank) {
+      instances_.emplace_back(new DeviceInstance(rank, this));
+    }
+  }
+
+  // Executes one all-reduce on every device, blocking until all complete.
+  void Reduce() {
+    const string exec_key =
+        strings::StrCat(col_params_.instance.instance_key, ":0:", run_count_++);
+    test::CollectiveTestEnv::RunOnAllRanks(
+        instances_.size(),
+        [this, &exec_key](int rank) { instances_[rank]->DoReduce(exec_key); });
+  }
+
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, ReducerHarness* parent) : parent_(parent) {
+      device_ = parent_->env_.InitDeviceParams(parent_->col_params_, rank,
+                                               &col_params_);
+    }
+
+    void DoReduce(const string& exec_key) {
+      const test::CollectiveTestEnv& env = parent_->env_;
+      const string& name = col_params_.instance.impl_details.collective_name;
+      Tensor output;
+      status_ = env.RunCollective(
+          device_, col_params_.merge_op.get(), &tensor_, tensor_.shape(),
+          true /*forward_input*/,
+          [this, &env, &exec_key, &name](OpKernelContext* ctx,
+                                         OpKernelContext::Params* params,
+                                         Tensor* output)
+              -> CollectiveImplementationInterface* {
+            if (name == kRingReduceName) {
+              return new RingReducer(env.col_exec(), env.dev_mgr(), ctx,
+                                     params, col_params_, exec_key, kStepId,
+                                     &tensor_, output);
+            }
+            return new HalvingDoublingReducer(
+                env.col_exec(), env.dev_mgr(), ctx, params, col_params_,
+                exec_key, kStepId, &tensor_, output,
+                name == kHierarchicalReduceName);
+          },
+          &output);
+      tensor_ = output;
+    }
+
+    ReducerHarness* parent_;
+    Device* device_;
+    CollectiveParams col_params_;
+    Tensor tensor_;
+    Status status_;
+  };
+
+  int64 run_count_ = 0;
+  test::CollectiveTestEnv env_;
+  CollectiveParams col_params_;
+  std::vector<std::unique_ptr<DeviceInstance>> instances_;
+};
+
+template <typename T>
+void RunTest(DataType dtype, const string& collective_name, int num_workers,
+             int num_devices, int tensor_len, int fail_after) {
+  ReducerHarness harness(num_workers, num_devices, dtype, collective_name,
+                         fail_after);
+  const int group_size = num_workers * num_devices;
+  std::vector<double> expected(tensor_len, 0.0);
+  for (int di = 0; di < group_size; ++di) {
+    Tensor* t = &harness.instances_[di]->tensor_;
+    *t = Tensor(dtype, TensorShape({tensor_len}));
+    for (int i = 0; i < tensor_len; ++i) {
+      double value = (dtype == DT_INT32 || dtype == DT_INT64)
+                         ? (di * 10 + i) * group_size
+                         : (di + 1) * 0.5 + i;
+      t->flat<T>()(i) = static_cast<T>(value);
+      expected[i] += value;
+    }
+  }
+  harness.Reduce();
+  for (int di = 0; di < group_size; ++di) {
+    const ReducerHarness::DeviceInstance* instance =
+        harness.instances_[di].get();
+    if (fail_after > 0) {
+      EXPECT_EQ("Deliberate failure", instance->status_.error_message())
+          << "device " << di;
+      continue;
+    }
+    TF_EXPECT_OK(instance->status_);
+    for (int i = 0; i < tensor_len; ++i) {
+      const double want = expected[i] / group_size;
+      EXPECT_NEAR(want, static_cast<double>(instance->tensor_.flat<T>()(i)),
+                  std::max(1e-4, std::abs(want) * 1e-5))
+          << "Mismatch at device " << di << " index " << i;
+    }
+  }
+}
+
+TEST(HalvingDoublingReducerTest, LargestPowerOfTwo) {
+  EXPECT_EQ(1, HalvingDoublingReducer::LargestPowerOfTwo(1));
+  EXPECT_EQ(2, HalvingDoublingReducer::LargestPowerOfTwo(2));
+  EXPECT_EQ(2, HalvingDoublingReducer::LargestPowerOfTwo(3));
+  EXPECT_EQ(8, HalvingDoublingReducer::LargestPowerOfTwo(8));
+  EXPECT_EQ(8, HalvingDoublingReducer::LargestPowerOfTwo(15));
+}
+
+#define DEF_TEST(B, A, W, D, L, F)                                         \
+  TEST(HalvingDoublingReducerTest,                                         \
+       DaTy##B##_Alg##A##_Wkr##W##_Dev##D##_Len##L##_Abrt##F) {            \
+    DataType dtype = DT_##B;                                               \
+    switch (dtype) {                                                       \
+      case DT_FLOAT:                                                       \
+        RunTest<float>(dtype, k##A##Name, W, D, L, F);                     \
+        break;                                                             \
+      case DT_DOUBLE:                                                      \
+        RunTest<double>(dtype, k##A##Name, W, D, L, F);                    \
+        break;                                                             \
+      case DT_INT32:                                                       \
+        RunTest<int32>(dtype, k##A##Name, W, D, L, F);                     \
+        break;                                                             \
+      case DT_INT64:                                                       \
+        RunTest<int64>(dtype, k##A##Name, W, D, L, F);                     \
+        break;                                                             \
+      default:                                                             \
+        LOG(FATAL) << "Unimplemented";                                     \
+    }                                                                      \
+  }
+
+// Success tests, including group sizes that are not a power of 2 and
+// tensors with fewer elements than devices.
+DEF_TEST(FLOAT, HalvingDoublingReduce, 1, 2, 1001, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 1, 3, 1001, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 1, 4, 1, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 1, 5, 7, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 3, 4, 4095, 0)
+DEF_TEST(FLOAT, HalvingDoublingReduce, 4, 4, 1045991, 0)
+DEF_TEST(DOUBLE, HalvingDoublingReduce, 1, 7, 1001, 0)
+DEF_TEST(INT32, HalvingDoublingReduce, 2, 3, 1001, 0)
+DEF_TEST(INT64, HalvingDoublingReduce, 2, 4, 4095, 0)
+DEF_TEST(FLOAT, HierarchicalReduce, 1, 4, 1001, 0)
+DEF_TEST(FLOAT, HierarchicalReduce, 2, 1, 1001, 0)
+DEF_TEST(FLOAT, HierarchicalReduce, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, HierarchicalReduce, 3, 2, 17, 0)
+DEF_TEST(FLOAT, HierarchicalReduce, 5, 4, 9408, 0)
+DEF_TEST(DOUBLE, HierarchicalReduce, 3, 3, 4095, 0)
+DEF_TEST(INT64, HierarchicalReduce, 4, 2, 1001, 0)
+
+// Failure tests
+DEF_TEST(FLOAT, HalvingDoublingReduce, 2, 4, 9408, 7)
+DEF_TEST(FLOAT, HierarchicalReduce, 2, 4, 9408, 11)
+
+// Measures all-reduce latency for tensors of 'num_elts' floats among 'W'
+// workers with 'D' devices each, so that the latency and bandwidth curves
+// of each algorithm can be compared with the ring.
+void BM_AllReduce(int iters, const string& collective_name, int num_workers,
+                  int num_devices, int num_elts) {
+  testing::StopTiming();
+  ReducerHarness harness(num_workers, num_devices, DT_FLOAT, collective_name,
+                         0 /*fail_after*/);
+  for (auto& instance : harness.instances_) {
+    instance->tensor_ = Tensor(DT_FLOAT, TensorShape({num_elts}));
+    instance->tensor_.flat<float>().setConstant(1.0);
+  }
+  harness.Reduce();  // Warm up.
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    harness.Reduce();
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elts *
+                          sizeof(float));
+}
+
+#define BM_ALL_REDUCE(A, W, D)                                          \
+  static void BM_##A##_Wkr##W##_Dev##D(int iters, int num_elts) {      \
+    BM_AllReduce(iters, k##A##Name, W, D, num_elts);                   \
+  }                                                                     \
+  BENCHMARK(BM_##A##_Wkr##W##_Dev##D)                                  \
+      ->Arg(16)                                                         \
+      ->Arg(1 << 10)                                                    \
+      ->Arg(1 << 14)                                                    \
+      ->Arg(1 << 18)                                                    \
+      ->Arg(1 << 22);
+
+BM_ALL_REDUCE(RingReduce, 1, 16)
+BM_ALL_REDUCE(HalvingDoublingReduce, 1, 16)
+BM_ALL_REDUCE(RingReduce, 4, 4)
+BM_ALL_REDUCE(HalvingDoublingReduce, 4, 4)
+BM_ALL_REDUCE(HierarchicalReduce, 4, 4)
+
+}  // namespace
+}  // namespace tensorflow
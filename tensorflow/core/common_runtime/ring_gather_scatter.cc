@@ -0,0 +1,272 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/ring_gather_scatter.h"
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+// Set true for greater intelligibility of debug mode log messages.
+#define READABLE_KEYS false
+
+namespace tensorflow {
+namespace {
+// Key to be used for BufRendezvous by RingGatherer and RingReduceScatterer.
+string RingChunkBufKey(const string& exec_key, int step, int src_rank,
+                       int dst_rank) {
+  if (READABLE_KEYS) {
+    return strings::StrCat("ringchunk(", exec_key, "):step(", step, "):src(",
+                           src_rank, "):dst(", dst_rank, ")");
+  } else {
+    return strings::StrCat(exec_key, ":", step, ":", src_rank, ":", dst_rank);
+  }
+}
+
+// Returns a Tensor aliasing the 'chunk_elts' elements of chunk 'i' of
+// 'flat', in which chunks start every 'stride' elements.
+Tensor Chunk(const Tensor& flat, int64 stride, int64 chunk_elts, int i) {
+  // As in CollectiveAdapter::ChunkAlias, always take an empty slice from
+  // the front of the tensor to avoid an illegal offset.
+  if (chunk_elts == 0) return flat.Slice(0, 0);
+  return flat.Slice(i * stride, i * stride + chunk_elts);
+}
+
+// Returns a one-dimensional alias of 't'.
+Tensor Flatten(const Tensor& t) {
+  Tensor flat;
+  CHECK(flat.CopyFrom(t, TensorShape({t.NumElements()})));
+  return flat;
+}
+}  // namespace
+
+RingCollectiveBase::RingCollectiveBase(
+    CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+    OpKernelContext* ctx, OpKernelContext::Params* op_params,
+    const CollectiveParams& col_params, const string& exec_key, int64 step_id,
+    const Tensor* input, Tensor* output)
+    : col_exec_(col_exec),
+      dev_mgr_(dev_mgr),
+      ctx_(ctx),
+      op_params_(op_params),
+      col_params_(col_params),
+      exec_key_(exec_key),
+      input_(input),
+      output_(output),
+      step_id_(step_id),
+      group_size_(col_params.group.group_size),
+      rank_(col_params.default_rank),
+      device_(nullptr) {
+  CHECK_GT(group_size_, 0);
+  CHECK_GE(rank_, 0);
+}
+
+void RingCollectiveBase::Run(StatusCallback done) {
+  Status status = dev_mgr_->LookupDevice(
+      col_params_.instance.device_names[rank_], &device_);
+  if (status.ok()) {
+    CHECK(device_);
+    device_locality_ = device_->attributes().locality();
+    status = RunRing();
+  }
+  if (!status.ok()) {
+    StartAbort(status);
+  }
+  done(status);
+}
+
+void RingCollectiveBase::StartAbort(const Status& s) {
+  {
+    mutex_lock l(abort_mu_);
+    if (aborted_) return;
+    aborted_ = true;
+  }
+  // Unblock any peers still waiting on transfers with this device.
+  LOG(ERROR) << "Aborting " << col_params_.name << " with " << s;
+  col_exec_->StartAbort(s);
+}
+
+int RingCollectiveBase::RingRank(int rank, int delta) const {
+  return ((rank + delta) % group_size_ + group_size_) % group_size_;
+}
+
+Status RingCollectiveBase::SendRecv(int step, const Tensor& send_t,
+                                    Tensor* recv_t) {
+  const int next = RingRank(rank_, 1);
+  const int prev = RingRank(rank_, -1);
+  // All chunks have the same size so the sender and receiver of each
+  // transfer agree on whether it is empty.
+  const bool do_send = send_t.NumElements() > 0;
+  const bool do_recv = recv_t->NumElements() > 0;
+  collective_util::PendingTransfers pending(
+      static_cast<int>(do_send) + static_cast<int>(do_recv), AbortCallback());
+  if (do_send) {
+    string send_buf_key = RingChunkBufKey(exec_key_, step, rank_, next);
+    VLOG(3) << "PostToPeer " << send_buf_key << " from_device "
+            << device_->name();
+    col_exec_->PostToPeer(col_params_.instance.device_names[next],
+                          col_params_.instance.task_names[next], send_buf_key,
+                          device_, ctx_->op_device_context(),
+                          ctx_->output_alloc_attr(0), &send_t,
+                          device_locality_, pending.Callback());
+  }
+  if (do_recv) {
+    string recv_buf_key = RingChunkBufKey(exec_key_, step, prev, rank_);
+    VLOG(3) << "RecvFromPeer " << recv_buf_key << " from_device "
+            << col_params_.instance.device_names[prev];
+    col_exec_->RecvFromPeer(col_params_.instance.device_names[prev],
+                            col_params_.instance.task_names[prev],
+                            col_params_.task.is_local[prev], recv_buf_key,
+                            device_, ctx_->op_device_context(),
+                            ctx_->output_alloc_attr(0), recv_t,
+                            device_locality_, 0 /*stream_index*/,
+                            pending.Callback());
+  }
+  return pending.Wait();
+}
+
+Status RingCollectiveBase::DeviceCopy(const Tensor* src, Tensor* dst,
+                                      const AllocatorAttributes& src_attr,
+                                      const AllocatorAttributes& dst_attr) {
+  if (src->NumElements() == 0) return Status::OK();
+  // We are running in a blockable thread and the callback can't block so
+  // just wait here on the copy.
+  Notification note;
+  Status status;
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      ctx_->op_device_context(), ctx_->op_device_context(), device_, device_,
+      src_attr, dst_attr, src, dst, 0 /*dev_to_dev_stream_index*/,
+      [&note, &status](const Status& s) {
+        status.Update(s);
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+Tensor RingCollectiveBase::TempTensor(int64 num_elts) const {
+  AllocationAttributes empty;
+  return Tensor(device_->GetAllocator(ctx_->output_alloc_attr(0)),
+                col_params_.instance.data_type, TensorShape({num_elts}),
+                empty);
+}
+
+RingGatherer::RingGatherer(CollectiveExecutor* col_exec,
+                           const DeviceMgr* dev_mgr, OpKernelContext* ctx,
+                           OpKernelContext::Params* op_params,
+                           const CollectiveParams& col_params,
+                           const string& exec_key, int64 step_id,
+                           const Tensor* input, Tensor* output)
+    : RingCollectiveBase(col_exec, dev_mgr, ctx, op_params, col_params,
+                         exec_key, step_id, input, output) {}
+
+Status RingGatherer::RunRing() {
+  const int64 chunk_elts = input_->NumElements();
+  CHECK_EQ(output_->NumElements(), chunk_elts * group_size_);
+  Tensor flat_input = Flatten(*input_);
+  Tensor flat_output = Flatten(*output_);
+
+  // The chunks are only copied, never computed on, so they may start at
+  // unaligned offsets of the output.
+  Tensor own_chunk = Chunk(flat_output, chunk_elts, chunk_elts, rank_);
+  TF_RETURN_IF_ERROR(DeviceCopy(&flat_input, &own_chunk,
+                                ctx_->input_alloc_attr(0),
+                                ctx_->output_alloc_attr(0)));
+  for (int step = 0; step < group_size_ - 1; ++step) {
+    Tensor send_t =
+        Chunk(flat_output, chunk_elts, chunk_elts, RingRank(rank_, -step));
+    Tensor recv_t = Chunk(flat_output, chunk_elts, chunk_elts,
+                          RingRank(rank_, -step - 1));
+    TF_RETURN_IF_ERROR(SendRecv(step, send_t, &recv_t));
+  }
+  return Status::OK();
+}
+
+RingReduceScatterer::RingReduceScatterer(
+    CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+    OpKernelContext* ctx, OpKernelContext::Params* op_params,
+    const CollectiveParams& col_params, const string& exec_key, int64 step_id,
+    const Tensor* input, Tensor* output)
+    : RingCollectiveBase(col_exec, dev_mgr, ctx, op_params, col_params,
+                         exec_key, step_id, input, output) {}
+
+Status RingReduceScatterer::RunRing() {
+  const int64 total_elts = input_->NumElements();
+  CHECK_EQ(total_elts % group_size_, 0);
+  const int64 chunk_elts = total_elts / group_size_;
+  CHECK_EQ(output_->NumElements(), chunk_elts);
+  Tensor flat_input = Flatten(*input_);
+  Tensor flat_output = Flatten(*output_);
+
+  // Partial sums accumulate in a scratch copy of the input, since the
+  // input may not be modified and the output only holds one chunk.  The
+  // merge and final ops need aligned operands, so as in RingReducer each
+  // chunk of the copy starts at a multiple of EIGEN_MAX_ALIGN_BYTES.
+  const int64 stride = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(col_params_.instance.data_type), chunk_elts, 1);
+  Tensor accum = TempTensor(stride * group_size_);
+  for (int i = 0; i < group_size_; ++i) {
+    Tensor src = Chunk(flat_input, chunk_elts, chunk_elts, i);
+    Tensor dst = Chunk(accum, stride, chunk_elts, i);
+    TF_RETURN_IF_ERROR(DeviceCopy(&src, &dst, ctx_->input_alloc_attr(0),
+                                  ctx_->output_alloc_attr(0)));
+  }
+  Tensor recv_t = TempTensor(chunk_elts);
+  for (int step = 0; step < group_size_ - 1; ++step) {
+    Tensor send_t =
+        Chunk(accum, stride, chunk_elts, RingRank(rank_, -step - 1));
+    Tensor keep_t =
+        Chunk(accum, stride, chunk_elts, RingRank(rank_, -step - 2));
+    TF_RETURN_IF_ERROR(SendRecv(step, send_t, &recv_t));
+    if (chunk_elts > 0) {
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          ctx_, op_params_, device_, col_params_.merge_op.get(), &keep_t,
+          &recv_t));
+    }
+  }
+
+  Tensor own_chunk = Chunk(accum, stride, chunk_elts, rank_);
+  if (col_params_.final_op && chunk_elts > 0) {
+    Tensor group_size_val =
+        collective_util::MakeScalar(col_params_.instance.data_type,
+                                    group_size_);
+    Tensor group_size_tensor;
+    if (col_params_.group.device_type != "CPU") {
+      group_size_tensor =
+          Tensor(device_->GetAllocator(ctx_->input_alloc_attr(0)),
+                 col_params_.instance.data_type, TensorShape({}));
+      Notification note;
+      Status status;
+      ctx_->op_device_context()->CopyCPUTensorToDevice(
+          &group_size_val, device_, &group_size_tensor,
+          [&note, &status](const Status& s) {
+            status.Update(s);
+            note.Notify();
+          });
+      note.WaitForNotification();
+      TF_RETURN_IF_ERROR(status);
+    } else {
+      group_size_tensor = group_size_val;
+    }
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        ctx_, op_params_, device_, col_params_.final_op.get(), &own_chunk,
+        &group_size_tensor));
+  }
+  return DeviceCopy(&own_chunk, &flat_output, ctx_->output_alloc_attr(0),
+                    ctx_->output_alloc_attr(0));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_RING_GATHER_SCATTER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_RING_GATHER_SCATTER_H_
+
+#include <functional>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+class DeviceMgr;
+
+// Shared machinery for collectives that move one chunk per step around
+// a ring of the group's devices in default rank order, sending to rank
+// r+1 and receiving from rank r-1.  Every device moves
+// (group_size-1)/group_size of the full value, which is bandwidth
+// optimal.
+class RingCollectiveBase : public CollectiveImplementationInterface {
+ public:
+  RingCollectiveBase(CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+                     OpKernelContext* ctx, OpKernelContext::Params* op_params,
+                     const CollectiveParams& col_params,
+                     const string& exec_key, int64 step_id,
+                     const Tensor* input, Tensor* output);
+
+  ~RingCollectiveBase() override {}
+
+  // Looks up the device and then calls RunRing().
+  void Run(StatusCallback done) override;
+
+ protected:
+  virtual Status RunRing() = 0;
+
+  // Sends 'send_t' to the next device of the ring while receiving
+  // 'recv_t' from the previous one, and blocks until both complete.
+  // Empty tensors are not transferred.
+  Status SendRecv(int step, const Tensor& send_t, Tensor* recv_t);
+
+  // Synchronously copies 'src' to 'dst' on this device.
+  Status DeviceCopy(const Tensor* src, Tensor* dst,
+                    const AllocatorAttributes& src_attr,
+                    const AllocatorAttributes& dst_attr);
+
+  // Returns a temporary Tensor with num_elts elements on this device.
+  Tensor TempTensor(int64 num_elts) const;
+
+  // Returns the ring position that is 'delta' steps after 'rank'.
+  int RingRank(int rank, int delta) const;
+
+  CollectiveExecutor* col_exec_;        // Not owned
+  const DeviceMgr* dev_mgr_;            // Not owned
+  OpKernelContext* ctx_;                // Not owned
+  OpKernelContext::Params* op_params_;  // Not owned
+  const CollectiveParams& col_params_;
+  const string exec_key_;
+  const Tensor* input_;  // Not owned
+  Tensor* output_;       // Not owned
+  const int64 step_id_;
+  const int group_size_;
+  const int rank_;
+  Device* device_;  // The device for which this instance labors
+  DeviceLocality device_locality_;
+
+ private:
+  // Called when a bad status is received that implies we should terminate
+  // execution and return a bad status.
+  void StartAbort(const Status& s);
+  std::function<void(const Status&)> AbortCallback() {
+    return [this](const Status& s) { StartAbort(s); };
+  }
+
+  mutex abort_mu_;
+  bool aborted_ GUARDED_BY(abort_mu_) = false;
+};
+
+// Concatenates the inputs of all devices of the group along dimension 0,
+// in default rank order.  All inputs must have the same shape; the output
+// has group_size times as many rows.
+//
+// Each device first places its own input in its slot of the output.  At
+// step s it then forwards the slot of rank r-s to rank r+1 while receiving
+// the slot of rank r-s-1, directly into the output, from rank r-1.
+class RingGatherer : public RingCollectiveBase {
+ public:
+  RingGatherer(CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+               OpKernelContext* ctx, OpKernelContext::Params* op_params,
+               const CollectiveParams& col_params, const string& exec_key,
+               int64 step_id, const Tensor* input, Tensor* output);
+
+  ~RingGatherer() override {}
+
+ protected:
+  Status RunRing() override;
+};
+
+// Reduces the inputs of all devices of the group with merge_op and
+// final_op, leaving each device with one slice of the result: the rank r
+// device receives rows [r*k, (r+1)*k) where k is dim 0 of the input
+// divided by group_size.
+//
+// At step s the rank r device sends its partial sum of chunk r-s-1 to
+// rank r+1 while receiving the partial sum of chunk r-s-2 from rank r-1
+// and merging it into its own copy, so that after group_size-1 steps it
+// holds the full reduction of chunk r.
+class RingReduceScatterer : public RingCollectiveBase {
+ public:
+  RingReduceScatterer(CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+                      OpKernelContext* ctx,
+                      OpKernelContext::Params* op_params,
+                      const CollectiveParams& col_params,
+                      const string& exec_key, int64 step_id,
+                      const Tensor* input, Tensor* output);
+
+  ~RingReduceScatterer() override {}
+
+ protected:
+  Status RunRing() override;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_RING_GATHER_SCATTER_H_
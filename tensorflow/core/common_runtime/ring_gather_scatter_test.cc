@@ -0,0 +1,268 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/ring_gather_scatter.h"
+
+#include <algorithm>
+#include <cmath>
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+// Runs an all-gather or reduce-scatter on every device of a
+// test::CollectiveTestEnv.
+class GatherScatterHarness {
+ public:
+  GatherScatterHarness(CollectiveType type, int num_workers, int num_devices,
+                       DataType dtype, int fail_after)
+      : env_(num_workers, num_devices, kStepId, fail_after) {
+    env_.InitParams(type, dtype, &col_params_);
+    for (int rank = 0; rank < col_params_.group.group_size; ++rank) {
+      instances_.emplace_back(new DeviceInstance(rank, this));
+    }
+  }
+
+  // Executes the collective on every device, blocking until all complete.
+  void Run() {
+    const string exec_key =
+        strings::StrCat(col_params_.instance.instance_key, ":0:", run_count_++);
+    test::CollectiveTestEnv::RunOnAllRanks(
+        instances_.size(),
+        [this, &exec_key](int rank) { instances_[rank]->DoRun(exec_key); });
+  }
+
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, GatherScatterHarness* parent) : parent_(parent) {
+      device_ = parent_->env_.InitDeviceParams(parent_->col_params_, rank,
+                                               &col_params_);
+    }
+
+    void DoRun(const string& exec_key) {
+      const test::CollectiveTestEnv& env = parent_->env_;
+      const int group_size = col_params_.group.group_size;
+      const bool gather = col_params_.instance.type == GATHER_COLLECTIVE;
+      TensorShape output_shape = input_.shape();
+      output_shape.set_dim(0, gather ? output_shape.dim_size(0) * group_size
+                                     : output_shape.dim_size(0) / group_size);
+      status_ = env.RunCollective(
+          device_, col_params_.merge_op.get(), &input_, output_shape,
+          false /*forward_input*/,
+          [this, &env, &exec_key, gather](OpKernelContext* ctx,
+                                          OpKernelContext::Params* params,
+                                          Tensor* output)
+              -> CollectiveImplementationInterface* {
+            if (gather) {
+              return new RingGatherer(env.col_exec(), env.dev_mgr(), ctx,
+                                      params, col_params_, exec_key, kStepId,
+                                      &input_, output);
+            }
+            return new RingReduceScatterer(env.col_exec(), env.dev_mgr(), ctx,
+                                           params, col_params_, exec_key,
+                                           kStepId, &input_, output);
+          },
+          &output_);
+    }
+
+    GatherScatterHarness* parent_;
+    Device* device_;
+    CollectiveParams col_params_;
+    Tensor input_;
+    Tensor output_;
+    Status status_;
+  };
+
+  int64 run_count_ = 0;
+  test::CollectiveTestEnv env_;
+  CollectiveParams col_params_;
+  std::vector<std::unique_ptr<DeviceInstance>> instances_;
+};
+
+// Returns the value of element i of the input of device di.
+double InputValue(DataType dtype, int group_size, int di, int i) {
+  return (dtype == DT_INT32 || dtype == DT_INT64) ? (di * 10 + i) * group_size
+                                                  : (di + 1) * 0.5 + i;
+}
+
+// Gathers inputs of shape [rows, 3] from each device.
+template <typename T>
+void RunGatherTest(DataType dtype, int num_workers, int num_devices, int rows,
+                   int fail_after) {
+  GatherScatterHarness harness(GATHER_COLLECTIVE, num_workers, num_devices,
+                               dtype, fail_after);
+  const int group_size = num_workers * num_devices;
+  const int row_elts = 3;
+  const int input_len = rows * row_elts;
+  for (int di = 0; di < group_size; ++di) {
+    Tensor* t = &harness.instances_[di]->input_;
+    *t = Tensor(dtype, TensorShape({rows, row_elts}));
+    for (int i = 0; i < input_len; ++i) {
+      t->flat<T>()(i) = static_cast<T>(InputValue(dtype, group_size, di, i));
+    }
+  }
+  harness.Run();
+  for (int di = 0; di < group_size; ++di) {
+    const GatherScatterHarness::DeviceInstance* instance =
+        harness.instances_[di].get();
+    if (fail_after > 0) {
+      EXPECT_EQ("Deliberate failure", instance->status_.error_message())
+          << "device " << di;
+      continue;
+    }
+    TF_EXPECT_OK(instance->status_);
+    EXPECT_EQ(TensorShape({group_size * rows, row_elts}),
+              instance->output_.shape());
+    for (int src = 0; src < group_size; ++src) {
+      for (int i = 0; i < input_len; ++i) {
+        EXPECT_EQ(static_cast<T>(InputValue(dtype, group_size, src, i)),
+                  instance->output_.flat<T>()(src * input_len + i))
+            << "Mismatch at device " << di << " source " << src << " index "
+            << i;
+      }
+    }
+  }
+}
+
+// Reduce-scatters inputs of group_size * chunk_len elements, averaging
+// them.
+template <typename T>
+void RunReduceScatterTest(DataType dtype, int num_workers, int num_devices,
+                          int chunk_len, int fail_after) {
+  GatherScatterHarness harness(REDUCE_SCATTER_COLLECTIVE, num_workers,
+                               num_devices, dtype, fail_after);
+  const int group_size = num_workers * num_devices;
+  const int input_len = group_size * chunk_len;
+  std::vector<double> expected(input_len, 0.0);
+  for (int di = 0; di < group_size; ++di) {
+    Tensor* t = &harness.instances_[di]->input_;
+    *t = Tensor(dtype, TensorShape({input_len}));
+    for (int i = 0; i < input_len; ++i) {
+      double value = InputValue(dtype, group_size, di, i);
+      t->flat<T>()(i) = static_cast<T>(value);
+      expected[i] += value;
+    }
+  }
+  harness.Run();
+  for (int di = 0; di < group_size; ++di) {
+    const GatherScatterHarness::DeviceInstance* instance =
+        harness.instances_[di].get();
+    if (fail_after > 0) {
+      EXPECT_EQ("Deliberate failure", instance->status_.error_message())
+          << "device " << di;
+      continue;
+    }
+    TF_EXPECT_OK(instance->status_);
+    EXPECT_EQ(TensorShape({chunk_len}), instance->output_.shape());
+    for (int i = 0; i < chunk_len; ++i) {
+      const double want = expected[di * chunk_len + i] / group_size;
+      EXPECT_NEAR(want, static_cast<double>(instance->output_.flat<T>()(i)),
+                  std::max(1e-4, std::abs(want) * 1e-5))
+          << "Mismatch at device " << di << " index " << i;
+    }
+  }
+}
+
+#define DEF_TEST(C, B, W, D, L, F)                                          \
+  TEST(RingGatherScatterTest,                                               \
+       C##_DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##F) {                  \
+    DataType dtype = DT_##B;                                                \
+    switch (dtype) {                                                        \
+      case DT_FLOAT:                                                        \
+        Run##C##Test<float>(dtype, W, D, L, F);                             \
+        break;                                                              \
+      case DT_DOUBLE:                                                       \
+        Run##C##Test<double>(dtype, W, D, L, F);                            \
+        break;                                                              \
+      case DT_INT32:                                                        \
+        Run##C##Test<int32>(dtype, W, D, L, F);                             \
+        break;                                                              \
+      case DT_INT64:                                                        \
+        Run##C##Test<int64>(dtype, W, D, L, F);                             \
+        break;                                                              \
+      default:                                                              \
+        LOG(FATAL) << "Unimplemented";                                      \
+    }                                                                       \
+  }
+
+// Success tests, including empty inputs.
+DEF_TEST(Gather, FLOAT, 1, 2, 1, 0)
+DEF_TEST(Gather, FLOAT, 1, 3, 0, 0)
+DEF_TEST(Gather, FLOAT, 1, 8, 1001, 0)
+DEF_TEST(Gather, FLOAT, 2, 4, 17, 0)
+DEF_TEST(Gather, DOUBLE, 3, 3, 1001, 0)
+DEF_TEST(Gather, INT32, 2, 3, 64, 0)
+DEF_TEST(Gather, INT64, 4, 2, 4095, 0)
+DEF_TEST(ReduceScatter, FLOAT, 1, 2, 1, 0)
+DEF_TEST(ReduceScatter, FLOAT, 1, 3, 0, 0)
+DEF_TEST(ReduceScatter, FLOAT, 1, 8, 1001, 0)
+DEF_TEST(ReduceScatter, FLOAT, 2, 4, 17, 0)
+DEF_TEST(ReduceScatter, DOUBLE, 3, 3, 1001, 0)
+DEF_TEST(ReduceScatter, INT32, 2, 3, 64, 0)
+DEF_TEST(ReduceScatter, INT64, 4, 2, 4095, 0)
+
+// Failure tests
+DEF_TEST(Gather, FLOAT, 2, 4, 128, 5)
+DEF_TEST(ReduceScatter, FLOAT, 2, 4, 128, 9)
+
+// Measures the bandwidth of all-gather and reduce-scatter among 'W'
+// workers with 'D' devices each, where every device contributes
+// 'num_elts' floats to the all-gather and receives 'num_elts' floats of
+// the reduce-scatter.  The reported rate is for the full per-device
+// output of the all-gather, or input of the reduce-scatter.
+void BM_GatherScatter(int iters, CollectiveType type, int num_workers,
+                      int num_devices, int num_elts) {
+  testing::StopTiming();
+  GatherScatterHarness harness(type, num_workers, num_devices, DT_FLOAT,
+                               0 /*fail_after*/);
+  const int group_size = num_workers * num_devices;
+  const int input_len =
+      (type == GATHER_COLLECTIVE) ? num_elts : num_elts * group_size;
+  for (auto& instance : harness.instances_) {
+    instance->input_ = Tensor(DT_FLOAT, TensorShape({input_len}));
+    instance->input_.flat<float>().setConstant(1.0);
+  }
+  harness.Run();  // Warm up.
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    harness.Run();
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elts * group_size *
+                          sizeof(float));
+}
+
+#define BM_GATHER_SCATTER(C, T, W, D)                                    \
+  static void BM_##C##_Wkr##W##_Dev##D(int iters, int num_elts) {        \
+    BM_GatherScatter(iters, T, W, D, num_elts);                          \
+  }                                                                      \
+  BENCHMARK(BM_##C##_Wkr##W##_Dev##D)                                    \
+      ->Arg(1 << 10)                                                     \
+      ->Arg(1 << 14)                                                     \
+      ->Arg(1 << 16)                                                     \
+      ->Arg(1 << 18);
+
+BM_GATHER_SCATTER(Gather, GATHER_COLLECTIVE, 1, 8)
+BM_GATHER_SCATTER(Gather, GATHER_COLLECTIVE, 4, 4)
+BM_GATHER_SCATTER(ReduceScatter, REDUCE_SCATTER_COLLECTIVE, 1, 8)
+BM_GATHER_SCATTER(ReduceScatter, REDUCE_SCATTER_COLLECTIVE, 4, 4)
+
+}  // namespace
+}  // namespace tensorflow
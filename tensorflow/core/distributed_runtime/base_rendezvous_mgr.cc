@@ -324,10 +324,79 @@ void BaseRemoteRendezvous::RecvAsync(const ParsedKey& parsed,
         });
     return;
   } else {
+    std::unique_ptr<PrefetchedRecv> prefetched;
+    {
+      mutex_lock l(mu_);
+      remote_recv_started_ = true;
+      if (!prefetched_.empty()) {
+        auto it = prefetched_.find(parsed.FullKey().ToString());
+        if (it != prefetched_.end()) {
+          if (!it->second->completed) {
+            // The prefetch is still in flight and will deliver the result.
+            it->second->recv_args = recv_args;
+            it->second->done = std::move(done);
+            return;
+          }
+          prefetched = std::move(it->second);
+          prefetched_.erase(it);
+        }
+      }
+    }
+    if (prefetched) {
+      done(prefetched->status, Args(), recv_args, prefetched->val,
+           prefetched->is_dead);
+      return;
+    }
     RecvFromRemoteAsync(parsed, recv_args, std::move(done));
   }
 }
 
+void BaseRemoteRendezvous::PrefetchRemoteAsync(
+    const ParsedKey& parsed, const Rendezvous::Args& args) {
+  CHECK(is_initialized()) << "PrefetchRemoteAsync called when uninitialized.";
+  if (!ValidateDevices(parsed, false /*!is_src*/).ok() ||
+      IsSameWorker(parsed.src, parsed.dst)) {
+    return;
+  }
+  const string key = parsed.FullKey().ToString();
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok() || remote_recv_started_ ||
+        prefetched_.count(key) > 0) {
+      return;
+    }
+    prefetched_[key].reset(new PrefetchedRecv);
+  }
+  VLOG(1) << "RemoteRendezvous Prefetch " << this << " " << key;
+  Ref();
+  RecvFromRemoteAsync(
+      parsed, args,
+      [this, key](const Status& s, const Rendezvous::Args& send_args,
+                  const Rendezvous::Args& recv_args, const Tensor& val,
+                  bool is_dead) {
+        std::unique_ptr<PrefetchedRecv> waiting;
+        {
+          mutex_lock l(mu_);
+          auto it = prefetched_.find(key);
+          CHECK(it != prefetched_.end());
+          PrefetchedRecv* prefetched = it->second.get();
+          if (prefetched->done) {
+            waiting = std::move(it->second);
+            prefetched_.erase(it);
+          } else {
+            prefetched->completed = true;
+            prefetched->status = s;
+            prefetched->val = val;
+            prefetched->is_dead = is_dead;
+          }
+        }
+        if (waiting) {
+          waiting->done(s, Args(), waiting->recv_args, val, is_dead);
+        }
+        Unref();
+      });
+}
+
 void BaseRemoteRendezvous::RecvLocalAsync(const ParsedKey& parsed,
                                           DoneCallback done) {
   {
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_BASE_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_BASE_RENDEZVOUS_MGR_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
@@ -135,6 +137,11 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
 
+  // Starts RecvFromRemoteAsync for "key" and holds the result until the
+  // RecvAsync call for the same key.
+  void PrefetchRemoteAsync(const ParsedKey& key,
+                           const Rendezvous::Args& args) override;
+
   void StartAbort(const Status& status) override;
 
   // This method is called only by the local Worker, forwarded through
@@ -195,6 +202,25 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   // Active outstanding RecvTensor calls.
   gtl::FlatSet<BaseRecvTensorCall*> active_ GUARDED_BY(mu_);
 
+  // A remote tensor requested by PrefetchRemoteAsync.  Until the fetch
+  // completes, "done" holds the callback of a RecvAsync that arrived in
+  // the meantime, if any.
+  struct PrefetchedRecv {
+    bool completed = false;
+    Status status;
+    Tensor val;
+    bool is_dead = false;
+    Args recv_args;
+    DoneCallback done;
+  };
+  // Keyed by ParsedKey::FullKey().
+  std::unordered_map<string, std::unique_ptr<PrefetchedRecv>> prefetched_
+      GUARDED_BY(mu_);
+  // Set by the first RecvAsync of a remote tensor, i.e. once the step has
+  // started.  Later prefetches are dropped so that no tensor is requested
+  // twice.
+  bool remote_recv_started_ GUARDED_BY(mu_) = false;
+
   bool is_initialized_locked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     return session_ != nullptr;
   }
@@ -64,6 +64,7 @@ class CompleteInstanceCall : public CancellableCall {
     }
     req_.set_device(device_name);
     req_.set_is_source(is_source);
+    req_.set_collective_name(instance.impl_details.collective_name);
   }
 
   ~CompleteInstanceCall() override {}
@@ -150,6 +151,7 @@ void CollectiveParamResolverDistributed::CompleteInstanceAsync(
   for (int32 offset : request->subdiv_offset()) {
     cp->instance.impl_details.subdiv_offsets.push_back(offset);
   }
+  cp->instance.impl_details.collective_name = request->collective_name();
   string* device = new string(request->device());
   VLOG(1) << "New cp " << cp << " for device " << *device << " : "
           << cp->ToString();
@@ -181,6 +183,8 @@ void CollectiveParamResolverDistributed::CompleteInstanceAsync(
                           ir->WaitForOutMu(l);
                           response->set_instance_key(cp->instance.instance_key);
                           response->set_source_rank(ir->source_rank);
+                          response->set_collective_name(
+                              ir->shared.instance.impl_details.collective_name);
                           done_and_cleanup(fi_status);
                         } else {
                           done_and_cleanup(fi_status);
@@ -283,8 +287,10 @@ void CollectiveParamResolverDistributed::UpdateInstanceCache(
   using InstanceRecPointer = InstanceRec*;
   InstanceRecPointer* irp = new InstanceRecPointer(nullptr);
   int32 source_rank = resp.source_rank();
+  string collective_name = resp.collective_name();
 
-  auto continue_with_ir = [this, cp, irp, source_rank, done](const Status& s) {
+  auto continue_with_ir = [this, cp, irp, source_rank, collective_name,
+                           done](const Status& s) {
     if (!s.ok()) {
       done(s);
       delete irp;
@@ -306,6 +312,16 @@ void CollectiveParamResolverDistributed::UpdateInstanceCache(
         }
         ir->source_rank = source_rank;
       }
+      // The group leader's choice of algorithm is authoritative.
+      if (!collective_name.empty() &&
+          ir->shared.instance.impl_details.collective_name !=
+              collective_name) {
+        VLOG(1) << "UpdateInstanceCache: instance "
+                << cp->instance.instance_key << " uses collective "
+                << collective_name << " selected by group leader instead of "
+                << ir->shared.instance.impl_details.collective_name;
+        ir->shared.instance.impl_details.collective_name = collective_name;
+      }
       if (ir->known_count < cp->group.group_size) {
         ir->known_count = cp->group.group_size;
         if (ir->known.size() != cp->group.group_size) {
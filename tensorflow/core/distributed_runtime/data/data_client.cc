@@ -0,0 +1,107 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/data/data_client.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/distributed_runtime/data/data_service_impl.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+
+mutex* get_registry_lock() {
+  static mutex registry_lock(LINKER_INITIALIZED);
+  return &registry_lock;
+}
+
+std::unordered_map<string, DataClient::Factory>* factories() {
+  static auto* factories =
+      new std::unordered_map<string, DataClient::Factory>;
+  return factories;
+}
+
+std::unordered_map<string, DataServiceImpl*>* local_services() {
+  static auto* local_services =
+      new std::unordered_map<string, DataServiceImpl*>;
+  return local_services;
+}
+
+// Calls a DataService in the same process, without serializing the requests.
+class LocalDataClient : public DataClient {
+ public:
+  explicit LocalDataClient(DataServiceImpl* service) : service_(service) {}
+
+#define CLIENT_METHOD(method)                                         \
+  void method##Async(const method##Request* request,                  \
+                     method##Response* response, StatusCallback done) \
+      override {                                                      \
+    done(service_->method(request, response));                        \
+  }
+
+  CLIENT_METHOD(CreateIterator);
+  CLIENT_METHOD(GetNext);
+  CLIENT_METHOD(ReleaseIterator);
+
+#undef CLIENT_METHOD
+
+ private:
+  DataServiceImpl* const service_;  // Not owned.
+};
+
+}  // namespace
+
+/* static */
+Status DataClient::Create(const string& target,
+                          std::unique_ptr<DataClient>* client) {
+  Factory factory;
+  {
+    mutex_lock l(*get_registry_lock());
+    auto service = local_services()->find(target);
+    if (service != local_services()->end()) {
+      client->reset(new LocalDataClient(service->second));
+      return Status::OK();
+    }
+    const size_t pos = target.find("://");
+    if (pos != string::npos) {
+      auto it = factories()->find(target.substr(0, pos));
+      if (it != factories()->end()) factory = it->second;
+    }
+  }
+  if (!factory) {
+    return errors::InvalidArgument("No DataService client for target \"",
+                                   target, "\".");
+  }
+  return factory(target, client);
+}
+
+/* static */
+void DataClient::RegisterFactory(const string& protocol, Factory factory) {
+  mutex_lock l(*get_registry_lock());
+  (*factories())[protocol] = std::move(factory);
+}
+
+/* static */
+void DataClient::RegisterLocalService(const string& target,
+                                      DataServiceImpl* service) {
+  mutex_lock l(*get_registry_lock());
+  (*local_services())[target] = service;
+}
+
+}  // namespace data
+}  // namespace tensorflow
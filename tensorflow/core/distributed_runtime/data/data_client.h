@@ -0,0 +1,78 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_CLIENT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_CLIENT_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+class DataServiceImpl;
+
+// This is a base class that can be implemented by a variety of
+// transports (e.g. gRPC which for each of the client methods makes an RPC).
+class DataClient {
+ public:
+  virtual ~DataClient() {}
+#define CLIENT_METHOD(method)                                \
+  virtual void method##Async(const method##Request* request, \
+                             method##Response* response,     \
+                             StatusCallback done) = 0;
+
+  CLIENT_METHOD(CreateIterator);
+  CLIENT_METHOD(GetNext);
+  CLIENT_METHOD(ReleaseIterator);
+
+#undef CLIENT_METHOD
+
+  // Creates a client for the DataService at `target`, e.g.
+  // "grpc://localhost:2222". If a service was registered for `target` in
+  // this process, the client calls it directly instead of through the
+  // transport.
+  static Status Create(const string& target,
+                       std::unique_ptr<DataClient>* client);
+
+  // Creates a client for a `target` whose protocol, e.g. "grpc", was
+  // registered with `RegisterFactory()`.
+  typedef std::function<Status(const string& target,
+                               std::unique_ptr<DataClient>* client)>
+      Factory;
+
+  // Makes `Create()` use `factory` for the targets that start with
+  // "`protocol`://".
+  static void RegisterFactory(const string& protocol, Factory factory);
+
+  // Registers the mapping from the given `target` to the given `service`.
+  //
+  // WARNING: The `service` pointer remains owned by the caller. It is
+  // the responsibility of the caller to ensure that `service` outlives
+  // any clients that may wrap it. There is no corresponding deregister
+  // method, since clean server shutdown is not currently implemented for
+  // any server type.
+  static void RegisterLocalService(const string& target,
+                                   DataServiceImpl* service);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_CLIENT_H_
@@ -0,0 +1,218 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/data/data_service_impl.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+
+// Returns the name of the only node in `graph_def` whose outputs are not
+// consumed by another node, which `DatasetToGraph` makes the dataset.
+Status FindDatasetNode(const GraphDef& graph_def, string* node_name) {
+  std::unordered_set<string> consumed;
+  for (const NodeDef& node : graph_def.node()) {
+    for (const string& input : node.input()) {
+      consumed.insert(ParseTensorName(input).first.ToString());
+    }
+  }
+  node_name->clear();
+  for (const NodeDef& node : graph_def.node()) {
+    if (consumed.count(node.name()) > 0) continue;
+    if (!node_name->empty()) {
+      return errors::InvalidArgument(
+          "The dataset graph has more than one sink node: ", *node_name,
+          " and ", node.name());
+    }
+    *node_name = node.name();
+  }
+  if (node_name->empty()) {
+    return errors::InvalidArgument("The dataset graph has no sink node.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+class DataServiceImpl::ServerIterator {
+ public:
+  // Builds the dataset in `graph_def` on the CPU of `env`, and creates an
+  // iterator over it.
+  static Status Create(const WorkerEnv* env, const GraphDef& graph_def,
+                       std::unique_ptr<ServerIterator>* out) {
+    string output_node;
+    TF_RETURN_IF_ERROR(FindDatasetNode(graph_def, &output_node));
+    Device* device;
+    TF_RETURN_IF_ERROR(env->device_mgr->LookupDevice("CPU:0", &device));
+
+    std::unique_ptr<ServerIterator> iterator(new ServerIterator);
+    iterator->flib_def_ = std::make_shared<FunctionLibraryDefinition>(
+        OpRegistry::Global(), graph_def.library());
+    iterator->pflr_.reset(new ProcessFunctionLibraryRuntime(
+        env->device_mgr, env->env, TF_GRAPH_DEF_VERSION,
+        iterator->flib_def_.get(), OptimizerOptions(), env->compute_pool));
+    FunctionLibraryRuntime* lib = iterator->pflr_->GetFLR(device->name());
+    if (lib == nullptr) {
+      return errors::Internal("No function library for device ",
+                              device->name());
+    }
+
+    Graph graph(OpRegistry::Global());
+    TF_RETURN_IF_ERROR(ImportGraphDef({}, graph_def, &graph, nullptr));
+    std::vector<Tensor> outputs;
+    GraphRunner graph_runner(device);
+    TF_RETURN_IF_ERROR(
+        graph_runner.Run(&graph, lib, {}, {output_node}, &outputs));
+    DatasetBase* dataset;
+    TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
+
+    IteratorContext::Params& params = iterator->params_;
+    params.env = env->env;
+    thread::ThreadPool* pool = env->compute_pool;
+    params.runner = [pool](std::function<void()> c) {
+      pool->Schedule(std::move(c));
+    };
+    params.lib = lib;
+    params.function_library = iterator->flib_def_;
+    params.allocator_getter = [device](AllocatorAttributes attrs) {
+      return device->GetAllocator(attrs);
+    };
+    IteratorContext ctx(params);
+    TF_RETURN_IF_ERROR(
+        dataset->MakeIterator(&ctx, "Iterator", &iterator->iterator_));
+    *out = std::move(iterator);
+    return Status::OK();
+  }
+
+  // Appends up to `max_elements` elements to `response`. An error that
+  // occurs after some elements were produced is returned by the next call,
+  // so that those elements are not lost. As with a local iterator, the
+  // calls after an error continue with the next element.
+  Status GetNext(int64 max_elements, GetNextResponse* response) {
+    mutex_lock l(mu_);
+    if (!status_.ok()) {
+      Status s = status_;
+      status_ = Status::OK();
+      return s;
+    }
+    IteratorContext ctx(params_);
+    while (!end_of_sequence_ && response->elements_size() < max_elements) {
+      std::vector<Tensor> components;
+      Status s = iterator_->GetNext(&ctx, &components, &end_of_sequence_);
+      if (!s.ok()) {
+        if (response->elements_size() == 0) return s;
+        status_ = s;
+        break;
+      }
+      if (end_of_sequence_) break;
+      DatasetElement* element = response->add_elements();
+      for (const Tensor& t : components) {
+        t.AsProtoTensorContent(element->add_components());
+      }
+    }
+    response->set_end_of_sequence(end_of_sequence_);
+    return Status::OK();
+  }
+
+ private:
+  ServerIterator() {}
+
+  std::shared_ptr<FunctionLibraryDefinition> flib_def_;
+  std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
+  IteratorContext::Params params_;
+  // Declared last, so that it is destroyed before the function library.
+  std::unique_ptr<IteratorBase> iterator_;
+
+  mutex mu_;
+  bool end_of_sequence_ GUARDED_BY(mu_) = false;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ServerIterator);
+};
+
+Status DataServiceImpl::CreateIterator(const CreateIteratorRequest* request,
+                                       CreateIteratorResponse* response) {
+  GraphDef graph_def;
+  if (!graph_def.ParseFromString(request->dataset_graph())) {
+    return errors::InvalidArgument("Error parsing dataset GraphDef.");
+  }
+  std::unique_ptr<ServerIterator> iterator;
+  TF_RETURN_IF_ERROR(ServerIterator::Create(env_, graph_def, &iterator));
+
+  mutex_lock l(mu_);
+  int64 iterator_id;
+  do {
+    iterator_id = random::New64() & kint64max;
+  } while (iterators_.count(iterator_id) > 0);
+  iterators_[iterator_id] = std::move(iterator);
+  response->set_iterator_id(iterator_id);
+  return Status::OK();
+}
+
+Status DataServiceImpl::GetNext(const GetNextRequest* request,
+                                GetNextResponse* response) {
+  std::shared_ptr<ServerIterator> iterator;
+  TF_RETURN_IF_ERROR(GetServerIterator(request->iterator_id(), &iterator));
+  return iterator->GetNext(std::max<int64>(request->max_elements(), 1),
+                           response);
+}
+
+Status DataServiceImpl::ReleaseIterator(const ReleaseIteratorRequest* request,
+                                        ReleaseIteratorResponse* response) {
+  std::shared_ptr<ServerIterator> iterator;
+  {
+    mutex_lock l(mu_);
+    auto it = iterators_.find(request->iterator_id());
+    if (it == iterators_.end()) {
+      return errors::NotFound("Unknown iterator ID: ",
+                              request->iterator_id());
+    }
+    // Destroy the iterator outside the lock, after any pending `GetNext()`.
+    iterator = std::move(it->second);
+    iterators_.erase(it);
+  }
+  return Status::OK();
+}
+
+Status DataServiceImpl::GetServerIterator(
+    int64 iterator_id, std::shared_ptr<ServerIterator>* iterator) {
+  mutex_lock l(mu_);
+  auto it = iterators_.find(iterator_id);
+  if (it == iterators_.end()) {
+    return errors::NotFound("Unknown iterator ID: ", iterator_id);
+  }
+  *iterator = it->second;
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,69 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_IMPL_H_
+
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// A DataService server builds the datasets sent by its clients on the CPU
+// of the local worker, and hands out their elements in batches.
+//
+// See data_service.proto for more details about each method.
+// This class can be wrapped by specific classes that implement rpc transports
+// over this (e.g. gRPC).
+class DataServiceImpl {
+ public:
+  explicit DataServiceImpl(const WorkerEnv* env) : env_(env) {}
+  virtual ~DataServiceImpl() {}
+
+  Status CreateIterator(const CreateIteratorRequest* request,
+                        CreateIteratorResponse* response);
+
+  Status GetNext(const GetNextRequest* request, GetNextResponse* response);
+
+  Status ReleaseIterator(const ReleaseIteratorRequest* request,
+                         ReleaseIteratorResponse* response);
+
+ private:
+  // The state of an iterator created by `CreateIterator()`.
+  class ServerIterator;
+
+  Status GetServerIterator(int64 iterator_id,
+                           std::shared_ptr<ServerIterator>* iterator);
+
+  const WorkerEnv* const env_;  // Not owned.
+
+  mutex mu_;
+  std::unordered_map<int64, std::shared_ptr<ServerIterator>> iterators_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DataServiceImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_IMPL_H_
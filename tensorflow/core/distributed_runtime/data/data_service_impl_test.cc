@@ -0,0 +1,159 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/data/data_service_impl.h"
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Returns the graph of `Dataset.range(stop)`, as `DatasetToGraph` would.
+GraphDef RangeDatasetGraph(int64 stop) {
+  using test::function::NDef;
+  return test::function::GDef(
+      {NDef("start", "Const", {},
+            {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(0)}}),
+       NDef("stop", "Const", {},
+            {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(stop)}}),
+       NDef("step", "Const", {},
+            {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(1)}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_types", DataTypeSlice{DT_INT64}},
+             {"output_shapes",
+              gtl::ArraySlice<TensorShape>{TensorShape({})}}})},
+      {});
+}
+
+class DataServiceImplTest : public ::testing::Test {
+ public:
+  DataServiceImplTest() : pool_(Env::Default(), "test", 2) {
+    worker_env_.env = Env::Default();
+    Device* device = DeviceFactory::NewDevice(
+        "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0");
+    worker_env_.local_devices = {device};
+    device_mgr_.reset(new DeviceMgr(worker_env_.local_devices));
+    worker_env_.device_mgr = device_mgr_.get();
+    worker_env_.compute_pool = &pool_;
+    service_.reset(new DataServiceImpl(&worker_env_));
+  }
+
+ protected:
+  int64 CreateIterator(const GraphDef& graph_def) {
+    CreateIteratorRequest request;
+    graph_def.SerializeToString(request.mutable_dataset_graph());
+    CreateIteratorResponse response;
+    TF_CHECK_OK(service_->CreateIterator(&request, &response));
+    return response.iterator_id();
+  }
+
+  Status GetNext(int64 iterator_id, int64 max_elements,
+                 std::vector<int64>* values, bool* end_of_sequence) {
+    GetNextRequest request;
+    request.set_iterator_id(iterator_id);
+    request.set_max_elements(max_elements);
+    GetNextResponse response;
+    TF_RETURN_IF_ERROR(service_->GetNext(&request, &response));
+    values->clear();
+    for (const DatasetElement& element : response.elements()) {
+      EXPECT_EQ(1, element.components_size());
+      Tensor t;
+      EXPECT_TRUE(t.FromProto(element.components(0)));
+      values->push_back(t.scalar<int64>()());
+    }
+    *end_of_sequence = response.end_of_sequence();
+    return Status::OK();
+  }
+
+  thread::ThreadPool pool_;
+  WorkerEnv worker_env_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<DataServiceImpl> service_;
+};
+
+TEST_F(DataServiceImplTest, GetNextInBatches) {
+  const int64 iterator_id = CreateIterator(RangeDatasetGraph(5));
+  std::vector<int64> values;
+  bool end_of_sequence;
+  TF_ASSERT_OK(GetNext(iterator_id, 2, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({0, 1}), values);
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(GetNext(iterator_id, 2, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({2, 3}), values);
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(GetNext(iterator_id, 2, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({4}), values);
+  EXPECT_TRUE(end_of_sequence);
+  TF_ASSERT_OK(GetNext(iterator_id, 2, &values, &end_of_sequence));
+  EXPECT_TRUE(values.empty());
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST_F(DataServiceImplTest, IndependentIterators) {
+  const int64 first = CreateIterator(RangeDatasetGraph(3));
+  const int64 second = CreateIterator(RangeDatasetGraph(3));
+  EXPECT_NE(first, second);
+  std::vector<int64> values;
+  bool end_of_sequence;
+  TF_ASSERT_OK(GetNext(first, 0, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({0}), values);
+  TF_ASSERT_OK(GetNext(second, 10, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({0, 1, 2}), values);
+  EXPECT_TRUE(end_of_sequence);
+  TF_ASSERT_OK(GetNext(first, 10, &values, &end_of_sequence));
+  EXPECT_EQ(std::vector<int64>({1, 2}), values);
+}
+
+TEST_F(DataServiceImplTest, ReleaseIterator) {
+  const int64 iterator_id = CreateIterator(RangeDatasetGraph(5));
+  ReleaseIteratorRequest request;
+  request.set_iterator_id(iterator_id);
+  ReleaseIteratorResponse response;
+  TF_ASSERT_OK(service_->ReleaseIterator(&request, &response));
+  EXPECT_TRUE(errors::IsNotFound(
+      service_->ReleaseIterator(&request, &response)));
+  std::vector<int64> values;
+  bool end_of_sequence;
+  EXPECT_TRUE(errors::IsNotFound(
+      GetNext(iterator_id, 1, &values, &end_of_sequence)));
+}
+
+TEST_F(DataServiceImplTest, InvalidGraph) {
+  CreateIteratorRequest request;
+  CreateIteratorResponse response;
+  request.set_dataset_graph("not a graph");
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      service_->CreateIterator(&request, &response)));
+
+  GraphDef graph_def = RangeDatasetGraph(5);
+  *graph_def.add_node() = test::function::NDef(
+      "unused", "Const", {},
+      {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(0)}});
+  graph_def.SerializeToString(request.mutable_dataset_graph());
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      service_->CreateIterator(&request, &response)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
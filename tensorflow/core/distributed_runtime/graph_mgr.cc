@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -47,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
@@ -75,6 +77,39 @@ GraphMgr::Item::~Item() {
     delete unit.root;
     unit.device->op_segment()->RemoveHold(this->session);
   }
+  // Steps that were prefetched for but never ran.  Cleanup() aborts their
+  // in-flight prefetches.
+  mutex_lock l(prefetch_mu);
+  for (const auto& p : prefetched_steps) {
+    graph_mgr->worker_env_->rendezvous_mgr->Cleanup(p.first);
+  }
+}
+
+constexpr size_t GraphMgr::Item::kMaxFinishedSteps;
+constexpr int64 GraphMgr::Item::kMaxPendingPrefetches;
+
+std::vector<int64> GraphMgr::Item::StartStep(int64 step_id) {
+  running_steps.insert(step_id);
+  prefetched_steps.erase(step_id);
+  ++num_started_steps;
+  std::vector<int64> stale;
+  for (auto it = prefetched_steps.begin(); it != prefetched_steps.end();) {
+    if (num_started_steps - it->second > kMaxPendingPrefetches) {
+      stale.push_back(it->first);
+      it = prefetched_steps.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return stale;
+}
+
+void GraphMgr::Item::FinishStep(int64 step_id) {
+  running_steps.erase(step_id);
+  finished_steps.push_back(step_id);
+  if (finished_steps.size() > kMaxFinishedSteps) {
+    finished_steps.pop_front();
+  }
 }
 
 // NOTE: node->device_name() is not set by GraphConstructor.  We
@@ -275,12 +310,68 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     if (unit->build_cost_model > 0) {
       skip_cost_models_ = false;
     }
+    if (graph_options.prefetch_remote_recvs() &&
+        collective_graph_key == BuildGraphOptions::kNoCollectiveGraphKey) {
+      TF_RETURN_IF_ERROR(CollectPrefetchKeys(*subgraph, item));
+    }
     TF_RETURN_IF_ERROR(
         NewLocalExecutor(params, std::move(subgraph), &unit->root));
   }
   return Status::OK();
 }
 
+Status GraphMgr::CollectPrefetchKeys(const Graph& graph, Item* item) {
+  for (const Node* n : graph.op_nodes()) {
+    if (!n->IsRecv()) continue;
+    bool client_terminated;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(n->attrs(), "client_terminated", &client_terminated));
+    if (client_terminated) continue;
+    // Only recvs that can run as soon as the step starts are prefetched;
+    // anything else may depend on control flow within the step.
+    bool is_root = true;
+    for (const Edge* e : n->in_edges()) {
+      if (!e->src()->IsSource()) {
+        is_root = false;
+        break;
+      }
+    }
+    if (!is_root) continue;
+    string send_device;
+    string recv_device;
+    string tensor_name;
+    int64 send_device_incarnation;
+    TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "send_device", &send_device));
+    TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "recv_device", &recv_device));
+    TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "tensor_name", &tensor_name));
+    TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "send_device_incarnation",
+                                   &send_device_incarnation));
+    if (DeviceNameUtils::IsSameAddressSpace(send_device, recv_device)) {
+      continue;
+    }
+    Item::PrefetchKey key;
+    if (n->IsHostRecv()) {
+      key.alloc_attrs.set_on_host(true);
+    } else {
+      // A device-resident output is allocated with the device context of
+      // the Recv kernel, which is not available ahead of the step.
+      DeviceNameUtils::ParsedName parsed_dst;
+      if (!DeviceNameUtils::ParseFullName(recv_device, &parsed_dst) ||
+          parsed_dst.type != DEVICE_CPU) {
+        continue;
+      }
+    }
+    TF_RETURN_IF_ERROR(Rendezvous::ParseKey(
+        Rendezvous::CreateKey(send_device,
+                              static_cast<uint64>(send_device_incarnation),
+                              recv_device, tensor_name, FrameAndIter(0, 0)),
+        &key.parsed));
+    VLOG(1) << "Will prefetch " << key.parsed.FullKey();
+    item->prefetch_keys.push_back(key);
+  }
+  return Status::OK();
+}
+
 Status GraphMgr::Register(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
@@ -418,6 +509,21 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
     }
   }
 
+  const int64 next_step_id =
+      item->prefetch_keys.empty() ? 0 : opts.next_step_id();
+  if (!item->prefetch_keys.empty()) {
+    std::vector<int64> stale_steps;
+    {
+      mutex_lock l(item->prefetch_mu);
+      stale_steps = item->StartStep(step_id);
+    }
+    for (int64 stale_step_id : stale_steps) {
+      VLOG(1) << "Aborting prefetch for step " << stale_step_id
+              << ", which never started";
+      worker_env_->rendezvous_mgr->Cleanup(stale_step_id);
+    }
+  }
+
   RemoteRendezvous* rendezvous = worker_env_->rendezvous_mgr->Find(step_id);
   Status s = rendezvous->Initialize(session);
   CollectiveExecutor::Handle* ce_handle =
@@ -440,6 +546,10 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
   }
 
   if (!s.ok()) {
+    if (!item->prefetch_keys.empty()) {
+      mutex_lock l(item->prefetch_mu);
+      item->FinishStep(step_id);
+    }
     done(s);
     delete ce_handle;
     item->Unref();
@@ -447,14 +557,60 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
     return;
   }
 
-  StartParallelExecutors(handle, step_id, item, rendezvous, ce_handle,
-                         collector, cost_graph, cancellation_manager,
-                         [item, rendezvous, ce_handle, done](const Status& s) {
-                           done(s);
-                           rendezvous->Unref();
-                           item->Unref();
-                           delete ce_handle;
-                         });
+  StartParallelExecutors(
+      handle, step_id, item, rendezvous, ce_handle, collector, cost_graph,
+      cancellation_manager,
+      [this, item, session, step_id, next_step_id, rendezvous, ce_handle,
+       done](const Status& s) {
+        if (!item->prefetch_keys.empty()) {
+          {
+            mutex_lock l(item->prefetch_mu);
+            item->FinishStep(step_id);
+          }
+          if (s.ok() && next_step_id != 0) {
+            PrefetchRemoteRecvs(item, session, next_step_id);
+          }
+        }
+        done(s);
+        rendezvous->Unref();
+        item->Unref();
+        delete ce_handle;
+      });
+}
+
+void GraphMgr::PrefetchRemoteRecvs(Item* item, WorkerSession* session,
+                                   int64 step_id) {
+  RemoteRendezvous* rendezvous;
+  {
+    mutex_lock l(item->prefetch_mu);
+    // The step may already be running, or even have finished, if the
+    // master issued it concurrently with the one that just finished.
+    if (item->running_steps.count(step_id) > 0 ||
+        std::find(item->finished_steps.begin(), item->finished_steps.end(),
+                  step_id) != item->finished_steps.end() ||
+        item->prefetched_steps.count(step_id) > 0) {
+      return;
+    }
+    // The rendezvous is created before the step is published, so that it
+    // is the one the step runs with, or is cleaned up in its place.
+    // Creating it afterwards could recreate the rendezvous of a step that
+    // started, finished and was cleaned up in between, and leak it.
+    rendezvous = worker_env_->rendezvous_mgr->Find(step_id);
+    item->prefetched_steps[step_id] = item->num_started_steps;
+  }
+  // If the step has started since, or has even been cleaned up, the
+  // prefetches below are ignored by the rendezvous.
+  Status s = rendezvous->Initialize(session);
+  if (s.ok()) {
+    for (const Item::PrefetchKey& key : item->prefetch_keys) {
+      Rendezvous::Args args;
+      args.alloc_attrs = key.alloc_attrs;
+      rendezvous->PrefetchRemoteAsync(key.parsed, args);
+    }
+  } else {
+    VLOG(1) << "Not prefetching for step " << step_id << ": " << s;
+  }
+  rendezvous->Unref();
 }
 
 void GraphMgr::StartParallelExecutors(const string& handle, int64 step_id,
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -141,6 +144,43 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // Root Recv nodes whose tensors are produced in other processes.  If
+    // GraphOptions.prefetch_remote_recvs is set, they are fetched into the
+    // rendezvous of the announced next step as soon as a step completes.
+    struct PrefetchKey {
+      Rendezvous::ParsedKey parsed;
+      AllocatorAttributes alloc_attrs;
+    };
+    std::vector<PrefetchKey> prefetch_keys;
+
+    mutex prefetch_mu;
+    // Steps of this graph that are currently executing.
+    std::unordered_set<int64> running_steps GUARDED_BY(prefetch_mu);
+    // Number of steps of this graph that have started.
+    int64 num_started_steps GUARDED_BY(prefetch_mu) = 0;
+    // Steps whose rendezvous holds prefetched tensors but that have not
+    // started yet, mapped to "num_started_steps" when they were prefetched.
+    // A step that has not started after kMaxPendingPrefetches more steps
+    // of this graph started (e.g. because the run that announced it was
+    // cancelled) is aborted and cleaned up, as are the remaining ones when
+    // the item is destroyed.
+    static constexpr int64 kMaxPendingPrefetches = 16;
+    std::unordered_map<int64, int64> prefetched_steps GUARDED_BY(prefetch_mu);
+    // The last kMaxFinishedSteps steps of this graph that finished, oldest
+    // first.  A step may finish before the prefetch announced for it by
+    // the step before it starts; it must then not be prefetched for, since
+    // nothing would ever read or clean up its rendezvous.
+    static constexpr size_t kMaxFinishedSteps = 16;
+    std::deque<int64> finished_steps GUARDED_BY(prefetch_mu);
+
+    // Marks "step_id" as running.  Returns the prefetched steps that are
+    // not expected to run any more; the caller must clean them up.
+    std::vector<int64> StartStep(int64 step_id)
+        EXCLUSIVE_LOCKS_REQUIRED(prefetch_mu);
+
+    // Marks "step_id" as no longer running.
+    void FinishStep(int64 step_id) EXCLUSIVE_LOCKS_REQUIRED(prefetch_mu);
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -182,6 +222,14 @@ class GraphMgr {
                   const DebugOptions& debug_options, int64 collective_graph_key,
                   DistributedFunctionLibraryRuntime* cluster_flr, Item* item);
 
+  // Adds the root Recv nodes of "graph" that receive from other processes
+  // to "item->prefetch_keys".
+  Status CollectPrefetchKeys(const Graph& graph, Item* item);
+
+  // Starts prefetching the remote recvs of "item" for "step_id", once the
+  // step before it has finished.
+  void PrefetchRemoteRecvs(Item* item, WorkerSession* session, int64 step_id);
+
   Status DecorateAndPublishGraphForDebug(const DebugOptions& debug_options,
                                          Graph* graph, Device* device);
 
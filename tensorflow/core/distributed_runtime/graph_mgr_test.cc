@@ -0,0 +1,242 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/graph_mgr.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/build_graph_options.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+const char* const kWorkerName = "/job:worker/replica:0/task:0";
+const char* const kLocalDevice = "/job:worker/replica:0/task:0/device:CPU:0";
+const char* const kRemoteDevice = "/job:worker/replica:0/task:1/device:CPU:0";
+
+class FakeRendezvousMgr;
+
+// Serves every remote recv immediately and counts them per step.
+class FakeRemoteRendezvous : public BaseRemoteRendezvous {
+ public:
+  FakeRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                       FakeRendezvousMgr* mgr)
+      : BaseRemoteRendezvous(env, step_id), mgr_(mgr) {}
+
+ protected:
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args,
+                           DoneCallback done) override;
+
+ private:
+  FakeRendezvousMgr* const mgr_;  // Not owned.
+};
+
+class FakeRendezvousMgr : public BaseRendezvousMgr {
+ public:
+  explicit FakeRendezvousMgr(const WorkerEnv* env) : BaseRendezvousMgr(env) {}
+
+  void Cleanup(int64 step_id) override {
+    {
+      mutex_lock l(mu_);
+      cleaned_up_.push_back(step_id);
+    }
+    BaseRendezvousMgr::Cleanup(step_id);
+  }
+
+  void RecordRemoteRecv(int64 step_id) {
+    mutex_lock l(mu_);
+    ++remote_recvs_[step_id];
+  }
+
+  // Number of remote recvs issued for "step_id", prefetched or not.
+  int RemoteRecvs(int64 step_id) {
+    mutex_lock l(mu_);
+    return remote_recvs_[step_id];
+  }
+
+  // Number of rendezvous created for "step_id".
+  int Created(int64 step_id) {
+    mutex_lock l(mu_);
+    return created_[step_id];
+  }
+
+  std::vector<int64> CleanedUp() {
+    mutex_lock l(mu_);
+    return cleaned_up_;
+  }
+
+ protected:
+  BaseRemoteRendezvous* Create(int64 step_id,
+                               const WorkerEnv* worker_env) override {
+    {
+      mutex_lock l(mu_);
+      ++created_[step_id];
+    }
+    return new FakeRemoteRendezvous(worker_env, step_id, this);
+  }
+
+ private:
+  mutex mu_;
+  std::map<int64, int> remote_recvs_ GUARDED_BY(mu_);
+  std::map<int64, int> created_ GUARDED_BY(mu_);
+  std::vector<int64> cleaned_up_ GUARDED_BY(mu_);
+};
+
+void FakeRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& args,
+    DoneCallback done) {
+  mgr_->RecordRemoteRecv(step_id_);
+  Tensor val(DT_FLOAT, TensorShape({}));
+  val.scalar<float>()() = 1.0f;
+  done(Status::OK(), Args(), args, val, false);
+}
+
+class GraphMgrTest : public ::testing::Test {
+ protected:
+  GraphMgrTest()
+      : pool_(new thread::ThreadPool(Env::Default(), "graph_mgr_test", 2)),
+        session_("sess", kWorkerName, std::unique_ptr<WorkerCacheInterface>(),
+                 std::unique_ptr<DeviceMgr>(), std::unique_ptr<GraphMgr>()) {
+    env_.env = Env::Default();
+    env_.compute_pool = pool_.get();
+    rmgr_.reset(new FakeRendezvousMgr(&env_));
+    env_.rendezvous_mgr = rmgr_.get();
+    std::vector<Device*> devices;
+    TF_CHECK_OK(
+        DeviceFactory::AddDevices(SessionOptions(), kWorkerName, &devices));
+    device_mgr_.reset(new DeviceMgr(devices));
+    gmgr_.reset(new GraphMgr(&env_, device_mgr_.get()));
+  }
+
+  ~GraphMgrTest() override {
+    // Waits for the executors to drop their references to the graphs.
+    pool_.reset();
+  }
+
+  // Registers a graph with a single root Recv from another worker.
+  string Register() {
+    GraphDef gdef;
+    TF_CHECK_OK(NodeDefBuilder("recv", "_Recv")
+                    .Attr("tensor_type", DT_FLOAT)
+                    .Attr("tensor_name", "x")
+                    .Attr("send_device", kRemoteDevice)
+                    .Attr("send_device_incarnation", 1)
+                    .Attr("recv_device", kLocalDevice)
+                    .Attr("client_terminated", false)
+                    .Device(kLocalDevice)
+                    .Finalize(gdef.add_node()));
+    GraphOptions graph_options;
+    graph_options.set_prefetch_remote_recvs(true);
+    string handle;
+    TF_CHECK_OK(gmgr_->Register("sess", gdef, graph_options, DebugOptions(),
+                                BuildGraphOptions::kNoCollectiveGraphKey,
+                                nullptr, &handle));
+    return handle;
+  }
+
+  void RunStep(const string& handle, int64 step_id, int64 next_step_id) {
+    ExecutorOpts opts;
+    opts.set_next_step_id(next_step_id);
+    CancellationManager cm;
+    Notification n;
+    Status status;
+    gmgr_->ExecuteAsync(handle, step_id, &session_, opts, nullptr, nullptr,
+                        &cm, {}, [&n, &status](const Status& s) {
+                          status = s;
+                          n.Notify();
+                        });
+    n.WaitForNotification();
+    TF_ASSERT_OK(status);
+  }
+
+  std::unique_ptr<thread::ThreadPool> pool_;
+  WorkerEnv env_;
+  std::unique_ptr<FakeRendezvousMgr> rmgr_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  WorkerSession session_;
+  std::unique_ptr<GraphMgr> gmgr_;
+};
+
+TEST_F(GraphMgrTest, PrefetchesAnnouncedStep) {
+  const string handle = Register();
+  RunStep(handle, 1, 2);
+  EXPECT_EQ(1, rmgr_->RemoteRecvs(1));
+  EXPECT_EQ(1, rmgr_->RemoteRecvs(2));
+  // Step 2 consumes the prefetched tensor.
+  RunStep(handle, 2, 0);
+  EXPECT_EQ(1, rmgr_->RemoteRecvs(2));
+  EXPECT_EQ(1, rmgr_->Created(2));
+  rmgr_->Cleanup(1);
+  rmgr_->Cleanup(2);
+}
+
+TEST_F(GraphMgrTest, DoesNotPrefetchFinishedStep) {
+  const string handle = Register();
+  // The master ran step 2 concurrently with step 1, and it was already
+  // cleaned up by the time step 1 announced it.
+  RunStep(handle, 2, 0);
+  rmgr_->Cleanup(2);
+  RunStep(handle, 1, 2);
+  EXPECT_EQ(1, rmgr_->RemoteRecvs(2));
+  EXPECT_EQ(1, rmgr_->Created(2));
+  rmgr_->Cleanup(1);
+}
+
+TEST_F(GraphMgrTest, CleansUpPrefetchOnDeregister) {
+  const string handle = Register();
+  RunStep(handle, 1, 2);
+  rmgr_->Cleanup(1);
+  TF_ASSERT_OK(gmgr_->Deregister(handle));
+  // The graph is destroyed once step 1 has dropped its reference to it.
+  pool_.reset();
+  EXPECT_EQ(std::vector<int64>({1, 2}), rmgr_->CleanedUp());
+}
+
+TEST_F(GraphMgrTest, CleansUpPrefetchForStepThatNeverStarts) {
+  const string handle = Register();
+  RunStep(handle, 1, 1000);
+  rmgr_->Cleanup(1);
+  // The run that would have used step 1000 never happens.
+  for (int64 step_id = 2; step_id < 20; ++step_id) {
+    RunStep(handle, step_id, 0);
+    rmgr_->Cleanup(step_id);
+  }
+  const std::vector<int64> cleaned_up = rmgr_->CleanedUp();
+  EXPECT_NE(cleaned_up.end(),
+            std::find(cleaned_up.begin(), cleaned_up.end(), 1000));
+}
+
+}  // namespace
+}  // namespace tensorflow
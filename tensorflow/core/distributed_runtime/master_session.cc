@@ -114,6 +114,19 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     return execution_count_.fetch_add(1);
   }
 
+  // Returns the step_id reserved for this execution by the previous one,
+  // or a new one from "new_step_id" if there is none, and reserves another
+  // for the following execution in "*next_step_id".
+  uint64 TakeStepIdAndReserveNext(const std::function<uint64()>& new_step_id,
+                                  uint64* next_step_id) {
+    mutex_lock l(mu_);
+    const uint64 step_id =
+        reserved_step_id_ != 0 ? reserved_step_id_ : new_step_id();
+    reserved_step_id_ = new_step_id();
+    *next_step_id = reserved_step_id_;
+    return step_id;
+  }
+
   // Turn RPC logging on or off, both at the WorkerCache used by this
   // master process, and at each remote worker in use for the current
   // partitions.
@@ -276,6 +289,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // init_result_ remembers the initialization error if any.
   Status init_result_ GUARDED_BY(mu_);
 
+  // The step_id announced to workers for the next execution, or 0.
+  uint64 reserved_step_id_ GUARDED_BY(mu_) = 0;
+
   std::unique_ptr<StatsPublisherInterface> stats_publisher_;
 
   // Send/Recv nodes that are the result of client-added
@@ -585,6 +601,9 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   if (pss->collect_partition_graphs) {
     exec_opts.set_record_partition_graphs(true);
   }
+  if (pss->next_step_id != 0) {
+    exec_opts.set_next_step_id(pss->next_step_id);
+  }
   if (pss->collect_costs || pss->collect_timeline) {
     pss->step_stats.resize(partitions_.size());
   }
@@ -1476,6 +1495,21 @@ uint64 MasterSession::NewStepId(int64 graph_key) {
   }
 }
 
+uint64 MasterSession::NewStepIdForGraph(ReffedClientGraph* rcg,
+                                        uint64* next_step_id) {
+  *next_step_id = 0;
+  const int64 graph_key = rcg->build_graph_options().collective_graph_key;
+  if (graph_key != BuildGraphOptions::kNoCollectiveGraphKey ||
+      !session_opts_.config.graph_options().prefetch_remote_recvs()) {
+    return NewStepId(graph_key);
+  }
+  // Random step_ids are drawn one execution early so that workers know
+  // which step to prefetch for.
+  return rcg->TakeStepIdAndReserveNext(
+      [this]() { return NewStepId(BuildGraphOptions::kNoCollectiveGraphKey); },
+      next_step_id);
+}
+
 Status MasterSession::PartialRunSetup(const PartialRunSetupRequest* req,
                                       PartialRunSetupResponse* resp) {
   std::vector<string> inputs, outputs, targets;
@@ -1850,11 +1884,13 @@ Status MasterSession::DoRunWithLocalExecution(
 
   // Keeps the highest 8 bits 0x01: we reserve some bits of the
   // step_id for future use.
-  uint64 step_id = NewStepId(bgopts.collective_graph_key);
+  uint64 next_step_id;
+  uint64 step_id = NewStepIdForGraph(rcg, &next_step_id);
   TRACEPRINTF("stepid %llu", step_id);
 
   std::unique_ptr<ProfileHandler> ph;
   FillPerStepState(rcg, req.options(), step_id, count, &pss, &ph);
+  pss.next_step_id = next_step_id;
 
   Status s = rcg->RunPartitions(env_, step_id, count, &pss, opts, req, resp,
                                 &cancellation_manager_, false);
@@ -1914,8 +1950,8 @@ Status MasterSession::DoRunCallable(CallOptions* opts, ReffedClientGraph* rcg,
   // Prepare.
   int64 count = rcg->get_and_increment_execution_count();
 
-  const uint64 step_id =
-      NewStepId(rcg->build_graph_options().collective_graph_key);
+  uint64 next_step_id;
+  const uint64 step_id = NewStepIdForGraph(rcg, &next_step_id);
   TRACEPRINTF("stepid %llu", step_id);
 
   const RunOptions& run_options = rcg->callable_options().run_options();
@@ -1926,6 +1962,7 @@ Status MasterSession::DoRunCallable(CallOptions* opts, ReffedClientGraph* rcg,
 
   std::unique_ptr<ProfileHandler> ph;
   FillPerStepState(rcg, run_options, step_id, count, &pss, &ph);
+  pss.next_step_id = next_step_id;
   Status s = rcg->RunPartitions(env_, step_id, count, &pss, opts, req, resp,
                                 &cancellation_manager_);
   cleanup.release();  // MarkRunCompletion called in PostRunCleanup().
@@ -159,12 +159,19 @@ class MasterSession : public core::RefCounted {
   int64 next_callable_handle_ GUARDED_BY(mu_) = 0;
   RCGMap callables_ GUARDED_BY(mu_);
 
+  // Returns the step_id for the next execution of "rcg".  If workers may
+  // prefetch remote recvs for the graph, also sets "*next_step_id" to the
+  // step_id reserved for the execution after that one; otherwise sets it
+  // to 0.
+  uint64 NewStepIdForGraph(ReffedClientGraph* rcg, uint64* next_step_id);
+
   struct PerStepState {
     bool collect_costs = false;
     bool collect_timeline = false;
     bool collect_rpcs = false;
     bool collect_partition_graphs = false;
     bool report_tensor_allocations_upon_oom = false;
+    uint64 next_step_id = 0;  // See ExecutorOpts.next_step_id.
     Microseconds start_micros = Microseconds(0);
     Microseconds end_micros = Microseconds(0);
     std::vector<StepStats> step_stats;  // per partition
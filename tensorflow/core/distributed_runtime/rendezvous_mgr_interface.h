@@ -40,6 +40,15 @@ class RemoteRendezvous : public Rendezvous {
  public:
   // Fully construct the RemoteRendezvous.
   virtual Status Initialize(WorkerSession* session) = 0;
+
+  // Speculatively starts receiving the tensor for "key", which must be
+  // produced in another process, before any consumer asks for it.  A later
+  // RecvAsync for the same key completes with the prefetched value.  Keys
+  // that have already been requested by RecvAsync are ignored.  The
+  // default implementation does nothing.
+  //
+  // REQUIRES: Initialize has been called.
+  virtual void PrefetchRemoteAsync(const ParsedKey& key, const Args& args) {}
 };
 
 // RendezvousMgr keeps track of a set of local rendezvous instances.
@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "grpcpp/generic/generic_stub.h"
+#include "tensorflow/core/distributed_runtime/data/data_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Polls the completion queue shared by all `GrpcDataClient`s. It is never
+// destroyed, so that a client may be deleted by the callback of its last
+// call, which runs on this thread.
+class GrpcDataClientThread {
+ public:
+  static GrpcDataClientThread* Get() {
+    static GrpcDataClientThread* thread = new GrpcDataClientThread;
+    return thread;
+  }
+
+  ::grpc::CompletionQueue* completion_queue() { return &completion_queue_; }
+
+ private:
+  GrpcDataClientThread() {
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "data_client_thread", [this]() {
+          void* tag;
+          bool ok;
+          while (completion_queue_.Next(&tag, &ok)) {
+            GrpcClientCQTag* callback_tag = static_cast<GrpcClientCQTag*>(tag);
+            callback_tag->OnCompleted(ok);
+          }
+        }));
+  }
+
+  ::grpc::CompletionQueue completion_queue_;
+  std::unique_ptr<Thread> thread_;
+};
+
+// REQUIRES: No calls are pending when the client is deleted.
+class GrpcDataClient : public DataClient {
+ public:
+  explicit GrpcDataClient(const SharedGrpcChannelPtr& channel)
+      : stub_(channel),
+        cq_(GrpcDataClientThread::Get()->completion_queue()) {}
+  ~GrpcDataClient() override {}
+
+#define CLIENT_METHOD(method)                                           \
+  void method##Async(const method##Request* request,                    \
+                     method##Response* response, StatusCallback done)   \
+      override {                                                        \
+    new RPCState<protobuf::Message>(                                    \
+        &stub_, cq_, "/tensorflow.data.DataService/" #method, *request, \
+        response, std::move(done), nullptr);                            \
+  }
+
+  CLIENT_METHOD(CreateIterator);
+  CLIENT_METHOD(GetNext);
+  CLIENT_METHOD(ReleaseIterator);
+
+#undef CLIENT_METHOD
+
+ private:
+  ::grpc::GenericStub stub_;
+  ::grpc::CompletionQueue* cq_;  // Not owned.
+};
+
+Status NewGrpcDataClient(const string& target,
+                         std::unique_ptr<DataClient>* client) {
+  StringPiece host_port(target);
+  if (!str_util::ConsumePrefix(&host_port, "grpc://")) {
+    return errors::InvalidArgument("Not a gRPC target: ", target);
+  }
+  SharedGrpcChannelPtr channel;
+  TF_RETURN_IF_ERROR(NewHostPortGrpcChannel(host_port.ToString(), &channel));
+  client->reset(new GrpcDataClient(channel));
+  return Status::OK();
+}
+
+// Makes `DataClient::Create()` support "grpc://" targets.
+class GrpcDataClientRegistrar {
+ public:
+  GrpcDataClientRegistrar() {
+    DataClient::RegisterFactory("grpc", NewGrpcDataClient);
+  }
+};
+static GrpcDataClientRegistrar registrar;
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
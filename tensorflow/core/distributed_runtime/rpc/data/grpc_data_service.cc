@@ -0,0 +1,47 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service.h"
+
+#include "grpcpp/impl/codegen/method_handler_impl.h"
+#include "grpcpp/impl/codegen/rpc_service_method.h"
+#include "grpcpp/impl/codegen/service_type.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace grpc {
+
+static const char* grpcDataService_method_names[] = {
+    "/tensorflow.data.DataService/CreateIterator",
+    "/tensorflow.data.DataService/GetNext",
+    "/tensorflow.data.DataService/ReleaseIterator",
+};
+
+DataService::AsyncService::AsyncService() {
+  for (int i = 0; i < 3; ++i) {
+    AddMethod(new ::grpc::internal::RpcServiceMethod(
+        grpcDataService_method_names[i],
+        ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+    ::grpc::Service::MarkMethodAsync(i);
+  }
+}
+
+DataService::AsyncService::~AsyncService() {}
+
+}  // namespace grpc
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,76 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service_impl.h"
+
+#include "tensorflow/core/util/ptr_util.h"
+
+namespace tensorflow {
+namespace data {
+
+GrpcDataServiceImpl::GrpcDataServiceImpl(
+    const WorkerEnv* env, ::grpc::ServerBuilder* server_builder)
+    : local_impl_(env) {
+  // `GetNext()` blocks while the input pipeline produces elements, so use
+  // enough threads for several consumers to be served at once.
+  request_handler_threadpool_ =
+      MakeUnique<thread::ThreadPool>(env->env, "DataServiceRequestHandler", 8);
+  server_builder->RegisterService(&service_);
+  cq_ = server_builder->AddCompletionQueue();
+}
+
+void GrpcDataServiceImpl::HandleRPCsLoop() {
+#define ENQUEUE_REQUEST(method)                                    \
+  do {                                                             \
+    DataCall<method##Request, method##Response>::EnqueueRequest(   \
+        &service_, cq_.get(),                                      \
+        &grpc::DataService::AsyncService::Request##method,         \
+        &GrpcDataServiceImpl::method##Handler, false);             \
+  } while (0)
+  ENQUEUE_REQUEST(CreateIterator);
+  ENQUEUE_REQUEST(GetNext);
+  ENQUEUE_REQUEST(ReleaseIterator);
+#undef ENQUEUE_REQUEST
+
+  void* tag;  // Matches the operation started against this cq_.
+  bool ok;
+
+  while (true) {
+    if (!cq_->Next(&tag, &ok)) {
+      // The queue is shutting down.
+      break;
+    }
+    UntypedCall<GrpcDataServiceImpl>::Tag* callback_tag =
+        static_cast<UntypedCall<GrpcDataServiceImpl>::Tag*>(tag);
+
+    if (callback_tag) {
+      callback_tag->OnCompleted(this, ok);
+    } else {
+      cq_->Shutdown();
+      break;
+    }
+  }
+}
+
+void GrpcDataServiceImpl::Shutdown() {
+  // This enqueues a special event (with a null tag)
+  // that causes the completion queue to be shut down on the
+  // polling thread.
+  shutdown_alarm_ = MakeUnique<::grpc::Alarm>(
+      cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,81 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
+
+#include "grpcpp/alarm.h"
+#include "grpcpp/completion_queue.h"
+#include "grpcpp/server_builder.h"
+#include "tensorflow/core/distributed_runtime/data/data_service_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+
+namespace tensorflow {
+namespace data {
+
+// This class is a wrapper that handles communication for gRPC.
+class GrpcDataServiceImpl : public AsyncServiceInterface {
+ public:
+  template <class RequestMessage, class ResponseMessage>
+  using DataCall = Call<GrpcDataServiceImpl, grpc::DataService::AsyncService,
+                        RequestMessage, ResponseMessage>;
+
+  GrpcDataServiceImpl(const WorkerEnv* env,
+                      ::grpc::ServerBuilder* server_builder);
+  virtual ~GrpcDataServiceImpl() {}
+
+  // The transport-independent service, which in-process clients can call
+  // directly.
+  DataServiceImpl* local_impl() { return &local_impl_; }
+
+  void HandleRPCsLoop() override;
+  void Shutdown() override;
+
+ private:
+#define HANDLER(method)                                                       \
+  void method##Handler(DataCall<method##Request, method##Response>* call) {   \
+    request_handler_threadpool_->Schedule([this, call]() {                    \
+      call->SendResponse(                                                     \
+          ToGrpcStatus(local_impl_.method(&call->request, &call->response))); \
+    });                                                                       \
+    DataCall<method##Request, method##Response>::EnqueueRequest(              \
+        &service_, cq_.get(),                                                 \
+        &grpc::DataService::AsyncService::Request##method,                    \
+        &GrpcDataServiceImpl::method##Handler, false);                        \
+  }
+  HANDLER(CreateIterator);
+  HANDLER(GetNext);
+  HANDLER(ReleaseIterator);
+#undef HANDLER
+
+  DataServiceImpl local_impl_;
+
+  std::unique_ptr<::grpc::Alarm> shutdown_alarm_;
+
+  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
+  grpc::DataService::AsyncService service_;
+
+  std::unique_ptr<thread::ThreadPool> request_handler_threadpool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcDataServiceImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
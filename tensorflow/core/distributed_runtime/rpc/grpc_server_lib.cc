@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
+#include "tensorflow/core/distributed_runtime/data/data_client.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 #include "tensorflow/core/distributed_runtime/local_master.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/master_env.h"
 #include "tensorflow/core/distributed_runtime/master_session.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_master_service.h"
@@ -84,6 +86,7 @@ GrpcServer::~GrpcServer() {
   delete master_service_;
   delete worker_service_;
   delete eager_service_;
+  delete data_service_;
 
   // TODO(mrry): Refactor the *Env classes so that it is less fiddly
   // to destroy them.
@@ -194,6 +197,7 @@ Status GrpcServer::Init(
   worker_service_ =
       NewGrpcWorkerService(worker_impl_.get(), &builder).release();
   eager_service_ = new eager::GrpcEagerServiceImpl(&worker_env_, &builder);
+  data_service_ = new data::GrpcDataServiceImpl(&worker_env_, &builder);
 
   // extra service:
   if (service_func != nullptr) {
@@ -266,6 +270,9 @@ Status GrpcServer::Init(
   // Provide direct access to the master from in-process clients.
   LocalMaster::Register(target(), master_impl_.get(),
                         config.operation_timeout_in_ms());
+  // ... and to the tf.data service.
+  data::DataClient::RegisterLocalService(target(),
+                                         data_service_->local_impl());
 
   return Status::OK();
 }
@@ -371,6 +378,9 @@ Status GrpcServer::Start() {
       eager_thread_.reset(
           env_->StartThread(ThreadOptions(), "TF_eager_service",
                             [this] { eager_service_->HandleRPCsLoop(); }));
+      data_thread_.reset(
+          env_->StartThread(ThreadOptions(), "TF_data_service",
+                            [this] { data_service_->HandleRPCsLoop(); }));
       state_ = STARTED;
       LOG(INFO) << "Started server with target: " << target();
       return Status::OK();
@@ -414,6 +424,7 @@ Status GrpcServer::Join() {
       master_thread_.reset();
       worker_thread_.reset();
       eager_thread_.reset();
+      data_thread_.reset();
       return Status::OK();
     default:
       LOG(FATAL);
@@ -38,6 +38,10 @@ namespace tensorflow {
 class GrpcWorker;
 class Master;
 
+namespace data {
+class GrpcDataServiceImpl;
+}  // namespace data
+
 // function that creates a RendezvousMgr.
 typedef std::function<RendezvousMgrInterface*(const WorkerEnv*)>
     RendezvousMgrCreationFunction;
@@ -163,6 +167,10 @@ class GrpcServer : public ServerInterface {
   // TensorFlow Eager implementation, and RPC polling thread.
   AsyncServiceInterface* eager_service_ = nullptr;
   std::unique_ptr<Thread> eager_thread_ GUARDED_BY(mu_);
+
+  // tf.data service implementation, and RPC polling thread.
+  data::GrpcDataServiceImpl* data_service_ = nullptr;
+  std::unique_ptr<Thread> data_thread_ GUARDED_BY(mu_);
   std::shared_ptr<WorkerSession> worker_session_;
 
   std::unique_ptr<::grpc::Server> server_ GUARDED_BY(mu_);
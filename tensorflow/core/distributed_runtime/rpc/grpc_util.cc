@@ -18,6 +18,36 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+// Holds a reference on a received gRPC slice.
+class GrpcSliceHolder : public core::RefCounted {
+ public:
+  explicit GrpcSliceHolder(const ::grpc::Slice& slice) : slice_(slice) {}
+
+  // Small slices store their bytes inline, so the data must be read from
+  // this copy of the slice rather than the original.
+  StringPiece data() const {
+    return StringPiece(reinterpret_cast<const char*>(slice_.begin()),
+                       slice_.size());
+  }
+
+ private:
+  ::grpc::Slice slice_;
+};
+}  // namespace
+
+bool GrpcByteSource::GetContiguousBuffer(StringPiece* data,
+                                         core::RefCounted** holder) {
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok() || slices.size() != 1) {
+    return false;
+  }
+  GrpcSliceHolder* slice_holder = new GrpcSliceHolder(slices[0]);
+  *data = slice_holder->data();
+  *holder = slice_holder;
+  return true;
+}
+
 ::grpc::Status GrpcMaybeUnparseProto(const protobuf::Message& src,
                                      grpc::ByteBuffer* dst) {
   bool own_buffer;
@@ -44,6 +44,11 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Succeeds if the message arrived in a single slice, which is then
+  // kept alive by a reference held by "*holder".
+  bool GetContiguousBuffer(StringPiece* data,
+                           core::RefCounted** holder) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
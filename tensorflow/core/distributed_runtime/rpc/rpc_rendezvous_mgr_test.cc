@@ -49,8 +49,10 @@ Rendezvous::ParsedKey MakeKey(const string& s) {
 namespace {
 // Fake cache implementation for WorkerEnv.
 class DummyWorkerCache : public WorkerCacheInterface {
+ public:
   void ListWorkers(std::vector<string>* workers) const override {}
   WorkerInterface* CreateWorker(const string& target) override {
+    ++num_create_worker_calls;
     return nullptr;
   }
   bool GetDeviceLocalityNonBlocking(const string& device,
@@ -59,6 +61,8 @@ class DummyWorkerCache : public WorkerCacheInterface {
   }
   void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
                               StatusCallback done) override {}
+
+  int num_create_worker_calls = 0;
 };
 }  // namespace
 
@@ -154,6 +158,32 @@ TEST_F(RpcRendezvousMgrTest, CleanupAll) {
   }
 }
 
+TEST_F(RpcRendezvousMgrTest, PrefetchRemote) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:0", "foo", FrameAndIter(0, 0)));
+  {
+    RemoteRendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    Rendezvous::Args args;
+    rendez->PrefetchRemoteAsync(key, args);
+    EXPECT_EQ(1, cache_->num_create_worker_calls);
+    // The Recv completes with the result of the prefetch, which fails
+    // because task:3 is unknown, without contacting the worker again.
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    Status s = rendez->Recv(key, args, &val, &val_dead);
+    EXPECT_TRUE(errors::IsInternal(s)) << s;
+    EXPECT_EQ(1, cache_->num_create_worker_calls);
+    // Prefetches after the step has started receiving are ignored.
+    rendez->PrefetchRemoteAsync(key, args);
+    EXPECT_EQ(1, cache_->num_create_worker_calls);
+  }
+  rmgr_.Cleanup(step_id);
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
@@ -18,11 +18,46 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 
 namespace tensorflow {
 
+// A TensorBuffer aliasing tensor contents within a received message, which
+// is kept alive by "holder".
+class RecvTensorBuffer : public TensorBuffer {
+ public:
+  RecvTensorBuffer(core::RefCounted* holder, const char* data, size_t len)
+      : holder_(holder), data_(const_cast<char*>(data)), len_(len) {
+    holder_->Ref();
+  }
+
+  ~RecvTensorBuffer() override { holder_->Unref(); }
+
+  void* data() const override { return data_; }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("RecvTensorResponse");
+  }
+
+  // The memory belongs to the message, so it must not be forwarded to an
+  // op output and overwritten.
+  bool OwnsMemory() const override { return false; }
+
+  Tensor MakeTensor(DataType dtype, const TensorShape& shape) {
+    CHECK_EQ(len_, shape.num_elements() * DataTypeSize(dtype));
+    return Tensor(dtype, shape, this);
+  }
+
+ private:
+  core::RefCounted* holder_;
+  char* data_;
+  size_t len_;
+};
+
 TensorResponse::Source::~Source() {}
 
 void TensorResponse::Clear() {
@@ -143,8 +178,23 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 
 }  // namespace
 
+bool TensorResponse::CanAliasContent(const char* data) const {
+  // Memory that a device may DMA from or to must come from allocator_.
+  if (!on_host_ || alloc_attrs_.gpu_compatible() ||
+      alloc_attrs_.nic_compatible()) {
+    return false;
+  }
+#if EIGEN_MAX_ALIGN_BYTES > 0
+  if (reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return false;
+  }
+#endif
+  return true;
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    const char* base, core::RefCounted* holder) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -195,12 +245,26 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (base != nullptr && num_bytes > 0) {
+          // The contents are already in memory that outlives the message,
+          // so alias them if they are properly aligned.
+          const char* content = base + input->CurrentPosition();
+          if (CanAliasContent(content)) {
+            if (static_cast<int64>(num_bytes) !=
+                shape.num_elements() * DataTypeSize(tensor_meta->dtype())) {
+              return false;
+            }
+            if (!input->Skip(num_bytes)) return false;
+            RecvTensorBuffer* buf =
+                new RecvTensorBuffer(holder, content, num_bytes);
+            tensor_ = buf->MakeTensor(tensor_meta->dtype(), shape);
+            buf->Unref();
+            break;
+          }
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -216,10 +280,27 @@ bool TensorResponse::ParseTensorSubmessage(
 }
 
 bool TensorResponse::ParseFast(Source* source) {
+  StringPiece data;
+  core::RefCounted* holder = nullptr;
+  if (source->GetContiguousBuffer(&data, &holder)) {
+    core::ScopedUnref unref(holder);
+    if (data.size() <= static_cast<size_t>(INT_MAX)) {
+      protobuf::io::CodedInputStream input(
+          reinterpret_cast<const uint8*>(data.data()),
+          static_cast<int>(data.size()));
+      return ParseFastFrom(&input, data.data(), holder);
+    }
+  }
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+  return ParseFastFrom(&input, nullptr, nullptr);
+}
+
+bool TensorResponse::ParseFastFrom(protobuf::io::CodedInputStream* input,
+                                   const char* base,
+                                   core::RefCounted* holder) {
   while (true) {
-    auto p = input.ReadTagWithCutoff(127);
+    auto p = input->ReadTagWithCutoff(127);
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
@@ -230,33 +311,34 @@ bool TensorResponse::ParseFast(Source* source) {
         if (wt != WIRETYPE_LENGTH_DELIMITED) return false;
 
         int length;
-        if (!ReadVarintSizeAsInt(&input, &length)) return false;
+        if (!ReadVarintSizeAsInt(input, &length)) return false;
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
-            input.IncrementRecursionDepthAndPushLimit(length);
+            input->IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(input, meta_.mutable_tensor(), base,
+                                   holder)) {
           return false;
         }
-        if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
+        if (!input->DecrementRecursionDepthAndPopLimit(p.first)) {
           return false;
         }
         break;
       }
       case RecvTensorResponse::kIsDeadFieldNumber: {
         uint32 v;
-        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        if ((wt != WIRETYPE_VARINT) || !input->ReadVarint32(&v)) return false;
         meta_.set_is_dead((v != 0) ? true : false);
         break;
       }
       case RecvTensorResponse::kSendStartMicrosFieldNumber: {
         protobuf_uint64 v;
-        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) return false;
+        if ((wt != WIRETYPE_VARINT) || !input->ReadVarint64(&v)) return false;
         meta_.set_send_start_micros(static_cast<int64>(v));
         break;
       }
       case RecvTensorResponse::kTransportOptionsFieldNumber: {
         if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
-            !ReadNestedMessage(&input, meta_.mutable_transport_options()))
+            !ReadNestedMessage(input, meta_.mutable_transport_options()))
           return false;
         break;
       }
@@ -18,7 +18,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -64,6 +66,18 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // If the serialized RecvTensorResponse is held in a single contiguous
+    // block of memory, sets "*data" to that block and "*holder" to a new
+    // reference on an object that keeps it alive, and returns true.  The
+    // caller must Unref() "*holder".  ParseFrom then aliases suitably
+    // aligned tensor contents instead of copying them.
+    //
+    // The default implementation returns false.
+    virtual bool GetContiguousBuffer(StringPiece* data,
+                                     core::RefCounted** holder) {
+      return false;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -88,9 +102,17 @@ class TensorResponse {
   const RecvTensorResponse& metadata() const { return meta_; }
 
  private:
+  // If "base" is non-null, "input" reads from the contiguous buffer at
+  // "base", which is kept alive by "holder".
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
+                             TensorProto* tensor_meta, const char* base,
+                             core::RefCounted* holder);
   bool ParseFast(Source* source);
+  bool ParseFastFrom(protobuf::io::CodedInputStream* input, const char* base,
+                     core::RefCounted* holder);
+  // Returns true if tensor contents at "data" may be aliased rather than
+  // copied into memory from allocator_.
+  bool CanAliasContent(const char* data) const;
   bool ParseSlow(Source* source);
 
   bool on_host_ = false;
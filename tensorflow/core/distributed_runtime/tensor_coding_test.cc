@@ -15,13 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -72,6 +76,47 @@ class StringSource : public TensorResponse::Source {
   int block_size_;
 };
 
+// Holds a copy of a serialized message in aligned memory, placed so that
+// the bytes at "aligned_offset" start on an EIGEN_MAX_ALIGN_BYTES boundary
+// (or one byte past it if "misalign" is true).
+class AlignedMessage : public core::RefCounted {
+ public:
+  AlignedMessage(const string& s, size_t aligned_offset, bool misalign) {
+    const size_t alignment = std::max(EIGEN_MAX_ALIGN_BYTES, 1);
+    const size_t pad = (alignment - aligned_offset % alignment) % alignment +
+                       (misalign ? 1 : 0);
+    mem_ = static_cast<char*>(
+        port::AlignedMalloc(pad + s.size() + 1, static_cast<int>(alignment)));
+    memcpy(mem_ + pad, s.data(), s.size());
+    data_ = StringPiece(mem_ + pad, s.size());
+  }
+  ~AlignedMessage() override { port::AlignedFree(mem_); }
+
+  StringPiece data() const { return data_; }
+
+ private:
+  char* mem_;
+  StringPiece data_;
+};
+
+// A Source whose message is contiguous in memory.
+class ContiguousSource : public StringSource {
+ public:
+  ContiguousSource(const string* s, AlignedMessage* msg)
+      : StringSource(s, -1), msg_(msg) {}
+
+  bool GetContiguousBuffer(StringPiece* data,
+                           core::RefCounted** holder) override {
+    msg_->Ref();
+    *data = msg_->data();
+    *holder = msg_;
+    return true;
+  }
+
+ private:
+  AlignedMessage* msg_;  // Not owned.
+};
+
 class TensorResponseTest : public ::testing::Test {
  public:
   void Validate(const Tensor& src, bool is_dead, bool use_tensor_content) {
@@ -156,6 +201,59 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, AliasContiguousContent) {
+  Tensor src(DT_FLOAT, TensorShape({4, 100}));
+  test::FillIota<float>(&src, 1.0f);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  const size_t content_offset = encoded.find(src.tensor_data().ToString());
+  ASSERT_NE(content_offset, string::npos);
+
+  DummyDevice cpu_device(Env::Default());
+  for (bool misalign : {false, true}) {
+    AlignedMessage* msg = new AlignedMessage(encoded, content_offset, misalign);
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    {
+      ContiguousSource source(&encoded, msg);
+      TF_EXPECT_OK(response.ParseFrom(&source));
+    }
+    const char* content = msg->data().data() + content_offset;
+    msg->Unref();  // The response keeps the message alive if it aliases it.
+    const Tensor& result = response.tensor();
+    // Only aligned contents are aliased; others are copied.
+    EXPECT_EQ(!misalign || EIGEN_MAX_ALIGN_BYTES <= 1,
+              result.tensor_data().data() == content);
+    test::ExpectTensorEqual<float>(src, result);
+  }
+}
+
+TEST_F(TensorResponseTest, NoAliasForDeviceCompatibleMemory) {
+  Tensor src(DT_INT32, TensorShape({64}));
+  test::FillIota<int32>(&src, 0);
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  const size_t content_offset = encoded.find(src.tensor_data().ToString());
+  ASSERT_NE(content_offset, string::npos);
+
+  AlignedMessage* msg = new AlignedMessage(encoded, content_offset, false);
+  core::ScopedUnref unref(msg);
+  DummyDevice cpu_device(Env::Default());
+  AllocatorAttributes attrs;
+  attrs.set_gpu_compatible(true);
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, attrs);
+  ContiguousSource source(&encoded, msg);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_NE(response.tensor().tensor_data().data(),
+            msg->data().data() + content_offset);
+  test::ExpectTensorEqual<int32>(src, response.tensor());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -191,6 +289,30 @@ static void BM_TensorResponse(int iters, int arg) {
 }
 BENCHMARK(BM_TensorResponse)->Arg(0)->Arg(1000)->Arg(100000);
 
+static void BM_TensorResponseContiguous(int iters, int arg) {
+  testing::StopTiming();
+  string encoded = MakeFloatTensorTestCase(arg);
+  // The tensor contents are followed only by send_start_micros.
+  const size_t content_offset = encoded.size() - arg - 4;
+  AlignedMessage* msg = new AlignedMessage(encoded, content_offset, false);
+  DummyDevice cpu_device(Env::Default());
+  testing::BytesProcessed(static_cast<int64>(iters) * arg);
+  testing::StartTiming();
+  while (--iters > 0) {
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    ContiguousSource source(&encoded, msg);
+    Status s = response.ParseFrom(&source);
+    if (iters == 1) {
+      testing::SetLabel(
+          strings::StrCat("Bytes: ", response.tensor().TotalBytes()));
+    }
+  }
+  testing::StopTiming();
+  msg->Unref();
+}
+BENCHMARK(BM_TensorResponseContiguous)->Arg(0)->Arg(1000)->Arg(100000);
+
 static void BM_TensorViaTensorProto(int iters, int arg) {
   testing::StopTiming();
   string encoded = MakeFloatTensorTestCase(arg);
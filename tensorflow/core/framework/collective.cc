@@ -21,6 +21,11 @@ limitations under the License.
 
 namespace tensorflow {
 
+const char* const kAutoSelectName = "auto";
+const char* const kRingReduceName = "RingReduce";
+const char* const kHalvingDoublingReduceName = "HalvingDoublingReduce";
+const char* const kHierarchicalReduceName = "HierarchicalReduce";
+
 string CollGroupParams::ToString() const {
   return strings::StrCat("CollGroupParams {group_key=", group_key,
                          " group_size=", group_size,
@@ -39,6 +44,7 @@ CollInstanceParams& CollInstanceParams::operator=(
     device_names.assign(other.device_names.begin(), other.device_names.end());
     task_names.assign(other.task_names.begin(), other.task_names.end());
     same_num_devices_per_task = other.same_num_devices_per_task;
+    impl_details.collective_name = other.impl_details.collective_name;
     impl_details.subdiv_offsets.assign(
         other.impl_details.subdiv_offsets.begin(),
         other.impl_details.subdiv_offsets.end());
@@ -65,7 +71,8 @@ string CollInstanceParams::ToString() const {
   for (const auto& n : task_names) {
     strings::StrAppend(&v, n, ", ");
   }
-  strings::StrAppend(&v, "}, subdiv_offsets={");
+  strings::StrAppend(&v, "}, collective_name=",
+                     impl_details.collective_name, ", subdiv_offsets={");
   for (const auto& d : impl_details.subdiv_offsets) {
     strings::StrAppend(&v, d, ",");
   }
@@ -40,6 +40,8 @@ class Tensor;
 enum CollectiveType {
   REDUCTION_COLLECTIVE = 0,
   BROADCAST_COLLECTIVE,
+  GATHER_COLLECTIVE,
+  REDUCE_SCATTER_COLLECTIVE,
   UNDEFINED_COLLECTIVE,
 };
 
@@ -64,12 +66,23 @@ struct CollGroupParams {
 // interpretation.  On first execution the runtime will update this
 // structure with decisions that will guide all subsequent executions.
 struct CollImplDetails {
+  // Name of the algorithm implementing the collective, e.g.
+  // kRingReduceName.  When empty or kAutoSelectName the
+  // ParamResolverInterface picks one on first execution.
+  string collective_name;
   std::vector<std::vector<int>> subdiv_permutations;
   std::vector<int> subdiv_offsets;
   // broadcast only: rank of source in each subdiv
   std::vector<int> subdiv_source_rank;
 };
 
+// Names of the available collective algorithms, for use in
+// CollImplDetails::collective_name.
+extern const char* const kAutoSelectName;
+extern const char* const kRingReduceName;
+extern const char* const kHalvingDoublingReduceName;
+extern const char* const kHierarchicalReduceName;
+
 // Data common to all members of a collective instance.
 struct CollInstanceParams {
   // Identifies all participating graph nodes.
@@ -106,8 +119,8 @@ struct CollectiveParams {
   bool is_source = false;  // broadcast only
   // Rank of this device in each subdivision permutation.
   std::vector<int> subdiv_rank;
-  std::unique_ptr<OpKernel> merge_op;  // reduction only
-  std::unique_ptr<OpKernel> final_op;  // reduction only
+  std::unique_ptr<OpKernel> merge_op;  // reduction and reduce-scatter only
+  std::unique_ptr<OpKernel> final_op;  // reduction and reduce-scatter only
   string ToString() const;
 };
 
@@ -239,6 +252,19 @@ class PeerAccessInterface {
 
 class PerStepCollectiveRemoteAccess;
 
+// Interface implemented by each algorithm that moves data for a
+// collective op, e.g. RingReducer.  An instance is created for a
+// single execution by a single device, and Run must be invoked from a
+// thread that may block.
+class CollectiveImplementationInterface {
+ public:
+  virtual ~CollectiveImplementationInterface() {}
+
+  // Executes the collective on behalf of one device, calling done
+  // when the output is complete or an error is encountered.
+  virtual void Run(StatusCallback done) = 0;
+};
+
 // A step-specific object that can execute a collective operation completely
 // described by a CollectiveParams object.
 class CollectiveExecutor : public PeerAccessInterface, public core::RefCounted {
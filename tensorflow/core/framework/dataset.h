@@ -22,6 +22,8 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset_stateful_op_whitelist.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/iterator_metrics.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -259,6 +261,12 @@ class IteratorContext {
     // Function call support.
     std::function<void(std::function<void()>)> runner = nullptr;
 
+    // True if `runner` was installed by a dataset, e.g. to run the input
+    // pipeline on a private thread pool, rather than taken from the op that
+    // created the iterator. Iterators that would otherwise move their work to
+    // a shared thread pool keep using such a runner.
+    bool runner_overridden = false;
+
     // A function that returns the current `StatsAggregator` instance to be
     // used when recording statistics about the iterator.
     //
@@ -275,6 +283,11 @@ class IteratorContext {
 
     // The Allocator to be used to allocate the output of an iterator.
     std::function<Allocator*(AllocatorAttributes)> allocator_getter = nullptr;
+
+    // The model that chooses the parallelism of the iterators of the
+    // pipeline whose `num_parallel_calls` is `model::kAutoTune`. If null,
+    // such iterators use a fixed parallelism.
+    std::shared_ptr<model::Model> model = nullptr;
   };
 
   explicit IteratorContext(Params params) : params_(std::move(params)) {}
@@ -285,6 +298,8 @@ class IteratorContext {
     return &params_.runner;
   }
 
+  bool runner_overridden() const { return params_.runner_overridden; }
+
   std::shared_ptr<StatsAggregator> stats_aggregator() {
     if (params_.stats_aggregator_getter) {
       return params_.stats_aggregator_getter();
@@ -313,6 +328,12 @@ class IteratorContext {
     return params_.stats_aggregator_getter;
   }
 
+  std::shared_ptr<model::Model> model() { return params_.model; }
+
+  void set_model(std::shared_ptr<model::Model> model) {
+    params_.model = std::move(model);
+  }
+
  private:
   Params params_;
 };
@@ -509,7 +530,8 @@ class DatasetIterator : public IteratorBase {
     const string prefix;
   };
 
-  explicit DatasetIterator(const Params& params) : params_(params) {
+  explicit DatasetIterator(const Params& params)
+      : params_(params), metrics_(IteratorMetrics::Get(params.prefix)) {
     params_.dataset->Ref();
   }
 
@@ -532,7 +554,11 @@ class DatasetIterator : public IteratorBase {
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) final {
     tracing::ScopedActivity activity(params_.prefix);
+    IteratorMetrics::ScopedGetNext get_next(metrics_);
     Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
+    if (s.ok() && !*end_of_sequence) {
+      get_next.RecordElement(*out_tensors);
+    }
     if (TF_PREDICT_FALSE(errors::IsOutOfRange(s) && !*end_of_sequence)) {
       s = errors::Internal(
           "Iterator \"", params_.prefix,
@@ -559,8 +585,13 @@ class DatasetIterator : public IteratorBase {
     return strings::StrCat(prefix(), ":", name);
   }
 
+  // The metrics shared by the iterators with the same prefix, which
+  // iterators that buffer elements can use to record the buffer utilization.
+  IteratorMetrics* metrics() const { return metrics_; }
+
  private:
   Params params_;
+  IteratorMetrics* const metrics_;
 };
 
 // Encapsulates the work required to plug a DatasetBase into the core TensorFlow
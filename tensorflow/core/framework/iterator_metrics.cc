@@ -0,0 +1,216 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/iterator_metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+const char kLabel[] = "prefix";
+
+monitoring::Counter<1>* GetNextCallsCounter() {
+  static monitoring::Counter<1>* counter = monitoring::Counter<1>::New(
+      "/tensorflow/data/iterator/get_next_calls",
+      "The number of calls to GetNext() of dataset iterators.", kLabel);
+  return counter;
+}
+
+monitoring::Counter<1>* ElementsCounter() {
+  static monitoring::Counter<1>* counter = monitoring::Counter<1>::New(
+      "/tensorflow/data/iterator/elements",
+      "The number of elements produced by dataset iterators.", kLabel);
+  return counter;
+}
+
+monitoring::Counter<1>* BytesCounter() {
+  static monitoring::Counter<1>* counter = monitoring::Counter<1>::New(
+      "/tensorflow/data/iterator/bytes",
+      "The total size of the elements produced by dataset iterators.", kLabel);
+  return counter;
+}
+
+monitoring::Counter<1>* GetNextTimeCounter() {
+  static monitoring::Counter<1>* counter = monitoring::Counter<1>::New(
+      "/tensorflow/data/iterator/get_next_time_us",
+      "The wall time spent in GetNext() of dataset iterators.", kLabel);
+  return counter;
+}
+
+monitoring::Counter<1>* InputTimeCounter() {
+  static monitoring::Counter<1>* counter = monitoring::Counter<1>::New(
+      "/tensorflow/data/iterator/input_time_us",
+      "The part of the wall time spent in GetNext() of dataset iterators that "
+      "was spent in GetNext() of their input iterators.",
+      kLabel);
+  return counter;
+}
+
+monitoring::Sampler<1>* BufferUtilizationSampler() {
+  static monitoring::Sampler<1>* sampler = monitoring::Sampler<1>::New(
+      {"/tensorflow/data/iterator/buffer_utilization",
+       "The fraction of the buffer of dataset iterators that is occupied when "
+       "an element is taken from it.",
+       kLabel},
+      monitoring::Buckets::Explicit(
+          {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0}));
+  return sampler;
+}
+
+mutex registry_mu(LINKER_INITIALIZED);
+
+// All `IteratorMetrics`, by prefix.
+std::map<string, IteratorMetrics*>* Registry()
+    SHARED_LOCKS_REQUIRED(registry_mu) {
+  static std::map<string, IteratorMetrics*>* registry =
+      new std::map<string, IteratorMetrics*>;
+  return registry;
+}
+
+// Returns `prefix` with the digits of every index in brackets replaced with
+// a single `*`, e.g. "Iterator::FlatMap[*]::Map" for
+// "Iterator::FlatMap[12]::Map".
+string StripIndices(const string& prefix) {
+  string stripped;
+  stripped.reserve(prefix.size());
+  size_t i = 0;
+  while (i < prefix.size()) {
+    stripped.push_back(prefix[i]);
+    if (prefix[i++] != '[') continue;
+    size_t end = i;
+    while (end < prefix.size() && isdigit(prefix[end])) ++end;
+    if (end > i && end < prefix.size() && prefix[end] == ']') {
+      stripped.push_back('*');
+      i = end;
+    }
+  }
+  return stripped;
+}
+
+// The innermost `GetNext()` call in progress on this thread.
+thread_local IteratorMetrics::ScopedGetNext* current_get_next = nullptr;
+
+}  // namespace
+
+IteratorMetrics::IteratorMetrics(const string& prefix)
+    : prefix_(prefix),
+      get_next_calls_(GetNextCallsCounter()->GetCell(prefix)),
+      elements_(ElementsCounter()->GetCell(prefix)),
+      bytes_(BytesCounter()->GetCell(prefix)),
+      get_next_time_us_(GetNextTimeCounter()->GetCell(prefix)),
+      input_time_us_(InputTimeCounter()->GetCell(prefix)),
+      buffer_utilization_(BufferUtilizationSampler()->GetCell(prefix)) {}
+
+/* static */
+IteratorMetrics* IteratorMetrics::Get(const string& prefix) {
+  const string key = StripIndices(prefix);
+  {
+    // Iterators are mostly created for stages that already have metrics.
+    tf_shared_lock l(registry_mu);
+    auto it = Registry()->find(key);
+    if (it != Registry()->end()) return it->second;
+  }
+  mutex_lock l(registry_mu);
+  IteratorMetrics*& metrics = (*Registry())[key];
+  if (metrics == nullptr) {
+    metrics = new IteratorMetrics(key);
+  }
+  return metrics;
+}
+
+/* static */
+string IteratorMetrics::Report() {
+  std::vector<const IteratorMetrics*> all_metrics;
+  {
+    mutex_lock l(registry_mu);
+    for (const auto& entry : *Registry()) {
+      all_metrics.push_back(entry.second);
+    }
+  }
+  auto self_time_us = [](const IteratorMetrics* metrics) {
+    return metrics->get_next_time_us() - metrics->input_time_us();
+  };
+  std::stable_sort(
+      all_metrics.begin(), all_metrics.end(),
+      [&self_time_us](const IteratorMetrics* a, const IteratorMetrics* b) {
+        return self_time_us(a) > self_time_us(b);
+      });
+  string report = strings::Printf(
+      "%12s %12s %14s %12s %12s %12s %8s  %s\n", "calls", "elements",
+      "bytes", "total_ms", "input_ms", "self_ms", "buffer", "iterator");
+  for (const IteratorMetrics* metrics : all_metrics) {
+    const HistogramProto buffer_utilization =
+        metrics->buffer_utilization_->value();
+    string buffer = "-";
+    if (buffer_utilization.num() > 0) {
+      buffer = strings::Printf(
+          "%.2f", buffer_utilization.sum() / buffer_utilization.num());
+    }
+    strings::Appendf(
+        &report, "%12lld %12lld %14lld %12.1f %12.1f %12.1f %8s  %s\n",
+        static_cast<long long>(metrics->get_next_calls()),
+        static_cast<long long>(metrics->elements()),
+        static_cast<long long>(metrics->bytes()),
+        metrics->get_next_time_us() / 1000.0,
+        metrics->input_time_us() / 1000.0, self_time_us(metrics) / 1000.0,
+        buffer.c_str(), metrics->prefix().c_str());
+  }
+  return report;
+}
+
+IteratorMetrics::ScopedGetNext::ScopedGetNext(IteratorMetrics* metrics)
+    : metrics_(metrics),
+      parent_(current_get_next),
+      start_us_(Env::Default()->NowMicros()) {
+  current_get_next = this;
+}
+
+IteratorMetrics::ScopedGetNext::~ScopedGetNext() {
+  const uint64 duration_us = Env::Default()->NowMicros() - start_us_;
+  metrics_->get_next_calls_->IncrementBy(1);
+  metrics_->get_next_time_us_->IncrementBy(duration_us);
+  metrics_->input_time_us_->IncrementBy(input_time_us_);
+  if (parent_ != nullptr) {
+    parent_->input_time_us_ += duration_us;
+  }
+  current_get_next = parent_;
+}
+
+void IteratorMetrics::ScopedGetNext::RecordElement(
+    const std::vector<Tensor>& element) {
+  int64 bytes = 0;
+  for (const Tensor& t : element) {
+    bytes += t.TotalBytes();
+  }
+  metrics_->elements_->IncrementBy(1);
+  metrics_->bytes_->IncrementBy(bytes);
+}
+
+void IteratorMetrics::RecordBufferUtilization(int64 buffered, int64 capacity) {
+  if (capacity > 0) {
+    buffer_utilization_->Add(static_cast<double>(buffered) /
+                             static_cast<double>(capacity));
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,110 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_FRAMEWORK_ITERATOR_METRICS_H_
+#define TENSORFLOW_CORE_FRAMEWORK_ITERATOR_METRICS_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Always-on instrumentation of the `GetNext()` calls of dataset iterators,
+// exported through `monitoring` with the iterator prefix as label:
+//
+//  /tensorflow/data/iterator/get_next_calls
+//  /tensorflow/data/iterator/elements
+//  /tensorflow/data/iterator/bytes: total size of the returned tensors.
+//  /tensorflow/data/iterator/get_next_time_us: wall time spent in
+//      `GetNext()`.
+//  /tensorflow/data/iterator/input_time_us: the part of the wall time spent
+//      in `GetNext()` of input iterators called on the same thread.
+//  /tensorflow/data/iterator/buffer_utilization: the fraction of the buffer
+//      that is occupied when an element is taken from it, for iterators that
+//      buffer elements.
+//
+// The difference between the last two times is the time the iterator itself
+// spends producing elements or, for iterators with background threads,
+// waiting for them. The stage with the largest such time is the bottleneck
+// of a synchronous pipeline.
+//
+// All iterators with the same prefix, up to the indices in brackets that
+// nested iterators such as those of `flat_map()` and `interleave()` get for
+// each input element, share one `IteratorMetrics`. It is never deleted, but
+// there is only one for each stage of a pipeline. This class is thread-safe.
+class IteratorMetrics {
+ public:
+  // Returns the metrics of the iterators with prefix `prefix`, in which
+  // every index in brackets is replaced with `*`.
+  static IteratorMetrics* Get(const string& prefix);
+
+  // Returns a table of the metrics of all iterators, with one row per prefix
+  // in decreasing order of self time. The metrics are not collected on mobile
+  // platforms, where the table is all zeros.
+  static string Report();
+
+  // Records a `GetNext()` call of an iterator from construction to
+  // destruction, which must happen on the same thread.
+  class ScopedGetNext {
+   public:
+    explicit ScopedGetNext(IteratorMetrics* metrics);
+    ~ScopedGetNext();
+
+    // Records that the call returned `element`.
+    void RecordElement(const std::vector<Tensor>& element);
+
+   private:
+    IteratorMetrics* const metrics_;
+    // The enclosing call on this thread, if any, which is charged with the
+    // duration of this call as input time.
+    ScopedGetNext* const parent_;
+    const uint64 start_us_;
+    uint64 input_time_us_ = 0;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(ScopedGetNext);
+  };
+
+  // Records that an element was taken from a buffer holding `buffered`
+  // elements out of `capacity`.
+  void RecordBufferUtilization(int64 buffered, int64 capacity);
+
+  const string& prefix() const { return prefix_; }
+  int64 get_next_calls() const { return get_next_calls_->value(); }
+  int64 elements() const { return elements_->value(); }
+  int64 bytes() const { return bytes_->value(); }
+  int64 get_next_time_us() const { return get_next_time_us_->value(); }
+  int64 input_time_us() const { return input_time_us_->value(); }
+
+ private:
+  explicit IteratorMetrics(const string& prefix);
+
+  const string prefix_;
+  monitoring::CounterCell* const get_next_calls_;
+  monitoring::CounterCell* const elements_;
+  monitoring::CounterCell* const bytes_;
+  monitoring::CounterCell* const get_next_time_us_;
+  monitoring::CounterCell* const input_time_us_;
+  monitoring::SamplerCell* const buffer_utilization_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IteratorMetrics);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_ITERATOR_METRICS_H_
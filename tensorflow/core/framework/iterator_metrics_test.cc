@@ -0,0 +1,107 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/iterator_metrics.h"
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(IteratorMetricsTest, SharedByPrefix) {
+  EXPECT_EQ(IteratorMetrics::Get("Iterator::SharedByPrefix"),
+            IteratorMetrics::Get("Iterator::SharedByPrefix"));
+  EXPECT_NE(IteratorMetrics::Get("Iterator::SharedByPrefix"),
+            IteratorMetrics::Get("Iterator::SharedByPrefix::Map"));
+}
+
+TEST(IteratorMetricsTest, SharedByElementIndex) {
+  IteratorMetrics* metrics =
+      IteratorMetrics::Get("Iterator::SharedByElementIndex[0]::Map");
+  EXPECT_EQ("Iterator::SharedByElementIndex[*]::Map", metrics->prefix());
+  EXPECT_EQ(metrics,
+            IteratorMetrics::Get("Iterator::SharedByElementIndex[12]::Map"));
+  EXPECT_EQ(IteratorMetrics::Get("Iterator::SharedByElementIndex[3][45]"),
+            IteratorMetrics::Get("Iterator::SharedByElementIndex[6][7]"));
+  // Brackets that do not hold an index are kept.
+  EXPECT_EQ(
+      "Iterator::SharedByElementIndex[x]",
+      IteratorMetrics::Get("Iterator::SharedByElementIndex[x]")->prefix());
+}
+
+TEST(IteratorMetricsTest, RecordsElements) {
+  IteratorMetrics* metrics = IteratorMetrics::Get("Iterator::RecordsElements");
+  {
+    IteratorMetrics::ScopedGetNext get_next(metrics);
+    get_next.RecordElement({Tensor(DT_FLOAT, {2, 3}), Tensor(DT_INT64, {})});
+  }
+  {
+    // End of sequence.
+    IteratorMetrics::ScopedGetNext get_next(metrics);
+  }
+  EXPECT_EQ(2, metrics->get_next_calls());
+  EXPECT_EQ(1, metrics->elements());
+  EXPECT_EQ(2 * 3 * 4 + 8, metrics->bytes());
+}
+
+TEST(IteratorMetricsTest, ChargesNestedCallsAsInputTime) {
+  IteratorMetrics* outer = IteratorMetrics::Get("Iterator::Nested");
+  IteratorMetrics* inner = IteratorMetrics::Get("Iterator::Nested::Range");
+  {
+    IteratorMetrics::ScopedGetNext outer_get_next(outer);
+    {
+      IteratorMetrics::ScopedGetNext inner_get_next(inner);
+      Env::Default()->SleepForMicros(2000);
+    }
+    Env::Default()->SleepForMicros(1000);
+  }
+  EXPECT_EQ(0, inner->input_time_us());
+  EXPECT_GE(inner->get_next_time_us(), 2000);
+  EXPECT_EQ(inner->get_next_time_us(), outer->input_time_us());
+  EXPECT_GE(outer->get_next_time_us() - outer->input_time_us(), 1000);
+
+  // Calls after the outer one has returned are not charged to it.
+  {
+    IteratorMetrics::ScopedGetNext inner_get_next(inner);
+    Env::Default()->SleepForMicros(100);
+  }
+  EXPECT_LT(outer->input_time_us(), inner->get_next_time_us());
+}
+
+TEST(IteratorMetricsTest, Report) {
+  IteratorMetrics* fast = IteratorMetrics::Get("Iterator::Report::Fast");
+  IteratorMetrics* slow = IteratorMetrics::Get("Iterator::Report::Slow");
+  {
+    IteratorMetrics::ScopedGetNext get_next(slow);
+    Env::Default()->SleepForMicros(1000);
+  }
+  {
+    IteratorMetrics::ScopedGetNext get_next(fast);
+  }
+  slow->RecordBufferUtilization(1, 4);
+  slow->RecordBufferUtilization(3, 4);
+
+  const string report = IteratorMetrics::Report();
+  const size_t slow_pos = report.find("Iterator::Report::Slow");
+  const size_t fast_pos = report.find("Iterator::Report::Fast");
+  ASSERT_NE(string::npos, slow_pos);
+  ASSERT_NE(string::npos, fast_pos);
+  // Iterators are listed in decreasing order of self time.
+  EXPECT_LT(slow_pos, fast_pos);
+  EXPECT_NE(string::npos, report.find("0.50  Iterator::Report::Slow"));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,208 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/model.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace model {
+
+Node::Node(const string& name, bool tunable, int64 parallelism,
+           int64 max_parallelism, std::function<void()> on_change,
+           std::function<std::shared_ptr<StatsAggregator>()>
+               stats_aggregator_getter)
+    : name_(name),
+      tunable_(tunable),
+      max_parallelism_(std::max<int64>(max_parallelism, 1)),
+      on_change_(std::move(on_change)),
+      stats_aggregator_getter_(std::move(stats_aggregator_getter)),
+      parallelism_(parallelism) {}
+
+void Node::RecordElement(int64 processing_time_us) {
+  num_elements_.fetch_add(1);
+  processing_time_us_.fetch_add(processing_time_us);
+}
+
+void Node::RecordGetNext(int64 wait_time_us, int64 buffered) {
+  num_get_next_.fetch_add(1);
+  wait_time_us_.fetch_add(wait_time_us);
+  buffered_.fetch_add(buffered);
+}
+
+void Node::SetParallelism(int64 parallelism) {
+  if (parallelism_.exchange(parallelism) != parallelism && on_change_) {
+    on_change_();
+  }
+}
+
+void Node::ExportStats() {
+  if (!stats_aggregator_getter_) return;
+  std::shared_ptr<StatsAggregator> stats_aggregator =
+      stats_aggregator_getter_();
+  if (!stats_aggregator) return;
+  stats_aggregator->AddScalar(strings::StrCat(name_, "::parallelism"),
+                              static_cast<float>(parallelism()));
+  const int64 num_elements = num_elements_.load();
+  if (num_elements > 0) {
+    stats_aggregator->AddScalar(
+        strings::StrCat(name_, "::processing_time_us"),
+        static_cast<float>(processing_time_us_.load()) / num_elements);
+  }
+  const int64 num_get_next = num_get_next_.load();
+  if (num_get_next > 0) {
+    stats_aggregator->AddScalar(
+        strings::StrCat(name_, "::wait_time_us"),
+        static_cast<float>(wait_time_us_.load()) / num_get_next);
+    stats_aggregator->AddScalar(
+        strings::StrCat(name_, "::buffered"),
+        static_cast<float>(buffered_.load()) / num_get_next);
+  }
+}
+
+constexpr int64 Model::kDefaultOptimizationPeriodMs;
+
+Model::Model(int64 optimization_period_ms)
+    : optimization_period_ms_(optimization_period_ms) {}
+
+Model::~Model() {
+  std::unique_ptr<Thread> optimization_thread;
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+    optimization_thread = std::move(optimization_thread_);
+  }
+  // Joins the optimization thread, if any.
+  optimization_thread.reset();
+}
+
+std::shared_ptr<Node> Model::AddNode(
+    const string& name, int64 max_parallelism,
+    std::function<void()> on_change,
+    std::function<std::shared_ptr<StatsAggregator>()>
+        stats_aggregator_getter) {
+  std::shared_ptr<Node> node(new Node(name, true /* tunable */, 1,
+                                      max_parallelism, std::move(on_change),
+                                      std::move(stats_aggregator_getter)));
+  mutex_lock l(mu_);
+  AddNodeLocked(node);
+  return node;
+}
+
+std::shared_ptr<Node> Model::AddFixedNode(
+    const string& name, int64 parallelism,
+    std::function<std::shared_ptr<StatsAggregator>()>
+        stats_aggregator_getter) {
+  std::shared_ptr<Node> node(new Node(name, false /* tunable */, parallelism,
+                                      parallelism, nullptr,
+                                      std::move(stats_aggregator_getter)));
+  mutex_lock l(mu_);
+  AddNodeLocked(node);
+  return node;
+}
+
+void Model::AddNodeLocked(std::shared_ptr<Node> node) {
+  // Pipelines without tunable nodes have nothing to optimize.
+  const bool tunable = node->tunable();
+  nodes_.push_back(std::move(node));
+  if (tunable && optimization_period_ms_ > 0 && !optimization_thread_) {
+    optimization_thread_.reset(Env::Default()->StartThread(
+        {}, "tf_data_model", [this]() { OptimizationThread(); }));
+  }
+}
+
+void Model::RemoveNode(const std::shared_ptr<Node>& node) {
+  mutex_lock l(mu_);
+  nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), node),
+               nodes_.end());
+}
+
+void Model::Optimize(int64 cpu_budget) {
+  mutex_lock l(mu_);
+  OptimizeLocked(cpu_budget);
+}
+
+void Model::OptimizeLocked(int64 cpu_budget) {
+  // Whether each node has produced elements, and if so their average
+  // processing time. The statistics keep changing concurrently, so they
+  // are read once.
+  std::vector<bool> measured(nodes_.size(), false);
+  std::vector<double> processing_time(nodes_.size(), 0.0);
+  std::vector<int64> parallelism(nodes_.size(), 1);
+  int64 remaining = cpu_budget;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const int64 num_elements = nodes_[i]->num_elements();
+    if (nodes_[i]->tunable() && num_elements > 0) {
+      measured[i] = true;
+      processing_time[i] =
+          static_cast<double>(nodes_[i]->processing_time_us()) / num_elements;
+      remaining -= 1;
+    } else {
+      // The parallelism of fixed nodes cannot change, and without
+      // statistics there is nothing to base a decision on.
+      parallelism[i] = nodes_[i]->parallelism();
+      remaining -= parallelism[i];
+    }
+  }
+  while (remaining > 0) {
+    // Find the measured stage with the lowest throughput that can still
+    // use another worker.
+    int bottleneck = -1;
+    double bottleneck_throughput = 0.0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (!measured[i] || parallelism[i] >= nodes_[i]->max_parallelism()) {
+        continue;
+      }
+      // Stages that take no measurable time are never the bottleneck.
+      const double throughput =
+          processing_time[i] > 0 ? parallelism[i] / processing_time[i]
+                                 : std::numeric_limits<double>::infinity();
+      if (bottleneck == -1 || throughput < bottleneck_throughput) {
+        bottleneck = i;
+        bottleneck_throughput = throughput;
+      }
+    }
+    if (bottleneck == -1) break;
+    ++parallelism[bottleneck];
+    --remaining;
+  }
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (measured[i]) {
+      VLOG(2) << "Setting parallelism of " << nodes_[i]->name() << " to "
+              << parallelism[i];
+      nodes_[i]->SetParallelism(parallelism[i]);
+    }
+    nodes_[i]->ExportStats();
+  }
+}
+
+void Model::OptimizationThread() {
+  const int64 cpu_budget = port::NumSchedulableCPUs();
+  mutex_lock l(mu_);
+  while (!cancelled_) {
+    WaitForMilliseconds(&l, &cond_var_, optimization_period_ms_);
+    if (cancelled_) break;
+    OptimizeLocked(cpu_budget);
+  }
+}
+
+}  // namespace model
+}  // namespace tensorflow
@@ -0,0 +1,175 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
+#define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace model {
+
+// Value of a parallelism argument (e.g. `num_parallel_calls`) that asks
+// the model to choose the parallelism of the iterator.
+constexpr int64 kAutoTune = -1;
+
+// A `Node` is a parallel stage of an input pipeline. The iterator
+// implementing the stage records how long it takes to produce each element
+// and how long its consumer waits for elements. If the node is tunable,
+// the iterator reads `parallelism()` to decide how many elements to
+// produce concurrently; otherwise the parallelism is fixed and only counts
+// against the CPU budget of the model.
+//
+// This class is thread-safe.
+class Node {
+ public:
+  Node(const string& name, bool tunable, int64 parallelism,
+       int64 max_parallelism, std::function<void()> on_change,
+       std::function<std::shared_ptr<StatsAggregator>()>
+           stats_aggregator_getter);
+
+  // The name of the node, typically the prefix of its iterator.
+  const string& name() const { return name_; }
+
+  // Whether the model chooses the parallelism of the node.
+  bool tunable() const { return tunable_; }
+
+  // The parallelism that the iterator should currently use.
+  int64 parallelism() const { return parallelism_.load(); }
+
+  int64 max_parallelism() const { return max_parallelism_; }
+
+  // Records that an element took `processing_time_us` of single-threaded
+  // work to produce.
+  void RecordElement(int64 processing_time_us);
+
+  // Records that a consumer of the iterator waited `wait_time_us` for an
+  // element while `buffered` elements were ready.
+  void RecordGetNext(int64 wait_time_us, int64 buffered);
+
+  // Statistics accumulated since the node was created.
+  int64 num_elements() const { return num_elements_.load(); }
+  int64 processing_time_us() const { return processing_time_us_.load(); }
+  int64 num_get_next() const { return num_get_next_.load(); }
+  int64 wait_time_us() const { return wait_time_us_.load(); }
+  int64 buffered() const { return buffered_.load(); }
+
+ private:
+  friend class Model;
+
+  // Sets the parallelism and notifies the iterator if it changed.
+  void SetParallelism(int64 parallelism);
+
+  // Reports the current parallelism and statistics to the stats
+  // aggregator of the iterator, if any.
+  void ExportStats();
+
+  const string name_;
+  const bool tunable_;
+  const int64 max_parallelism_;
+  const std::function<void()> on_change_;
+  const std::function<std::shared_ptr<StatsAggregator>()>
+      stats_aggregator_getter_;
+  std::atomic<int64> parallelism_;
+  std::atomic<int64> num_elements_{0};
+  std::atomic<int64> processing_time_us_{0};
+  std::atomic<int64> num_get_next_{0};
+  std::atomic<int64> wait_time_us_{0};
+  std::atomic<int64> buffered_{0};
+};
+
+// A `Model` divides a CPU budget among the tunable stages of an input
+// pipeline. One model is shared by all iterators created from the same
+// `IteratorResource`, so that the parallelism of each stage is chosen
+// with respect to the whole pipeline rather than in isolation.
+//
+// Each stage is modeled as a pool of `p` workers that each produce one
+// element every `t` seconds, where `t` is the measured average processing
+// time of the stage. The throughput of the pipeline is limited by its
+// slowest stage, so `Optimize()` repeatedly gives one more worker to the
+// stage with the lowest throughput `p / t` until the budget is used up.
+//
+// When the first tunable node is added, the model starts a background
+// thread that calls `Optimize()` every `optimization_period_ms` with the
+// number of schedulable CPUs as the budget. `Optimize()` exports the
+// parallelism and statistics of each node through the `StatsAggregator`
+// of its iterator, as "<name>::parallelism", "<name>::processing_time_us",
+// "<name>::wait_time_us" and "<name>::buffered".
+//
+// This class is thread-safe.
+class Model {
+ public:
+  static constexpr int64 kDefaultOptimizationPeriodMs = 100;
+
+  // If `optimization_period_ms` is 0, `Optimize()` is only called
+  // explicitly.
+  explicit Model(int64 optimization_period_ms = kDefaultOptimizationPeriodMs);
+  ~Model();
+
+  // Adds a tunable node to the model. `on_change` is invoked, while the
+  // model holds an internal lock, whenever the parallelism of the node
+  // changes; it must not call back into the model. The node initially has
+  // parallelism 1, and its parallelism never exceeds `max_parallelism`.
+  //
+  // The caller must call `RemoveNode()` before `on_change` becomes
+  // invalid.
+  std::shared_ptr<Node> AddNode(
+      const string& name, int64 max_parallelism,
+      std::function<void()> on_change,
+      std::function<std::shared_ptr<StatsAggregator>()>
+          stats_aggregator_getter);
+
+  // Adds a node whose parallelism is fixed to `parallelism`, which is
+  // deducted from the budget of the tunable nodes.
+  std::shared_ptr<Node> AddFixedNode(
+      const string& name, int64 parallelism,
+      std::function<std::shared_ptr<StatsAggregator>()>
+          stats_aggregator_getter);
+
+  // Removes `node` from the model. After this method returns, the
+  // `on_change` callback of `node` will not be invoked again.
+  void RemoveNode(const std::shared_ptr<Node>& node);
+
+  // Redistributes `cpu_budget` among the tunable nodes of the model, based
+  // on the statistics recorded so far. Fixed nodes, and tunable nodes that
+  // have not produced an element yet, keep their current parallelism.
+  void Optimize(int64 cpu_budget);
+
+ private:
+  void AddNodeLocked(std::shared_ptr<Node> node)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void OptimizeLocked(int64 cpu_budget) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void OptimizationThread();
+
+  const int64 optimization_period_ms_;
+  mutex mu_;
+  condition_variable cond_var_;
+  std::vector<std::shared_ptr<Node>> nodes_ GUARDED_BY(mu_);
+  std::unique_ptr<Thread> optimization_thread_ GUARDED_BY(mu_);
+  bool cancelled_ GUARDED_BY(mu_) = false;
+};
+
+}  // namespace model
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
@@ -0,0 +1,133 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/model.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace model {
+namespace {
+
+// Records `num_elements` elements that took `processing_time_us` each.
+void RecordElements(Node* node, int64 num_elements, int64 processing_time_us) {
+  for (int64 i = 0; i < num_elements; ++i) {
+    node->RecordElement(processing_time_us);
+  }
+}
+
+TEST(ModelTest, BudgetGoesToBottleneck) {
+  Model model(0);
+  std::shared_ptr<Node> fast = model.AddNode("fast", 16, nullptr, nullptr);
+  std::shared_ptr<Node> slow = model.AddNode("slow", 16, nullptr, nullptr);
+  RecordElements(fast.get(), 10, 100);
+  RecordElements(slow.get(), 10, 300);
+
+  model.Optimize(8);
+  // Both stages then produce an element every 50us.
+  EXPECT_EQ(2, fast->parallelism());
+  EXPECT_EQ(6, slow->parallelism());
+}
+
+TEST(ModelTest, FixedNodesUseBudget) {
+  Model model(0);
+  std::shared_ptr<Node> fixed = model.AddFixedNode("fixed", 4, nullptr);
+  std::shared_ptr<Node> tunable =
+      model.AddNode("tunable", 16, nullptr, nullptr);
+  RecordElements(fixed.get(), 10, 100);
+  RecordElements(tunable.get(), 10, 100);
+
+  model.Optimize(6);
+  EXPECT_EQ(4, fixed->parallelism());
+  EXPECT_EQ(2, tunable->parallelism());
+
+  model.RemoveNode(fixed);
+  model.Optimize(6);
+  EXPECT_EQ(6, tunable->parallelism());
+}
+
+TEST(ModelTest, MaxParallelism) {
+  Model model(0);
+  std::shared_ptr<Node> capped = model.AddNode("capped", 2, nullptr, nullptr);
+  std::shared_ptr<Node> other = model.AddNode("other", 16, nullptr, nullptr);
+  RecordElements(capped.get(), 10, 1000);
+  RecordElements(other.get(), 10, 100);
+
+  model.Optimize(8);
+  EXPECT_EQ(2, capped->parallelism());
+  EXPECT_EQ(6, other->parallelism());
+}
+
+TEST(ModelTest, UnmeasuredNodesKeepParallelism) {
+  Model model(0);
+  std::shared_ptr<Node> unmeasured =
+      model.AddNode("unmeasured", 16, nullptr, nullptr);
+  std::shared_ptr<Node> measured =
+      model.AddNode("measured", 16, nullptr, nullptr);
+  RecordElements(measured.get(), 10, 100);
+
+  model.Optimize(4);
+  EXPECT_EQ(1, unmeasured->parallelism());
+  EXPECT_EQ(3, measured->parallelism());
+}
+
+TEST(ModelTest, SmallBudget) {
+  Model model(0);
+  std::shared_ptr<Node> a = model.AddNode("a", 16, nullptr, nullptr);
+  std::shared_ptr<Node> b = model.AddNode("b", 16, nullptr, nullptr);
+  RecordElements(a.get(), 10, 100);
+  RecordElements(b.get(), 10, 100);
+
+  // Every stage needs at least one worker to make progress.
+  model.Optimize(1);
+  EXPECT_EQ(1, a->parallelism());
+  EXPECT_EQ(1, b->parallelism());
+}
+
+TEST(ModelTest, OnChange) {
+  Model model(0);
+  int num_changes = 0;
+  std::shared_ptr<Node> node = model.AddNode(
+      "node", 16, [&num_changes]() { ++num_changes; }, nullptr);
+  RecordElements(node.get(), 10, 100);
+
+  model.Optimize(4);
+  EXPECT_EQ(4, node->parallelism());
+  EXPECT_EQ(1, num_changes);
+
+  // The callback is only invoked if the parallelism changes.
+  model.Optimize(4);
+  EXPECT_EQ(1, num_changes);
+
+  model.RemoveNode(node);
+  model.Optimize(2);
+  EXPECT_EQ(4, node->parallelism());
+  EXPECT_EQ(1, num_changes);
+}
+
+TEST(ModelTest, RecordGetNext) {
+  Model model(0);
+  std::shared_ptr<Node> node = model.AddNode("node", 16, nullptr, nullptr);
+  node->RecordGetNext(10, 2);
+  node->RecordGetNext(30, 4);
+  EXPECT_EQ(2, node->num_get_next());
+  EXPECT_EQ(40, node->wait_time_us());
+  EXPECT_EQ(6, node->buffered());
+  EXPECT_EQ(0, node->num_elements());
+}
+
+}  // namespace
+}  // namespace model
+}  // namespace tensorflow
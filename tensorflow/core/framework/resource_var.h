@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
 
 namespace tensorflow {
 
@@ -48,10 +53,69 @@ class Var : public ResourceBase {
   bool is_initialized = false;  // GUARDED_BY(mu_) but annotalysis doesn't like
                                 // it.
 
+  // Dirty row tracking, for incremental checkpoints.  Once
+  // StartTrackingDirtyRows() has been called, kernels that update the
+  // variable record which rows (indices into dimension 0) they changed, and
+  // TakeDirtyRows() returns and clears them.  These have their own lock, and
+  // do not require mu().
+  void StartTrackingDirtyRows() {
+    mutex_lock l(dirty_rows_mu_);
+    tracking_dirty_rows_ = true;
+  }
+  bool tracking_dirty_rows() const { return tracking_dirty_rows_; }
+
+  // Records that the "n" rows "rows" may have changed.
+  template <typename Index>
+  void MarkRowsDirty(const Index* rows, int64 n) {
+    if (!tracking_dirty_rows_) return;
+    mutex_lock l(dirty_rows_mu_);
+    if (all_rows_dirty_) return;
+    for (int64 i = 0; i < n; ++i) {
+      dirty_rows_.insert(rows[i]);
+    }
+  }
+
+  // Records that any row may have changed.
+  void MarkAllRowsDirty() {
+    if (!tracking_dirty_rows_) return;
+    mutex_lock l(dirty_rows_mu_);
+    all_rows_dirty_ = true;
+    dirty_rows_.clear();
+  }
+
+  // Returns false if the variable does not track dirty rows.  Otherwise
+  // sets "*all" if any row may have changed since the last call, or else
+  // fills "rows" with the sorted rows that did, and clears them.
+  bool TakeDirtyRows(bool* all, std::vector<int64>* rows) {
+    mutex_lock l(dirty_rows_mu_);
+    if (!tracking_dirty_rows_) return false;
+    *all = all_rows_dirty_;
+    rows->assign(dirty_rows_.begin(), dirty_rows_.end());
+    std::sort(rows->begin(), rows->end());
+    all_rows_dirty_ = false;
+    dirty_rows_.clear();
+    return true;
+  }
+
+  // Marks the rows returned by TakeDirtyRows() dirty again, e.g. because
+  // they could not be saved.
+  void RestoreDirtyRows(bool all, const std::vector<int64>& rows) {
+    if (all) {
+      MarkAllRowsDirty();
+    } else {
+      MarkRowsDirty(rows.data(), rows.size());
+    }
+  }
+
  private:
   mutex mu_;
   Tensor tensor_;
 
+  mutex dirty_rows_mu_;
+  std::atomic<bool> tracking_dirty_rows_{false};
+  bool all_rows_dirty_ GUARDED_BY(dirty_rows_mu_) = false;
+  gtl::FlatSet<int64> dirty_rows_ GUARDED_BY(dirty_rows_mu_);
+
   ~Var() override {}
 };
 
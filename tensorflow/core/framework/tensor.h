@@ -501,6 +501,12 @@ class Tensor {
 
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
+  friend class RecvTensorBuffer;   // For access to the private constructor
+                                   // taking the buffer.
+  friend class ColumnTensorBuffer;  // For access to the private constructor
+                                    // taking the buffer.
+  friend class MappedTensorBuffer;  // For access to the private constructor
+                                    // taking the buffer.
 
   // Creates a tensor with the input datatype, shape and buf.
   //
@@ -0,0 +1,295 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/graph_view.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/protobuf.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using vectorization_utils::TensorDesc;
+using vectorization_utils::Vectorizer;
+using vectorization_utils::VectorizerRegistry;
+
+// Looks up the description of the tensor `input` of a function body, which
+// is either an argument name or of the form `node:output:index`. Sets `*found`
+// to false if the tensor has not been described yet.
+Status LookupTensor(const string& input,
+                    const std::unordered_map<string, TensorDesc>& descs,
+                    bool* found, TensorDesc* desc) {
+  if (str_util::StartsWith(input, "^")) {
+    return errors::Unimplemented("Control input ", input,
+                                 " cannot be vectorized.");
+  }
+  std::vector<string> parts = str_util::Split(input, ':');
+  if (parts.size() != 1 && (parts.size() != 3 || parts[2] != "0")) {
+    return errors::Unimplemented("Input ", input, " cannot be vectorized.");
+  }
+  auto it = descs.find(parts[0]);
+  *found = it != descs.end();
+  if (*found) {
+    *desc = it->second;
+  }
+  return Status::OK();
+}
+
+// Rewrites the nodes of `f` so that they compute its results for a batch of
+// elements, given descriptions of its arguments. Returns an error if a node
+// cannot be vectorized, or if an output does not depend on the element (in
+// which case it would have to be tiled).
+Status VectorizeFunction(const std::vector<TensorDesc>& args, FunctionDef* f) {
+  const OpDef& signature = f->signature();
+  if (args.size() != static_cast<size_t>(signature.input_arg_size())) {
+    return errors::InvalidArgument("Function ", signature.name(), " expects ",
+                                   signature.input_arg_size(),
+                                   " arguments, got ", args.size());
+  }
+  std::unordered_map<string, TensorDesc> descs;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    descs[signature.input_arg(i).name()] = args[i];
+  }
+
+  // Function bodies are not necessarily sorted, so vectorize the nodes whose
+  // inputs have all been described until none are left.
+  std::vector<NodeDef*> pending;
+  for (NodeDef& node : *f->mutable_node_def()) {
+    pending.push_back(&node);
+  }
+  while (!pending.empty()) {
+    std::vector<NodeDef*> blocked;
+    for (NodeDef* node : pending) {
+      std::vector<TensorDesc> inputs(node->input_size());
+      bool ready = true;
+      for (int i = 0; i < node->input_size() && ready; ++i) {
+        TF_RETURN_IF_ERROR(
+            LookupTensor(node->input(i), descs, &ready, &inputs[i]));
+      }
+      if (!ready) {
+        blocked.push_back(node);
+        continue;
+      }
+      const Vectorizer* vectorizer =
+          VectorizerRegistry::Global()->Get(node->op());
+      if (vectorizer == nullptr) {
+        return errors::Unimplemented("No vectorizer is registered for ",
+                                     node->op());
+      }
+      TF_RETURN_IF_ERROR(
+          vectorizer->Vectorize(inputs, node, &descs[node->name()]));
+    }
+    if (blocked.size() == pending.size()) {
+      return errors::InvalidArgument("Function ", signature.name(),
+                                     " has undefined or cyclic inputs.");
+    }
+    pending.swap(blocked);
+  }
+
+  for (const auto& output_arg : signature.output_arg()) {
+    auto it = f->ret().find(output_arg.name());
+    if (it == f->ret().end()) {
+      return errors::InvalidArgument("Function ", signature.name(),
+                                     " does not define output ",
+                                     output_arg.name());
+    }
+    bool found;
+    TensorDesc desc;
+    TF_RETURN_IF_ERROR(LookupTensor(it->second, descs, &found, &desc));
+    if (!found || !desc.batched) {
+      return errors::Unimplemented("Output ", output_arg.name(),
+                                   " does not depend on the input element.");
+    }
+  }
+  return Status::OK();
+}
+
+const FunctionDef* FindFunction(const string& name,
+                                const FunctionDefLibrary& library) {
+  for (const FunctionDef& f : library.function()) {
+    if (f.signature().name() == name) {
+      return &f;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the rank of the value of a Const node, or -1 if `node` is not a
+// Const node.
+int ConstRank(const NodeDef* node) {
+  if (node == nullptr || !IsConstant(*node)) {
+    return -1;
+  }
+  const TensorShapeProto& shape =
+      node->attr().at("value").tensor().tensor_shape();
+  return shape.unknown_rank() ? -1 : shape.dim_size();
+}
+
+// Adds a vectorized copy of the function of `map_node` to the library of
+// `output`, and sets `*vectorized_name` to its name.
+Status AddVectorizedFunction(const NodeDef& map_node, const NodeDef& input_node,
+                             const GraphView& graph, GraphDef* output,
+                             string* vectorized_name) {
+  const NameAttrList& func = map_node.attr().at("f").func();
+  const FunctionDef* f = FindFunction(func.name(), output->library());
+  if (f == nullptr) {
+    return errors::NotFound("Function ", func.name(), " is not defined.");
+  }
+  if (!input_node.attr().count("output_shapes")) {
+    return errors::InvalidArgument("The shapes of the input of ",
+                                   map_node.name(), " are unknown.");
+  }
+
+  // Batching the input before the map requires its elements to have the
+  // same shapes, which is only guaranteed when they are fully defined.
+  std::vector<TensorDesc> args;
+  for (const TensorShapeProto& shape :
+       input_node.attr().at("output_shapes").list().shape()) {
+    if (!PartialTensorShape(shape).IsFullyDefined()) {
+      return errors::Unimplemented("The shapes of the input of ",
+                                   map_node.name(), " are not fully defined.");
+    }
+    TensorDesc desc;
+    desc.batched = true;
+    desc.rank = shape.dim_size();
+    args.push_back(desc);
+  }
+  const int num_other_args =
+      map_node.attr().at("Targuments").list().type_size();
+  for (int i = 0; i < num_other_args; ++i) {
+    TensorDesc desc;
+    desc.rank = ConstRank(graph.GetNode(NodeName(map_node.input(i + 1))));
+    args.push_back(desc);
+  }
+
+  FunctionDef vectorized(*f);
+  TF_RETURN_IF_ERROR(VectorizeFunction(args, &vectorized));
+  *vectorized_name = strings::StrCat(func.name(), "_vectorized");
+  for (int id = 0; FindFunction(*vectorized_name, output->library());
+       ++id) {
+    *vectorized_name = strings::StrCat(func.name(), "_vectorized_", id);
+  }
+  vectorized.mutable_signature()->set_name(*vectorized_name);
+  *output->mutable_library()->add_function() = std::move(vectorized);
+  return Status::OK();
+}
+
+}  // namespace
+
+Status MapVectorization::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                  GraphDef* output) {
+  *output = item.graph;
+  GraphView graph(output);
+  std::set<string> nodes_to_delete;
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != "BatchDataset" && node.op() != "BatchDatasetV2") {
+      continue;
+    }
+
+    // Use a more descriptive variable name now that we know the node type.
+    const NodeDef batch_node(node);
+    GraphView::InputPort input_port = graph.GetInputPort(batch_node.name(), 0);
+    NodeDef* node2 = graph.GetRegularFanin(input_port).node;
+    if (node2->op() != "MapDataset" && node2->op() != "ParallelMapDataset") {
+      continue;
+    }
+    // Use a more descriptive variable name now that we know the node type.
+    const NodeDef map_node(*node2);
+    // Other consumers of the map would still need it per element.
+    if (graph.GetFanouts(*node2, false).size() != 1) {
+      continue;
+    }
+    const NodeDef* input_node = graph.GetNode(NodeName(map_node.input(0)));
+    if (input_node == nullptr) {
+      continue;
+    }
+
+    string vectorized_name;
+    Status s = AddVectorizedFunction(map_node, *input_node, graph, output,
+                                     &vectorized_name);
+    if (!s.ok()) {
+      VLOG(1) << "Not vectorizing " << map_node.name() << ": " << s;
+      continue;
+    }
+
+    // The new `Batch` node batches the input of the map.
+    NodeDef* new_batch_node = output->add_node();
+    *new_batch_node = batch_node;
+    graph_utils::SetUniqueName(batch_node.op(), output, new_batch_node);
+    new_batch_node->set_input(0, map_node.input(0));
+    (*new_batch_node->mutable_attr())["output_types"] =
+        input_node->attr().at("output_types");
+    int64 batch_dim = -1;
+    const auto& batch_shapes = batch_node.attr().at("output_shapes").list();
+    if (batch_shapes.shape_size() > 0 &&
+        batch_shapes.shape(0).dim_size() > 0) {
+      batch_dim = batch_shapes.shape(0).dim(0).size();
+    }
+    AttrValue* new_batch_shapes =
+        &(*new_batch_node->mutable_attr())["output_shapes"];
+    new_batch_shapes->mutable_list()->clear_shape();
+    for (const TensorShapeProto& shape :
+         input_node->attr().at("output_shapes").list().shape()) {
+      TensorShapeProto* batched = new_batch_shapes->mutable_list()->add_shape();
+      batched->add_dim()->set_size(batch_dim);
+      for (const auto& dim : shape.dim()) {
+        *batched->add_dim() = dim;
+      }
+    }
+
+    // The new `Map` node applies the vectorized function to the batches.
+    NodeDef* new_map_node = output->add_node();
+    *new_map_node = map_node;
+    graph_utils::SetUniqueName(map_node.op(), output, new_map_node);
+    new_map_node->set_input(0, new_batch_node->name());
+    (*new_map_node->mutable_attr())["f"].mutable_func()->set_name(
+        vectorized_name);
+    for (auto key : {"output_shapes", "output_types"}) {
+      (*new_map_node->mutable_attr())[key] = batch_node.attr().at(key);
+    }
+
+    // Mark the `Map` and `Batch` nodes for removal.
+    nodes_to_delete.insert(map_node.name());
+    nodes_to_delete.insert(batch_node.name());
+
+    graph_utils::ReplaceInput(batch_node, *new_map_node, &graph);
+  }
+  TF_RETURN_IF_ERROR(graph_utils::DeleteNodes(nodes_to_delete, output));
+  return Status::OK();
+}
+
+void MapVectorization::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                const GraphDef& optimize_output,
+                                double result) {
+  // no-op
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // end namespace grappler
+}  // end namespace tensorflow
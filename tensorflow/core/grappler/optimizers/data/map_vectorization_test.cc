@@ -0,0 +1,169 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Builds `range(10).map(function_name).batch(5)`, where the elements of the
+// range have the shape `element_shape`.
+void BuildMapAndBatch(const string &function_name,
+                      const PartialTensorShape &element_shape,
+                      GraphDef *graph, NodeDef **range_node,
+                      NodeDef **map_node, NodeDef **batch_node) {
+  *graph->mutable_library()->add_function() = test::function::XTimesTwo();
+  *graph->mutable_library()->add_function() = test::function::XTimesFour();
+
+  NodeDef *start_node;
+  TF_ASSERT_OK(graph_utils::AddScalarConstNode<int64>(0, graph, &start_node));
+  NodeDef *stop_node;
+  TF_ASSERT_OK(graph_utils::AddScalarConstNode<int64>(10, graph, &stop_node));
+  NodeDef *step_node;
+  TF_ASSERT_OK(graph_utils::AddScalarConstNode<int64>(1, graph, &step_node));
+
+  AttrValue types_attr;
+  SetAttrValue(std::vector<DataType>({DT_INT64}), &types_attr);
+  {
+    std::vector<string> range_inputs(3);
+    range_inputs[0] = start_node->name();
+    range_inputs[1] = stop_node->name();
+    range_inputs[2] = step_node->name();
+    std::vector<std::pair<string, AttrValue>> range_attrs(2);
+    AttrValue shapes_attr;
+    SetAttrValue(std::vector<PartialTensorShape>({element_shape}),
+                 &shapes_attr);
+    range_attrs[0] = std::make_pair("output_shapes", shapes_attr);
+    range_attrs[1] = std::make_pair("output_types", types_attr);
+    TF_ASSERT_OK(graph_utils::AddNode("", "RangeDataset", range_inputs,
+                                      range_attrs, graph, range_node));
+  }
+
+  {
+    std::vector<string> map_inputs(1);
+    map_inputs[0] = (*range_node)->name();
+    std::vector<std::pair<string, AttrValue>> map_attrs(4);
+    NameAttrList func;
+    func.set_name(function_name);
+    (*func.mutable_attr())["T"].set_type(DT_INT64);
+    AttrValue f_attr;
+    SetAttrValue(func, &f_attr);
+    map_attrs[0] = std::make_pair("f", f_attr);
+    AttrValue args_attr;
+    SetAttrValue(std::vector<DataType>(), &args_attr);
+    map_attrs[1] = std::make_pair("Targuments", args_attr);
+    AttrValue shapes_attr;
+    SetAttrValue(std::vector<PartialTensorShape>({element_shape}),
+                 &shapes_attr);
+    map_attrs[2] = std::make_pair("output_shapes", shapes_attr);
+    map_attrs[3] = std::make_pair("output_types", types_attr);
+    TF_ASSERT_OK(graph_utils::AddNode("", "MapDataset", map_inputs, map_attrs,
+                                      graph, map_node));
+  }
+
+  NodeDef *batch_size_node;
+  TF_ASSERT_OK(
+      graph_utils::AddScalarConstNode<int64>(5, graph, &batch_size_node));
+  {
+    std::vector<string> batch_inputs(2);
+    batch_inputs[0] = (*map_node)->name();
+    batch_inputs[1] = batch_size_node->name();
+    std::vector<std::pair<string, AttrValue>> batch_attrs(2);
+    AttrValue shapes_attr;
+    SetAttrValue(std::vector<PartialTensorShape>(
+                     {PartialTensorShape({-1}).Concatenate(element_shape)}),
+                 &shapes_attr);
+    batch_attrs[0] = std::make_pair("output_shapes", shapes_attr);
+    batch_attrs[1] = std::make_pair("output_types", types_attr);
+    TF_ASSERT_OK(graph_utils::AddNode("", "BatchDataset", batch_inputs,
+                                      batch_attrs, graph, batch_node));
+  }
+}
+
+TEST(MapVectorizationTest, VectorizeCwiseFunction) {
+  GrapplerItem item;
+  NodeDef *range_node, *map_node, *batch_node;
+  BuildMapAndBatch("XTimesTwo", PartialTensorShape({2}), &item.graph,
+                   &range_node, &map_node, &batch_node);
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsNodeWithName(map_node->name(), output));
+  EXPECT_FALSE(graph_utils::ContainsNodeWithName(batch_node->name(), output));
+  const NodeDef &new_batch_node =
+      output.node(graph_utils::FindNodeWithOp("BatchDataset", output));
+  const NodeDef &new_map_node =
+      output.node(graph_utils::FindNodeWithOp("MapDataset", output));
+  EXPECT_EQ(new_batch_node.input(0), range_node->name());
+  EXPECT_EQ(new_batch_node.input(1), batch_node->input(1));
+  EXPECT_EQ(new_map_node.input(0), new_batch_node.name());
+  EXPECT_EQ(PartialTensorShape(
+                new_batch_node.attr().at("output_shapes").list().shape(0))
+                .DebugString(),
+            PartialTensorShape({-1, 2}).DebugString());
+  EXPECT_TRUE(AreAttrValuesEqual(new_map_node.attr().at("output_shapes"),
+                                 batch_node->attr().at("output_shapes")));
+  EXPECT_EQ(new_map_node.attr().at("f").func().name(), "XTimesTwo_vectorized");
+  EXPECT_EQ(new_map_node.attr().at("f").func().attr().at("T").type(),
+            DT_INT64);
+  int num_vectorized = 0;
+  for (const FunctionDef &f : output.library().function()) {
+    if (f.signature().name() == "XTimesTwo_vectorized") ++num_vectorized;
+  }
+  EXPECT_EQ(num_vectorized, 1);
+}
+
+TEST(MapVectorizationTest, KeepMapWithoutVectorizer) {
+  GrapplerItem item;
+  NodeDef *range_node, *map_node, *batch_node;
+  // `XTimesFour` calls the function `XTimesTwo`, which is not an op with a
+  // registered vectorizer.
+  BuildMapAndBatch("XTimesFour", PartialTensorShape({2}), &item.graph,
+                   &range_node, &map_node, &batch_node);
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::Compare(item.graph, output));
+  EXPECT_EQ(output.library().function_size(), 2);
+}
+
+TEST(MapVectorizationTest, KeepMapWithPartiallyDefinedShapes) {
+  GrapplerItem item;
+  NodeDef *range_node, *map_node, *batch_node;
+  BuildMapAndBatch("XTimesTwo", PartialTensorShape({-1}), &item.graph,
+                   &range_node, &map_node, &batch_node);
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::Compare(item.graph, output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,180 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace vectorization_utils {
+namespace {
+
+Status CheckNumInputs(const NodeDef& node,
+                      const std::vector<TensorDesc>& inputs, size_t expected) {
+  if (inputs.size() != expected) {
+    return errors::InvalidArgument("Expected ", expected, " inputs for ",
+                                   node.op(), " node ", node.name(), ", got ",
+                                   inputs.size());
+  }
+  return Status::OK();
+}
+
+// Constants do not depend on the input element, so they are left as is.
+class ConstVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const std::vector<TensorDesc>& inputs, NodeDef* node,
+                   TensorDesc* output) const override {
+    TF_RETURN_IF_ERROR(CheckNumInputs(*node, inputs, 0));
+    auto it = node->attr().find("value");
+    if (it == node->attr().end()) {
+      return errors::InvalidArgument("Const node ", node->name(),
+                                     " has no value.");
+    }
+    const TensorShapeProto& shape = it->second.tensor().tensor_shape();
+    output->batched = false;
+    output->rank = shape.unknown_rank() ? -1 : shape.dim_size();
+    return Status::OK();
+  }
+};
+
+// Element-wise ops of one input compute the same values for a batch as for
+// each of its elements.
+class CwiseUnaryVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const std::vector<TensorDesc>& inputs, NodeDef* node,
+                   TensorDesc* output) const override {
+    TF_RETURN_IF_ERROR(CheckNumInputs(*node, inputs, 1));
+    *output = inputs[0];
+    return Status::OK();
+  }
+};
+
+// Element-wise ops of two inputs broadcast their inputs against each other by
+// aligning their trailing dimensions, so the leading batch dimension of one
+// input must only meet the batch dimension of the other input, or nothing.
+class CwiseBinaryVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const std::vector<TensorDesc>& inputs, NodeDef* node,
+                   TensorDesc* output) const override {
+    TF_RETURN_IF_ERROR(CheckNumInputs(*node, inputs, 2));
+    const TensorDesc& x = inputs[0];
+    const TensorDesc& y = inputs[1];
+    if (!x.batched && !y.batched) {
+      output->batched = false;
+      output->rank = (x.rank < 0 || y.rank < 0) ? -1 : std::max(x.rank, y.rank);
+      return Status::OK();
+    }
+    if (x.batched && y.batched) {
+      if (x.rank < 0 || x.rank != y.rank) {
+        return errors::Unimplemented(
+            "Cannot vectorize ", node->name(),
+            ": both inputs must have the same known rank.");
+      }
+    } else {
+      const TensorDesc& batched = x.batched ? x : y;
+      const TensorDesc& unbatched = x.batched ? y : x;
+      if (batched.rank < 0 || unbatched.rank < 0 ||
+          unbatched.rank > batched.rank) {
+        return errors::Unimplemented(
+            "Cannot vectorize ", node->name(),
+            ": the rank of the unbatched input must be known and no greater "
+            "than the rank of the batched input.");
+      }
+    }
+    output->batched = true;
+    output->rank = x.batched ? x.rank : y.rank;
+    return Status::OK();
+  }
+};
+
+// `Select` picks whole rows when its condition is a vector and its other
+// inputs are not, so all inputs must be batched and of the same rank for it
+// to be element-wise.
+class SelectVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const std::vector<TensorDesc>& inputs, NodeDef* node,
+                   TensorDesc* output) const override {
+    TF_RETURN_IF_ERROR(CheckNumInputs(*node, inputs, 3));
+    for (const TensorDesc& input : inputs) {
+      if (!input.batched || input.rank < 0 || input.rank != inputs[0].rank) {
+        return errors::Unimplemented(
+            "Cannot vectorize ", node->name(),
+            ": all inputs must be batched and have the same known rank.");
+      }
+    }
+    *output = inputs[0];
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("Const", ConstVectorizer);
+
+REGISTER_VECTORIZER("Abs", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Cast", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Ceil", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Cos", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Exp", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Floor", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Identity", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("IsFinite", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("IsInf", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("IsNan", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Log", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Log1p", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("LogicalNot", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Neg", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Reciprocal", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Relu", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Relu6", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Round", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Rsqrt", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Sigmoid", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Sign", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Sin", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Sqrt", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Square", CwiseUnaryVectorizer);
+REGISTER_VECTORIZER("Tanh", CwiseUnaryVectorizer);
+
+REGISTER_VECTORIZER("Add", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Div", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Equal", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("FloorDiv", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("FloorMod", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Greater", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("GreaterEqual", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Less", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("LessEqual", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("LogicalAnd", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("LogicalOr", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Maximum", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Minimum", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Mod", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Mul", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("NotEqual", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Pow", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("RealDiv", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("SquaredDifference", CwiseBinaryVectorizer);
+REGISTER_VECTORIZER("Sub", CwiseBinaryVectorizer);
+
+REGISTER_VECTORIZER("Select", SelectVectorizer);
+
+}  // namespace
+}  // namespace vectorization_utils
+}  // namespace grappler
+}  // namespace tensorflow
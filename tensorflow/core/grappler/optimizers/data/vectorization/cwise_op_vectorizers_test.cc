@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace vectorization_utils {
+namespace {
+
+TensorDesc Desc(bool batched, int rank) {
+  TensorDesc desc;
+  desc.batched = batched;
+  desc.rank = rank;
+  return desc;
+}
+
+Status Vectorize(const string& op, const std::vector<TensorDesc>& inputs,
+                 TensorDesc* output) {
+  const Vectorizer* vectorizer = VectorizerRegistry::Global()->Get(op);
+  if (vectorizer == nullptr) {
+    return errors::NotFound("No vectorizer for ", op);
+  }
+  NodeDef node;
+  node.set_name("node");
+  node.set_op(op);
+  return vectorizer->Vectorize(inputs, &node, output);
+}
+
+TEST(CwiseOpVectorizersTest, UnregisteredOp) {
+  EXPECT_EQ(VectorizerRegistry::Global()->Get("RandomUniform"), nullptr);
+}
+
+TEST(CwiseOpVectorizersTest, Const) {
+  NodeDef node;
+  node.set_name("const");
+  node.set_op("Const");
+  SetAttrValue(test::AsTensor<float>({1, 2, 3}, {3}),
+               &(*node.mutable_attr())["value"]);
+  const Vectorizer* vectorizer = VectorizerRegistry::Global()->Get("Const");
+  ASSERT_NE(vectorizer, nullptr);
+  TensorDesc output;
+  TF_ASSERT_OK(vectorizer->Vectorize({}, &node, &output));
+  EXPECT_FALSE(output.batched);
+  EXPECT_EQ(output.rank, 1);
+}
+
+TEST(CwiseOpVectorizersTest, Unary) {
+  TensorDesc output;
+  TF_ASSERT_OK(Vectorize("Sqrt", {Desc(true, 2)}, &output));
+  EXPECT_TRUE(output.batched);
+  EXPECT_EQ(output.rank, 2);
+  EXPECT_FALSE(Vectorize("Sqrt", {}, &output).ok());
+}
+
+TEST(CwiseOpVectorizersTest, Binary) {
+  TensorDesc output;
+  TF_ASSERT_OK(Vectorize("Add", {Desc(true, 2), Desc(true, 2)}, &output));
+  EXPECT_TRUE(output.batched);
+  EXPECT_EQ(output.rank, 2);
+
+  // An unbatched input broadcasts along the trailing dimensions.
+  TF_ASSERT_OK(Vectorize("Mul", {Desc(false, 1), Desc(true, 2)}, &output));
+  EXPECT_TRUE(output.batched);
+  EXPECT_EQ(output.rank, 2);
+  TF_ASSERT_OK(Vectorize("Mul", {Desc(false, 0), Desc(false, 1)}, &output));
+  EXPECT_FALSE(output.batched);
+  EXPECT_EQ(output.rank, 1);
+
+  // The batch dimension would be broadcast against an element dimension.
+  EXPECT_FALSE(Vectorize("Add", {Desc(true, 1), Desc(true, 2)}, &output).ok());
+  EXPECT_FALSE(Vectorize("Add", {Desc(true, 1), Desc(false, 2)}, &output).ok());
+  // Unknown ranks cannot be checked.
+  EXPECT_FALSE(Vectorize("Sub", {Desc(true, -1), Desc(true, -1)}, &output)
+                   .ok());
+  EXPECT_FALSE(Vectorize("Sub", {Desc(true, 1), Desc(false, -1)}, &output)
+                   .ok());
+}
+
+TEST(CwiseOpVectorizersTest, Select) {
+  TensorDesc output;
+  TF_ASSERT_OK(Vectorize(
+      "Select", {Desc(true, 1), Desc(true, 1), Desc(true, 1)}, &output));
+  EXPECT_TRUE(output.batched);
+  EXPECT_EQ(output.rank, 1);
+  // A vector condition selects rows of a matrix.
+  EXPECT_FALSE(Vectorize("Select",
+                         {Desc(true, 0), Desc(true, 1), Desc(true, 1)},
+                         &output)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace vectorization_utils
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,54 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_VECTORIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_VECTORIZER_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace vectorization_utils {
+
+// Describes a tensor computed by a map function, as seen by the vectorizer.
+struct TensorDesc {
+  // True if the value of the tensor depends on the input element. Batched
+  // tensors have an extra leading (batch) dimension in the vectorized
+  // function; the others are computed once and shared by the whole batch.
+  bool batched = false;
+  // The rank of the tensor for a single element, or -1 if it is unknown.
+  int rank = -1;
+};
+
+// Interface for rewriting a node of a map function so that it computes its
+// op for a whole batch of elements at once.
+class Vectorizer {
+ public:
+  virtual ~Vectorizer() {}
+
+  // Rewrites `node` in place, given descriptions of its inputs, and sets
+  // `*output` to the description of its (only) output. Returns an error if
+  // the node cannot be vectorized; in which case `node` is left unchanged.
+  virtual Status Vectorize(const std::vector<TensorDesc>& inputs,
+                           NodeDef* node, TensorDesc* output) const = 0;
+};
+
+}  // namespace vectorization_utils
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_VECTORIZER_H_
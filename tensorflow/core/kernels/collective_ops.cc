@@ -40,6 +40,10 @@ class CollectiveOpKernel : public AsyncOpKernel {
     if (col_params_.group.group_size >
         col_params_.instance.device_names.size()) {
       // This is the first invocation: Finish initializing col_params_.
+      // The shape of the input lets the resolver pick an implementation.
+      if (c->num_inputs() > 0) {
+        col_params_.instance.shape = c->input(0).shape();
+      }
       // Call in a blockable thread because it's not guaranteed that
       // this call cannot block.
       c->env()->SchedClosure([this, c, done, col_exec]() {
@@ -59,21 +63,30 @@ class CollectiveOpKernel : public AsyncOpKernel {
     return true;
   }
 
-  CollectiveParams col_params_;
-};
+  // Returns the OpKernel named 'name' for use as a merge_op or final_op,
+  // or null if 'name' is empty or "Id".
+  std::unique_ptr<OpKernel> BuildOpKernel(OpKernelConstruction* c,
+                                          const string& name,
+                                          NodeDef* sub_node) {
+    std::unique_ptr<OpKernel> k;
+    if (name.empty() || name == "Id") return k;
+    sub_node->set_name(name);
+    sub_node->set_op(name);
+    Status status;
+    k = CreateOpKernel(c->device_type(), c->device(),
+                       c->device()->GetAllocator(AllocatorAttributes()),
+                       *sub_node, c->graph_def_version(), &status);
+    if (!status.ok()) {
+      c->CtxFailureWithWarning(errors::Internal("Failed to build OpKernel for ",
+                                                name, " : ",
+                                                status.error_message()));
+    }
+    return k;
+  }
 
-class CollectiveReduceOpKernel : public CollectiveOpKernel {
- public:
-  explicit CollectiveReduceOpKernel(OpKernelConstruction* c)
-      : CollectiveOpKernel(c) {
-    col_params_.instance.type = REDUCTION_COLLECTIVE;
-    OP_REQUIRES_OK(c, c->GetAttr("group_size", &col_params_.group.group_size));
-    OP_REQUIRES_OK(c, c->GetAttr("group_key", &col_params_.group.group_key));
-    OP_REQUIRES_OK(
-        c, c->GetAttr("instance_key", &col_params_.instance.instance_key));
-    OP_REQUIRES_OK(
-        c, c->GetAttr("subdiv_offsets",
-                      &col_params_.instance.impl_details.subdiv_offsets));
+  // Reads the merge_op and final_op attrs, validates them, and builds the
+  // corresponding OpKernels into col_params_.
+  void InitReductionOps(OpKernelConstruction* c, const string& op_label) {
     string merge_op_name;
     OP_REQUIRES_OK(c, c->GetAttr("merge_op", &merge_op_name));
     OP_REQUIRES(c, merge_op_name == "Add" || merge_op_name == "Mul",
@@ -86,12 +99,10 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                 errors::InvalidArgument(
                     "final_op must be one of {\"Id\", \"Div\"} but got ",
                     final_op_name));
-    OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
 
     const NodeDef& real_node = c->def();
-    col_params_.name = strings::StrCat(real_node.name(), ": Reduce(",
+    col_params_.name = strings::StrCat(real_node.name(), ": ", op_label, "(",
                                        merge_op_name, ",", final_op_name, ")");
-    col_params_.group.device_type = c->device_type();
 
     // Find the OpKernels by name, type and device type.
     NodeDef sub_node;
@@ -105,23 +116,27 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
     col_params_.final_op = BuildOpKernel(c, final_op_name, &sub_node);
   }
 
-  std::unique_ptr<OpKernel> BuildOpKernel(OpKernelConstruction* c,
-                                          const string& name,
-                                          NodeDef* sub_node) {
-    std::unique_ptr<OpKernel> k;
-    if (name.empty() || name == "Id") return k;
-    sub_node->set_name(name);
-    sub_node->set_op(name);
-    Status status;
-    k = CreateOpKernel(c->device_type(), c->device(),
-                       c->device()->GetAllocator(AllocatorAttributes()),
-                       *sub_node, c->graph_def_version(), &status);
-    if (!status.ok()) {
-      c->CtxFailureWithWarning(errors::Internal("Failed to build OpKernel for ",
-                                                name, " : ",
-                                                status.error_message()));
-    }
-    return k;
+  CollectiveParams col_params_;
+};
+
+class CollectiveReduceOpKernel : public CollectiveOpKernel {
+ public:
+  explicit CollectiveReduceOpKernel(OpKernelConstruction* c)
+      : CollectiveOpKernel(c) {
+    col_params_.instance.type = REDUCTION_COLLECTIVE;
+    OP_REQUIRES_OK(c, c->GetAttr("group_size", &col_params_.group.group_size));
+    OP_REQUIRES_OK(c, c->GetAttr("group_key", &col_params_.group.group_key));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("instance_key", &col_params_.instance.instance_key));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("subdiv_offsets",
+                      &col_params_.instance.impl_details.subdiv_offsets));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("collective_name",
+                      &col_params_.instance.impl_details.collective_name));
+    OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
+    col_params_.group.device_type = c->device_type();
+    InitReductionOps(c, "Reduce");
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
@@ -262,5 +277,118 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveBcastRecv").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("CollectiveBcastRecv").Device(DEVICE_GPU),
                         CollectiveBcastRecvOpKernel);
 
+class CollectiveGatherOpKernel : public CollectiveOpKernel {
+ public:
+  explicit CollectiveGatherOpKernel(OpKernelConstruction* c)
+      : CollectiveOpKernel(c) {
+    col_params_.instance.type = GATHER_COLLECTIVE;
+    OP_REQUIRES_OK(c, c->GetAttr("group_size", &col_params_.group.group_size));
+    OP_REQUIRES_OK(c, c->GetAttr("group_key", &col_params_.group.group_key));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("instance_key", &col_params_.instance.instance_key));
+    OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
+    col_params_.instance.impl_details.subdiv_offsets = {0};
+
+    col_params_.name = strings::StrCat(name(), ": Gather");
+    col_params_.group.device_type = c->device_type();
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    CollectiveExecutor* col_exec = c->collective_executor();
+    OP_REQUIRES_ASYNC(
+        c, col_exec,
+        errors::Internal(
+            "Failed to get CollectiveExecutor from OpKernelContext for Op ",
+            col_params_.name),
+        done);
+    OP_REQUIRES_ASYNC(
+        c, c->input(0).dims() > 0,
+        errors::InvalidArgument("Input of ", col_params_.name,
+                                " must be at least rank 1"),
+        done);
+    if (!CanProceedWithCompute(c, col_exec, done)) return;
+    // The output stacks the inputs of all group members along dimension 0.
+    TensorShape output_shape = c->input(0).shape();
+    output_shape.set_dim(
+        0, output_shape.dim_size(0) * col_params_.group.group_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK_ASYNC(c, c->allocate_output(0, output_shape, &output),
+                         done);
+
+    auto actual_done = [c, col_exec, done](const Status& s) {
+      OP_REQUIRES_OK_ASYNC(c, s, done);
+      done();
+    };
+    col_exec->ExecuteAsync(c, col_params_, GetCollectiveKey(c), actual_done);
+  }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(CollectiveGatherOpKernel);
+};
+
+REGISTER_KERNEL_BUILDER(Name("CollectiveGather").Device(DEVICE_CPU),
+                        CollectiveGatherOpKernel);
+REGISTER_KERNEL_BUILDER(Name("CollectiveGather").Device(DEVICE_GPU),
+                        CollectiveGatherOpKernel);
+
+class CollectiveReduceScatterOpKernel : public CollectiveOpKernel {
+ public:
+  explicit CollectiveReduceScatterOpKernel(OpKernelConstruction* c)
+      : CollectiveOpKernel(c) {
+    col_params_.instance.type = REDUCE_SCATTER_COLLECTIVE;
+    OP_REQUIRES_OK(c, c->GetAttr("group_size", &col_params_.group.group_size));
+    OP_REQUIRES_OK(c, c->GetAttr("group_key", &col_params_.group.group_key));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("instance_key", &col_params_.instance.instance_key));
+    OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
+    col_params_.instance.impl_details.subdiv_offsets = {0};
+    col_params_.group.device_type = c->device_type();
+    InitReductionOps(c, "ReduceScatter");
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    CollectiveExecutor* col_exec = c->collective_executor();
+    OP_REQUIRES_ASYNC(
+        c, col_exec,
+        errors::Internal(
+            "Failed to get CollectiveExecutor from OpKernelContext for Op ",
+            col_params_.name),
+        done);
+    const TensorShape& input_shape = c->input(0).shape();
+    OP_REQUIRES_ASYNC(
+        c,
+        input_shape.dims() > 0 &&
+            input_shape.dim_size(0) % col_params_.group.group_size == 0,
+        errors::InvalidArgument("Dimension 0 of the input of ",
+                                col_params_.name,
+                                " must be divisible by group_size ",
+                                col_params_.group.group_size, " but shape is ",
+                                input_shape.DebugString()),
+        done);
+    if (!CanProceedWithCompute(c, col_exec, done)) return;
+    // Each group member receives an equal slice of dimension 0.
+    TensorShape output_shape = input_shape;
+    output_shape.set_dim(
+        0, output_shape.dim_size(0) / col_params_.group.group_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK_ASYNC(c, c->allocate_output(0, output_shape, &output),
+                         done);
+
+    auto actual_done = [c, col_exec, done](const Status& s) {
+      OP_REQUIRES_OK_ASYNC(c, s, done);
+      done();
+    };
+    col_exec->ExecuteAsync(c, col_params_, GetCollectiveKey(c), actual_done);
+  }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(CollectiveReduceScatterOpKernel);
+};
+
+REGISTER_KERNEL_BUILDER(Name("CollectiveReduceScatter").Device(DEVICE_CPU),
+                        CollectiveReduceScatterOpKernel);
+REGISTER_KERNEL_BUILDER(Name("CollectiveReduceScatter").Device(DEVICE_GPU),
+                        CollectiveReduceScatterOpKernel);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,487 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/captured_function.h"
+#include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class BucketBySequenceLengthDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit BucketBySequenceLengthDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("element_length_func", &element_length_func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    const Tensor* bucket_boundaries_t;
+    OP_REQUIRES_OK(ctx, ctx->input("bucket_boundaries", &bucket_boundaries_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bucket_boundaries_t->shape()),
+                errors::InvalidArgument("bucket_boundaries must be a vector."));
+    std::vector<int64> bucket_boundaries;
+    bucket_boundaries.reserve(bucket_boundaries_t->NumElements());
+    for (int64 i = 0; i < bucket_boundaries_t->NumElements(); ++i) {
+      const int64 boundary = bucket_boundaries_t->vec<int64>()(i);
+      OP_REQUIRES(
+          ctx, bucket_boundaries.empty() || bucket_boundaries.back() < boundary,
+          errors::InvalidArgument(
+              "bucket_boundaries must be strictly increasing."));
+      bucket_boundaries.push_back(boundary);
+    }
+
+    int64 max_tokens;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "max_tokens", &max_tokens));
+    OP_REQUIRES(
+        ctx, max_tokens > 0,
+        errors::InvalidArgument("max_tokens must be greater than zero."));
+
+    OpInputList padding_values_list;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("padding_values", &padding_values_list));
+    std::vector<Tensor> padding_values;
+    OP_REQUIRES(ctx,
+                padding_values_list.size() == input->output_shapes().size(),
+                errors::InvalidArgument(
+                    "Number of padding values (", padding_values_list.size(),
+                    ") must match the number of components in the input "
+                    "dataset's elements (",
+                    input->output_shapes().size(), ")"));
+    for (int i = 0; i < padding_values_list.size(); ++i) {
+      const Tensor& padding_value_t = padding_values_list[i];
+      OP_REQUIRES(
+          ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+          errors::InvalidArgument("All padding values must be scalars"));
+      OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                  errors::InvalidArgument(
+                      "Mismatched type between padding value ", i,
+                      " and input dataset's component ", i, ": ",
+                      DataTypeString(padding_value_t.dtype()), " vs. ",
+                      DataTypeString(input->output_dtypes()[i])));
+      padding_values.push_back(tensor::DeepCopy(padding_value_t));
+    }
+
+    std::unique_ptr<CapturedFunction> captured_element_length_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(
+                            element_length_func_, ctx, "other_arguments",
+                            &captured_element_length_func));
+
+    *output = new Dataset(ctx, input, element_length_func_,
+                          std::move(captured_element_length_func),
+                          std::move(bucket_boundaries), max_tokens,
+                          std::move(padding_values), output_shapes_);
+  }
+
+ private:
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input,
+            const NameAttrList& element_length_func,
+            std::unique_ptr<CapturedFunction> captured_element_length_func,
+            std::vector<int64> bucket_boundaries, int64 max_tokens,
+            std::vector<Tensor> padding_values,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          element_length_func_(element_length_func),
+          captured_element_length_func_(
+              std::move(captured_element_length_func)),
+          bucket_boundaries_(std::move(bucket_boundaries)),
+          max_tokens_(max_tokens),
+          padding_values_(std::move(padding_values)),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(
+          {this, strings::StrCat(prefix, "::BucketBySequenceLength")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return strings::StrCat("BucketBySequenceLengthDatasetOp(", max_tokens_,
+                             ")::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(OpKernelContext* ctx, DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      TF_RETURN_IF_ERROR(b->AddFunction(ctx, element_length_func_.name()));
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddParentDataset(ctx, input_, &input_graph_node));
+
+      Tensor bucket_boundaries_t(
+          DT_INT64,
+          TensorShape({static_cast<int64>(bucket_boundaries_.size())}));
+      for (size_t i = 0; i < bucket_boundaries_.size(); ++i) {
+        bucket_boundaries_t.vec<int64>()(i) = bucket_boundaries_[i];
+      }
+      Node* bucket_boundaries = nullptr;
+      TF_RETURN_IF_ERROR(b->AddTensor(bucket_boundaries_t, &bucket_boundaries));
+      Node* max_tokens = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(max_tokens_, &max_tokens));
+
+      std::vector<Node*> padding_values;
+      padding_values.reserve(padding_values_.size());
+      for (const Tensor& t : padding_values_) {
+        Node* node;
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        padding_values.emplace_back(node);
+      }
+
+      std::vector<Node*> other_arguments;
+      DataTypeVector other_arguments_types;
+      other_arguments.reserve(
+          captured_element_length_func_->captured_inputs().size());
+      other_arguments_types.reserve(
+          captured_element_length_func_->captured_inputs().size());
+      for (const Tensor& t : captured_element_length_func_->captured_inputs()) {
+        Node* node;
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        other_arguments.emplace_back(node);
+        other_arguments_types.emplace_back(t.dtype());
+      }
+
+      AttrValue element_length_func;
+      b->BuildAttrValue(element_length_func_, &element_length_func);
+      AttrValue other_arguments_types_attr;
+      b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+      AttrValue output_types;
+      b->BuildAttrValue(output_dtypes(), &output_types);
+
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {{0, input_graph_node}, {1, bucket_boundaries}, {2, max_tokens}},
+          {{3, padding_values}, {4, other_arguments}},
+          {{"element_length_func", element_length_func},
+           {"Targuments", other_arguments_types_attr},
+           {"Toutput_types", output_types}},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            buckets_(params.dataset->bucket_boundaries_.size() + 1) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        Bucket batch;
+        {
+          mutex_lock l(mu_);
+          while (input_impl_ && batch.elements.empty()) {
+            std::vector<Tensor> element;
+            bool end_of_input;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &element, &end_of_input));
+            if (end_of_input) {
+              input_impl_.reset();
+              break;
+            }
+            int64 length;
+            TF_RETURN_IF_ERROR(ElementLength(ctx, element, &length));
+            const int64 max_tokens = dataset()->max_tokens_;
+            Bucket& bucket = buckets_[std::upper_bound(
+                                          dataset()->bucket_boundaries_.begin(),
+                                          dataset()->bucket_boundaries_.end(),
+                                          length) -
+                                      dataset()->bucket_boundaries_.begin()];
+            // Emit the bucket before `element` if the padded batch would
+            // exceed `max_tokens` with it, and otherwise after `element` if
+            // the bucket is full.
+            if (!bucket.elements.empty() &&
+                static_cast<int64>(bucket.elements.size() + 1) *
+                        std::max(bucket.max_length, length) >
+                    max_tokens) {
+              std::swap(batch, bucket);
+            }
+            bucket.Add(std::move(element), length);
+            if (batch.elements.empty() &&
+                static_cast<int64>(bucket.elements.size()) *
+                        bucket.max_length >=
+                    max_tokens) {
+              std::swap(batch, bucket);
+            }
+          }
+          if (!input_impl_ && batch.elements.empty()) {
+            // Flush the remaining buckets in order of their boundaries.
+            for (Bucket& bucket : buckets_) {
+              if (!bucket.elements.empty()) {
+                std::swap(batch, bucket);
+                break;
+              }
+            }
+          }
+        }
+
+        if (batch.elements.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        RecordBatch(ctx, batch);
+        TF_RETURN_IF_ERROR(BatchElements(ctx, &batch.elements, out_tensors));
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (input_impl_) {
+          TF_RETURN_IF_ERROR(SaveParent(writer, input_impl_));
+        } else {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("exhausted"), ""));
+        }
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+          const Bucket& bucket = buckets_[i];
+          const string name = full_name(strings::StrCat("buckets[", i, "]"));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(name, "_size"),
+              static_cast<int64>(bucket.elements.size())));
+          for (size_t j = 0; j < bucket.elements.size(); ++j) {
+            TF_RETURN_IF_ERROR(
+                writer->WriteScalar(strings::StrCat(name, "[", j, "]_length"),
+                                    bucket.lengths[j]));
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                strings::StrCat(name, "[", j, "]_size"),
+                static_cast<int64>(bucket.elements[j].size())));
+            for (size_t k = 0; k < bucket.elements[j].size(); ++k) {
+              TF_RETURN_IF_ERROR(writer->WriteTensor(
+                  strings::StrCat(name, "[", j, "][", k, "]"),
+                  bucket.elements[j][k]));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (reader->Contains(full_name("exhausted"))) {
+          input_impl_.reset();
+        } else {
+          TF_RETURN_IF_ERROR(
+              dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+          TF_RETURN_IF_ERROR(RestoreParent(ctx, reader, input_impl_));
+        }
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+          Bucket& bucket = buckets_[i];
+          bucket = Bucket();
+          const string name = full_name(strings::StrCat("buckets[", i, "]"));
+          int64 size;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(strings::StrCat(name, "_size"), &size));
+          for (int64 j = 0; j < size; ++j) {
+            int64 length;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                strings::StrCat(name, "[", j, "]_length"), &length));
+            int64 num_components;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                strings::StrCat(name, "[", j, "]_size"), &num_components));
+            std::vector<Tensor> element(num_components);
+            for (int64 k = 0; k < num_components; ++k) {
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  strings::StrCat(name, "[", j, "][", k, "]"), &element[k]));
+            }
+            bucket.Add(std::move(element), length);
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      // The buffered elements of a bucket.
+      struct Bucket {
+        std::vector<std::vector<Tensor>> elements;
+        // The length of each element, as returned by `element_length_func`.
+        std::vector<int64> lengths;
+        int64 max_length = 0;
+        int64 num_tokens = 0;
+
+        void Add(std::vector<Tensor> element, int64 length) {
+          elements.push_back(std::move(element));
+          lengths.push_back(length);
+          max_length = std::max(max_length, length);
+          num_tokens += length;
+        }
+      };
+
+      Status ElementLength(IteratorContext* ctx,
+                           const std::vector<Tensor>& element, int64* length)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::vector<Tensor> element_length_func_output;
+        TF_RETURN_IF_ERROR(
+            dataset()->captured_element_length_func_->RunWithBorrowedArgs(
+                ctx, element, &element_length_func_output));
+        if (element_length_func_output.size() != 1 ||
+            element_length_func_output[0].dtype() != DT_INT64 ||
+            element_length_func_output[0].NumElements() != 1) {
+          return errors::InvalidArgument(
+              "`element_length_func` must return a scalar int64.");
+        }
+        *length = element_length_func_output[0].scalar<int64>()();
+        if (*length < 0) {
+          return errors::InvalidArgument(
+              "`element_length_func` must return a non-negative length, but "
+              "got ",
+              *length, ".");
+        }
+        return Status::OK();
+      }
+
+      // Reports the size of `batch` and the fraction of its tokens that are
+      // padding to the stats aggregator, if any.
+      void RecordBatch(IteratorContext* ctx, const Bucket& batch) {
+        std::shared_ptr<StatsAggregator> stats_aggregator =
+            ctx->stats_aggregator();
+        if (!stats_aggregator) {
+          return;
+        }
+        const int64 padded_tokens =
+            static_cast<int64>(batch.elements.size()) * batch.max_length;
+        stats_aggregator->AddToHistogram(
+            strings::StrCat(prefix(), "::batch_size"),
+            {static_cast<double>(batch.elements.size())});
+        stats_aggregator->AddToHistogram(
+            strings::StrCat(prefix(), "::batch_tokens"),
+            {static_cast<double>(batch.num_tokens)});
+        if (padded_tokens > 0) {
+          stats_aggregator->AddToHistogram(
+              strings::StrCat(prefix(), "::padding_ratio"),
+              {1.0 - static_cast<double>(batch.num_tokens) /
+                         static_cast<double>(padded_tokens)});
+        }
+      }
+
+      // Copies the components of `elements` into one tensor per component,
+      // whose dimensions are the largest among the elements. The tensors
+      // are filled with padding only if the elements differ in shape.
+      Status BatchElements(IteratorContext* ctx,
+                           std::vector<std::vector<Tensor>>* elements,
+                           std::vector<Tensor>* out_tensors) {
+        const int64 num_batch_elements = elements->size();
+        const size_t num_tuple_components = (*elements)[0].size();
+        out_tensors->reserve(num_tuple_components);
+        for (size_t component_index = 0;
+             component_index < num_tuple_components; ++component_index) {
+          TensorShape component_shape =
+              (*elements)[0][component_index].shape();
+          bool needs_padding = false;
+          for (int64 i = 1; i < num_batch_elements; ++i) {
+            const TensorShape& element_shape =
+                (*elements)[i][component_index].shape();
+            if (element_shape.dims() != component_shape.dims()) {
+              return errors::InvalidArgument(
+                  "All elements in a batch must have the same rank for "
+                  "component ",
+                  component_index, ": got ranks ", component_shape.dims(),
+                  " and ", element_shape.dims());
+            }
+            for (int dim = 0; dim < element_shape.dims(); ++dim) {
+              if (element_shape.dim_size(dim) !=
+                  component_shape.dim_size(dim)) {
+                needs_padding = true;
+                component_shape.set_dim(
+                    dim, std::max(element_shape.dim_size(dim),
+                                  component_shape.dim_size(dim)));
+              }
+            }
+          }
+
+          TensorShape batch_component_shape({num_batch_elements});
+          batch_component_shape.AppendShape(component_shape);
+          Tensor batch_component(ctx->allocator({}),
+                                 output_dtypes()[component_index],
+                                 batch_component_shape);
+          if (needs_padding) {
+            TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+                &batch_component, dataset()->padding_values_[component_index]));
+          }
+          for (int64 i = 0; i < num_batch_elements; ++i) {
+            Tensor& element = (*elements)[i][component_index];
+            // Take the fast path if possible.
+            if (element.shape() == component_shape) {
+              TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+                  std::move(element), &batch_component, i));
+            } else {
+              TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
+                  element, &batch_component, i));
+            }
+          }
+          out_tensors->push_back(std::move(batch_component));
+        }
+        return Status::OK();
+      }
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      // One bucket per interval between `bucket_boundaries_`.
+      std::vector<Bucket> buckets_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const NameAttrList element_length_func_;
+    const std::unique_ptr<CapturedFunction> captured_element_length_func_;
+    const std::vector<int64> bucket_boundaries_;
+    const int64 max_tokens_;
+    const std::vector<Tensor> padding_values_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  NameAttrList element_length_func_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -12,9 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <deque>
+
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/column_cache.h"
+#include "tensorflow/core/kernels/data/compressed_cache.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -29,7 +34,12 @@ namespace {
 class CacheDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit CacheDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    if (!compression_.empty()) {
+      OP_REQUIRES_OK(ctx, CompressedCache::ValidateCompression(compression_));
+    }
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -39,8 +49,13 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                    ParseScalarArgument<string>(ctx, "filename", &filename));
 
     if (filename.empty()) {
-      *output = new MemoryDataset(input);
+      *output = new MemoryDataset(input, compression_);
     } else {
+      OP_REQUIRES(ctx, compression_.empty(),
+                  errors::InvalidArgument(
+                      "Compression is only supported when caching in memory, "
+                      "but got filename \"",
+                      filename, "\" and compression \"", compression_, "\"."));
       *output = new FileDataset(ctx, input, filename, ctx->env());
     }
   }
@@ -55,6 +70,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           filename_(std::move(filename)),
           env_(env),
           num_tensors_(input->output_dtypes().size()),
+          use_columns_(HasColumnComponent(input)),
           tensor_index_padding_size_(StringPaddingSize(num_tensors_)),
           item_index_padding_size_(StringPaddingSize(kMaxItems)),
           tensor_format_string_(strings::Printf("%%%zuzu_%%%zuzu",
@@ -96,6 +112,16 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     }
 
    private:
+    static bool HasColumnComponent(const DatasetBase* input) {
+      for (size_t i = 0; i < input->output_dtypes().size(); ++i) {
+        if (CanStoreInColumn(input->output_dtypes()[i],
+                             input->output_shapes()[i])) {
+          return true;
+        }
+      }
+      return false;
+    }
+
     static size_t StringPaddingSize(size_t num_tensors) {
       return strings::Printf("%zu", num_tensors - 1).size();
     }
@@ -173,10 +199,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       // creates the cache directory, and passes on the underlying iterator's
       // elements.
       //
-      // Caching is performed by writing the input tensors to disk using the
-      // `BundleWriter`. Note that the cache gets fully flushed to disk only
-      // after the input iterator has been fully exhausted. If the program
-      // exits, before completion of an epoch, the cached state would be lost.
+      // Caching is performed by writing the input tensors to disk. Components
+      // with a fixed size are written to contiguous columns using the
+      // `ColumnCacheWriter`, and the others using the `BundleWriter`. Note
+      // that the cache gets fully flushed to disk only after the input
+      // iterator has been fully exhausted. If the program exits, before
+      // completion of an epoch, the cached state would be lost.
       // To ensure that the partial cache persists across sessions, one should
       // checkpoint the input pipeline. On each call to `SaveInternal` the
       // partial cache gets flushed to disk in files with prefix
@@ -204,6 +232,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           mutex_lock l(mu_);
           TF_RETURN_IF_ERROR(EnsureLockFileExists());
           TF_RETURN_IF_ERROR(writer_->status());
+          if (column_writer_) {
+            TF_RETURN_IF_ERROR(column_writer_->status());
+          }
           if (cur_index_ >= kMaxItems) {
             // As a courtesy, close the [truncated] cache file.
             Status s = Finish();
@@ -228,10 +259,13 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                 "Expected ",
                 dataset()->num_tensors_, " got: ", out_tensors->size());
           }
-          size_t tensor_index = 0;
-          for (const Tensor& t : *out_tensors) {
-            DCHECK_LT(tensor_index, dataset()->num_tensors_);
-            string key = dataset()->FormatName(cur_index_, tensor_index++);
+          for (size_t i = 0; i < out_tensors->size(); ++i) {
+            const Tensor& t = (*out_tensors)[i];
+            if (column_writer_ && column_writer_->IsColumn(i)) {
+              TF_RETURN_IF_ERROR(column_writer_->Add(i, t));
+              continue;
+            }
+            string key = dataset()->FormatName(cur_index_, i);
             TF_RETURN_IF_ERROR(writer_->Add(key, t));
           }
           if (*end_of_sequence) {
@@ -256,8 +290,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           // about flushing the current shard. This ensures that we never write
           // empty shards.
           if (lockfile_created_) {
-            // Flush the current bundle.
+            // Flush the current bundle and columns.
             TF_RETURN_IF_ERROR(writer_->Finish());
+            if (column_writer_) {
+              TF_RETURN_IF_ERROR(column_writer_->Finish());
+            }
 
             // Note: We do not delete the lockfile here. We keep lockfiles of
             // all shards around until the entire cache has been written to
@@ -310,10 +347,19 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
           lockfile_ = strings::StrCat(filename_, ".lockfile");
           writer_.reset(new BundleWriter(dataset()->env_, filename_));
+          ResetColumnWriter();
           return Status::OK();
         }
 
        private:
+        void ResetColumnWriter() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          if (dataset()->use_columns_) {
+            column_writer_.reset(new ColumnCacheWriter(
+                dataset()->env_, filename_, dataset()->output_dtypes(),
+                dataset()->output_shapes()));
+          }
+        }
+
         Status EnsureLockFileExists() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           if (iteration_completed_)
             return errors::OutOfRange(
@@ -370,6 +416,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
             // new temp files which can delete the temp files created by a
             // BundleWriter in another Session.
             writer_.reset(new BundleWriter(dataset()->env_, filename_));
+            ResetColumnWriter();
             lockfile_created_ = true;
             return Status::OK();
           }
@@ -377,9 +424,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
         Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           iteration_completed_ = true;
-          // Flush the current bundle.
+          // Flush the current bundle and columns.
           TF_RETURN_IF_ERROR(writer_->Finish());
-          // Merge all the bundles.
+          if (column_writer_) {
+            TF_RETURN_IF_ERROR(column_writer_->Finish());
+          }
+          // Merge all the bundles and columns.
           // Currently there are `shard_id_ + 1` bundles, one for each
           // checkpoint. Each bundle has prefix <filename>_<id> where `id` is an
           // integer starting at 0 an incremented by 1 for each new checkpoint.
@@ -393,6 +443,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
               prefixes.emplace_back(
                   strings::StrCat(dataset()->filename_, "_", i));
             }
+            // The merged bundle marks the cache as complete, so it must be
+            // written after the merged columns.
+            if (column_writer_) {
+              TF_RETURN_IF_ERROR(MergeColumnCaches(dataset()->env_, prefixes,
+                                                   dataset()->filename_));
+            }
             TF_RETURN_IF_ERROR(
                 MergeBundles(dataset()->env_, prefixes, dataset()->filename_));
           }
@@ -414,6 +470,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         // `StrCat(dataset()->filename_, "_", shard_id_)`.
         string filename_;
         std::unique_ptr<BundleWriter> writer_ GUARDED_BY(mu_);
+        // Set if any component is stored in a column.
+        std::unique_ptr<ColumnCacheWriter> column_writer_ GUARDED_BY(mu_);
         string lockfile_ GUARDED_BY(mu_);
         bool lockfile_created_ GUARDED_BY(mu_);
         bool iteration_completed_ GUARDED_BY(mu_);
@@ -425,15 +483,33 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
             : DatasetIterator<FileDataset>(params),
               cur_index_(0),
               reader_(dataset()->env_, dataset()->filename_),
-              iterator_restored_(false) {}
+              iterator_restored_(false) {
+          // Caches written before the columnar format was introduced store
+          // every component in the bundle.
+          if (ColumnCacheReader::Exists(dataset()->env_,
+                                        dataset()->filename_)) {
+            columns_status_ = ColumnCacheReader::Open(
+                dataset()->env_, dataset()->filename_, &columns_);
+          }
+          for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
+            if (!IsColumn(i)) {
+              num_bundle_tensors_++;
+            }
+          }
+        }
 
         Status GetNextInternal(IteratorContext* ctx,
                                std::vector<Tensor>* out_tensors,
                                bool* end_of_sequence) override {
           mutex_lock l(mu_);
           *end_of_sequence = false;
+          TF_RETURN_IF_ERROR(columns_status_);
           TF_RETURN_IF_ERROR(reader_.status());
-          if (!reader_.Valid()) {
+          if (columns_ && cur_index_ >= columns_->num_elements()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          if (num_bundle_tensors_ > 0 && !reader_.Valid()) {
             return errors::Internal(
                 "Cache iterator is in an invalid state. (Perhaps GetNext "
                 "called "
@@ -443,6 +519,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           out_tensors->resize(dataset()->num_tensors_);
 
           for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
+            if (IsColumn(i)) {
+              TF_RETURN_IF_ERROR(
+                  columns_->Read(i, cur_index_, &(*out_tensors)[i]));
+              continue;
+            }
             // When the iterator is restored from the checkpoint, `reader_` is
             // already pointing at `key` so we do not need to skip the header
             // entry.
@@ -492,16 +573,29 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           if (!reader_.Valid()) {
             return errors::Internal("Error initializing BundleReader.");
           }
-          reader_.Seek(dataset()->FormatName(cur_index_, 0));
-          iterator_restored_ = true;
+          if (num_bundle_tensors_ > 0) {
+            // Columns are not in the bundle, so this finds the first
+            // component of the element that is.
+            reader_.Seek(dataset()->FormatName(cur_index_, 0));
+            iterator_restored_ = true;
+          }
           return Status::OK();
         }
 
        private:
+        bool IsColumn(size_t index) const {
+          return columns_ && columns_->IsColumn(index);
+        }
+
         mutex mu_;
         size_t cur_index_ GUARDED_BY(mu_);
         BundleReader reader_ GUARDED_BY(mu_);
         bool iterator_restored_ GUARDED_BY(mu_);
+        // Set if the cache was written in the columnar format.
+        std::unique_ptr<ColumnCacheReader> columns_;
+        Status columns_status_;
+        // The number of components of each element stored in the bundle.
+        size_t num_bundle_tensors_ = 0;
       };  // FileReaderIterator
 
       void InitializeIterator() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -532,6 +626,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     const string filename_;
     Env* const env_;
     const size_t num_tensors_;
+    // True if any component is written in the columnar format.
+    const bool use_columns_;
     const size_t tensor_index_padding_size_;
     static const size_t kMaxItems = 10000000;  // 10 million
     const size_t item_index_padding_size_;
@@ -540,7 +636,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
   class MemoryDataset : public DatasetBase {
    public:
-    explicit MemoryDataset(const DatasetBase* input) : input_(input) {
+    MemoryDataset(const DatasetBase* input, const string& compression)
+        : input_(input), compression_(compression) {
       input->Ref();
     }
 
@@ -553,6 +650,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         return std::unique_ptr<IteratorBase>(new MemoryReaderIterator(
             {this, strings::StrCat(prefix, "::MemoryReader")}, cache_.get()));
       }
+      if (compressed_cache_) {
+        return std::unique_ptr<IteratorBase>(new CompressedMemoryReaderIterator(
+            {this, strings::StrCat(prefix, "::CompressedMemoryReader")},
+            compressed_cache_.get()));
+      }
       if (!writer_iterator_created_) {
         writer_iterator_created_ = true;
         return std::unique_ptr<IteratorBase>(new MemoryWriterIterator(
@@ -581,15 +683,25 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     // This iterator is used when dataset->cache_ is null. After buffering
     // the tensors in memory, upon exhausing the underlying iterator, they are
     // updated into the parent dataset's cache_ pointer.
+    //
+    // If the dataset has a compression, the items are instead serialized into
+    // a `CompressedCacheBuilder`, which compresses each full block on the
+    // runner threads, and the result is moved into the parent dataset's
+    // compressed_cache_ pointer.
     class MemoryWriterIterator : public DatasetIterator<MemoryDataset> {
      public:
       explicit MemoryWriterIterator(const Params& params)
-          : DatasetIterator<MemoryDataset>(params),
-            cache_(new std::vector<std::vector<Tensor>>) {}
+          : DatasetIterator<MemoryDataset>(params) {
+        if (dataset()->compression_.empty()) {
+          cache_.reset(new std::vector<std::vector<Tensor>>);
+        } else {
+          builder_.reset(new CompressedCacheBuilder(dataset()->compression_));
+        }
+      }
 
       ~MemoryWriterIterator() override {
         mutex_lock l(mu_);
-        if (cache_) {
+        if (cache_ || builder_) {
           LOG(ERROR)
               << "The calling iterator did not fully read the dataset we were "
                  "attempting to cache. In order to avoid unexpected truncation "
@@ -613,16 +725,27 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         TF_RETURN_IF_ERROR(
             input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
         if (*end_of_sequence) {
-          // Guard on cache_ to not crash if GetNext is called a second time
-          // after *end_of_sequence == true
+          // Guard on cache_ and builder_ to not crash if GetNext is called a
+          // second time after *end_of_sequence == true
           if (cache_) {
             mutex_lock l(dataset()->mu_);
             DCHECK(dataset()->writer_iterator_created_);
             DCHECK(!dataset()->cache_);
             cache_.swap(dataset()->cache_);
+          } else if (builder_) {
+            std::unique_ptr<CompressedCache> compressed_cache;
+            TF_RETURN_IF_ERROR(builder_->Finish(&compressed_cache));
+            builder_.reset();
+            mutex_lock l(dataset()->mu_);
+            DCHECK(dataset()->writer_iterator_created_);
+            DCHECK(!dataset()->compressed_cache_);
+            compressed_cache.swap(dataset()->compressed_cache_);
           }
           return Status::OK();
         }
+        if (builder_) {
+          return builder_->Add(*out_tensors, *ctx->runner());
+        }
         cache_->emplace_back(*out_tensors);
         return Status::OK();
       }
@@ -631,6 +754,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
       std::unique_ptr<std::vector<std::vector<Tensor>>> cache_ GUARDED_BY(mu_);
+      std::unique_ptr<CompressedCacheBuilder> builder_ GUARDED_BY(mu_);
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDataset> {
@@ -664,6 +788,82 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       size_t index_ GUARDED_BY(mu_);
     };  // MemoryReaderIterator
 
+    // Reads the items of a `CompressedCache`, decompressing up to
+    // `kBlocksAhead` blocks in parallel on the runner threads.
+    class CompressedMemoryReaderIterator
+        : public DatasetIterator<MemoryDataset> {
+     public:
+      explicit CompressedMemoryReaderIterator(const Params& params,
+                                              const CompressedCache* cache)
+          : DatasetIterator<MemoryDataset>(params), cache_(cache) {
+        CHECK(cache);
+      }
+
+      ~CompressedMemoryReaderIterator() override {
+        // The pending closures refer to `cache_`, which is owned by the
+        // dataset, so we must wait for them before releasing our reference
+        // to it.
+        mutex_lock l(mu_);
+        for (const auto& block : blocks_) {
+          block->done.WaitForNotification();
+        }
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        ScheduleBlocks(ctx);
+        while (!blocks_.empty()) {
+          DecompressedBlock* block = blocks_.front().get();
+          block->done.WaitForNotification();
+          TF_RETURN_IF_ERROR(block->status);
+          if (element_index_ < block->elements.size()) {
+            *out_tensors = std::move(block->elements[element_index_++]);
+            *end_of_sequence = false;
+            return Status::OK();
+          }
+          blocks_.pop_front();
+          element_index_ = 0;
+          ScheduleBlocks(ctx);
+        }
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     private:
+      static constexpr size_t kBlocksAhead = 8;
+
+      struct DecompressedBlock {
+        Notification done;
+        Status status;
+        std::vector<std::vector<Tensor>> elements;
+      };
+
+      void ScheduleBlocks(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (blocks_.size() < kBlocksAhead &&
+               next_block_ < cache_->num_blocks()) {
+          std::shared_ptr<DecompressedBlock> block =
+              std::make_shared<DecompressedBlock>();
+          blocks_.push_back(block);
+          const CompressedCache* cache = cache_;
+          const size_t index = next_block_++;
+          (*ctx->runner())([cache, index, block]() {
+            block->status = cache->ReadBlock(index, &block->elements);
+            block->done.Notify();
+          });
+        }
+      }
+
+      mutex mu_;
+      const CompressedCache* const cache_;
+      // The blocks that have been scheduled for decompression, in order.
+      std::deque<std::shared_ptr<DecompressedBlock>> blocks_ GUARDED_BY(mu_);
+      size_t next_block_ GUARDED_BY(mu_) = 0;
+      // The index of the next element in `blocks_.front()`.
+      size_t element_index_ GUARDED_BY(mu_) = 0;
+    };  // CompressedMemoryReaderIterator
+
     class DuplicateWriterIterator : public DatasetIterator<MemoryDataset> {
      public:
       explicit DuplicateWriterIterator(const Params& params)
@@ -678,12 +878,16 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     };  // DuplicateWriterIterator
 
     const DatasetBase* const input_;
+    const string compression_;
     mutable mutex mu_;
     mutable std::unique_ptr<std::vector<std::vector<Tensor>>> cache_
         GUARDED_BY(mu_);
+    mutable std::unique_ptr<CompressedCache> compressed_cache_ GUARDED_BY(mu_);
     mutable bool writer_iterator_created_ GUARDED_BY(mu_) = false;
   };  // MemoryDataset
-};    // CacheDatasetOp
+
+  string compression_;
+};  // CacheDatasetOp
 
 REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
                         CacheDatasetOp);
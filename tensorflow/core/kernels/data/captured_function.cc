@@ -189,6 +189,11 @@ Status CapturedFunction::MaybeInstantiate(
       return errors::Internal("Failed to instantiate function body.");
     }
     ret_types_ = fbody->ret_types;
+    Status s = InlineFunction::Create(lib_, f_handle_, &inline_function_);
+    if (!s.ok()) {
+      VLOG(1) << "Not inlining function " << func_.name() << ": " << s;
+      inline_function_.reset();
+    }
   } else {
     // TODO(mrry): Consider moving this under a shared lock, as it is
     // the common case.
@@ -206,6 +211,11 @@ Status CapturedFunction::Run(IteratorContext* ctx, std::vector<Tensor>&& args,
                              std::vector<Tensor>* rets) {
   FunctionLibraryRuntime::Handle handle;
   TF_RETURN_IF_ERROR(MaybeInstantiate(ctx, &handle));
+  OwnedArgsCallFrame frame(std::move(args), &captured_inputs_, ret_types_);
+  if (inline_function_ != nullptr) {
+    TF_RETURN_IF_ERROR(inline_function_->Run(&frame, ctx->runner()));
+    return frame.ConsumeRetvals(rets);
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   f_opts.step_id = CapturedFunction::generate_step_id();
@@ -226,7 +236,6 @@ Status CapturedFunction::Run(IteratorContext* ctx, std::vector<Tensor>&& args,
   CancellationManager c_mgr;
   f_opts.cancellation_manager = &c_mgr;
 
-  OwnedArgsCallFrame frame(std::move(args), &captured_inputs_, ret_types_);
   Notification n;
   Status s;
   ctx->lib()->Run(f_opts, handle, &frame, [&n, &s](Status func_status) {
@@ -243,6 +252,11 @@ Status CapturedFunction::RunWithBorrowedArgs(IteratorContext* ctx,
                                              std::vector<Tensor>* rets) {
   FunctionLibraryRuntime::Handle handle;
   TF_RETURN_IF_ERROR(MaybeInstantiate(ctx, &handle));
+  BorrowedArgsCallFrame frame(args, &captured_inputs_, ret_types_);
+  if (inline_function_ != nullptr) {
+    TF_RETURN_IF_ERROR(inline_function_->Run(&frame, ctx->runner()));
+    return frame.ConsumeRetvals(rets);
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   f_opts.step_id = CapturedFunction::generate_step_id();
@@ -263,7 +277,6 @@ Status CapturedFunction::RunWithBorrowedArgs(IteratorContext* ctx,
   CancellationManager c_mgr;
   f_opts.cancellation_manager = &c_mgr;
 
-  BorrowedArgsCallFrame frame(args, &captured_inputs_, ret_types_);
   Notification n;
   Status s;
 
@@ -291,6 +304,7 @@ Status CapturedFunction::RunInstantiated(const std::vector<Tensor>& args,
   FunctionLibraryRuntime* lib;
   FunctionLibraryRuntime::Handle handle;
   std::function<void(std::function<void()>)>* runner;
+  const InlineFunction* inline_function;
   {
     tf_shared_lock l(mu_);
     if (lib_ == nullptr) {
@@ -301,6 +315,13 @@ Status CapturedFunction::RunInstantiated(const std::vector<Tensor>& args,
     lib = lib_;
     handle = f_handle_;
     runner = &captured_runner_;
+    inline_function = inline_function_.get();
+  }
+
+  BorrowedArgsCallFrame frame(args, &captured_inputs_, ret_types_);
+  if (inline_function != nullptr) {
+    TF_RETURN_IF_ERROR(inline_function->Run(&frame, runner));
+    return frame.ConsumeRetvals(rets);
   }
 
   FunctionLibraryRuntime::Options f_opts;
@@ -322,7 +343,6 @@ Status CapturedFunction::RunInstantiated(const std::vector<Tensor>& args,
   CancellationManager c_mgr;
   f_opts.cancellation_manager = &c_mgr;
 
-  BorrowedArgsCallFrame frame(args, &captured_inputs_, ret_types_);
   Notification n;
   Status s;
 
@@ -348,6 +368,24 @@ void CapturedFunction::RunAsync(IteratorContext* ctx,
     done(s);
     return;
   }
+  if (inline_function_ != nullptr) {
+    // Run the kernels in a single closure on the runner, so that concurrent
+    // calls still run in parallel.
+    auto runner = std::make_shared<std::function<void(std::function<void()>)>>(
+        *ctx->runner());
+    auto frame = std::make_shared<OwnedArgsCallFrame>(
+        std::move(args), &captured_inputs_, ret_types_);
+    (*runner)(std::bind(
+        [this, rets, runner, frame](FunctionLibraryRuntime::DoneCallback done) {
+          Status s = inline_function_->Run(frame.get(), runner.get());
+          if (s.ok()) {
+            s = frame->ConsumeRetvals(rets);
+          }
+          done(s);
+        },
+        std::move(done)));
+    return;
+  }
   auto frame =
       new OwnedArgsCallFrame(std::move(args), &captured_inputs_, ret_types_);
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/inline_function.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -90,7 +91,9 @@ class CapturedFunction {
   // Asynchronously runs the captured function on the given `args`, stores
   // the results in `*rets`, and calls the given `done` callback when the
   // function returns. This method takes ownership of the tensors in `args`,
-  // in order to be able to deallocate them as early as possible.
+  // in order to be able to deallocate them as early as possible. A function
+  // that runs without the executor still runs on `ctx->runner()`, so that
+  // concurrent calls run in parallel.
   void RunAsync(IteratorContext* ctx, std::vector<Tensor>&& args,
                 std::vector<Tensor>* rets,
                 FunctionLibraryRuntime::DoneCallback done);
@@ -126,6 +129,9 @@ class CapturedFunction {
   const std::vector<Tensor> captured_inputs_;
   DataTypeSlice ret_types_;
   std::function<void(std::function<void()>)> captured_runner_ = nullptr;
+  // Set by `MaybeInstantiate()` if the function body is small enough to run
+  // its kernels directly, and never modified afterwards.
+  std::unique_ptr<InlineFunction> inline_function_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CapturedFunction);
 };
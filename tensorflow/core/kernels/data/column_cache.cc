@@ -0,0 +1,504 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/column_cache.h"
+
+#include <string.h>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+const uint32 kColumnMetaMagic = 0x636f6c31;  // "col1"
+
+// Chunk size for copying columns when merging caches.
+const size_t kMergeChunkBytes = 8 << 20;
+
+// Zeros used to pad rows to their stride.
+const char kPadding[Allocator::kAllocatorAlignment] = {0};
+
+// Keeps a mapped column alive for as long as any tensor aliases it.
+class MappedColumn : public core::RefCounted {
+ public:
+  explicit MappedColumn(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const {
+    return static_cast<const char*>(region_->data());
+  }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+// The layout of one component of the cache.
+struct ColumnLayout {
+  bool is_column = false;
+  DataType dtype = DT_INVALID;
+  TensorShape shape;
+  int64 row_bytes = 0;
+  // The distance in bytes between the starts of consecutive rows.
+  int64 stride = 0;
+};
+
+ColumnLayout MakeLayout(DataType dtype, const PartialTensorShape& shape) {
+  ColumnLayout layout;
+  if (!DataTypeCanUseMemcpy(dtype) || !shape.AsTensorShape(&layout.shape)) {
+    return layout;
+  }
+  layout.row_bytes = layout.shape.num_elements() * DataTypeSize(dtype);
+  if (layout.row_bytes == 0) {
+    return layout;
+  }
+  layout.is_column = true;
+  layout.dtype = dtype;
+  layout.stride = layout.row_bytes;
+  if (layout.row_bytes >= kMinAlignedRowBytes) {
+    const int64 alignment = Allocator::kAllocatorAlignment;
+    layout.stride = (layout.row_bytes + alignment - 1) / alignment * alignment;
+  }
+  return layout;
+}
+
+struct ColumnMeta {
+  int64 num_elements = 0;
+  std::vector<ColumnLayout> layouts;
+};
+
+string EncodeMeta(const ColumnMeta& meta) {
+  string out;
+  core::PutFixed32(&out, kColumnMetaMagic);
+  core::PutVarint64(&out, meta.num_elements);
+  core::PutVarint32(&out, meta.layouts.size());
+  for (const ColumnLayout& layout : meta.layouts) {
+    core::PutVarint32(&out, layout.is_column ? 1 : 0);
+    if (!layout.is_column) continue;
+    core::PutVarint32(&out, layout.dtype);
+    core::PutVarint32(&out, layout.shape.dims());
+    for (int d = 0; d < layout.shape.dims(); ++d) {
+      core::PutVarint64(&out, layout.shape.dim_size(d));
+    }
+    core::PutVarint64(&out, layout.stride);
+  }
+  return out;
+}
+
+Status ReadMeta(Env* env, StringPiece prefix, ColumnMeta* meta) {
+  const string filename = ColumnMetaFilename(prefix);
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+  StringPiece input(contents);
+  const Status corrupt =
+      errors::DataLoss("Corrupt column cache metadata: ", filename);
+  if (input.size() < sizeof(uint32) ||
+      core::DecodeFixed32(input.data()) != kColumnMetaMagic) {
+    return corrupt;
+  }
+  input.remove_prefix(sizeof(uint32));
+  uint64 num_elements;
+  uint32 num_components;
+  if (!core::GetVarint64(&input, &num_elements) ||
+      !core::GetVarint32(&input, &num_components)) {
+    return corrupt;
+  }
+  meta->num_elements = num_elements;
+  meta->layouts.resize(num_components);
+  for (ColumnLayout& layout : meta->layouts) {
+    uint32 is_column;
+    if (!core::GetVarint32(&input, &is_column)) return corrupt;
+    if (!is_column) continue;
+    uint32 dtype, dims;
+    if (!core::GetVarint32(&input, &dtype) ||
+        !core::GetVarint32(&input, &dims)) {
+      return corrupt;
+    }
+    layout.is_column = true;
+    layout.dtype = static_cast<DataType>(dtype);
+    for (uint32 d = 0; d < dims; ++d) {
+      uint64 dim_size;
+      if (!core::GetVarint64(&input, &dim_size)) return corrupt;
+      layout.shape.AddDim(dim_size);
+    }
+    uint64 stride;
+    if (!core::GetVarint64(&input, &stride)) return corrupt;
+    layout.stride = stride;
+    layout.row_bytes =
+        layout.shape.num_elements() * DataTypeSize(layout.dtype);
+    if (layout.row_bytes <= 0 || layout.stride < layout.row_bytes) {
+      return corrupt;
+    }
+  }
+  return Status::OK();
+}
+
+// Atomically replaces the metadata file of the cache `prefix`.
+Status WriteMeta(Env* env, StringPiece prefix, const ColumnMeta& meta) {
+  const string filename = ColumnMetaFilename(prefix);
+  const string tmp_filename =
+      strings::StrCat(filename, ".tempstate", random::New64());
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_filename, EncodeMeta(meta)));
+  return env->RenameFile(tmp_filename, filename);
+}
+
+bool SameLayout(const ColumnLayout& a, const ColumnLayout& b) {
+  return a.is_column == b.is_column &&
+         (!a.is_column || (a.dtype == b.dtype && a.shape == b.shape &&
+                           a.stride == b.stride));
+}
+
+// Appends the contents of `filename` to `out`.
+Status AppendFile(Env* env, const string& filename, WritableFile* out) {
+  uint64 size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &size));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  std::unique_ptr<char[]> scratch(new char[kMergeChunkBytes]);
+  for (uint64 offset = 0; offset < size;) {
+    const size_t n = std::min<uint64>(kMergeChunkBytes, size - offset);
+    StringPiece chunk;
+    TF_RETURN_IF_ERROR(file->Read(offset, n, &chunk, scratch.get()));
+    if (chunk.size() != n) {
+      return errors::DataLoss("Unexpected end of column file ", filename);
+    }
+    TF_RETURN_IF_ERROR(out->Append(chunk));
+    offset += n;
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// A TensorBuffer aliasing one row of a mapped column.
+class ColumnTensorBuffer : public TensorBuffer {
+ public:
+  ColumnTensorBuffer(MappedColumn* column, const char* data, size_t len)
+      : column_(column), data_(const_cast<char*>(data)), len_(len) {
+    column_->Ref();
+  }
+
+  ~ColumnTensorBuffer() override { column_->Unref(); }
+
+  void* data() const override { return data_; }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("ColumnCache");
+  }
+
+  // The mapping is read-only, so it must not be forwarded to an op output.
+  bool OwnsMemory() const override { return false; }
+
+  Tensor MakeTensor(DataType dtype, const TensorShape& shape) {
+    CHECK_EQ(len_, shape.num_elements() * DataTypeSize(dtype));
+    return Tensor(dtype, shape, this);
+  }
+
+ private:
+  MappedColumn* column_;
+  char* data_;
+  size_t len_;
+};
+
+bool CanStoreInColumn(DataType dtype, const PartialTensorShape& shape) {
+  return MakeLayout(dtype, shape).is_column;
+}
+
+string ColumnFilename(StringPiece prefix, size_t index) {
+  return strings::StrCat(prefix, ".column-", index);
+}
+
+string ColumnMetaFilename(StringPiece prefix) {
+  return strings::StrCat(prefix, ".columns");
+}
+
+struct ColumnCacheWriter::Column {
+  ColumnLayout layout;
+  string tmp_filename;
+  std::unique_ptr<WritableFile> file;
+  int64 num_rows = 0;
+};
+
+ColumnCacheWriter::ColumnCacheWriter(
+    Env* env, StringPiece prefix, const DataTypeVector& dtypes,
+    const std::vector<PartialTensorShape>& shapes)
+    : env_(env),
+      prefix_(prefix.ToString()),
+      tmp_suffix_(strings::StrCat(".tempstate", random::New64())) {
+  DCHECK_EQ(dtypes.size(), shapes.size());
+  columns_.resize(dtypes.size());
+  for (size_t i = 0; i < dtypes.size(); ++i) {
+    ColumnLayout layout = MakeLayout(dtypes[i], shapes[i]);
+    if (!layout.is_column) continue;
+    std::unique_ptr<Column> column(new Column);
+    column->layout = std::move(layout);
+    column->tmp_filename =
+        strings::StrCat(ColumnFilename(prefix_, i), tmp_suffix_);
+    status_.Update(
+        env_->NewWritableFile(column->tmp_filename, &column->file));
+    columns_[i] = std::move(column);
+  }
+}
+
+ColumnCacheWriter::~ColumnCacheWriter() {
+  if (finished_) return;
+  for (const auto& column : columns_) {
+    if (column == nullptr || column->file == nullptr) continue;
+    column->file->Close().IgnoreError();
+    env_->DeleteFile(column->tmp_filename).IgnoreError();
+  }
+}
+
+bool ColumnCacheWriter::IsColumn(size_t index) const {
+  return index < columns_.size() && columns_[index] != nullptr;
+}
+
+Status ColumnCacheWriter::Add(size_t index, const Tensor& t) {
+  TF_RETURN_IF_ERROR(status_);
+  if (finished_) {
+    return errors::FailedPrecondition("Column cache ", prefix_,
+                                      " is already finished.");
+  }
+  if (!IsColumn(index)) {
+    return errors::InvalidArgument("Component ", index,
+                                   " is not stored in a column.");
+  }
+  Column* column = columns_[index].get();
+  const ColumnLayout& layout = column->layout;
+  if (t.dtype() != layout.dtype || t.shape() != layout.shape) {
+    return errors::InvalidArgument(
+        "Cannot cache component ", index, ": expected a ",
+        DataTypeString(layout.dtype), " tensor of shape ",
+        layout.shape.DebugString(), " but got a ", DataTypeString(t.dtype()),
+        " tensor of shape ", t.shape().DebugString(), ".");
+  }
+  Status s = column->file->Append(t.tensor_data());
+  if (s.ok() && layout.stride > layout.row_bytes) {
+    s = column->file->Append(
+        StringPiece(kPadding, layout.stride - layout.row_bytes));
+  }
+  status_.Update(s);
+  ++column->num_rows;
+  return s;
+}
+
+Status ColumnCacheWriter::Finish() {
+  TF_RETURN_IF_ERROR(status_);
+  if (finished_) {
+    return errors::FailedPrecondition("Column cache ", prefix_,
+                                      " is already finished.");
+  }
+  finished_ = true;
+  ColumnMeta meta;
+  meta.num_elements = -1;
+  meta.layouts.resize(columns_.size());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    Column* column = columns_[i].get();
+    if (column == nullptr) continue;
+    meta.layouts[i] = column->layout;
+    if (meta.num_elements < 0) {
+      meta.num_elements = column->num_rows;
+    } else if (meta.num_elements != column->num_rows) {
+      status_.Update(errors::Internal("Column ", i, " of ", prefix_, " has ",
+                                      column->num_rows, " rows but expected ",
+                                      meta.num_elements, "."));
+    }
+    status_.Update(column->file->Close());
+  }
+  if (meta.num_elements < 0) {
+    status_.Update(errors::InvalidArgument(
+        "Column cache ", prefix_, " has no components stored in columns."));
+  }
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    Column* column = columns_[i].get();
+    if (column == nullptr) continue;
+    if (status_.ok()) {
+      status_.Update(
+          env_->RenameFile(column->tmp_filename, ColumnFilename(prefix_, i)));
+    } else {
+      env_->DeleteFile(column->tmp_filename).IgnoreError();
+    }
+  }
+  TF_RETURN_IF_ERROR(status_);
+  status_ = WriteMeta(env_, prefix_, meta);
+  return status_;
+}
+
+Status MergeColumnCaches(Env* env, const std::vector<string>& prefixes,
+                         StringPiece merged_prefix) {
+  if (prefixes.empty()) {
+    return errors::InvalidArgument("No column caches to merge.");
+  }
+  ColumnMeta merged;
+  for (size_t p = 0; p < prefixes.size(); ++p) {
+    ColumnMeta meta;
+    TF_RETURN_IF_ERROR(ReadMeta(env, prefixes[p], &meta));
+    if (p == 0) {
+      merged = meta;
+      continue;
+    }
+    if (meta.layouts.size() != merged.layouts.size()) {
+      return errors::InvalidArgument("Column cache ", prefixes[p],
+                                     " has a different number of components.");
+    }
+    for (size_t i = 0; i < meta.layouts.size(); ++i) {
+      if (!SameLayout(meta.layouts[i], merged.layouts[i])) {
+        return errors::InvalidArgument("Column ", i, " of ", prefixes[p],
+                                       " has a different layout.");
+      }
+    }
+    merged.num_elements += meta.num_elements;
+  }
+
+  const string tmp_suffix = strings::StrCat(".tempstate", random::New64());
+  for (size_t i = 0; i < merged.layouts.size(); ++i) {
+    if (!merged.layouts[i].is_column) continue;
+    const string filename = ColumnFilename(merged_prefix, i);
+    if (prefixes.size() == 1) {
+      // The common case, when the cache was written without checkpoints.
+      TF_RETURN_IF_ERROR(
+          env->RenameFile(ColumnFilename(prefixes[0], i), filename));
+      continue;
+    }
+    const string tmp_filename = strings::StrCat(filename, tmp_suffix);
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_filename, &file));
+    for (const string& prefix : prefixes) {
+      TF_RETURN_IF_ERROR(
+          AppendFile(env, ColumnFilename(prefix, i), file.get()));
+    }
+    TF_RETURN_IF_ERROR(file->Close());
+    TF_RETURN_IF_ERROR(env->RenameFile(tmp_filename, filename));
+    for (const string& prefix : prefixes) {
+      TF_RETURN_IF_ERROR(env->DeleteFile(ColumnFilename(prefix, i)));
+    }
+  }
+  for (const string& prefix : prefixes) {
+    TF_RETURN_IF_ERROR(env->DeleteFile(ColumnMetaFilename(prefix)));
+  }
+  return WriteMeta(env, merged_prefix, merged);
+}
+
+struct ColumnCacheReader::Column {
+  ~Column() {
+    if (mapped != nullptr) mapped->Unref();
+  }
+
+  ColumnLayout layout;
+  // Exactly one of `mapped` and `file` is set.
+  MappedColumn* mapped = nullptr;
+  std::unique_ptr<RandomAccessFile> file;
+};
+
+/* static */
+bool ColumnCacheReader::Exists(Env* env, StringPiece prefix) {
+  return env->FileExists(ColumnMetaFilename(prefix)).ok();
+}
+
+/* static */
+Status ColumnCacheReader::Open(Env* env, StringPiece prefix,
+                               std::unique_ptr<ColumnCacheReader>* out) {
+  ColumnMeta meta;
+  TF_RETURN_IF_ERROR(ReadMeta(env, prefix, &meta));
+  std::unique_ptr<ColumnCacheReader> reader(new ColumnCacheReader);
+  reader->num_elements_ = meta.num_elements;
+  reader->columns_.resize(meta.layouts.size());
+  for (size_t i = 0; i < meta.layouts.size(); ++i) {
+    if (!meta.layouts[i].is_column) continue;
+    std::unique_ptr<Column> column(new Column);
+    column->layout = meta.layouts[i];
+    const string filename = ColumnFilename(prefix, i);
+    const uint64 expected_size = meta.num_elements * column->layout.stride;
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    // An empty file cannot be mapped, but is never read either.
+    Status s = expected_size == 0
+                   ? errors::Unimplemented("Empty column")
+                   : env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    if (s.ok()) {
+      column->mapped = new MappedColumn(std::move(region));
+      if (column->mapped->length() != expected_size) {
+        return errors::DataLoss("Column file ", filename, " has ",
+                                column->mapped->length(),
+                                " bytes but expected ", expected_size, ".");
+      }
+    } else if (errors::IsUnimplemented(s)) {
+      // Not every file system supports memory-mapping.
+      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &column->file));
+    } else {
+      return s;
+    }
+    reader->columns_[i] = std::move(column);
+  }
+  *out = std::move(reader);
+  return Status::OK();
+}
+
+ColumnCacheReader::~ColumnCacheReader() {}
+
+bool ColumnCacheReader::IsColumn(size_t index) const {
+  return index < columns_.size() && columns_[index] != nullptr;
+}
+
+Status ColumnCacheReader::Read(size_t index, int64 element,
+                               Tensor* out) const {
+  if (!IsColumn(index)) {
+    return errors::InvalidArgument("Component ", index,
+                                   " is not stored in a column.");
+  }
+  if (element < 0 || element >= num_elements_) {
+    return errors::OutOfRange("Element ", element, " is out of range.");
+  }
+  const Column& column = *columns_[index];
+  const ColumnLayout& layout = column.layout;
+  const int64 offset = element * layout.stride;
+  if (column.mapped != nullptr) {
+    const char* row = column.mapped->data() + offset;
+    if (reinterpret_cast<intptr_t>(row) % Allocator::kAllocatorAlignment ==
+        0) {
+      ColumnTensorBuffer* buf =
+          new ColumnTensorBuffer(column.mapped, row, layout.row_bytes);
+      *out = buf->MakeTensor(layout.dtype, layout.shape);
+      buf->Unref();
+      return Status::OK();
+    }
+    *out = Tensor(layout.dtype, layout.shape);
+    memcpy(const_cast<char*>(out->tensor_data().data()), row,
+           layout.row_bytes);
+    return Status::OK();
+  }
+  *out = Tensor(layout.dtype, layout.shape);
+  char* dst = const_cast<char*>(out->tensor_data().data());
+  StringPiece row;
+  TF_RETURN_IF_ERROR(column.file->Read(offset, layout.row_bytes, &row, dst));
+  if (row.size() != layout.row_bytes) {
+    return errors::DataLoss("Unexpected end of column file for component ",
+                            index, ".");
+  }
+  if (row.data() != dst) {
+    memcpy(dst, row.data(), layout.row_bytes);
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
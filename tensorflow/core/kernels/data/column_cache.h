@@ -0,0 +1,140 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_COLUMN_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_COLUMN_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+
+// The columnar on-disk format of a `Dataset.cache(filename)` cache.
+//
+// Every component of the cached elements whose dtype can be memcpy'd and
+// whose shape is fully defined is stored as a column: the values of that
+// component for all elements, one after another, in the file
+// `ColumnFilename(prefix, index)`. Rows of at least `kMinAlignedRowBytes`
+// bytes are padded to a multiple of `Allocator::kAllocatorAlignment`, so
+// that when a column is memory-mapped each row can be returned as a tensor
+// that aliases the mapping. The file `ColumnMetaFilename(prefix)` records the
+// number of elements and the layout of each column, and is written last.
+//
+// The remaining (variable-size) components are not handled here, and are
+// stored in a tensor bundle by the caller.
+
+// Rows of a column that are smaller than this are not padded, and are copied
+// out of the column when read.
+constexpr int64 kMinAlignedRowBytes = 512;
+
+// Returns true if the values of a component with the given `dtype` and
+// `shape` can be stored in a column.
+bool CanStoreInColumn(DataType dtype, const PartialTensorShape& shape);
+
+// Returns the name of the file holding column `index` of the cache `prefix`.
+string ColumnFilename(StringPiece prefix, size_t index);
+// Returns the name of the metadata file of the cache `prefix`.
+string ColumnMetaFilename(StringPiece prefix);
+
+// Writes the columns of a sequence of elements. The columns only become
+// visible to readers when `Finish()` succeeds.
+class ColumnCacheWriter {
+ public:
+  ColumnCacheWriter(Env* env, StringPiece prefix, const DataTypeVector& dtypes,
+                    const std::vector<PartialTensorShape>& shapes);
+  ~ColumnCacheWriter();
+
+  // Returns true if component `index` is stored in a column, in which case
+  // the caller must pass its values to `Add()`.
+  bool IsColumn(size_t index) const;
+
+  // Appends `t`, the value of component `index` of the next element.
+  //
+  // REQUIRES: `IsColumn(index)`.
+  Status Add(size_t index, const Tensor& t);
+
+  // Closes the columns and writes the metadata file. All columns must have
+  // the same number of rows.
+  Status Finish();
+
+  // Returns the first error encountered so far.
+  Status status() const { return status_; }
+
+ private:
+  struct Column;
+
+  Env* const env_;
+  const string prefix_;
+  const string tmp_suffix_;
+  // Indexed by component; `nullptr` for components that are not columns.
+  std::vector<std::unique_ptr<Column>> columns_;
+  bool finished_ = false;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnCacheWriter);
+};
+
+// Concatenates the columns of the caches `prefixes`, in order, into the cache
+// `merged_prefix`, and deletes them. The caches must have identical layouts.
+Status MergeColumnCaches(Env* env, const std::vector<string>& prefixes,
+                         StringPiece merged_prefix);
+
+// Reads the columns of a cache written by `ColumnCacheWriter`.
+class ColumnCacheReader {
+ public:
+  // Returns true if the cache `prefix` has been written in this format.
+  static bool Exists(Env* env, StringPiece prefix);
+
+  // Opens the cache `prefix`. Its columns are memory-mapped if the file
+  // system supports it, and read with `RandomAccessFile` otherwise.
+  static Status Open(Env* env, StringPiece prefix,
+                     std::unique_ptr<ColumnCacheReader>* out);
+
+  ~ColumnCacheReader();
+
+  // Returns the number of elements in the cache.
+  int64 num_elements() const { return num_elements_; }
+
+  // Returns true if component `index` is stored in a column.
+  bool IsColumn(size_t index) const;
+
+  // Reads the value of component `index` of element `element`. When the
+  // column is mapped and its rows are aligned, `*out` aliases the mapping and
+  // keeps it alive; otherwise the row is copied into a new tensor.
+  //
+  // REQUIRES: `IsColumn(index)` and `0 <= element < num_elements()`.
+  Status Read(size_t index, int64 element, Tensor* out) const;
+
+ private:
+  struct Column;
+
+  ColumnCacheReader() {}
+
+  int64 num_elements_ = 0;
+  // Indexed by component; `nullptr` for components that are not columns.
+  std::vector<std::unique_ptr<Column>> columns_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnCacheReader);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_COLUMN_CACHE_H_
@@ -0,0 +1,225 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/column_cache.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& prefix) {
+  return strings::StrCat(testing::TmpDir(), "/", prefix);
+}
+
+// Elements have an aligned float image, an unaligned int64 label and a
+// variable-length string.
+const DataTypeVector& Dtypes() {
+  static DataTypeVector* dtypes =
+      new DataTypeVector({DT_FLOAT, DT_INT64, DT_STRING});
+  return *dtypes;
+}
+
+const std::vector<PartialTensorShape>& Shapes() {
+  static std::vector<PartialTensorShape>* shapes =
+      new std::vector<PartialTensorShape>(
+          {PartialTensorShape({7, 7, 3}), PartialTensorShape({}),
+           PartialTensorShape({-1})});
+  return *shapes;
+}
+
+Tensor Image(int64 i) {
+  Tensor t(DT_FLOAT, TensorShape({7, 7, 3}));
+  t.flat<float>().setConstant(static_cast<float>(i));
+  return t;
+}
+
+Tensor Label(int64 i) {
+  Tensor t(DT_INT64, TensorShape({}));
+  t.scalar<int64>()() = i;
+  return t;
+}
+
+// Writes elements [begin, end) to the cache `prefix`.
+Status WriteElements(const string& prefix, int64 begin, int64 end) {
+  ColumnCacheWriter writer(Env::Default(), prefix, Dtypes(), Shapes());
+  for (int64 i = begin; i < end; ++i) {
+    TF_RETURN_IF_ERROR(writer.Add(0, Image(i)));
+    TF_RETURN_IF_ERROR(writer.Add(1, Label(i)));
+  }
+  return writer.Finish();
+}
+
+void ExpectElements(const string& prefix, int64 num_elements) {
+  std::unique_ptr<ColumnCacheReader> reader;
+  TF_ASSERT_OK(ColumnCacheReader::Open(Env::Default(), prefix, &reader));
+  EXPECT_EQ(num_elements, reader->num_elements());
+  EXPECT_TRUE(reader->IsColumn(0));
+  EXPECT_TRUE(reader->IsColumn(1));
+  EXPECT_FALSE(reader->IsColumn(2));
+  for (int64 i = 0; i < num_elements; ++i) {
+    Tensor image, label;
+    TF_ASSERT_OK(reader->Read(0, i, &image));
+    TF_ASSERT_OK(reader->Read(1, i, &label));
+    EXPECT_TRUE(image.IsAligned());
+    test::ExpectTensorEqual<float>(Image(i), image);
+    test::ExpectTensorEqual<int64>(Label(i), label);
+  }
+  Tensor t;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->Read(0, num_elements, &t)));
+  EXPECT_TRUE(errors::IsInvalidArgument(reader->Read(2, 0, &t)));
+}
+
+TEST(ColumnCacheTest, CanStoreInColumn) {
+  EXPECT_TRUE(CanStoreInColumn(DT_FLOAT, PartialTensorShape({2, 3})));
+  EXPECT_TRUE(CanStoreInColumn(DT_INT64, PartialTensorShape({})));
+  EXPECT_FALSE(CanStoreInColumn(DT_FLOAT, PartialTensorShape({-1, 3})));
+  EXPECT_FALSE(CanStoreInColumn(DT_FLOAT, PartialTensorShape()));
+  EXPECT_FALSE(CanStoreInColumn(DT_FLOAT, PartialTensorShape({0})));
+  EXPECT_FALSE(CanStoreInColumn(DT_STRING, PartialTensorShape({})));
+  EXPECT_FALSE(CanStoreInColumn(DT_VARIANT, PartialTensorShape({})));
+}
+
+TEST(ColumnCacheTest, WriteAndRead) {
+  const string prefix = Prefix("write_and_read");
+  EXPECT_FALSE(ColumnCacheReader::Exists(Env::Default(), prefix));
+  TF_ASSERT_OK(WriteElements(prefix, 0, 10));
+  EXPECT_TRUE(ColumnCacheReader::Exists(Env::Default(), prefix));
+  ExpectElements(prefix, 10);
+}
+
+TEST(ColumnCacheTest, AlignedRowsArePadded) {
+  const string prefix = Prefix("padded");
+  TF_ASSERT_OK(WriteElements(prefix, 0, 3));
+  // 7 * 7 * 3 floats take 588 bytes, which is padded to 640.
+  uint64 size;
+  TF_ASSERT_OK(Env::Default()->GetFileSize(ColumnFilename(prefix, 0), &size));
+  EXPECT_EQ(3 * 640, size);
+  EXPECT_EQ(0, 640 % Allocator::kAllocatorAlignment);
+  // Labels are too small to be worth padding.
+  TF_ASSERT_OK(Env::Default()->GetFileSize(ColumnFilename(prefix, 1), &size));
+  EXPECT_EQ(3 * sizeof(int64), size);
+}
+
+TEST(ColumnCacheTest, Merge) {
+  const string prefix = Prefix("merge");
+  std::vector<string> shards;
+  for (int i = 0; i < 3; ++i) {
+    shards.push_back(strings::StrCat(prefix, "_", i));
+    TF_ASSERT_OK(WriteElements(shards.back(), i * 4, (i + 1) * 4));
+  }
+  TF_ASSERT_OK(MergeColumnCaches(Env::Default(), shards, prefix));
+  ExpectElements(prefix, 12);
+  for (const string& shard : shards) {
+    EXPECT_FALSE(ColumnCacheReader::Exists(Env::Default(), shard));
+    EXPECT_FALSE(Env::Default()->FileExists(ColumnFilename(shard, 0)).ok());
+  }
+}
+
+TEST(ColumnCacheTest, MergeSingleShard) {
+  const string prefix = Prefix("merge_single");
+  const string shard = strings::StrCat(prefix, "_0");
+  TF_ASSERT_OK(WriteElements(shard, 0, 5));
+  TF_ASSERT_OK(MergeColumnCaches(Env::Default(), {shard}, prefix));
+  ExpectElements(prefix, 5);
+  EXPECT_FALSE(ColumnCacheReader::Exists(Env::Default(), shard));
+}
+
+TEST(ColumnCacheTest, UnfinishedWriterLeavesNoFiles) {
+  const string prefix = Prefix("unfinished");
+  {
+    ColumnCacheWriter writer(Env::Default(), prefix, Dtypes(), Shapes());
+    TF_ASSERT_OK(writer.Add(0, Image(0)));
+  }
+  EXPECT_FALSE(ColumnCacheReader::Exists(Env::Default(), prefix));
+  EXPECT_FALSE(Env::Default()->FileExists(ColumnFilename(prefix, 0)).ok());
+}
+
+TEST(ColumnCacheTest, Errors) {
+  const string prefix = Prefix("errors");
+  ColumnCacheWriter writer(Env::Default(), prefix, Dtypes(), Shapes());
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Add(0, Label(0))));
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Add(2, Label(0))));
+
+  ColumnCacheWriter uneven(Env::Default(), prefix, Dtypes(), Shapes());
+  TF_ASSERT_OK(uneven.Add(0, Image(0)));
+  EXPECT_TRUE(errors::IsInternal(uneven.Finish()));
+  EXPECT_FALSE(ColumnCacheReader::Exists(Env::Default(), prefix));
+
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), ColumnMetaFilename(prefix),
+                                 "not a column cache"));
+  std::unique_ptr<ColumnCacheReader> reader;
+  EXPECT_TRUE(errors::IsDataLoss(
+      ColumnCacheReader::Open(Env::Default(), prefix, &reader)));
+}
+
+// Reads an epoch of 224x224x3 images from a cache in the columnar format, or
+// from a tensor bundle as `CacheDataset` did before.
+static void BM_ReadEpoch(int iters, int columnar) {
+  testing::StopTiming();
+  const int kNumElements = 64;
+  const TensorShape shape({224, 224, 3});
+  const string prefix = Prefix(strings::StrCat("bm_read_epoch_", columnar));
+  Tensor image(DT_FLOAT, shape);
+  image.flat<float>().setRandom();
+  if (columnar) {
+    ColumnCacheWriter writer(Env::Default(), prefix, {DT_FLOAT},
+                             {PartialTensorShape(shape.dim_sizes())});
+    for (int i = 0; i < kNumElements; ++i) {
+      TF_CHECK_OK(writer.Add(0, image));
+    }
+    TF_CHECK_OK(writer.Finish());
+  } else {
+    BundleWriter writer(Env::Default(), prefix);
+    for (int i = 0; i < kNumElements; ++i) {
+      TF_CHECK_OK(writer.Add(strings::Printf("%07d_0", i), image));
+    }
+    TF_CHECK_OK(writer.Finish());
+  }
+
+  testing::StartTiming();
+  for (int it = 0; it < iters; ++it) {
+    Tensor t;
+    if (columnar) {
+      std::unique_ptr<ColumnCacheReader> reader;
+      TF_CHECK_OK(ColumnCacheReader::Open(Env::Default(), prefix, &reader));
+      for (int i = 0; i < kNumElements; ++i) {
+        TF_CHECK_OK(reader->Read(0, i, &t));
+      }
+    } else {
+      BundleReader reader(Env::Default(), prefix);
+      reader.Next();  // The first entry in the table is a header entry.
+      for (int i = 0; i < kNumElements; ++i) {
+        TF_CHECK_OK(reader.ReadCurrent(&t));
+        reader.Next();
+      }
+    }
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumElements);
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumElements *
+                          image.TotalBytes());
+  testing::SetLabel(columnar ? "columnar" : "bundle");
+}
+BENCHMARK(BM_ReadEpoch)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
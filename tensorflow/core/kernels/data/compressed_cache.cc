@@ -0,0 +1,307 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/compressed_cache.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/tensor_coding.h"
+
+namespace tensorflow {
+
+namespace {
+
+void EncodeTensor(const Tensor& t, string* out) {
+  core::PutVarint32(out, t.dtype());
+  core::PutVarint32(out, t.dims());
+  for (int d = 0; d < t.dims(); ++d) {
+    core::PutVarint64(out, t.dim_size(d));
+  }
+  if (DataTypeCanUseMemcpy(t.dtype())) {
+    StringPiece data = t.tensor_data();
+    out->append(data.data(), data.size());
+    return;
+  }
+  string encoded;
+  if (t.dtype() == DT_STRING) {
+    port::EncodeStringList(t.flat<string>().data(), t.NumElements(),
+                           &encoded);
+  } else {
+    TensorProto proto;
+    t.AsProtoTensorContent(&proto);
+    proto.SerializeToString(&encoded);
+  }
+  core::PutVarint64(out, encoded.size());
+  out->append(encoded);
+}
+
+Status DecodeTensor(StringPiece* input, Tensor* t) {
+  const Status corrupt = errors::DataLoss("Corrupt compressed cache block.");
+  uint32 dtype, dims;
+  if (!core::GetVarint32(input, &dtype) || !core::GetVarint32(input, &dims)) {
+    return corrupt;
+  }
+  TensorShape shape;
+  for (uint32 d = 0; d < dims; ++d) {
+    uint64 dim_size;
+    if (!core::GetVarint64(input, &dim_size)) return corrupt;
+    shape.AddDim(dim_size);
+  }
+  *t = Tensor(static_cast<DataType>(dtype), shape);
+  if (DataTypeCanUseMemcpy(t->dtype())) {
+    const size_t size = t->TotalBytes();
+    if (input->size() < size) return corrupt;
+    memcpy(const_cast<char*>(t->tensor_data().data()), input->data(), size);
+    input->remove_prefix(size);
+    return Status::OK();
+  }
+  uint64 size;
+  if (!core::GetVarint64(input, &size) || input->size() < size) {
+    return corrupt;
+  }
+  const string encoded(input->data(), size);
+  input->remove_prefix(size);
+  if (t->dtype() == DT_STRING) {
+    if (!port::DecodeStringList(encoded, t->flat<string>().data(),
+                                t->NumElements())) {
+      return corrupt;
+    }
+    return Status::OK();
+  }
+  TensorProto proto;
+  if (!proto.ParseFromString(encoded) || !t->FromProto(proto)) {
+    return corrupt;
+  }
+  return Status::OK();
+}
+
+Status Compress(const string& compression, const string& input,
+                string* output) {
+  if (compression == io::compression::kSnappy) {
+    if (!port::Snappy_Compress(input.data(), input.size(), output)) {
+      return errors::Unimplemented(
+          "Snappy compression is not supported in this build.");
+    }
+    return Status::OK();
+  }
+  uLongf size = compressBound(input.size());
+  output->resize(size);
+  int err = compress2(reinterpret_cast<Bytef*>(&(*output)[0]), &size,
+                      reinterpret_cast<const Bytef*>(input.data()),
+                      input.size(), Z_DEFAULT_COMPRESSION);
+  if (err != Z_OK) {
+    return errors::Internal("zlib compression failed with error ", err);
+  }
+  output->resize(size);
+  return Status::OK();
+}
+
+Status Uncompress(const string& compression, StringPiece input,
+                  size_t uncompressed_size, string* output) {
+  output->resize(uncompressed_size);
+  if (uncompressed_size == 0) {
+    return Status::OK();
+  }
+  if (compression == io::compression::kSnappy) {
+    size_t size;
+    if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                            &size) ||
+        size != uncompressed_size ||
+        !port::Snappy_Uncompress(input.data(), input.size(),
+                                 &(*output)[0])) {
+      return errors::DataLoss("Snappy decompression failed.");
+    }
+    return Status::OK();
+  }
+  uLongf size = uncompressed_size;
+  int err = uncompress(reinterpret_cast<Bytef*>(&(*output)[0]), &size,
+                       reinterpret_cast<const Bytef*>(input.data()),
+                       input.size());
+  if (err != Z_OK || size != uncompressed_size) {
+    return errors::DataLoss("zlib decompression failed with error ", err);
+  }
+  return Status::OK();
+}
+
+// Appends the elements of an uncompressed block to `*elements`.
+Status DecodeElements(StringPiece input, int64 num_elements,
+                      std::vector<std::vector<Tensor>>* elements) {
+  elements->reserve(elements->size() + num_elements);
+  for (int64 i = 0; i < num_elements; ++i) {
+    uint32 num_components;
+    if (!core::GetVarint32(&input, &num_components)) {
+      return errors::DataLoss("Corrupt compressed cache block.");
+    }
+    std::vector<Tensor> element(num_components);
+    for (Tensor& t : element) {
+      TF_RETURN_IF_ERROR(DecodeTensor(&input, &t));
+    }
+    elements->push_back(std::move(element));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status CompressElements(const string& compression,
+                        const std::vector<std::vector<Tensor>>& elements,
+                        string* out) {
+  string block;
+  for (const std::vector<Tensor>& element : elements) {
+    core::PutVarint32(&block, element.size());
+    for (const Tensor& t : element) {
+      EncodeTensor(t, &block);
+    }
+  }
+  string compressed;
+  TF_RETURN_IF_ERROR(Compress(compression, block, &compressed));
+  out->clear();
+  core::PutVarint64(out, block.size());
+  core::PutVarint64(out, elements.size());
+  out->append(compressed);
+  return Status::OK();
+}
+
+Status UncompressElements(const string& compression, StringPiece data,
+                          std::vector<std::vector<Tensor>>* elements) {
+  uint64 uncompressed_size, num_elements;
+  if (!core::GetVarint64(&data, &uncompressed_size) ||
+      !core::GetVarint64(&data, &num_elements)) {
+    return errors::DataLoss("Corrupt compressed block header.");
+  }
+  string block;
+  TF_RETURN_IF_ERROR(Uncompress(compression, data, uncompressed_size, &block));
+  return DecodeElements(block, num_elements, elements);
+}
+
+/* static */
+Status CompressedCache::ValidateCompression(const string& compression) {
+  if (compression != io::compression::kSnappy &&
+      compression != io::compression::kZlib) {
+    return errors::InvalidArgument("Unsupported cache compression \"",
+                                   compression, "\". Expected \"",
+                                   io::compression::kSnappy, "\" or \"",
+                                   io::compression::kZlib, "\".");
+  }
+  return Status::OK();
+}
+
+Status CompressedCache::ReadBlock(
+    size_t index, std::vector<std::vector<Tensor>>* elements) const {
+  if (index >= blocks_.size()) {
+    return errors::OutOfRange("Block ", index, " is out of range.");
+  }
+  const Block& block = blocks_[index];
+  string uncompressed;
+  TF_RETURN_IF_ERROR(Uncompress(compression_, block.data,
+                                block.uncompressed_size, &uncompressed));
+  return DecodeElements(uncompressed, block.num_elements, elements);
+}
+
+CompressedCacheBuilder::CompressedCacheBuilder(const string& compression)
+    : compression_(compression), cache_(new CompressedCache(compression)) {
+  DCHECK(CompressedCache::ValidateCompression(compression).ok());
+}
+
+CompressedCacheBuilder::~CompressedCacheBuilder() {
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+Status CompressedCacheBuilder::Add(const std::vector<Tensor>& element,
+                                   const Runner& runner) {
+  std::function<void()> compress_block;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(status_);
+    if (cache_ == nullptr) {
+      return errors::FailedPrecondition("The compressed cache is finished.");
+    }
+    core::PutVarint32(&block_, element.size());
+    for (const Tensor& t : element) {
+      EncodeTensor(t, &block_);
+    }
+    ++block_num_elements_;
+    if (block_.size() >= CompressedCache::kBlockBytes) {
+      compress_block = SealBlock();
+    }
+  }
+  if (compress_block) {
+    runner(std::move(compress_block));
+  }
+  return Status::OK();
+}
+
+Status CompressedCacheBuilder::Finish(std::unique_ptr<CompressedCache>* out) {
+  std::function<void()> compress_block;
+  {
+    mutex_lock l(mu_);
+    if (cache_ == nullptr) {
+      return errors::FailedPrecondition("The compressed cache is finished.");
+    }
+    if (block_num_elements_ > 0) {
+      compress_block = SealBlock();
+    }
+  }
+  // Compress the last block inline, since we have to wait for it anyway.
+  if (compress_block) {
+    compress_block();
+  }
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) {
+    cond_var_.wait(l);
+  }
+  TF_RETURN_IF_ERROR(status_);
+  for (const CompressedCache::Block& block : cache_->blocks_) {
+    cache_->num_elements_ += block.num_elements;
+    cache_->uncompressed_bytes_ += block.uncompressed_size;
+    cache_->compressed_bytes_ += block.data.size();
+  }
+  VLOG(1) << "Compressed " << cache_->num_elements_ << " cached elements from "
+          << cache_->uncompressed_bytes_ << " to " << cache_->compressed_bytes_
+          << " bytes with " << compression_;
+  *out = std::move(cache_);
+  return Status::OK();
+}
+
+std::function<void()> CompressedCacheBuilder::SealBlock() {
+  const size_t index = cache_->blocks_.size();
+  cache_->blocks_.emplace_back();
+  cache_->blocks_.back().uncompressed_size = block_.size();
+  cache_->blocks_.back().num_elements = block_num_elements_;
+  std::shared_ptr<string> uncompressed = std::make_shared<string>();
+  uncompressed->swap(block_);
+  block_num_elements_ = 0;
+  ++num_pending_;
+  return [this, index, uncompressed]() {
+    string compressed;
+    Status s = Compress(compression_, *uncompressed, &compressed);
+    mutex_lock l(mu_);
+    status_.Update(s);
+    cache_->blocks_[index].data.swap(compressed);
+    --num_pending_;
+    cond_var_.notify_all();
+  };
+}
+
+}  // namespace tensorflow
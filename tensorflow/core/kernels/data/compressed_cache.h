@@ -0,0 +1,123 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_COMPRESSED_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_COMPRESSED_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// An immutable sequence of dataset elements held in memory, serialized and
+// compressed in blocks of about `kBlockBytes` uncompressed bytes. Blocks can
+// be decompressed independently, and therefore in parallel.
+class CompressedCache {
+ public:
+  // The uncompressed size at which a block is sealed and compressed.
+  static constexpr size_t kBlockBytes = 4 << 20;
+
+  // Returns OK if `compression` is one of `io::compression::kSnappy` and
+  // `io::compression::kZlib`.
+  static Status ValidateCompression(const string& compression);
+
+  size_t num_blocks() const { return blocks_.size(); }
+  int64 num_elements() const { return num_elements_; }
+  // The total size of the blocks, before and after compression.
+  int64 uncompressed_bytes() const { return uncompressed_bytes_; }
+  int64 compressed_bytes() const { return compressed_bytes_; }
+
+  // Decompresses block `index`, and appends its elements to `*elements`.
+  Status ReadBlock(size_t index,
+                   std::vector<std::vector<Tensor>>* elements) const;
+
+ private:
+  friend class CompressedCacheBuilder;
+
+  struct Block {
+    string data;
+    size_t uncompressed_size = 0;
+    int64 num_elements = 0;
+  };
+
+  explicit CompressedCache(const string& compression)
+      : compression_(compression) {}
+
+  const string compression_;
+  std::vector<Block> blocks_;
+  int64 num_elements_ = 0;
+  int64 uncompressed_bytes_ = 0;
+  int64 compressed_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompressedCache);
+};
+
+// Serializes `elements` and compresses them with `compression` into a
+// self-contained block, which can be decoded by `UncompressElements()`.
+//
+// REQUIRES: `CompressedCache::ValidateCompression(compression)` is OK.
+Status CompressElements(const string& compression,
+                        const std::vector<std::vector<Tensor>>& elements,
+                        string* out);
+
+// Decodes a block written by `CompressElements()`, and appends its elements
+// to `*elements`.
+Status UncompressElements(const string& compression, StringPiece data,
+                          std::vector<std::vector<Tensor>>* elements);
+
+// Builds a `CompressedCache` from a sequence of elements.
+class CompressedCacheBuilder {
+ public:
+  typedef std::function<void(std::function<void()>)> Runner;
+
+  // REQUIRES: `CompressedCache::ValidateCompression(compression)` is OK.
+  explicit CompressedCacheBuilder(const string& compression);
+
+  // Waits for any blocks that are still being compressed.
+  ~CompressedCacheBuilder();
+
+  // Serializes `element` into the current block. When the block is full, it
+  // is compressed by a closure scheduled on `runner`.
+  Status Add(const std::vector<Tensor>& element, const Runner& runner);
+
+  // Compresses the last block, waits for all blocks, and returns the cache.
+  Status Finish(std::unique_ptr<CompressedCache>* out);
+
+ private:
+  // Seals the current block, and returns a closure that compresses it.
+  std::function<void()> SealBlock() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string compression_;
+  mutex mu_;
+  condition_variable cond_var_;
+  // Reset by `Finish()`.
+  std::unique_ptr<CompressedCache> cache_ GUARDED_BY(mu_);
+  string block_ GUARDED_BY(mu_);
+  int64 block_num_elements_ GUARDED_BY(mu_) = 0;
+  // The number of sealed blocks that are still being compressed.
+  int64 num_pending_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompressedCacheBuilder);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_COMPRESSED_CACHE_H_
@@ -0,0 +1,180 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/compressed_cache.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Elements have a compressible float image, an int64 label and a string.
+constexpr int64 kImageSize = 256 * 256;
+
+std::vector<Tensor> Element(int64 i) {
+  Tensor image(DT_FLOAT, TensorShape({kImageSize}));
+  image.flat<float>().setConstant(static_cast<float>(i));
+  Tensor label(DT_INT64, TensorShape({}));
+  label.scalar<int64>()() = i;
+  Tensor text(DT_STRING, TensorShape({2}));
+  text.vec<string>()(0) = strings::StrCat("element ", i);
+  text.vec<string>()(1) = "";
+  return {image, label, text};
+}
+
+bool SnappySupported() {
+  string out;
+  return port::Snappy_Compress("", 0, &out);
+}
+
+class CompressedCacheTest : public ::testing::TestWithParam<const char*> {
+ protected:
+  void SetUp() override {
+    if (string(GetParam()) == io::compression::kSnappy && !SnappySupported()) {
+      skip_ = true;
+    }
+  }
+
+  bool skip_ = false;
+};
+
+TEST_P(CompressedCacheTest, RoundTrip) {
+  if (skip_) return;
+  // Each image has 256KB, so the cache has several blocks.
+  const int64 kNumElements = 50;
+  thread::ThreadPool pool(Env::Default(), "compress", 4);
+  CompressedCacheBuilder builder(GetParam());
+  for (int64 i = 0; i < kNumElements; ++i) {
+    TF_ASSERT_OK(builder.Add(Element(i), [&pool](std::function<void()> fn) {
+      pool.Schedule(std::move(fn));
+    }));
+  }
+  std::unique_ptr<CompressedCache> cache;
+  TF_ASSERT_OK(builder.Finish(&cache));
+  EXPECT_EQ(kNumElements, cache->num_elements());
+  EXPECT_GT(cache->num_blocks(), 1);
+  EXPECT_LT(cache->compressed_bytes(), cache->uncompressed_bytes() / 10);
+
+  std::vector<std::vector<Tensor>> elements;
+  for (size_t b = 0; b < cache->num_blocks(); ++b) {
+    TF_ASSERT_OK(cache->ReadBlock(b, &elements));
+  }
+  ASSERT_EQ(kNumElements, elements.size());
+  for (int64 i = 0; i < kNumElements; ++i) {
+    const std::vector<Tensor> expected = Element(i);
+    ASSERT_EQ(expected.size(), elements[i].size());
+    test::ExpectTensorEqual<float>(expected[0], elements[i][0]);
+    test::ExpectTensorEqual<int64>(expected[1], elements[i][1]);
+    test::ExpectTensorEqual<string>(expected[2], elements[i][2]);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(cache->ReadBlock(cache->num_blocks(),
+                                                    &elements)));
+}
+
+TEST_P(CompressedCacheTest, Empty) {
+  if (skip_) return;
+  CompressedCacheBuilder builder(GetParam());
+  std::unique_ptr<CompressedCache> cache;
+  TF_ASSERT_OK(builder.Finish(&cache));
+  EXPECT_EQ(0, cache->num_blocks());
+  EXPECT_EQ(0, cache->num_elements());
+}
+
+TEST_P(CompressedCacheTest, AddAfterFinish) {
+  if (skip_) return;
+  CompressedCacheBuilder builder(GetParam());
+  std::unique_ptr<CompressedCache> cache;
+  TF_ASSERT_OK(builder.Finish(&cache));
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      builder.Add(Element(0), [](std::function<void()> fn) { fn(); })));
+  EXPECT_TRUE(errors::IsFailedPrecondition(builder.Finish(&cache)));
+}
+
+TEST_P(CompressedCacheTest, CompressElements) {
+  if (skip_) return;
+  std::vector<std::vector<Tensor>> elements = {Element(0), Element(1)};
+  string data;
+  TF_ASSERT_OK(CompressElements(GetParam(), elements, &data));
+  EXPECT_LT(data.size(), kImageSize);
+  std::vector<std::vector<Tensor>> decoded;
+  TF_ASSERT_OK(UncompressElements(GetParam(), data, &decoded));
+  ASSERT_EQ(2, decoded.size());
+  for (int i = 0; i < 2; ++i) {
+    test::ExpectTensorEqual<float>(elements[i][0], decoded[i][0]);
+    test::ExpectTensorEqual<int64>(elements[i][1], decoded[i][1]);
+    test::ExpectTensorEqual<string>(elements[i][2], decoded[i][2]);
+  }
+  EXPECT_TRUE(errors::IsDataLoss(UncompressElements(
+      GetParam(), StringPiece(data).substr(0, data.size() / 2), &decoded)));
+}
+
+INSTANTIATE_TEST_CASE_P(Compressions, CompressedCacheTest,
+                        ::testing::Values(io::compression::kSnappy,
+                                          io::compression::kZlib));
+
+TEST(CompressedCacheTest, ValidateCompression) {
+  TF_EXPECT_OK(CompressedCache::ValidateCompression("SNAPPY"));
+  TF_EXPECT_OK(CompressedCache::ValidateCompression("ZLIB"));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CompressedCache::ValidateCompression("")));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CompressedCache::ValidateCompression("GZIP")));
+}
+
+static void BM_ReadCache(int iters, int zlib) {
+  testing::StopTiming();
+  const char* compression =
+      zlib ? io::compression::kZlib : io::compression::kSnappy;
+  if (!zlib && !SnappySupported()) {
+    testing::SetLabel("snappy unsupported");
+    return;
+  }
+  const int64 kNumElements = 200;
+  thread::ThreadPool pool(Env::Default(), "compress", 8);
+  auto runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  CompressedCacheBuilder builder(compression);
+  for (int64 i = 0; i < kNumElements; ++i) {
+    TF_CHECK_OK(builder.Add(Element(i), runner));
+  }
+  std::unique_ptr<CompressedCache> cache;
+  TF_CHECK_OK(builder.Finish(&cache));
+  testing::SetLabel(strings::StrCat(compression, " ratio ",
+                                    cache->uncompressed_bytes() /
+                                        std::max<int64>(
+                                            1, cache->compressed_bytes())));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    std::vector<std::vector<Tensor>> elements;
+    for (size_t b = 0; b < cache->num_blocks(); ++b) {
+      TF_CHECK_OK(cache->ReadBlock(b, &elements));
+    }
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumElements);
+  testing::BytesProcessed(static_cast<int64>(iters) *
+                          cache->uncompressed_bytes());
+}
+BENCHMARK(BM_ReadCache)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,194 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Idle threads of the global pool exit after this long.
+constexpr int64 kGlobalIdleTimeoutMs = 10 * 1000;
+
+// A logical thread started by `ElasticThreadPool::StartThread()`.
+class LogicalThread : public Thread {
+ public:
+  explicit LogicalThread(std::shared_ptr<Notification> done)
+      : done_(std::move(done)) {}
+
+  ~LogicalThread() override { done_->WaitForNotification(); }
+
+ private:
+  const std::shared_ptr<Notification> done_;
+};
+
+}  // namespace
+
+ElasticThreadPool::ElasticThreadPool(Env* env, int max_compute_threads,
+                                     int64 idle_timeout_ms)
+    : env_(env),
+      max_compute_threads_(std::max(max_compute_threads, 1)),
+      idle_timeout_ms_(idle_timeout_ms) {}
+
+ElasticThreadPool::~ElasticThreadPool() {
+  mutex_lock l(mu_);
+  while (!logical_threads_.empty() || num_pending_closures_ > 0 ||
+         num_running_closures_ > 0 || num_running_logical_threads_ > 0) {
+    done_cond_var_.wait(l);
+  }
+  cancelled_ = true;
+  cond_var_.notify_all();
+  while (num_threads_ > 0) {
+    done_cond_var_.wait(l);
+  }
+}
+
+/* static */
+ElasticThreadPool* ElasticThreadPool::Global() {
+  static ElasticThreadPool* pool = new ElasticThreadPool(
+      Env::Default(), port::NumSchedulableCPUs(), kGlobalIdleTimeoutMs);
+  return pool;
+}
+
+ElasticThreadPool::Runner ElasticThreadPool::NewRunner() {
+  std::shared_ptr<RunnerQueue> queue(new RunnerQueue);
+  return [this, queue](std::function<void()> fn) {
+    Schedule(queue, std::move(fn));
+  };
+}
+
+Thread* ElasticThreadPool::StartThread(std::function<void()> fn) {
+  std::shared_ptr<Notification> done(new Notification);
+  mutex_lock l(mu_);
+  logical_threads_.emplace_back(std::move(fn), done);
+  WakeThreadsLocked();
+  return new LogicalThread(done);
+}
+
+int ElasticThreadPool::NumThreads() {
+  mutex_lock l(mu_);
+  return num_threads_;
+}
+
+int ElasticThreadPool::PeakNumThreads() {
+  mutex_lock l(mu_);
+  return peak_num_threads_;
+}
+
+void ElasticThreadPool::Schedule(const std::shared_ptr<RunnerQueue>& queue,
+                                 std::function<void()> fn) {
+  mutex_lock l(mu_);
+  queue->closures.push_back(std::move(fn));
+  ++num_pending_closures_;
+  if (!queue->ready) {
+    queue->ready = true;
+    ready_queues_.push_back(queue);
+  }
+  WakeThreadsLocked();
+}
+
+int64 ElasticThreadPool::NumRunnableLocked() {
+  const int64 free_compute_threads =
+      std::max<int64>(max_compute_threads_ - num_running_closures_, 0);
+  return static_cast<int64>(logical_threads_.size()) +
+         std::min(num_pending_closures_, free_compute_threads);
+}
+
+void ElasticThreadPool::WakeThreadsLocked() {
+  const int64 num_runnable = NumRunnableLocked();
+  // Threads that have been notified but not woken up yet still count as
+  // idle, so this can start more threads than necessary. The extra threads
+  // exit after `idle_timeout_ms_`.
+  for (int64 i = 0; i < std::min<int64>(num_runnable, num_idle_threads_);
+       ++i) {
+    cond_var_.notify_one();
+  }
+  while (num_idle_threads_ < num_runnable) {
+    // New threads count as idle until they pick up work.
+    ++num_threads_;
+    ++num_idle_threads_;
+    peak_num_threads_ = std::max(peak_num_threads_, num_threads_);
+    env_->SchedClosure([this]() { WorkerLoop(); });
+  }
+}
+
+void ElasticThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> fn;
+    // Set if `fn` is a logical thread.
+    std::shared_ptr<Notification> done;
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && NumRunnableLocked() == 0) {
+        if (WaitForMilliseconds(&l, &cond_var_, idle_timeout_ms_) ==
+            kCond_Timeout) {
+          break;
+        }
+      }
+      --num_idle_threads_;
+      if (NumRunnableLocked() == 0) {
+        // The thread has been idle for too long, or the pool is being
+        // destroyed.
+        --num_threads_;
+        done_cond_var_.notify_all();
+        return;
+      }
+      // Logical threads take precedence because they cannot be delayed by
+      // a lack of compute threads.
+      if (!logical_threads_.empty()) {
+        fn = std::move(logical_threads_.front().first);
+        done = std::move(logical_threads_.front().second);
+        logical_threads_.pop_front();
+        ++num_running_logical_threads_;
+      } else {
+        std::shared_ptr<RunnerQueue> queue = std::move(ready_queues_.front());
+        ready_queues_.pop_front();
+        fn = std::move(queue->closures.front());
+        queue->closures.pop_front();
+        if (queue->closures.empty()) {
+          queue->ready = false;
+        } else {
+          ready_queues_.push_back(std::move(queue));
+        }
+        --num_pending_closures_;
+        ++num_running_closures_;
+      }
+    }
+    fn();
+    fn = nullptr;
+    {
+      mutex_lock l(mu_);
+      if (done) {
+        --num_running_logical_threads_;
+      } else {
+        --num_running_closures_;
+      }
+      // This thread picks up the next runnable work item, if any, itself.
+      ++num_idle_threads_;
+      done_cond_var_.notify_all();
+    }
+    // Notify after the thread is idle again, so that a logical thread
+    // started after joining this one reuses it.
+    if (done) {
+      done->Notify();
+    }
+  }
+}
+
+}  // namespace tensorflow
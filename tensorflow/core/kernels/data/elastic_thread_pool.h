@@ -0,0 +1,130 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_ELASTIC_THREAD_POOL_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_ELASTIC_THREAD_POOL_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An `ElasticThreadPool` multiplexes the background work of many dataset
+// iterators onto one set of threads that grows on demand and shrinks when
+// threads stay idle.
+//
+// The pool runs two kinds of work:
+//
+//  * Closures passed to a runner returned by `NewRunner()`. These are
+//    expected to run for a short time, and at most `max_compute_threads`
+//    of them run at once. Each runner has its own queue, and the pool takes
+//    closures from the queues in round-robin order so that an iterator
+//    with a deep backlog does not starve the others.
+//
+//  * Logical threads started with `StartThread()`. These may block for
+//    arbitrarily long (e.g. waiting for a consumer), so each one occupies a
+//    pool thread until it returns and they do not count against
+//    `max_compute_threads`. The pool thread is then reused instead of
+//    being torn down, which avoids creating a thread for every short-lived
+//    iterator.
+//
+// This class is thread-safe.
+class ElasticThreadPool {
+ public:
+  using Runner = std::function<void(std::function<void()>)>;
+
+  // Threads of the pool exit after being idle for `idle_timeout_ms`.
+  ElasticThreadPool(Env* env, int max_compute_threads, int64 idle_timeout_ms);
+
+  // Waits for all scheduled closures and logical threads to complete.
+  ~ElasticThreadPool();
+
+  // Returns the process-wide pool shared by the parallel dataset
+  // iterators, which runs at most one closure per schedulable CPU at once.
+  static ElasticThreadPool* Global();
+
+  // Returns a runner whose closures share the pool fairly with the
+  // closures of the other runners. The runner may outlive the pool only
+  // if it is not invoked afterwards.
+  Runner NewRunner();
+
+  // Runs `fn` on a thread of the pool. Deleting the returned `Thread` blocks
+  // until `fn` returns.
+  Thread* StartThread(std::function<void()> fn);
+
+  int max_compute_threads() const { return max_compute_threads_; }
+
+  // The number of threads currently owned by the pool.
+  int NumThreads();
+
+  // The largest number of threads owned by the pool at any time.
+  int PeakNumThreads();
+
+ private:
+  // The queue of closures of one runner.
+  struct RunnerQueue {
+    std::deque<std::function<void()>> closures;
+    // Whether the queue is in `ready_queues_`.
+    bool ready = false;
+  };
+
+  void Schedule(const std::shared_ptr<RunnerQueue>& queue,
+                std::function<void()> fn);
+
+  // The number of work items that a thread could start running now.
+  int64 NumRunnableLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Wakes or starts a thread for each runnable work item.
+  void WakeThreadsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void WorkerLoop();
+
+  Env* const env_;
+  const int max_compute_threads_;
+  const int64 idle_timeout_ms_;
+
+  mutex mu_;
+  // Notified when there is work for idle threads.
+  condition_variable cond_var_;
+  // Notified when a work item completes or a thread exits.
+  condition_variable done_cond_var_;
+  // Logical threads waiting for a pool thread, with the notifications to
+  // signal when they have completed.
+  std::deque<std::pair<std::function<void()>, std::shared_ptr<Notification>>>
+      logical_threads_ GUARDED_BY(mu_);
+  // Runner queues with pending closures, in the order that they are
+  // served.
+  std::deque<std::shared_ptr<RunnerQueue>> ready_queues_ GUARDED_BY(mu_);
+  int64 num_pending_closures_ GUARDED_BY(mu_) = 0;
+  int64 num_running_closures_ GUARDED_BY(mu_) = 0;
+  int64 num_running_logical_threads_ GUARDED_BY(mu_) = 0;
+  int num_threads_ GUARDED_BY(mu_) = 0;
+  int num_idle_threads_ GUARDED_BY(mu_) = 0;
+  int peak_num_threads_ GUARDED_BY(mu_) = 0;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ElasticThreadPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_ELASTIC_THREAD_POOL_H_
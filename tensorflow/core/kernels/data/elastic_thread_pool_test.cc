@@ -0,0 +1,217 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ElasticThreadPoolTest, RunsClosures) {
+  ElasticThreadPool pool(Env::Default(), 4, 1000);
+  ElasticThreadPool::Runner runner = pool.NewRunner();
+  std::atomic<int> count(0);
+  BlockingCounter counter(100);
+  for (int i = 0; i < 100; ++i) {
+    runner([&count, &counter]() {
+      ++count;
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_EQ(100, count);
+  EXPECT_LE(pool.PeakNumThreads(), 4);
+}
+
+TEST(ElasticThreadPoolTest, CapsConcurrentClosures) {
+  ElasticThreadPool pool(Env::Default(), 2, 1000);
+  std::vector<ElasticThreadPool::Runner> runners = {pool.NewRunner(),
+                                                    pool.NewRunner()};
+  mutex mu;
+  int running = 0;
+  int max_running = 0;
+  BlockingCounter counter(20);
+  for (int i = 0; i < 20; ++i) {
+    runners[i % 2]([&]() {
+      {
+        mutex_lock l(mu);
+        max_running = std::max(max_running, ++running);
+      }
+      Env::Default()->SleepForMicroseconds(1000);
+      {
+        mutex_lock l(mu);
+        --running;
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_LE(max_running, 2);
+}
+
+TEST(ElasticThreadPoolTest, FairSharing) {
+  ElasticThreadPool pool(Env::Default(), 1, 1000);
+  ElasticThreadPool::Runner runner_a = pool.NewRunner();
+  ElasticThreadPool::Runner runner_b = pool.NewRunner();
+  // Occupy the only compute thread while the runners queue closures.
+  Notification started;
+  Notification release;
+  runner_a([&started, &release]() {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  mutex mu;
+  string order;
+  BlockingCounter counter(6);
+  for (int i = 0; i < 3; ++i) {
+    runner_a([&]() {
+      mutex_lock l(mu);
+      order += "a";
+      counter.DecrementCount();
+    });
+  }
+  for (int i = 0; i < 3; ++i) {
+    runner_b([&]() {
+      mutex_lock l(mu);
+      order += "b";
+      counter.DecrementCount();
+    });
+  }
+  release.Notify();
+  counter.Wait();
+  EXPECT_EQ("ababab", order);
+}
+
+TEST(ElasticThreadPoolTest, LogicalThreadsMayBlock) {
+  ElasticThreadPool pool(Env::Default(), 1, 1000);
+  // The logical threads only complete if they all run at once, despite
+  // the limit on compute threads.
+  BlockingCounter all_started(3);
+  Notification closure_done;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back(pool.StartThread([&all_started, &closure_done]() {
+      all_started.DecrementCount();
+      all_started.Wait();
+      closure_done.WaitForNotification();
+    }));
+  }
+  all_started.Wait();
+  // Closures still run while the logical threads are blocked.
+  pool.NewRunner()([&closure_done]() { closure_done.Notify(); });
+  threads.clear();
+  EXPECT_EQ(4, pool.PeakNumThreads());
+}
+
+TEST(ElasticThreadPoolTest, ReusesThreads) {
+  ElasticThreadPool pool(Env::Default(), 1, 10 * 1000);
+  for (int i = 0; i < 10; ++i) {
+    int value = 0;
+    std::unique_ptr<Thread> thread(pool.StartThread([&value]() { value = 1; }));
+    thread.reset();
+    EXPECT_EQ(1, value);
+  }
+  EXPECT_EQ(1, pool.PeakNumThreads());
+}
+
+TEST(ElasticThreadPoolTest, IdleThreadsExit) {
+  ElasticThreadPool pool(Env::Default(), 4, 10);
+  std::unique_ptr<Thread> thread(pool.StartThread([]() {}));
+  thread.reset();
+  while (pool.NumThreads() > 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_EQ(1, pool.PeakNumThreads());
+}
+
+// Spends some CPU time on an element.
+void Work(int64* element) {
+  for (int i = 0; i < 1000; ++i) {
+    *element = *element * 6364136223846793005LL + 1442695040888963407LL;
+  }
+}
+
+// Runs `iters` elements through a pipeline of `num_stages` parallel stages,
+// each of which does some work on an element before passing it on. If
+// `shared` is false, every stage has a private thread pool with one thread
+// per CPU, as the parallel dataset iterators had; otherwise all stages share
+// an elastic pool.
+static void BM_Pipeline(int iters, int num_stages, int shared) {
+  testing::StopTiming();
+  const int num_cpus = port::NumSchedulableCPUs();
+  std::unique_ptr<ElasticThreadPool> elastic_pool;
+  std::vector<std::unique_ptr<thread::ThreadPool>> private_pools;
+  std::vector<std::function<void(std::function<void()>)>> runners;
+  if (shared) {
+    elastic_pool.reset(new ElasticThreadPool(Env::Default(), num_cpus, 1000));
+    for (int i = 0; i < num_stages; ++i) {
+      runners.push_back(elastic_pool->NewRunner());
+    }
+  } else {
+    for (int i = 0; i < num_stages; ++i) {
+      private_pools.emplace_back(new thread::ThreadPool(
+          Env::Default(), strings::StrCat("stage_", i), num_cpus));
+      thread::ThreadPool* pool = private_pools.back().get();
+      runners.push_back(
+          [pool](std::function<void()> fn) { pool->Schedule(std::move(fn)); });
+    }
+  }
+
+  BlockingCounter counter(iters);
+  std::function<void(int, int64)> run_stage = [&](int stage, int64 element) {
+    runners[stage]([&, stage, element]() {
+      int64 value = element;
+      Work(&value);
+      if (stage + 1 < num_stages) {
+        run_stage(stage + 1, value);
+      } else {
+        counter.DecrementCount();
+      }
+    });
+  };
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    run_stage(0, i);
+  }
+  counter.Wait();
+  testing::StopTiming();
+
+  testing::ItemsProcessed(static_cast<int64>(iters));
+  const int num_threads =
+      shared ? elastic_pool->PeakNumThreads() : num_stages * num_cpus;
+  testing::SetLabel(strings::StrCat("threads: ", num_threads));
+}
+
+BENCHMARK(BM_Pipeline)
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/inline_function.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+constexpr int InlineFunction::kMaxKernels;
+
+/* static */
+Status InlineFunction::Create(FunctionLibraryRuntime* lib,
+                              FunctionLibraryRuntime::Handle handle,
+                              std::unique_ptr<InlineFunction>* out) {
+  const FunctionBody* fbody = lib->GetFunctionBody(handle);
+  if (fbody == nullptr) {
+    return errors::Internal("Failed to instantiate function body.");
+  }
+  if (lib->device()->device_type() != DEVICE_CPU) {
+    return errors::Unimplemented("Only functions on CPU can be inlined.");
+  }
+  const Graph& graph = *fbody->graph;
+
+  std::unique_ptr<InlineFunction> function(new InlineFunction(lib));
+  function->num_args_ = fbody->arg_types.size();
+  function->num_slots_ = function->num_args_;
+  function->ret_slots_.resize(fbody->ret_types.size(), -1);
+  // The first slot of the outputs of each node, indexed by node ID.
+  std::vector<int> first_slot(graph.num_node_ids(), -1);
+  for (size_t i = 0; i < fbody->arg_nodes.size(); ++i) {
+    first_slot[fbody->arg_nodes[i]->id()] = i;
+  }
+  std::unordered_map<const Node*, int> ret_indices;
+  for (size_t i = 0; i < fbody->ret_nodes.size(); ++i) {
+    ret_indices[fbody->ret_nodes[i]] = i;
+  }
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (Node* node : order) {
+    if (!node->IsOp() || first_slot[node->id()] >= 0) {
+      continue;
+    }
+    std::vector<int> input_slots(node->num_inputs(), -1);
+    for (const Edge* edge : node->in_edges()) {
+      if (edge->IsControlEdge()) {
+        continue;
+      }
+      const int src_slot = first_slot[edge->src()->id()];
+      if (src_slot < 0) {
+        return errors::Internal("Input ", edge->dst_input(), " of ",
+                                node->name(), " is not computed.");
+      }
+      input_slots[edge->dst_input()] = src_slot + edge->src_output();
+    }
+    auto ret = ret_indices.find(node);
+    if (ret != ret_indices.end()) {
+      function->ret_slots_[ret->second] = input_slots[0];
+      continue;
+    }
+
+    if (function->steps_.size() >= kMaxKernels) {
+      return errors::Unimplemented("The function has more than ", kMaxKernels,
+                                   " kernels.");
+    }
+    if (node->IsControlFlow() || node->IsSend() || node->IsRecv() ||
+        node->op_def().is_stateful()) {
+      return errors::Unimplemented(node->type_string(),
+                                   " nodes cannot be inlined.");
+    }
+    for (DataType dtype : node->input_types()) {
+      if (IsRefType(dtype)) {
+        return errors::Unimplemented("Reference inputs cannot be inlined.");
+      }
+    }
+    for (DataType dtype : node->output_types()) {
+      if (IsRefType(dtype)) {
+        return errors::Unimplemented("Reference outputs cannot be inlined.");
+      }
+    }
+    function->steps_.emplace_back();
+    Step& step = function->steps_.back();
+    TF_RETURN_IF_ERROR(lib->CreateKernel(node->def(), &step.kernel));
+    // Function calls and other asynchronous kernels need the executor.
+    if (step.kernel->AsAsync() != nullptr) {
+      return errors::Unimplemented("Asynchronous kernel ", node->type_string(),
+                                   " cannot be inlined.");
+    }
+    step.input_slots = std::move(input_slots);
+    step.first_output_slot = function->num_slots_;
+    step.output_attrs.resize(node->num_outputs());
+    first_slot[node->id()] = step.first_output_slot;
+    function->num_slots_ += node->num_outputs();
+  }
+  for (int slot : function->ret_slots_) {
+    if (slot < 0) {
+      return errors::Internal("A return value is not computed.");
+    }
+  }
+
+  // Find the last use of each slot. Return values are never moved out.
+  std::vector<std::pair<int, int>> last_use(function->num_slots_, {-1, -1});
+  for (size_t i = 0; i < function->steps_.size(); ++i) {
+    Step& step = function->steps_[i];
+    step.move_inputs.resize(step.input_slots.size(), false);
+    for (size_t j = 0; j < step.input_slots.size(); ++j) {
+      last_use[step.input_slots[j]] = {static_cast<int>(i),
+                                       static_cast<int>(j)};
+    }
+  }
+  for (int slot : function->ret_slots_) {
+    last_use[slot] = {-1, -1};
+  }
+  for (const auto& use : last_use) {
+    if (use.first >= 0) {
+      function->steps_[use.first].move_inputs[use.second] = true;
+    }
+  }
+
+  *out = std::move(function);
+  return Status::OK();
+}
+
+InlineFunction::~InlineFunction() {
+  // The kernels were created by `FunctionLibraryRuntime::CreateKernel()`
+  // and are not cached, so they are owned here.
+  for (Step& step : steps_) {
+    delete step.kernel;
+  }
+}
+
+Status InlineFunction::Run(
+    CallFrameInterface* frame,
+    std::function<void(std::function<void()>)>* runner) const {
+  if (frame->num_args() != static_cast<size_t>(num_args_)) {
+    return errors::InvalidArgument("Expected ", num_args_, " arguments, got ",
+                                   frame->num_args());
+  }
+  std::vector<Tensor> slots(num_slots_);
+  for (int i = 0; i < num_args_; ++i) {
+    TF_RETURN_IF_ERROR(frame->GetArg(i, &slots[i]));
+  }
+
+  Device* device = lib_->device();
+  OpKernelContext::Params params;
+  params.device = device;
+  params.function_library = lib_;
+  params.resource_manager = device->resource_manager();
+  params.runner = runner;
+  for (const Step& step : steps_) {
+    const size_t num_inputs = step.input_slots.size();
+    gtl::InlinedVector<Tensor, 4> step_inputs(num_inputs);
+    gtl::InlinedVector<TensorValue, 4> inputs(num_inputs);
+    for (size_t j = 0; j < num_inputs; ++j) {
+      Tensor* slot = &slots[step.input_slots[j]];
+      if (step.move_inputs[j]) {
+        step_inputs[j] = std::move(*slot);
+      } else {
+        step_inputs[j] = *slot;
+      }
+      inputs[j] = TensorValue(&step_inputs[j]);
+    }
+    params.op_kernel = step.kernel;
+    params.inputs = &inputs;
+    params.output_attr_array = step.output_attrs.data();
+
+    const int num_outputs = step.kernel->num_outputs();
+    OpKernelContext ctx(&params, num_outputs);
+    device->Compute(step.kernel, &ctx);
+    TF_RETURN_IF_ERROR(ctx.status());
+    for (int i = 0; i < num_outputs; ++i) {
+      TensorValue value = ctx.release_output(i);
+      if (value.tensor == nullptr) {
+        return errors::Internal(step.kernel->name(), " did not set output ",
+                                i);
+      }
+      slots[step.first_output_slot + i] = std::move(*value.tensor);
+      delete value.tensor;
+    }
+  }
+
+  for (size_t i = 0; i < ret_slots_.size(); ++i) {
+    TF_RETURN_IF_ERROR(frame->SetRetval(i, slots[ret_slots_[i]]));
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,88 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_INLINE_FUNCTION_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_INLINE_FUNCTION_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+
+// Runs the body of a small instantiated function by calling the kernels of
+// its nodes one after another on the calling thread.
+//
+// This avoids the per-call cost of `FunctionLibraryRuntime::Run()` (setting
+// up an executor, a rendezvous and a step container, and scheduling each
+// kernel on a runner), which dominates for functions of a handful of cheap
+// ops such as the map functions of most input pipelines. Only function
+// bodies of synchronous, stateless, non-control-flow kernels on a CPU device
+// can be run this way; see `Create()`.
+//
+// The kernels are created once and shared, so `Run()` may be called
+// concurrently.
+class InlineFunction {
+ public:
+  // The largest number of kernels that a function may have to be inlined.
+  static constexpr int kMaxKernels = 32;
+
+  // Creates an `InlineFunction` for the function `handle` instantiated by
+  // `lib`. Returns `errors::Unimplemented()` if its body is not eligible.
+  static Status Create(FunctionLibraryRuntime* lib,
+                       FunctionLibraryRuntime::Handle handle,
+                       std::unique_ptr<InlineFunction>* out);
+
+  ~InlineFunction();
+
+  // Runs the function on the arguments of `frame`, and sets its return
+  // values. `runner` is passed to the kernels that schedule closures.
+  Status Run(CallFrameInterface* frame,
+             std::function<void(std::function<void()>)>* runner) const;
+
+ private:
+  // A kernel, and where its inputs and outputs are stored during a call.
+  struct Step {
+    OpKernel* kernel = nullptr;  // Owned.
+    std::vector<int> input_slots;
+    // True for the inputs that are the last use of their slot, which are
+    // moved out of the slot so that the kernel may forward their buffers.
+    std::vector<bool> move_inputs;
+    int first_output_slot = 0;
+    gtl::InlinedVector<AllocatorAttributes, 4> output_attrs;
+  };
+
+  explicit InlineFunction(FunctionLibraryRuntime* lib) : lib_(lib) {}
+
+  FunctionLibraryRuntime* const lib_;  // Not owned.
+  // Slots [0, num_args) hold the arguments, and the following slots hold the
+  // outputs of the steps.
+  int num_args_ = 0;
+  int num_slots_ = 0;
+  std::vector<Step> steps_;
+  std::vector<int> ret_slots_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineFunction);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_INLINE_FUNCTION_H_
@@ -0,0 +1,191 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/inline_function.h"
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+namespace f = test::function;
+typedef FunctionDefHelper FDH;
+
+FunctionDef XPlusRandom() {
+  return FDH::Define(
+      // Name
+      "XPlusRandom",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          {{"shape"}, "Shape", {"x"}, {{"T", DT_FLOAT}}},
+          {{"r"},
+           "RandomUniform",
+           {"shape"},
+           {{"T", DT_INT32}, {"dtype", DT_FLOAT}}},
+          {{"y"}, "Add", {"x", "r"}, {{"T", DT_FLOAT}}},
+      });
+}
+
+// Runs functions on a single CPU device.
+class FunctionRuntime {
+ public:
+  FunctionRuntime() {
+    SessionOptions options;
+    (*options.config.mutable_device_count())["CPU"] = 1;
+    std::vector<Device*> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(
+        options, "/job:localhost/replica:0/task:0", &devices));
+    device_mgr_.reset(new DeviceMgr(devices));
+
+    FunctionDefLibrary proto;
+    *proto.add_function() = f::XTimesTwo();
+    *proto.add_function() = f::XTimesFour();
+    *proto.add_function() = XPlusRandom();
+    lib_def_.reset(new FunctionLibraryDefinition(OpRegistry::Global(), proto));
+    pflr_.reset(new ProcessFunctionLibraryRuntime(
+        device_mgr_.get(), Env::Default(), TF_GRAPH_DEF_VERSION, lib_def_.get(),
+        OptimizerOptions(), nullptr /* default_thread_pool */,
+        nullptr /* cluster_flr */));
+    lib_ = pflr_->GetFLR("/job:localhost/replica:0/task:0/cpu:0");
+    runner_ = [](std::function<void()> fn) { fn(); };
+  }
+
+  FunctionLibraryRuntime* lib() { return lib_; }
+  std::function<void(std::function<void()>)>* runner() { return &runner_; }
+
+  Status Instantiate(const string& name, f::Attrs attrs,
+                     FunctionLibraryRuntime::Handle* handle) {
+    return lib_->Instantiate(name, attrs, handle);
+  }
+
+  // Runs `handle` with `FunctionLibraryRuntime::Run()`.
+  Status Run(FunctionLibraryRuntime::Handle handle, CallFrameInterface* frame) {
+    FunctionLibraryRuntime::Options opts;
+    opts.runner = &runner_;
+    Notification n;
+    Status status;
+    lib_->Run(opts, handle, frame, [&n, &status](const Status& s) {
+      status = s;
+      n.Notify();
+    });
+    n.WaitForNotification();
+    return status;
+  }
+
+ private:
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<FunctionLibraryDefinition> lib_def_;
+  std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
+  FunctionLibraryRuntime* lib_;
+  std::function<void(std::function<void()>)> runner_;
+};
+
+TEST(InlineFunctionTest, RunsStraightLineFunction) {
+  FunctionRuntime runtime;
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(runtime.Instantiate("XTimesTwo", {{"T", DT_FLOAT}}, &handle));
+  std::unique_ptr<InlineFunction> function;
+  TF_ASSERT_OK(InlineFunction::Create(runtime.lib(), handle, &function));
+
+  for (int i = 0; i < 2; ++i) {
+    FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(frame.SetArgs({test::AsTensor<float>({1, 2, 3, 4}, {2, 2})}));
+    TF_ASSERT_OK(function->Run(&frame, runtime.runner()));
+    std::vector<Tensor> rets;
+    TF_ASSERT_OK(frame.ConsumeRetvals(&rets));
+    ASSERT_EQ(rets.size(), 1);
+    test::ExpectTensorEqual<float>(
+        rets[0], test::AsTensor<float>({2, 4, 6, 8}, {2, 2}));
+  }
+}
+
+TEST(InlineFunctionTest, ArgumentIsNotModified) {
+  FunctionRuntime runtime;
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(runtime.Instantiate("XTimesTwo", {{"T", DT_FLOAT}}, &handle));
+  std::unique_ptr<InlineFunction> function;
+  TF_ASSERT_OK(InlineFunction::Create(runtime.lib(), handle, &function));
+
+  Tensor arg = test::AsTensor<float>({1, 2}, {2});
+  FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(frame.SetArgs({arg}));
+  TF_ASSERT_OK(function->Run(&frame, runtime.runner()));
+  test::ExpectTensorEqual<float>(arg, test::AsTensor<float>({1, 2}, {2}));
+}
+
+TEST(InlineFunctionTest, RejectsFunctionCalls) {
+  FunctionRuntime runtime;
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(runtime.Instantiate("XTimesFour", {{"T", DT_FLOAT}}, &handle));
+  std::unique_ptr<InlineFunction> function;
+  EXPECT_TRUE(errors::IsUnimplemented(
+      InlineFunction::Create(runtime.lib(), handle, &function)));
+}
+
+TEST(InlineFunctionTest, RejectsStatefulOps) {
+  FunctionRuntime runtime;
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(runtime.Instantiate("XPlusRandom", {}, &handle));
+  std::unique_ptr<InlineFunction> function;
+  EXPECT_TRUE(errors::IsUnimplemented(
+      InlineFunction::Create(runtime.lib(), handle, &function)));
+}
+
+// Measures the per-call overhead of running a tiny function, with the
+// executor (`inline = 0`) or with `InlineFunction` (`inline = 1`).
+static void BM_RunXTimesTwo(int iters, int inline_function) {
+  testing::StopTiming();
+  FunctionRuntime runtime;
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(runtime.Instantiate("XTimesTwo", {{"T", DT_FLOAT}}, &handle));
+  std::unique_ptr<InlineFunction> function;
+  TF_CHECK_OK(InlineFunction::Create(runtime.lib(), handle, &function));
+  const Tensor arg = test::AsScalar<float>(1);
+  std::vector<Tensor> rets;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+    TF_CHECK_OK(frame.SetArgs({arg}));
+    if (inline_function) {
+      TF_CHECK_OK(function->Run(&frame, runtime.runner()));
+    } else {
+      TF_CHECK_OK(runtime.Run(handle, &frame));
+    }
+    TF_CHECK_OK(frame.ConsumeRetvals(&rets));
+  }
+  testing::StopTiming();
+  testing::SetLabel(inline_function ? "inline" : "executor");
+}
+
+BENCHMARK(BM_RunXTimesTwo)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 #include "tensorflow/core/framework/iterator.pb.h"
+#include "tensorflow/core/framework/iterator_metrics.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
@@ -94,9 +96,14 @@ class IteratorResource : public ResourceBase {
         pflr_(std::move(pflr)),
         lib_(lib),
         iterator_(nullptr),
+        model_(std::make_shared<model::Model>()),
         output_dtypes_(output_dtypes),
         output_shapes_(output_shapes) {}
 
+  ~IteratorResource() override {
+    VLOG(1) << "Dataset iterator metrics:\n" << IteratorMetrics::Report();
+  }
+
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) {
     std::shared_ptr<IteratorBase> captured_iterator(iterator_);
@@ -104,6 +111,7 @@ class IteratorResource : public ResourceBase {
       if (lib_ != nullptr) {
         ctx->set_lib(lib_);
       }
+      ctx->set_model(model_);
       return captured_iterator->GetNext(ctx, out_tensors, end_of_sequence);
     } else {
       return errors::FailedPrecondition(
@@ -159,6 +167,7 @@ class IteratorResource : public ResourceBase {
     TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
 
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model(model_);
     std::unique_ptr<IteratorBase> iterator;
     TF_RETURN_IF_ERROR(dataset->MakeIterator(&iter_ctx, "Iterator", &iterator));
     TF_RETURN_IF_ERROR(set_iterator(std::move(iterator)));
@@ -173,6 +182,7 @@ class IteratorResource : public ResourceBase {
       params.allocator_getter = [device](AllocatorAttributes attrs) {
         return device->GetAllocator(attrs);
       };
+      params.model = model_;
       IteratorContext iter_ctx(std::move(params));
 
       TF_RETURN_IF_ERROR(captured_iterator->Restore(&iter_ctx, reader));
@@ -215,6 +225,9 @@ class IteratorResource : public ResourceBase {
     return output_shapes_;
   }
 
+  // The model that tunes the iterators created for this resource.
+  std::shared_ptr<model::Model> model() const { return model_; }
+
  private:
   // The following (device_mgr_, flib_def_, pflr_) are only used when the
   // IteratorResource is shared between sessions and in that case we create
@@ -224,6 +237,7 @@ class IteratorResource : public ResourceBase {
   std::unique_ptr<ProcessFunctionLibraryRuntime> pflr_;
   FunctionLibraryRuntime* lib_ = nullptr;  // not owned.
   std::shared_ptr<IteratorBase> iterator_;
+  const std::shared_ptr<model::Model> model_;
   mutex mu_;
   std::shared_ptr<const FunctionLibraryDefinition> lib_def_ GUARDED_BY(mu_);
   const DataTypeVector output_dtypes_;
@@ -655,6 +669,7 @@ class MakeIteratorOp : public OpKernel {
     core::ScopedUnref unref(iterator_resource);
 
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model(iterator_resource->model());
     std::unique_ptr<IteratorBase> iterator;
     OP_REQUIRES_OK(ctx,
                    dataset->MakeIterator(&iter_ctx, "Iterator", &iterator));
@@ -952,6 +967,7 @@ class OneShotIteratorOp : public AsyncOpKernel {
     DatasetBase* dataset;
     TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(return_values[0], &dataset));
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model((*iterator)->model());
     std::unique_ptr<IteratorBase> iter;
     TF_RETURN_IF_ERROR(dataset->MakeIterator(&iter_ctx, "Iterator", &iter));
     TF_RETURN_IF_ERROR((*iterator)->set_iterator(std::move(iter)));
@@ -17,15 +17,18 @@ limitations under the License.
 #include <utility>
 
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
 #include "tensorflow/core/kernels/inplace_ops_functor.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -77,7 +80,9 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       case 2:
         OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                                 &num_parallel_calls));
-        OP_REQUIRES(ctx, num_parallel_calls > 0,
+        OP_REQUIRES(ctx,
+                    num_parallel_calls > 0 ||
+                        num_parallel_calls == model::kAutoTune,
                     errors::InvalidArgument(
                         "num_parallel_calls must be greater than zero."));
         break;
@@ -189,9 +194,14 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            runner_(ElasticThreadPool::Global()->NewRunner()) {}
 
       ~Iterator() override {
+        // Stop the model from notifying `cond_var_`.
+        if (node_) {
+          model_->RemoveNode(node_);
+        }
         mutex_lock l(mu_);
         // Cancel the runner thread.
         cancelled_ = true;
@@ -203,13 +213,26 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        if (dataset()->num_parallel_calls_ == model::kAutoTune &&
+            ctx->model()) {
+          model_ = ctx->model();
+          node_ = model_->AddNode(
+              prefix(), port::NumSchedulableCPUs(),
+              [this]() {
+                mutex_lock l(mu_);
+                cond_var_.notify_all();
+              },
+              ctx->stats_aggregator_getter());
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
+        const uint64 start_micros = node_ ? ctx->env()->NowMicros() : 0;
         std::shared_ptr<BatchResult> result;
+        int64 num_results;
         {
           mutex_lock l(mu_);
           EnsureRunnerThreadStarted(ctx);
@@ -217,10 +240,15 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
                  batch_results_.front()->num_calls > 0) {
             cond_var_.wait(l);
           }
+          num_results = batch_results_.size();
           std::swap(result, batch_results_.front());
           batch_results_.pop_front();
         }
         cond_var_.notify_all();
+        if (node_) {
+          node_->RecordGetNext(ctx->env()->NowMicros() - start_micros,
+                               num_results);
+        }
         return ProcessResult(ctx, result, out_tensors, end_of_sequence);
       }
 
@@ -358,9 +386,15 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
                                    std::vector<Tensor> input_element) {
               std::shared_ptr<std::vector<Tensor>> return_values(
                   new std::vector<Tensor>());
+              const uint64 start_micros = ctx->env()->NowMicros();
               dataset()->captured_func_->RunAsync(
                   ctx.get(), std::move(input_element), return_values.get(),
-                  [this, ctx, result, return_values, offset](Status status) {
+                  [this, ctx, result, return_values, offset,
+                   start_micros](Status status) {
+                    if (node_) {
+                      node_->RecordElement(ctx->env()->NowMicros() -
+                                           start_micros);
+                    }
                     Callback(ctx, result, return_values, offset, status);
                   });
             },
@@ -392,8 +426,12 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (!runner_thread_) {
           std::shared_ptr<IteratorContext> ctx_copy(new IteratorContext(*ctx));
-          runner_thread_.reset(ctx->env()->StartThread(
-              {}, "runner_thread",
+          // Run `f` on the thread pool shared by all dataset iterators,
+          // unless an upstream dataset chose where the pipeline runs.
+          if (!ctx->runner_overridden()) {
+            *ctx_copy->runner() = runner_;
+          }
+          runner_thread_.reset(ElasticThreadPool::Global()->StartThread(
               std::bind(&Iterator::RunnerThread, this, ctx_copy)));
         }
       }
@@ -419,8 +457,19 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         result->output_allocated = true;
       }
 
+      // Returns the number of calls that may be in flight at once.
+      int64 NumParallelCalls() {
+        if (node_) {
+          return node_->parallelism();
+        }
+        if (dataset()->num_parallel_calls_ == model::kAutoTune) {
+          return port::NumSchedulableCPUs();
+        }
+        return dataset()->num_parallel_calls_;
+      }
+
       int MaxBatchResults() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        return (dataset()->num_parallel_calls_ + dataset()->batch_size_ - 1) /
+        return (NumParallelCalls() + dataset()->batch_size_ - 1) /
                dataset()->batch_size_;
       }
 
@@ -472,12 +521,12 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       void RunnerThread(const std::shared_ptr<IteratorContext>& ctx)
           LOCKS_EXCLUDED(mu_) {
         std::vector<std::pair<std::shared_ptr<BatchResult>, int64>> new_calls;
-        new_calls.reserve(dataset()->num_parallel_calls_);
+        new_calls.reserve(NumParallelCalls());
         while (true) {
           {
             mutex_lock l(mu_);
             while (!cancelled_ &&
-                   (num_calls_ >= dataset()->num_parallel_calls_ ||
+                   (num_calls_ >= NumParallelCalls() ||
                     batch_results_.size() > MaxBatchResults() ||
                     (batch_results_.size() == MaxBatchResults() &&
                      call_counter_ % dataset()->batch_size_ == 0))) {
@@ -488,7 +537,7 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
               return;
             }
 
-            while (num_calls_ < dataset()->num_parallel_calls_ &&
+            while (num_calls_ < NumParallelCalls() &&
                    (batch_results_.size() < MaxBatchResults() ||
                     (batch_results_.size() == MaxBatchResults() &&
                      call_counter_ % dataset()->batch_size_ != 0))) {
@@ -626,6 +675,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // Schedules the closures of `f` on the shared pool.
+      const ElasticThreadPool::Runner runner_;
       // Used for coordination between the main thread, the runner thread, and
       // the callback threads.
       mutex mu_;
@@ -642,6 +693,9 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       std::unique_ptr<IteratorBase> input_impl_;
       // Buffer for storing the (intermediate) batch results.
       std::deque<std::shared_ptr<BatchResult>> batch_results_ GUARDED_BY(mu_);
+      // Set if the model chooses the number of parallel calls.
+      std::shared_ptr<model::Model> model_;
+      std::shared_ptr<model::Node> node_;
       std::unique_ptr<Thread> runner_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
     };
@@ -147,10 +147,12 @@ class OptimizeDatasetOp : public UnaryDatasetOpKernel {
         IteratorContext::Params params;
         params.env = ctx->env();
         params.runner = *(ctx->runner());
+        params.runner_overridden = ctx->runner_overridden();
         params.stats_aggregator_getter = ctx->stats_aggregator_getter();
         params.lib = ctx->lib();
         params.function_library = dataset()->flib_def_;
         params.allocator_getter = ctx->allocator_getter();
+        params.model = ctx->model();
         IteratorContext iter_ctx(params);
         return input_impl_->GetNext(&iter_ctx, out_tensors, end_of_sequence);
       }
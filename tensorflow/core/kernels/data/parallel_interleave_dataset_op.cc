@@ -12,14 +12,17 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
 #include "tensorflow/core/kernels/data/dataset.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -39,6 +42,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &interleave_func_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("max_buffer_output_elements",
+                                     &max_buffer_output_elements_));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -72,6 +77,12 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES(
         ctx, buffer_output_elements > 0,
         errors::InvalidArgument("`buffer_output_elements` must be > 0"));
+    OP_REQUIRES(ctx,
+                max_buffer_output_elements_ == 0 ||
+                    max_buffer_output_elements_ >= buffer_output_elements,
+                errors::InvalidArgument(
+                    "`max_buffer_output_elements` must be 0 or >= "
+                    "`buffer_output_elements`"));
 
     int64 prefetch_input_elements = 0;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "prefetch_input_elements",
@@ -88,6 +99,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     *output =
         new Dataset(ctx, input, interleave_func_, std::move(captured_func),
                     cycle_length, block_length, sloppy, buffer_output_elements,
+                    std::max(max_buffer_output_elements_,
+                             buffer_output_elements),
                     prefetch_input_elements, output_types_, output_shapes_);
   }
 
@@ -98,7 +111,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             const NameAttrList& func,
             std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
             int64 block_length, bool sloppy, int64 buffer_output_elements,
-            int64 prefetch_input_elements, const DataTypeVector& output_types,
+            int64 max_buffer_output_elements, int64 prefetch_input_elements,
+            const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes)
         : GraphDatasetBase(ctx),
           input_(input),
@@ -108,6 +122,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           block_length_(block_length),
           sloppy_(sloppy),
           buffer_output_elements_(buffer_output_elements),
+          max_buffer_output_elements_(max_buffer_output_elements),
           prefetch_input_elements_(prefetch_input_elements),
           output_types_(output_types),
           output_shapes_(output_shapes) {
@@ -165,6 +180,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       b->BuildAttrValue(interleave_func_, &f);
       AttrValue other_arguments_types_attr;
       b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+      AttrValue max_buffer_output_elements;
+      b->BuildAttrValue(max_buffer_output_elements_,
+                        &max_buffer_output_elements);
 
       TF_RETURN_IF_ERROR(b->AddDataset(
           this,
@@ -175,7 +193,10 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
            {5, buffer_output_elements_node},
            {6, prefetch_input_elements_node}},
           {{1, other_arguments}},
-          {{"f", f}, {"Targuments", other_arguments_types_attr}}, output));
+          {{"f", f},
+           {"Targuments", other_arguments_types_attr},
+           {"max_buffer_output_elements", max_buffer_output_elements}},
+          output));
       return Status::OK();
     }
 
@@ -232,14 +253,31 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     //     union of `interleave_indices_` and `staging_indices_`.
     //  3. Unless `input_impl_` is empty, every `worker_` must be pointed to by
     //     an element in `interleave_indices_` or `staging_indices_`.
+    //
+    // Each worker buffers up to `WorkerState::buffer_limit` elements, which
+    // starts at `buffer_output_elements_`. When the client (with `sloppy_`
+    // false) has to wait for the worker whose turn it is, that worker's limit
+    // is doubled, up to `max_buffer_output_elements_`, so that an input that
+    // has stalled once can get further ahead before it stalls again. The
+    // limit goes back to `buffer_output_elements_` when the worker moves on
+    // to a new input element. Buffering never changes which element is
+    // produced next, so the order stays deterministic.
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
           : DatasetIterator<Dataset>(params),
+            runner_(ElasticThreadPool::Global()->NewRunner()),
             workers_(dataset()->num_threads()),
-            worker_thread_states_(dataset()->num_threads()) {}
+            worker_thread_states_(dataset()->num_threads()) {
+        for (auto& worker : workers_) {
+          worker.buffer_limit = dataset()->buffer_output_elements_;
+        }
+      }
 
       ~Iterator() override {
+        if (node_) {
+          model_->RemoveNode(node_);
+        }
         mutex_lock l(mu_);
         cancelled_ = true;
         // Notify all workers in case they are blocked.
@@ -249,6 +287,13 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        // The worker threads are never resized, but they take up part of
+        // the CPU budget of the tunable stages of the pipeline.
+        if (ctx->model()) {
+          model_ = ctx->model();
+          node_ = model_->AddFixedNode(prefix(), dataset()->num_threads(),
+                                       ctx->stats_aggregator_getter());
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
@@ -260,6 +305,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         TF_RETURN_IF_ERROR(EnsureWorkerThreadsStarted(ctx));
+        // Whether the buffer of a stalled worker has been grown in this call.
+        bool grew_buffer = false;
         while (!cancelled_) {
           // Wait for an item to become available, blocking if necessary. If we
           // are allowed to be sloppy, we can skip over input datasets that do
@@ -300,6 +347,13 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                 next_index_ = index;
                 block_count_ = 0;
               }
+              if (!grew_buffer) {
+                // This input is a straggler; let it buffer more.
+                current_worker->buffer_limit =
+                    std::min(2 * current_worker->buffer_limit,
+                             dataset()->max_buffer_output_elements_);
+                grew_buffer = true;
+              }
               break;
             } else if (!current_worker->is_producing) {
               // This iterator has reached end of input.
@@ -313,6 +367,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                   input_impl_.reset();
                 } else {
                   current_worker->SetInputs(s, std::move(args));
+                  current_worker->buffer_limit =
+                      dataset()->buffer_output_elements_;
                   staging_indices_.emplace_back(current_worker_index);
                 }
               }
@@ -474,10 +530,10 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         if (reader->Contains(full_name("worker_threads_running"))) {
           worker_threads_.reserve(dataset()->num_threads());
           for (size_t i = 0; i < dataset()->num_threads(); ++i) {
-            worker_threads_.emplace_back(ctx->env()->StartThread(
-                {}, "worker_thread",
-                std::bind(&Iterator::WorkerThread, this,
-                          new IteratorContext(*ctx), i)));
+            worker_threads_.emplace_back(
+                ElasticThreadPool::Global()->StartThread(
+                    std::bind(&Iterator::WorkerThread, this,
+                              MakeWorkerContext(ctx), i)));
           }
         }
         return Status::OK();
@@ -509,6 +565,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         // Concretely, all output elements will have been consumed only when:
         // is_producing == false && outputs.empty();
         bool is_producing = false;
+        // The maximum number of elements in `outputs`.
+        int64 buffer_limit = 0;
         // Condition variable used to coordinate between threads. The worker
         // thread waits on this condition variable when it is either (1) waiting
         // for the main thread to add arguments to `input`, or (2) waiting for
@@ -573,10 +631,10 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
               return Status::OK();
             }
             workers_[i].SetInputs(s, std::move(args));
-            worker_threads_.emplace_back(ctx->env()->StartThread(
-                {}, "worker_thread",
-                std::bind(&Iterator::WorkerThread, this,
-                          new IteratorContext(*ctx), i)));
+            worker_threads_.emplace_back(
+                ElasticThreadPool::Global()->StartThread(
+                    std::bind(&Iterator::WorkerThread, this,
+                              MakeWorkerContext(ctx), i)));
             if (i < dataset()->cycle_length_) {
               interleave_indices_.push_back(i);
             } else {
@@ -591,6 +649,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       }
 
       // Produces elements into the worker's output buffers.
+      // Returns a copy of `ctx`, owned by the caller, that runs functions
+      // on the shared dataset thread pool, unless an upstream dataset chose
+      // where the pipeline runs.
+      IteratorContext* MakeWorkerContext(IteratorContext* ctx) {
+        IteratorContext* worker_ctx = new IteratorContext(*ctx);
+        if (!ctx->runner_overridden()) {
+          *worker_ctx->runner() = runner_;
+        }
+        return worker_ctx;
+      }
+
       void WorkerThread(IteratorContext* ctx_ptr, const int64 thread_index) {
         // Notes on checkpointing thread local state, i.e., `WorkerThreadState`:
         //
@@ -703,8 +772,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           if (!iterator_creation_status.ok()) {
             mutex_lock l(mu_);
             // Wait for space in the prefetch queue.
-            while (!cancelled_ && workers_[thread_index].outputs.size() ==
-                                      dataset()->buffer_output_elements_) {
+            while (!cancelled_ && workers_[thread_index].outputs.size() >=
+                                      workers_[thread_index].buffer_limit) {
               workers_[thread_index].cond_var.wait(l);
             }
             if (cancelled_) return;
@@ -729,12 +798,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                     worker_thread_states_[thread_index]
                         .output_elem.output.empty() &&
                     !worker_thread_states_[thread_index].end_of_sequence) {
+                  const uint64 start_micros = ctx->env()->NowMicros();
                   worker_thread_states_[thread_index].output_elem.status =
                       worker_thread_states_[thread_index].iterator->GetNext(
                           ctx.get(),
                           &worker_thread_states_[thread_index]
                                .output_elem.output,
                           &worker_thread_states_[thread_index].end_of_sequence);
+                  if (node_) {
+                    node_->RecordElement(ctx->env()->NowMicros() -
+                                         start_micros);
+                  }
                   end_of_sequence =
                       worker_thread_states_[thread_index].end_of_sequence;
                 } else {
@@ -752,8 +826,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                 mutex_lock l(mu_);
 
                 // Wait for space in the prefetch queue.
-                while (!cancelled_ && workers_[thread_index].outputs.size() ==
-                                          dataset()->buffer_output_elements_) {
+                while (!cancelled_ && workers_[thread_index].outputs.size() >=
+                                          workers_[thread_index].buffer_limit) {
                   workers_[thread_index].cond_var.wait(l);
                 }
                 if (cancelled_) return;
@@ -814,6 +888,11 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               full_name(strings::StrCat(prefix, "_is_producing")), ""));
         }
+        if (workers_[index].buffer_limit > dataset()->buffer_output_elements_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat(prefix, "_buffer_limit")),
+              workers_[index].buffer_limit));
+        }
         return Status::OK();
       }
 
@@ -849,6 +928,14 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         } else {
           workers_[index].is_producing = false;
         }
+        const string buffer_limit_key =
+            full_name(strings::StrCat(worker_prefix, "_buffer_limit"));
+        if (reader->Contains(buffer_limit_key)) {
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              buffer_limit_key, &workers_[index].buffer_limit));
+        } else {
+          workers_[index].buffer_limit = dataset()->buffer_output_elements_;
+        }
         return Status::OK();
       }
 
@@ -994,6 +1081,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // Schedules closures of the worker threads on the shared pool.
+      const ElasticThreadPool::Runner runner_;
+
       // Mutex & condition variable to guard mutable iterator internals and
       // coordinate among worker threads and client thread[s].
       mutex mu_ ACQUIRED_BEFORE(ckpt_mu_);
@@ -1032,6 +1122,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       size_t block_count_ GUARDED_BY(mu_) = 0;
       // Flag to instruct the worker threads to exit.
       bool cancelled_ GUARDED_BY(mu_) = false;
+      // Set if the iterator belongs to a pipeline with a model.
+      std::shared_ptr<model::Model> model_;
+      std::shared_ptr<model::Node> node_;
       // The worker threads. This must be last to ensure the
       // threads have exited before any other members are deallocated.
       // TODO(b/65178177): Avoid allocating additional threads.
@@ -1045,6 +1138,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     const int64 block_length_;
     const bool sloppy_;
     const int64 buffer_output_elements_;
+    const int64 max_buffer_output_elements_;
     const int64 prefetch_input_elements_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
@@ -1054,6 +1148,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   NameAttrList interleave_func_;
+  int64 max_buffer_output_elements_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParallelInterleaveDataset").Device(DEVICE_CPU),
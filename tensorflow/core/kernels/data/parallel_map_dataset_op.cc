@@ -15,12 +15,15 @@ limitations under the License.
 #include <deque>
 
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace tensorflow {
 
@@ -53,7 +56,9 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
     int32 num_parallel_calls;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                             &num_parallel_calls));
-    OP_REQUIRES(ctx, num_parallel_calls > 0,
+    OP_REQUIRES(ctx,
+                num_parallel_calls > 0 ||
+                    num_parallel_calls == model::kAutoTune,
                 errors::InvalidArgument(
                     "num_parallel_calls must be greater than zero."));
 
@@ -151,9 +156,14 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            runner_(ElasticThreadPool::Global()->NewRunner()) {}
 
       ~Iterator() override {
+        // Stop the model from notifying `cond_var_`.
+        if (node_) {
+          model_->RemoveNode(node_);
+        }
         // TODO(mrry): Replace this cancellation logic with a
         // CancellationManager. The syntax would be more heavyweight,
         // but it would be possible to thread a cancellation manager
@@ -170,24 +180,43 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        if (dataset()->num_parallel_calls_ == model::kAutoTune &&
+            ctx->model()) {
+          model_ = ctx->model();
+          node_ = model_->AddNode(
+              prefix(), port::NumSchedulableCPUs(),
+              [this]() {
+                mutex_lock l(mu_);
+                cond_var_.notify_all();
+              },
+              ctx->stats_aggregator_getter());
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
+        const uint64 start_micros = node_ ? ctx->env()->NowMicros() : 0;
         std::shared_ptr<InvocationResult> result;
+        int64 num_results;
         {
           mutex_lock l(mu_);
           EnsureRunnerThreadStarted(ctx);
           while (invocation_results_.empty()) {
             cond_var_.wait(l);
           }
+          num_results = invocation_results_.size();
           std::swap(result, invocation_results_.front());
           invocation_results_.pop_front();
         }
         cond_var_.notify_all();
+        metrics()->RecordBufferUtilization(num_results, MaxInvocationResults());
         result->notification.WaitForNotification();
+        if (node_) {
+          node_->RecordGetNext(ctx->env()->NowMicros() - start_micros,
+                               num_results);
+        }
         return ProcessResult(result, out_tensors, end_of_sequence);
       }
 
@@ -276,8 +305,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (!runner_thread_) {
           std::shared_ptr<IteratorContext> ctx_copy(new IteratorContext(*ctx));
-          runner_thread_.reset(ctx->env()->StartThread(
-              {}, "runner_thread",
+          // Run `f` on the thread pool shared by all dataset iterators,
+          // unless an upstream dataset chose where the pipeline runs.
+          if (!ctx->runner_overridden()) {
+            *ctx_copy->runner() = runner_;
+          }
+          runner_thread_.reset(ElasticThreadPool::Global()->StartThread(
               std::bind(&Iterator::RunnerThread, this, ctx_copy)));
         }
       }
@@ -307,7 +340,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         // Call `func_(input_element)`, store the result in
         // `result->return_values`, and notify `result->notification` to unblock
         // a consumer.
-        auto done = [this, result](Status status) {
+        Env* env = ctx->env();
+        const uint64 start_micros = env->NowMicros();
+        auto done = [this, result, env, start_micros](Status status) {
+          if (node_) {
+            node_->RecordElement(env->NowMicros() - start_micros);
+          }
           result->status.Update(status);
           CallCompleted(result);
         };
@@ -315,7 +353,18 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
                                             &result->return_values, done);
       }
 
-      int64 MaxInvocationResults() { return dataset()->num_parallel_calls_; }
+      // Returns the number of calls that may be in flight at once.
+      int64 NumParallelCalls() {
+        if (node_) {
+          return node_->parallelism();
+        }
+        if (dataset()->num_parallel_calls_ == model::kAutoTune) {
+          return port::NumSchedulableCPUs();
+        }
+        return dataset()->num_parallel_calls_;
+      }
+
+      int64 MaxInvocationResults() { return NumParallelCalls(); }
 
       Status ProcessResult(const std::shared_ptr<InvocationResult>& result,
                            std::vector<Tensor>* out_tensors,
@@ -337,19 +386,19 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
 
       void RunnerThread(const std::shared_ptr<IteratorContext>& ctx) {
         std::vector<std::shared_ptr<InvocationResult>> new_calls;
-        new_calls.reserve(dataset()->num_parallel_calls_);
+        new_calls.reserve(NumParallelCalls());
         while (true) {
           {
             mutex_lock l(mu_);
             while (!cancelled_ &&
-                   (num_calls_ >= dataset()->num_parallel_calls_ ||
+                   (num_calls_ >= NumParallelCalls() ||
                     invocation_results_.size() >= MaxInvocationResults())) {
               cond_var_.wait(l);
             }
             if (cancelled_) {
               return;
             }
-            while (num_calls_ < dataset()->num_parallel_calls_ &&
+            while (num_calls_ < NumParallelCalls() &&
                    invocation_results_.size() < MaxInvocationResults()) {
               invocation_results_.emplace_back(new InvocationResult());
               new_calls.push_back(invocation_results_.back());
@@ -403,6 +452,8 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
             strings::StrCat("invocation_results[", index, "].error_message"));
       }
 
+      // Schedules the closures of `f` on the shared pool.
+      const ElasticThreadPool::Runner runner_;
       // Used for coordination between the main thread and the runner thread.
       mutex mu_;
       // Used for coordination between the main thread and the runner thread. In
@@ -417,6 +468,9 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
       // Buffer for storing the invocation results.
       std::deque<std::shared_ptr<InvocationResult>> invocation_results_
           GUARDED_BY(mu_);
+      // Set if the model chooses the number of parallel calls.
+      std::shared_ptr<model::Model> model_;
+      std::shared_ptr<model::Node> node_;
       std::unique_ptr<Thread> runner_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
     };
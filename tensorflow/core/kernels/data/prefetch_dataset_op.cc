@@ -15,10 +15,13 @@ limitations under the License.
 #include <deque>
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
 #include "tensorflow/core/kernels/data/prefetch_autotuner.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 
@@ -129,7 +132,8 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
           }
 
           if (!buffer_.empty()) {
-            return Consume(out_tensors, end_of_sequence);
+            return Consume(out_tensors, end_of_sequence,
+                           ctx->stats_aggregator());
           }
 
           if (prefetch_thread_finished_) {
@@ -218,14 +222,28 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
         std::vector<Tensor> value;
       };
 
-      Status Consume(std::vector<Tensor>* out_tensors, bool* end_of_sequence)
+      Status Consume(std::vector<Tensor>* out_tensors, bool* end_of_sequence,
+                     const std::shared_ptr<StatsAggregator>& stats_aggregator)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (stats_aggregator) {
+          stats_aggregator->AddScalar(
+              strings::StrCat(prefix(), "::buffer_limit"),
+              static_cast<float>(auto_tuner_.buffer_limit()));
+          stats_aggregator->AddToHistogram(
+              strings::StrCat(prefix(), "::buffer_utilization"),
+              {static_cast<double>(buffer_.size()) /
+               static_cast<double>(auto_tuner_.buffer_limit())});
+        }
+        metrics()->RecordBufferUtilization(buffer_.size(),
+                                           auto_tuner_.buffer_limit());
         // A new element is available. Forward the status from computing it, and
         // (if we successfully got an element) the output values.
         Status s = buffer_.front().status;
         if (s.ok()) {
           *out_tensors = std::move(buffer_.front().value);
         }
+        // Let the autotuner grow the buffer if it keeps filling up.
+        auto_tuner_.RecordConsumption(buffer_.size());
         buffer_.pop_front();
         *end_of_sequence = false;
 
@@ -241,10 +259,9 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
       Status EnsurePrefetchThreadStarted(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (!prefetch_thread_) {
-          prefetch_thread_.reset(
-              ctx->env()->StartThread({}, "prefetch_thread",
-                                      std::bind(&Iterator::PrefetchThread, this,
-                                                new IteratorContext(*ctx))));
+          prefetch_thread_.reset(ElasticThreadPool::Global()->StartThread(
+              std::bind(&Iterator::PrefetchThread, this,
+                        new IteratorContext(*ctx))));
         }
         return Status::OK();
       }
@@ -15,6 +15,8 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
@@ -425,8 +427,8 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
           }
           TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
               dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_.reset(
-              new io::InputBuffer(file_.get(), dataset()->buffer_size_));
+          input_buffer_.reset(new io::InputBuffer(
+              file_.get(), dataset()->buffer_size_, /*readahead=*/true));
           TF_RETURN_IF_ERROR(
               input_buffer_->SkipNBytes(dataset()->header_bytes_));
         } while (true);
@@ -468,8 +470,8 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
           file_pos_limit_ = file_size - dataset()->footer_bytes_;
           TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
               dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_.reset(
-              new io::InputBuffer(file_.get(), dataset()->buffer_size_));
+          input_buffer_.reset(new io::InputBuffer(
+              file_.get(), dataset()->buffer_size_, /*readahead=*/true));
           TF_RETURN_IF_ERROR(input_buffer_->Seek(current_pos));
         }
 
@@ -496,9 +498,24 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
 REGISTER_KERNEL_BUILDER(Name("FixedLengthRecordDataset").Device(DEVICE_CPU),
                         FixedLengthRecordDatasetOp);
 
+// The threads that issue the readahead of `TFRecordDataset` iterators. The
+// reads block on I/O, so they do not run on the shared compute threads.
+thread::ThreadPool* ReadaheadThreadPool() {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "tf_record_readahead", 64);
+  return pool;
+}
+
 class TFRecordDatasetOp : public DatasetOpKernel {
  public:
-  using DatasetOpKernel::DatasetOpKernel;
+  explicit TFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("num_readahead_blocks", &num_readahead_blocks_));
+    OP_REQUIRES(ctx, num_readahead_blocks_ >= 0,
+                errors::InvalidArgument(
+                    "`num_readahead_blocks` must be >= 0 (0 == no readahead)"));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
     const Tensor* filenames_tensor;
@@ -524,23 +541,27 @@ class TFRecordDatasetOp : public DatasetOpKernel {
                 errors::InvalidArgument(
                     "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-    *output =
-        new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+    *output = new Dataset(ctx, std::move(filenames), compression_type,
+                          buffer_size, num_readahead_blocks_);
   }
 
  private:
   class Dataset : public GraphDatasetBase {
    public:
     explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                     const string& compression_type, int64 buffer_size)
+                     const string& compression_type, int64 buffer_size,
+                     int64 num_readahead_blocks)
         : GraphDatasetBase(ctx),
           filenames_(std::move(filenames)),
           compression_type_(compression_type),
           options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {
+              compression_type)),
+          num_readahead_blocks_(num_readahead_blocks) {
       if (buffer_size > 0) {
         options_.buffer_size = buffer_size;
+        parallel_options_.block_size = buffer_size;
       }
+      parallel_options_.num_readahead_blocks = num_readahead_blocks;
     }
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -571,16 +592,27 @@ class TFRecordDatasetOp : public DatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
       Node* buffer_size = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+      AttrValue num_readahead_blocks;
+      b->BuildAttrValue(num_readahead_blocks_, &num_readahead_blocks);
       TF_RETURN_IF_ERROR(b->AddDataset(
-          this, {filenames, compression_type, buffer_size}, output));
+          this, {filenames, compression_type, buffer_size},
+          {{"num_readahead_blocks", num_readahead_blocks}}, output));
       return Status::OK();
     }
 
+    // Returns true if the iterators should read with a `ParallelRecordReader`,
+    // which only supports uncompressed files.
+    bool UseReadahead() const {
+      return num_readahead_blocks_ > 0 &&
+             options_.compression_type == io::RecordReaderOptions::NONE;
+    }
+
    private:
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            compute_runner_(ElasticThreadPool::Global()->NewRunner()) {}
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
@@ -588,9 +620,11 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         mutex_lock l(mu_);
         do {
           // We are currently processing a file, so try to read the next record.
-          if (reader_) {
+          if (reader_ || parallel_reader_) {
             Tensor result_tensor(ctx->allocator({}), DT_STRING, {});
-            Status s = reader_->ReadRecord(&result_tensor.scalar<string>()());
+            string* record = &result_tensor.scalar<string>()();
+            Status s = reader_ ? reader_->ReadRecord(record)
+                               : parallel_reader_->ReadRecord(record);
             if (s.ok()) {
               out_tensors->emplace_back(std::move(result_tensor));
               *end_of_sequence = false;
@@ -624,6 +658,9 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         if (reader_) {
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("offset"), reader_->TellOffset()));
+        } else if (parallel_reader_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name("offset"), parallel_reader_->TellOffset()));
         }
         return Status::OK();
       }
@@ -640,7 +677,11 @@ class TFRecordDatasetOp : public DatasetOpKernel {
           int64 offset;
           TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("offset"), &offset));
           TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-          TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+          if (reader_) {
+            TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+          } else {
+            TF_RETURN_IF_ERROR(parallel_reader_->SeekOffset(offset));
+          }
         }
         return Status::OK();
       }
@@ -658,30 +699,48 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         const string& next_filename =
             dataset()->filenames_[current_file_index_];
         TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
-        reader_.reset(
-            new io::SequentialRecordReader(file_.get(), dataset()->options_));
+        if (dataset()->UseReadahead()) {
+          parallel_reader_.reset(new io::ParallelRecordReader(
+              file_.get(), dataset()->parallel_options_,
+              [](std::function<void()> fn) {
+                ReadaheadThreadPool()->Schedule(std::move(fn));
+              },
+              compute_runner_));
+        } else {
+          reader_.reset(
+              new io::SequentialRecordReader(file_.get(), dataset()->options_));
+        }
         return Status::OK();
       }
 
       // Resets all reader streams.
       void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         reader_.reset();
+        parallel_reader_.reset();
         file_.reset();
       }
 
+      const ElasticThreadPool::Runner compute_runner_;
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
 
-      // `reader_` will borrow the object that `file_` points to, so
-      // we must destroy `reader_` before `file_`.
+      // `reader_` and `parallel_reader_` will borrow the object that `file_`
+      // points to, so we must destroy them before `file_`. At most one of
+      // them is set.
       std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
       std::unique_ptr<io::SequentialRecordReader> reader_ GUARDED_BY(mu_);
+      std::unique_ptr<io::ParallelRecordReader> parallel_reader_
+          GUARDED_BY(mu_);
     };
 
     const std::vector<string> filenames_;
     const string compression_type_;
     io::RecordReaderOptions options_;
+    const int64 num_readahead_blocks_;
+    io::ParallelRecordReader::Options parallel_options_;
   };
+
+  int64 num_readahead_blocks_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TFRecordDataset").Device(DEVICE_CPU),
@@ -0,0 +1,277 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/distributed_runtime/data/data_client.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+
+namespace {
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class RemoteDatasetOp : public DatasetOpKernel {
+ public:
+  explicit RemoteDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    string target;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "target", &target));
+    string dataset_graph;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "dataset_graph",
+                                                    &dataset_graph));
+    int64 max_elements_per_request;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(
+                            ctx, "max_elements_per_request",
+                            &max_elements_per_request));
+    OP_REQUIRES(
+        ctx, max_elements_per_request > 0,
+        errors::InvalidArgument("max_elements_per_request must be > 0."));
+
+    *output = new Dataset(ctx, target, dataset_graph, max_elements_per_request,
+                          output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const string& target,
+            const string& dataset_graph, int64 max_elements_per_request,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : GraphDatasetBase(ctx),
+          target_(target),
+          dataset_graph_(dataset_graph),
+          max_elements_per_request_(max_elements_per_request),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::Remote")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return strings::StrCat("RemoteDatasetOp(", target_, ")::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(OpKernelContext* ctx, DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* target_node;
+      TF_RETURN_IF_ERROR(b->AddScalar(target_, &target_node));
+      Node* dataset_graph_node;
+      TF_RETURN_IF_ERROR(b->AddScalar(dataset_graph_, &dataset_graph_node));
+      Node* max_elements_per_request_node;
+      TF_RETURN_IF_ERROR(b->AddScalar(max_elements_per_request_,
+                                      &max_elements_per_request_node));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {target_node, dataset_graph_node, max_elements_per_request_node},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // Pulls the elements of an iterator on the server in batches. The next
+    // batch is requested as soon as the current one is handed out, so that
+    // the round trip overlaps with the work of the consumer.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        while (request_pending_) {
+          cond_var_.wait(l);
+        }
+        if (client_ == nullptr) return;
+        // Release the server iterator without waiting for the response. The
+        // callback keeps the client alive until the call is done.
+        std::shared_ptr<data::DataClient> client = client_;
+        auto request = std::make_shared<data::ReleaseIteratorRequest>();
+        auto response = std::make_shared<data::ReleaseIteratorResponse>();
+        request->set_iterator_id(iterator_id_);
+        client->ReleaseIteratorAsync(
+            request.get(), response.get(),
+            [client, request, response](const Status& s) {
+              if (!s.ok()) {
+                LOG(WARNING) << "Failed to release remote iterator: " << s;
+              }
+            });
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (client_ == nullptr) {
+          TF_RETURN_IF_ERROR(CreateRemoteIterator());
+        }
+        while (buffer_.empty() && !end_of_sequence_) {
+          if (!status_.ok()) {
+            // Return the error once; a later call sends a new request.
+            Status s = status_;
+            status_ = Status::OK();
+            return s;
+          }
+          if (!request_pending_) {
+            StartRequest(ctx);
+          }
+          while (request_pending_) {
+            cond_var_.wait(l);
+          }
+        }
+        if (buffer_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        *out_tensors = std::move(buffer_.front());
+        buffer_.pop_front();
+        *end_of_sequence = false;
+        if (buffer_.empty() && !end_of_sequence_ && !request_pending_ &&
+            status_.ok()) {
+          StartRequest(ctx);
+        }
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "Saving the state of a RemoteDataset iterator is not supported.");
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        return errors::Unimplemented(
+            "Restoring the state of a RemoteDataset iterator is not "
+            "supported.");
+      }
+
+     private:
+      Status CreateRemoteIterator() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::unique_ptr<data::DataClient> client;
+        TF_RETURN_IF_ERROR(
+            data::DataClient::Create(dataset()->target_, &client));
+        data::CreateIteratorRequest request;
+        request.set_dataset_graph(dataset()->dataset_graph_);
+        data::CreateIteratorResponse response;
+        Status s;
+        Notification n;
+        client->CreateIteratorAsync(&request, &response,
+                                    [&s, &n](const Status& status) {
+                                      s = status;
+                                      n.Notify();
+                                    });
+        n.WaitForNotification();
+        TF_RETURN_IF_ERROR(s);
+        iterator_id_ = response.iterator_id();
+        client_ = std::move(client);
+        return Status::OK();
+      }
+
+      // Sends a `GetNext` request from a thread of `ctx->runner()`, since an
+      // in-process server runs the callback on the calling thread.
+      void StartRequest(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        request_pending_ = true;
+        auto request = std::make_shared<data::GetNextRequest>();
+        auto response = std::make_shared<data::GetNextResponse>();
+        request->set_iterator_id(iterator_id_);
+        request->set_max_elements(dataset()->max_elements_per_request_);
+        std::shared_ptr<data::DataClient> client = client_;
+        (*ctx->runner())([this, client, request, response]() {
+          client->GetNextAsync(
+              request.get(), response.get(),
+              [this, request, response](const Status& s) {
+                mutex_lock l(mu_);
+                status_ = s.ok() ? AppendElements(*response) : s;
+                request_pending_ = false;
+                cond_var_.notify_all();
+              });
+        });
+      }
+
+      Status AppendElements(const data::GetNextResponse& response)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const DataTypeVector& dtypes = dataset()->output_dtypes();
+        for (const data::DatasetElement& element : response.elements()) {
+          if (element.components_size() != static_cast<int>(dtypes.size())) {
+            return errors::InvalidArgument(
+                "The remote dataset produced an element with ",
+                element.components_size(), " components, but ", dtypes.size(),
+                " were expected.");
+          }
+          std::vector<Tensor> components(dtypes.size());
+          for (int i = 0; i < element.components_size(); ++i) {
+            if (!components[i].FromProto(element.components(i)) ||
+                components[i].dtype() != dtypes[i]) {
+              return errors::InvalidArgument(
+                  "The remote dataset produced an invalid component ", i,
+                  "; expected a tensor of type ", DataTypeString(dtypes[i]));
+            }
+          }
+          buffer_.push_back(std::move(components));
+        }
+        end_of_sequence_ = response.end_of_sequence();
+        return Status::OK();
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      // Set once the server iterator has been created.
+      std::shared_ptr<data::DataClient> client_ GUARDED_BY(mu_);
+      int64 iterator_id_ GUARDED_BY(mu_) = 0;
+      std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+      bool request_pending_ GUARDED_BY(mu_) = false;
+      bool end_of_sequence_ GUARDED_BY(mu_) = false;
+      Status status_ GUARDED_BY(mu_);
+    };
+
+    const string target_;
+    const string dataset_graph_;
+    const int64 max_elements_per_request_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("RemoteDataset").Device(DEVICE_CPU),
+                        RemoteDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
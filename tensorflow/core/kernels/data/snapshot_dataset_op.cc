@@ -0,0 +1,837 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/kernels/data/compressed_cache.h"
+#include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/elastic_thread_pool.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The uncompressed size at which a block of elements is compressed and
+// written as one record of a snapshot file.
+const int64 kBlockBytes = 1 << 20;
+
+// The number of blocks per snapshot file that may wait to be written, or
+// that may have been read ahead of the consumer.
+const size_t kMaxBufferedBlocks = 2;
+
+// The file whose presence marks a complete snapshot.
+const char kMetadataFilename[] = "snapshot.metadata";
+
+// The contents of the metadata file of a snapshot.
+struct SnapshotMetadata {
+  // The prefix of the names of the snapshot files.
+  string run_id;
+  int64 num_shards = 0;
+  string compression;
+  int64 num_elements = 0;
+
+  string Encode() const {
+    return strings::StrCat(run_id, "\n", num_shards, "\n", compression, "\n",
+                           num_elements, "\n");
+  }
+
+  Status Decode(const string& data) {
+    std::vector<string> lines = str_util::Split(data, '\n');
+    if (lines.size() < 4 || lines[0].empty() ||
+        !strings::safe_strto64(lines[1], &num_shards) || num_shards <= 0 ||
+        !CompressedCache::ValidateCompression(lines[2]).ok() ||
+        !strings::safe_strto64(lines[3], &num_elements)) {
+      return errors::DataLoss("Corrupt snapshot metadata.");
+    }
+    run_id = lines[0];
+    compression = lines[2];
+    return Status::OK();
+  }
+};
+
+// Returns true if `node` calls back into Python.
+bool IsPyFunc(const NodeDef& node) {
+  return node.op() == "PyFunc" || node.op() == "PyFuncStateless" ||
+         node.op() == "EagerPyFunc";
+}
+
+// Clears the parts of `graph_def` that differ between runs of the same input
+// pipeline, so that they do not lead to a new snapshot on every run: the
+// `seed` and `seed2` inputs of its ops, which are drawn at random when left
+// unset, and the tokens that name Python functions within a process.
+// Returns true if the pipeline calls Python functions, whose bodies are not
+// part of the graph.
+bool NormalizeForFingerprint(GraphDef* graph_def) {
+  bool calls_python = false;
+  std::unordered_map<StringPiece, NodeDef*, StringPieceHasher> nodes;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    nodes[node.name()] = &node;
+  }
+  for (const NodeDef& node : graph_def->node()) {
+    const OpDef* op_def;
+    NameRangeMap inputs;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        !NameRangesForNode(node, *op_def, &inputs, nullptr).ok()) {
+      continue;
+    }
+    for (const char* arg : {"seed", "seed2"}) {
+      auto range = inputs.find(arg);
+      if (range == inputs.end() ||
+          range->second.first >= node.input_size()) {
+        continue;
+      }
+      auto input = nodes.find(
+          ParseTensorName(node.input(range->second.first)).first);
+      if (input == nodes.end() || input->second->op() != "Const") continue;
+      Tensor seed(DT_INT64, TensorShape({}));
+      seed.scalar<int64>()() = 0;
+      seed.AsProtoTensorContent(
+          (*input->second->mutable_attr())["value"].mutable_tensor());
+    }
+  }
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (IsPyFunc(node)) {
+      node.mutable_attr()->erase("token");
+      calls_python = true;
+    }
+  }
+  for (FunctionDef& function :
+       *graph_def->mutable_library()->mutable_function()) {
+    for (NodeDef& node : *function.mutable_node_def()) {
+      if (IsPyFunc(node)) {
+        node.mutable_attr()->erase("token");
+        calls_python = true;
+      }
+    }
+  }
+  return calls_python;
+}
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class SnapshotDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SnapshotDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    OP_REQUIRES_OK(ctx, CompressedCache::ValidateCompression(compression_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shuffle_shards", &shuffle_shards_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    string path;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "path", &path));
+    OP_REQUIRES(ctx, !path.empty(),
+                errors::InvalidArgument("path must not be empty."));
+
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_shards", &num_shards));
+    OP_REQUIRES(
+        ctx, num_shards > 0,
+        errors::InvalidArgument("num_shards must be greater than zero."));
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+
+    // By TensorFlow convention, passing 0 for both seeds indicates
+    // that the shuffling should be seeded non-deterministically.
+    if (seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+
+    // The snapshot of `input` is identified by the fingerprint of its graph,
+    // so that any change to the input pipeline leads to a new snapshot.
+    GraphDefBuilder b;
+    DatasetBase::DatasetGraphDefBuilder db(&b);
+    Node* input_node = nullptr;
+    OP_REQUIRES_OK(ctx, db.AddParentDataset(ctx, input, &input_node));
+    GraphDef graph_def;
+    OP_REQUIRES_OK(ctx, b.ToGraphDef(&graph_def));
+    if (NormalizeForFingerprint(&graph_def)) {
+      LOG(WARNING) << "The input of the snapshot under " << path
+                   << " calls Python functions. Changes to their code do not "
+                      "change the snapshot that is used.";
+    }
+    string serialized_graph_def;
+    OP_REQUIRES(ctx,
+                SerializeToStringDeterministic(graph_def,
+                                               &serialized_graph_def),
+                errors::Internal("Failed to serialize the input graph."));
+    const string directory = io::JoinPath(
+        path, strings::Printf("%016llx", static_cast<unsigned long long>(
+                                             Fingerprint64(
+                                                 serialized_graph_def))));
+
+    *output = new Dataset(ctx, input, path, num_shards, compression_,
+                          shuffle_shards_, seed, seed2, directory);
+  }
+
+ private:
+  // Writes the elements of `input` to a set of files on the first pass, and
+  // reads them back on later passes.
+  //
+  // The i-th element is written to file `i % num_shards`. Each file is a
+  // sequence of records, each of which is a block of elements compressed by
+  // `CompressElements()`. The files are written by one thread each, and a
+  // snapshot is committed by writing its metadata file once all of its files
+  // are complete. A snapshot is read with one thread per file, and the
+  // elements are taken from the files in round-robin order, which restores
+  // the order of `input` unless `shuffle_shards` permutes the files.
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, const string& path,
+            int64 num_shards, const string& compression, bool shuffle_shards,
+            int64 seed, int64 seed2, const string& directory)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          path_(path),
+          num_shards_(num_shards),
+          compression_(compression),
+          shuffle_shards_(shuffle_shards),
+          seed_(seed),
+          seed2_(seed2),
+          directory_(directory),
+          env_(ctx->env()),
+          parent_generator_(seed, seed2),
+          generator_(&parent_generator_) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::Snapshot")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return strings::StrCat("SnapshotDatasetOp(", directory_, ")::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(OpKernelContext* ctx, DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddParentDataset(ctx, input_, &input_graph_node));
+      Node* path = nullptr;
+      Node* num_shards = nullptr;
+      Node* seed = nullptr;
+      Node* seed2 = nullptr;
+      AttrValue compression;
+      AttrValue shuffle_shards;
+
+      TF_RETURN_IF_ERROR(b->AddScalar(path_, &path));
+      TF_RETURN_IF_ERROR(b->AddScalar(num_shards_, &num_shards));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
+      b->BuildAttrValue(compression_, &compression);
+      b->BuildAttrValue(shuffle_shards_, &shuffle_shards);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {input_graph_node, path, num_shards, seed, seed2},  // Inputs
+          {std::make_pair("compression", compression),
+           std::make_pair("shuffle_shards", shuffle_shards)},  // Attrs
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        StopLocked();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (mode_ == kUndecided) {
+          TF_RETURN_IF_ERROR(StartLocked(ctx));
+        }
+        if (mode_ == kReading) {
+          return ReadNextLocked(out_tensors, end_of_sequence);
+        }
+        if (!input_impl_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (*end_of_sequence) {
+          input_impl_.reset();
+          if (mode_ == kWriting) {
+            FinishWritingLocked();
+          }
+          return Status::OK();
+        }
+        if (mode_ == kWriting) {
+          WriteLocked(*out_tensors);
+        }
+        ++num_elements_;
+        return Status::OK();
+      }
+
+     protected:
+      // A snapshot that is being written cannot be resumed, so an iterator
+      // restored from a checkpoint taken while writing produces the rest of
+      // the input without writing a snapshot.
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        const int64 mode = mode_ == kWriting ? kPassThrough : mode_;
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("mode"), mode));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("num_elements"), num_elements_));
+        if (mode == kPassThrough) {
+          if (input_impl_) {
+            TF_RETURN_IF_ERROR(SaveParent(writer, input_impl_));
+          } else {
+            TF_RETURN_IF_ERROR(
+                writer->WriteScalar(full_name("end_of_input_sequence"), ""));
+          }
+        } else if (mode == kReading) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("num_shards"),
+                                  static_cast<int64>(order_.size())));
+          for (size_t i = 0; i < order_.size(); ++i) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name(strings::StrCat("order_", i)), order_[i]));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        StopLocked();
+        int64 mode;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("mode"), &mode));
+        int64 num_elements;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("num_elements"), &num_elements));
+        mode_ = kUndecided;
+        num_elements_ = 0;
+        if (mode == kPassThrough) {
+          mode_ = kPassThrough;
+          num_elements_ = num_elements;
+          if (!reader->Contains(full_name("end_of_input_sequence"))) {
+            TF_RETURN_IF_ERROR(
+                dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+            TF_RETURN_IF_ERROR(RestoreParent(ctx, reader, input_impl_));
+          }
+        } else if (mode == kReading) {
+          int64 num_shards;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("num_shards"), &num_shards));
+          std::vector<int64> order(num_shards);
+          for (int64 i = 0; i < num_shards; ++i) {
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                full_name(strings::StrCat("order_", i)), &order[i]));
+          }
+          SnapshotMetadata metadata;
+          TF_RETURN_IF_ERROR(ReadMetadata(&metadata));
+          if (metadata.num_shards != num_shards) {
+            return errors::FailedPrecondition(
+                "The snapshot in ", dataset()->directory_,
+                " changed since the checkpoint was written.");
+          }
+          StartReadingLocked(metadata, std::move(order));
+          // Skip the elements that were produced before the checkpoint.
+          std::vector<Tensor> element;
+          bool end_of_sequence = false;
+          while (num_elements_ < num_elements && !end_of_sequence) {
+            TF_RETURN_IF_ERROR(ReadNextLocked(&element, &end_of_sequence));
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      enum Mode : int64 {
+        // Nothing has been produced yet.
+        kUndecided = 0,
+        // Producing the input, and writing it to a new snapshot.
+        kWriting = 1,
+        // Producing the input without writing a snapshot.
+        kPassThrough = 2,
+        // Reading an existing snapshot.
+        kReading = 3,
+      };
+
+      // The state of one snapshot file that is being written.
+      struct ShardWriter {
+        string filename;
+        std::unique_ptr<WritableFile> file;
+        std::unique_ptr<io::RecordWriter> writer;
+        // The block that is being filled by the consumer.
+        std::vector<std::vector<Tensor>> block;
+        int64 block_bytes = 0;
+        // Full blocks that the writer thread has yet to write. Guarded by
+        // `shards_mu_`.
+        std::deque<std::vector<std::vector<Tensor>>> pending;
+        std::unique_ptr<Thread> thread;
+      };
+
+      // The state of one snapshot file that is being read.
+      struct ShardReader {
+        string filename;
+        // The following fields are guarded by `shards_mu_`.
+        //
+        // Blocks that have been read, the first of which is partially
+        // produced from index `next`.
+        std::deque<std::vector<std::vector<Tensor>>> blocks;
+        size_t next = 0;
+        bool done = false;
+        Status status;
+        // Set once all elements of the file have been produced.
+        bool exhausted = false;
+        std::unique_ptr<Thread> thread;
+      };
+
+      Status ReadMetadata(SnapshotMetadata* metadata) {
+        string data;
+        TF_RETURN_IF_ERROR(ReadFileToString(
+            dataset()->env_,
+            io::JoinPath(dataset()->directory_, kMetadataFilename), &data));
+        return metadata->Decode(data);
+      }
+
+      string ShardFilename(const string& run_id, int64 shard) const {
+        return io::JoinPath(
+            dataset()->directory_,
+            strings::Printf("%s_%05lld.snapshot", run_id.c_str(),
+                            static_cast<long long>(shard)));
+      }
+
+      // Reads the snapshot if it is complete, and otherwise starts writing
+      // a new one.
+      Status StartLocked(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = dataset()->env_;
+        const string metadata_filename =
+            io::JoinPath(dataset()->directory_, kMetadataFilename);
+        if (env->FileExists(metadata_filename).ok()) {
+          SnapshotMetadata metadata;
+          TF_RETURN_IF_ERROR(ReadMetadata(&metadata));
+          std::vector<int64> order(metadata.num_shards);
+          for (int64 i = 0; i < metadata.num_shards; ++i) {
+            order[i] = i;
+          }
+          if (dataset()->shuffle_shards_) {
+            mutex_lock l(dataset()->mu_);
+            for (int64 i = metadata.num_shards - 1; i > 0; --i) {
+              std::swap(order[i], order[dataset()->generator_() % (i + 1)]);
+            }
+          }
+          VLOG(1) << "Reading the snapshot in " << dataset()->directory_
+                  << ", with " << metadata.num_elements << " elements.";
+          StartReadingLocked(metadata, std::move(order));
+          return Status::OK();
+        }
+
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+        mode_ = kPassThrough;
+        // Failing to write a snapshot does not fail the input pipeline.
+        Status s = StartWritingLocked();
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to start writing a snapshot in "
+                       << dataset()->directory_ << ": " << s;
+          AbandonWritingLocked();
+        }
+        return Status::OK();
+      }
+
+      Status StartWritingLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = dataset()->env_;
+        TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dataset()->directory_));
+        run_id_ = strings::Printf(
+            "%016llx", static_cast<unsigned long long>(random::New64()));
+        {
+          mutex_lock l(shards_mu_);
+          finish_writing_ = false;
+          cancelled_ = false;
+          write_status_ = Status::OK();
+        }
+        for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+          writers_.emplace_back(new ShardWriter);
+          ShardWriter* shard = writers_.back().get();
+          shard->filename = ShardFilename(run_id_, i);
+          TF_RETURN_IF_ERROR(
+              env->NewWritableFile(shard->filename, &shard->file));
+          shard->writer.reset(new io::RecordWriter(shard->file.get()));
+        }
+        for (auto& shard : writers_) {
+          shard->thread.reset(ElasticThreadPool::Global()->StartThread(
+              std::bind(&Iterator::WriterThread, this, shard.get())));
+        }
+        mode_ = kWriting;
+        return Status::OK();
+      }
+
+      // Adds `element` to the block of its file, and hands the block to the
+      // writer thread of the file once it is full.
+      void WriteLocked(const std::vector<Tensor>& element)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        ShardWriter* shard =
+            writers_[num_elements_ % dataset()->num_shards_].get();
+        shard->block.push_back(element);
+        for (const Tensor& t : element) {
+          shard->block_bytes += t.TotalBytes();
+        }
+        if (shard->block_bytes < kBlockBytes) {
+          return;
+        }
+        Status s;
+        {
+          mutex_lock l(shards_mu_);
+          while (shard->pending.size() >= kMaxBufferedBlocks &&
+                 write_status_.ok()) {
+            shards_cond_var_.wait(l);
+          }
+          s = write_status_;
+          shard->pending.push_back(std::move(shard->block));
+          shards_cond_var_.notify_all();
+        }
+        shard->block.clear();
+        shard->block_bytes = 0;
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to write a snapshot in "
+                       << dataset()->directory_ << ": " << s;
+          AbandonWritingLocked();
+        }
+      }
+
+      // Writes the remaining blocks, and commits the snapshot.
+      void FinishWritingLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        {
+          mutex_lock l(shards_mu_);
+          for (auto& shard : writers_) {
+            if (!shard->block.empty()) {
+              shard->pending.push_back(std::move(shard->block));
+            }
+          }
+          finish_writing_ = true;
+          shards_cond_var_.notify_all();
+        }
+        for (auto& shard : writers_) {
+          shard->thread.reset();
+        }
+        Status s;
+        {
+          mutex_lock l(shards_mu_);
+          s = write_status_;
+        }
+        if (s.ok()) {
+          s = CommitLocked();
+        }
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to write a snapshot in "
+                       << dataset()->directory_ << ": " << s;
+          AbandonWritingLocked();
+          return;
+        }
+        writers_.clear();
+        mode_ = kPassThrough;
+      }
+
+      // Writes the metadata file, unless another iterator committed a
+      // snapshot of the same input first.
+      Status CommitLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = dataset()->env_;
+        const string metadata_filename =
+            io::JoinPath(dataset()->directory_, kMetadataFilename);
+        if (env->FileExists(metadata_filename).ok()) {
+          return errors::AlreadyExists("The snapshot in ",
+                                       dataset()->directory_,
+                                       " was written concurrently.");
+        }
+        SnapshotMetadata metadata;
+        metadata.run_id = run_id_;
+        metadata.num_shards = dataset()->num_shards_;
+        metadata.compression = dataset()->compression_;
+        metadata.num_elements = num_elements_;
+        const string tmp_filename =
+            strings::StrCat(metadata_filename, ".", run_id_, ".tmp");
+        TF_RETURN_IF_ERROR(
+            WriteStringToFile(env, tmp_filename, metadata.Encode()));
+        TF_RETURN_IF_ERROR(env->RenameFile(tmp_filename, metadata_filename));
+        VLOG(1) << "Wrote a snapshot of " << num_elements_ << " elements to "
+                << dataset()->directory_;
+        return Status::OK();
+      }
+
+      // Stops the writer threads, and deletes the files of the snapshot.
+      void AbandonWritingLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        {
+          mutex_lock l(shards_mu_);
+          cancelled_ = true;
+          shards_cond_var_.notify_all();
+        }
+        for (auto& shard : writers_) {
+          shard->thread.reset();
+          shard->writer.reset();
+          shard->file.reset();
+          dataset()->env_->DeleteFile(shard->filename).IgnoreError();
+        }
+        writers_.clear();
+        mode_ = kPassThrough;
+      }
+
+      void WriterThread(ShardWriter* shard) {
+        Status s;
+        while (true) {
+          std::vector<std::vector<Tensor>> block;
+          {
+            mutex_lock l(shards_mu_);
+            while (shard->pending.empty() && !finish_writing_ &&
+                   !cancelled_) {
+              shards_cond_var_.wait(l);
+            }
+            if (cancelled_ || shard->pending.empty()) {
+              break;
+            }
+            block = std::move(shard->pending.front());
+            shard->pending.pop_front();
+            shards_cond_var_.notify_all();
+          }
+          string data;
+          s = CompressElements(dataset()->compression_, block, &data);
+          if (s.ok()) {
+            s = shard->writer->WriteRecord(data);
+          }
+          if (!s.ok()) {
+            break;
+          }
+        }
+        if (s.ok()) {
+          s = shard->writer->Close();
+        }
+        if (s.ok()) {
+          s = shard->file->Close();
+        }
+        mutex_lock l(shards_mu_);
+        write_status_.Update(s);
+        shards_cond_var_.notify_all();
+      }
+
+      void StartReadingLocked(const SnapshotMetadata& metadata,
+                              std::vector<int64> order)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        mode_ = kReading;
+        read_compression_ = metadata.compression;
+        order_ = std::move(order);
+        cursor_ = 0;
+        num_exhausted_ = 0;
+        {
+          mutex_lock l(shards_mu_);
+          cancelled_ = false;
+        }
+        for (int64 i = 0; i < metadata.num_shards; ++i) {
+          readers_.emplace_back(new ShardReader);
+          readers_.back()->filename = ShardFilename(metadata.run_id, i);
+        }
+        for (auto& shard : readers_) {
+          shard->thread.reset(ElasticThreadPool::Global()->StartThread(
+              std::bind(&Iterator::ReaderThread, this, shard.get())));
+        }
+      }
+
+      // Produces the next element of the file at `order_[cursor_]`, skipping
+      // the files that have no elements left.
+      Status ReadNextLocked(std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        mutex_lock l(shards_mu_);
+        while (num_exhausted_ < order_.size()) {
+          ShardReader* shard = readers_[order_[cursor_]].get();
+          if (!shard->exhausted) {
+            while (shard->blocks.empty() && !shard->done) {
+              shards_cond_var_.wait(l);
+            }
+            if (!shard->blocks.empty()) {
+              std::vector<std::vector<Tensor>>& block = shard->blocks.front();
+              *out_tensors = std::move(block[shard->next++]);
+              if (shard->next == block.size()) {
+                shard->blocks.pop_front();
+                shard->next = 0;
+                shards_cond_var_.notify_all();
+              }
+              cursor_ = (cursor_ + 1) % order_.size();
+              ++num_elements_;
+              *end_of_sequence = false;
+              return Status::OK();
+            }
+            TF_RETURN_IF_ERROR(shard->status);
+            shard->exhausted = true;
+            ++num_exhausted_;
+          }
+          cursor_ = (cursor_ + 1) % order_.size();
+        }
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+      void ReaderThread(ShardReader* shard) {
+        std::unique_ptr<RandomAccessFile> file;
+        Status s =
+            dataset()->env_->NewRandomAccessFile(shard->filename, &file);
+        if (s.ok()) {
+          io::SequentialRecordReader reader(file.get());
+          while (true) {
+            {
+              mutex_lock l(shards_mu_);
+              while (shard->blocks.size() >= kMaxBufferedBlocks &&
+                     !cancelled_) {
+                shards_cond_var_.wait(l);
+              }
+              if (cancelled_) {
+                break;
+              }
+            }
+            string record;
+            s = reader.ReadRecord(&record);
+            if (errors::IsOutOfRange(s)) {
+              s = Status::OK();
+              break;
+            }
+            std::vector<std::vector<Tensor>> block;
+            if (s.ok()) {
+              s = UncompressElements(read_compression_, record, &block);
+            }
+            if (!s.ok()) {
+              break;
+            }
+            if (!block.empty()) {
+              mutex_lock l(shards_mu_);
+              shard->blocks.push_back(std::move(block));
+              shards_cond_var_.notify_all();
+            }
+          }
+        }
+        mutex_lock l(shards_mu_);
+        shard->status = s;
+        shard->done = true;
+        shards_cond_var_.notify_all();
+      }
+
+      // Stops any writer or reader threads.
+      void StopLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (mode_ == kWriting) {
+          AbandonWritingLocked();
+        }
+        {
+          mutex_lock l(shards_mu_);
+          cancelled_ = true;
+          shards_cond_var_.notify_all();
+        }
+        readers_.clear();
+        input_impl_.reset();
+      }
+
+      mutex mu_;
+      Mode mode_ GUARDED_BY(mu_) = kUndecided;
+      // The number of elements produced so far.
+      int64 num_elements_ GUARDED_BY(mu_) = 0;
+      // Set in the writing and pass-through modes, until the end of input.
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+
+      // Writing mode.
+      string run_id_ GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<ShardWriter>> writers_ GUARDED_BY(mu_);
+
+      // Reading mode.
+      string read_compression_;
+      std::vector<std::unique_ptr<ShardReader>> readers_ GUARDED_BY(mu_);
+      // The order in which the files are visited.
+      std::vector<int64> order_ GUARDED_BY(mu_);
+      size_t cursor_ GUARDED_BY(mu_) = 0;
+      size_t num_exhausted_ GUARDED_BY(mu_) = 0;
+
+      // Shared with the writer and reader threads.
+      mutex shards_mu_;
+      condition_variable shards_cond_var_;
+      bool finish_writing_ GUARDED_BY(shards_mu_) = false;
+      bool cancelled_ GUARDED_BY(shards_mu_) = false;
+      Status write_status_ GUARDED_BY(shards_mu_);
+    };
+
+    const DatasetBase* const input_;
+    const string path_;
+    const int64 num_shards_;
+    const string compression_;
+    const bool shuffle_shards_;
+    const int64 seed_;
+    const int64 seed2_;
+    // The directory of the snapshot of `input_`.
+    const string directory_;
+    Env* const env_;
+    mutable mutex mu_;
+    mutable random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+    mutable random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        GUARDED_BY(mu_);
+  };
+
+  string compression_;
+  bool shuffle_shards_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
+                        SnapshotDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,502 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/compressed_cache.h"
+#include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of spilled blocks that are decompressed in memory at once, and
+// whose elements are interleaved in the output.
+const int64 kMaxResidentBlocks = 8;
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class SpillingShuffleDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SpillingShuffleDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    OP_REQUIRES_OK(ctx, CompressedCache::ValidateCompression(compression_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    int64 block_size;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "block_size", &block_size));
+    OP_REQUIRES(
+        ctx, block_size > 0 && block_size <= buffer_size,
+        errors::InvalidArgument("block_size must be greater than zero and at "
+                                "most buffer_size, but got ",
+                                block_size, " and ", buffer_size, "."));
+
+    string spill_directory;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "spill_directory",
+                                                    &spill_directory));
+    OP_REQUIRES(ctx, !spill_directory.empty(),
+                errors::InvalidArgument("spill_directory must not be empty."));
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+
+    // By TensorFlow convention, passing 0 for both seeds indicates
+    // that the shuffling should be seeded non-deterministically.
+    if (seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+
+    *output = new Dataset(ctx, input, buffer_size, block_size, spill_directory,
+                          compression_, seed, seed2);
+  }
+
+ private:
+  // A shuffle whose buffer is mostly kept on disk.
+  //
+  // The iterator reads the input in blocks of `block_size` elements. It
+  // shuffles each block, compresses it, and writes it to a file in
+  // `spill_directory`, until `buffer_size / block_size` blocks are spilled.
+  // To produce elements, it picks spilled blocks uniformly at random, loads
+  // up to `kMaxResidentBlocks` of them into memory, and outputs the next
+  // element of a random resident block. Every block that is loaded is
+  // replaced by a new block from the input.
+  //
+  // This is a two-level shuffle: the order of the blocks is a window shuffle
+  // with a window of `buffer_size` elements, as with `ShuffleDataset`, while
+  // the memory used is only about `kMaxResidentBlocks + 1` blocks.
+  //
+  // Each iterator uses a new pair of seeds from the dataset, so that every
+  // epoch is shuffled differently.
+  //
+  // A checkpoint refers to the spilled blocks by file name. The iterator
+  // never deletes a file that a saved or restored checkpoint refers to, so
+  // those files stay in `spill_directory` for as long as the checkpoints
+  // may be restored.
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
+            int64 block_size, const string& spill_directory,
+            const string& compression, int64 seed, int64 seed2)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          buffer_size_(buffer_size),
+          block_size_(block_size),
+          spill_directory_(spill_directory),
+          compression_(compression),
+          env_(ctx->env()),
+          seed_(seed),
+          seed2_(seed2),
+          parent_generator_(seed, seed2),
+          generator_(&parent_generator_) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      int64 iterator_seed;
+      int64 iterator_seed2;
+      {
+        mutex_lock l(mu_);
+        iterator_seed = Random();
+        iterator_seed2 = Random();
+      }
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::SpillingShuffle")},
+                       iterator_seed, iterator_seed2));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return strings::StrCat("SpillingShuffleDatasetOp(", buffer_size_, ", ",
+                             block_size_, ")::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(OpKernelContext* ctx, DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      mutex_lock l(mu_);
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddParentDataset(ctx, input_, &input_graph_node));
+      Node* buffer_size = nullptr;
+      Node* block_size = nullptr;
+      Node* spill_directory = nullptr;
+      Node* seed = nullptr;
+      Node* seed2 = nullptr;
+      AttrValue compression;
+
+      TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
+      TF_RETURN_IF_ERROR(b->AddScalar(block_size_, &block_size));
+      TF_RETURN_IF_ERROR(b->AddScalar(spill_directory_, &spill_directory));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
+      b->BuildAttrValue(compression_, &compression);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {input_graph_node, buffer_size, block_size, spill_directory, seed,
+           seed2},                                           // Inputs
+          {std::make_pair("compression", compression)},  // Attrs
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params, int64 seed, int64 seed2)
+          : DatasetIterator<Dataset>(params),
+            seed_(seed),
+            seed2_(seed2),
+            parent_generator_(seed, seed2),
+            generator_(&parent_generator_),
+            file_prefix_(io::JoinPath(
+                params.dataset->spill_directory_,
+                strings::Printf("shuffle_%016llx_",
+                                static_cast<unsigned long long>(
+                                    random::New64())))) {}
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        for (const string& filename : spilled_) {
+          DeleteSpillFileLocked(filename).IgnoreError();
+        }
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (!input_impl_ && !end_of_input_) {
+          TF_RETURN_IF_ERROR(
+              dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+        }
+        const size_t num_window_blocks =
+            dataset()->buffer_size_ / dataset()->block_size_;
+        while (true) {
+          while (!end_of_input_ && spilled_.size() < num_window_blocks) {
+            TF_RETURN_IF_ERROR(SpillBlockLocked(ctx));
+          }
+          if (resident_.size() >= static_cast<size_t>(kMaxResidentBlocks) ||
+              spilled_.empty()) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(LoadRandomBlockLocked());
+        }
+        if (resident_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        const size_t i = Random() % resident_.size();
+        ResidentBlock& block = resident_[i];
+        *out_tensors = std::move(block.elements[block.next++]);
+        if (block.next == block.elements.size()) {
+          std::swap(resident_[i], resident_.back());
+          resident_.pop_back();
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        {
+          mutex_lock l(dataset()->mu_);
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("ds_num_random_samples"),
+                                  dataset()->num_random_samples_));
+        }
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("num_random_samples"),
+                                num_random_samples_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("seed"), seed_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("seed2"), seed2_));
+
+        if (end_of_input_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("end_of_input_sequence"), ""));
+        } else if (input_impl_) {
+          TF_RETURN_IF_ERROR(SaveParent(writer, input_impl_));
+        } else {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("input_impl_empty"), ""));
+        }
+
+        // The spilled blocks are saved by file name, and the remaining
+        // elements of the resident blocks are compressed again.
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("num_spilled"), spilled_.size()));
+        for (size_t i = 0; i < spilled_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat("spilled_", i)), spilled_[i]));
+          checkpointed_.insert(spilled_[i]);
+        }
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("num_resident"), resident_.size()));
+        for (size_t i = 0; i < resident_.size(); ++i) {
+          const ResidentBlock& block = resident_[i];
+          std::vector<std::vector<Tensor>> remaining(
+              block.elements.begin() + block.next, block.elements.end());
+          string data;
+          TF_RETURN_IF_ERROR(
+              CompressElements(dataset()->compression_, remaining, &data));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat("resident_", i)), data));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        {
+          mutex_lock l(dataset()->mu_);
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("ds_num_random_samples"),
+                                 &dataset()->num_random_samples_));
+          dataset()->ResetRngs();
+        }
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("num_random_samples"),
+                                              &num_random_samples_));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("seed"), &seed_));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("seed2"), &seed2_));
+        ResetRngs();
+
+        input_impl_.reset();
+        end_of_input_ =
+            reader->Contains(full_name("end_of_input_sequence"));
+        if (!end_of_input_ &&
+            !reader->Contains(full_name("input_impl_empty"))) {
+          TF_RETURN_IF_ERROR(
+              dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
+          TF_RETURN_IF_ERROR(RestoreParent(ctx, reader, input_impl_));
+        }
+
+        for (const string& filename : spilled_) {
+          DeleteSpillFileLocked(filename).IgnoreError();
+        }
+        spilled_.clear();
+        int64 num_spilled;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("num_spilled"), &num_spilled));
+        for (int64 i = 0; i < num_spilled; ++i) {
+          string filename;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat("spilled_", i)), &filename));
+          Status s = dataset()->env_->FileExists(filename);
+          if (!s.ok()) {
+            return errors::NotFound("The spilled block ", filename,
+                                    " of the checkpoint could not be found: ",
+                                    s.error_message());
+          }
+          checkpointed_.insert(filename);
+          spilled_.push_back(filename);
+        }
+        resident_.clear();
+        int64 num_resident;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("num_resident"), &num_resident));
+        for (int64 i = 0; i < num_resident; ++i) {
+          string data;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat("resident_", i)), &data));
+          resident_.emplace_back();
+          TF_RETURN_IF_ERROR(UncompressElements(
+              dataset()->compression_, data, &resident_.back().elements));
+        }
+        return Status::OK();
+      }
+
+     private:
+      struct ResidentBlock {
+        std::vector<std::vector<Tensor>> elements;
+        // The index of the next element of `elements` to produce.
+        size_t next = 0;
+      };
+
+      // Reads the next block of elements from the input, shuffles it, and
+      // spills it to disk.
+      Status SpillBlockLocked(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::vector<std::vector<Tensor>> block;
+        block.reserve(dataset()->block_size_);
+        while (block.size() < static_cast<size_t>(dataset()->block_size_)) {
+          std::vector<Tensor> element;
+          bool end_of_input_sequence = false;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input_sequence));
+          if (end_of_input_sequence) {
+            end_of_input_ = true;
+            input_impl_.reset();
+            break;
+          }
+          block.push_back(std::move(element));
+        }
+        if (block.empty()) {
+          return Status::OK();
+        }
+        for (size_t i = block.size() - 1; i > 0; --i) {
+          std::swap(block[i], block[Random() % (i + 1)]);
+        }
+        string data;
+        TF_RETURN_IF_ERROR(
+            CompressElements(dataset()->compression_, block, &data));
+        return WriteSpillFileLocked(data);
+      }
+
+      Status WriteSpillFileLocked(const string& data)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!created_spill_directory_) {
+          TF_RETURN_IF_ERROR(dataset()->env_->RecursivelyCreateDir(
+              dataset()->spill_directory_));
+          created_spill_directory_ = true;
+        }
+        const string filename =
+            strings::StrCat(file_prefix_, next_file_index_++);
+        TF_RETURN_IF_ERROR(WriteStringToFile(dataset()->env_, filename, data));
+        spilled_.push_back(filename);
+        return Status::OK();
+      }
+
+      // Moves a spilled block chosen uniformly at random into memory.
+      Status LoadRandomBlockLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const size_t i = Random() % spilled_.size();
+        string data;
+        TF_RETURN_IF_ERROR(
+            ReadFileToString(dataset()->env_, spilled_[i], &data));
+        ResidentBlock block;
+        TF_RETURN_IF_ERROR(
+            UncompressElements(dataset()->compression_, data, &block.elements));
+        TF_RETURN_IF_ERROR(DeleteSpillFileLocked(spilled_[i]));
+        std::swap(spilled_[i], spilled_.back());
+        spilled_.pop_back();
+        if (!block.elements.empty()) {
+          resident_.push_back(std::move(block));
+        }
+        return Status::OK();
+      }
+
+      // Deletes a spilled block, unless a checkpoint refers to it.
+      Status DeleteSpillFileLocked(const string& filename)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (checkpointed_.count(filename) > 0) {
+          return Status::OK();
+        }
+        return dataset()->env_->DeleteFile(filename);
+      }
+
+      random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        num_random_samples_++;
+        return generator_();
+      }
+
+      void ResetRngs() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        // Reset the generators based on the current iterator seeds.
+        parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+        generator_ = random::SingleSampleAdapter<random::PhiloxRandom>(
+            &parent_generator_);
+        generator_.Skip(num_random_samples_);
+      }
+
+      mutex mu_;
+      int64 seed_ GUARDED_BY(mu_);
+      int64 seed2_ GUARDED_BY(mu_);
+      random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator_
+          GUARDED_BY(mu_);
+      int64 num_random_samples_ GUARDED_BY(mu_) = 0;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      const string file_prefix_;
+      int64 next_file_index_ GUARDED_BY(mu_) = 0;
+      bool created_spill_directory_ GUARDED_BY(mu_) = false;
+      // The files of the spilled blocks, in no particular order.
+      std::vector<string> spilled_ GUARDED_BY(mu_);
+      // The files that a saved or restored checkpoint refers to.
+      std::unordered_set<string> checkpointed_ GUARDED_BY(mu_);
+      std::vector<ResidentBlock> resident_ GUARDED_BY(mu_);
+    };
+
+    random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random() const
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_random_samples_++;
+      return generator_();
+    }
+
+    void ResetRngs() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // Reset the generators based on the current seeds.
+      parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+      generator_ =
+          random::SingleSampleAdapter<random::PhiloxRandom>(&parent_generator_);
+      generator_.Skip(num_random_samples_);
+    }
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const int64 block_size_;
+    const string spill_directory_;
+    const string compression_;
+    Env* const env_;
+    const int64 seed_;
+    const int64 seed2_;
+    mutable mutex mu_;
+    mutable random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+    mutable random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        GUARDED_BY(mu_);
+    mutable int64 num_random_samples_ GUARDED_BY(mu_) = 0;
+  };
+
+  string compression_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("SpillingShuffleDataset").Device(DEVICE_CPU),
+                        SpillingShuffleDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -85,25 +85,20 @@ class SetStatsAggregatorDatasetOp : public UnaryDatasetOpKernel {
           : DatasetIterator<Dataset>(params) {}
 
       Status Initialize(IteratorContext* ctx) override {
-        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+        // Input iterators may capture the stats aggregator when they are
+        // created, e.g. to report the choices of an autotuning model.
+        IteratorContext set_stats_aggregator_ctx =
+            MakeStatsAggregatorContext(ctx);
+        return dataset()->input_->MakeIterator(&set_stats_aggregator_ctx,
+                                               prefix(), &input_impl_);
       }
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
-        StatsAggregatorResource* stats_aggregator_resource =
-            dataset()->stats_aggregator_resource_;
-        IteratorContext::Params params;
-        params.env = ctx->env();
-        params.runner = *(ctx->runner());
-        params.stats_aggregator_getter = [stats_aggregator_resource]() {
-          return stats_aggregator_resource->stats_aggregator();
-        };
-        params.lib = ctx->lib();
-        params.function_library = ctx->function_library();
-        params.allocator_getter = ctx->allocator_getter();
-        IteratorContext set_stats_aggregator_ctx(params);
+        IteratorContext set_stats_aggregator_ctx =
+            MakeStatsAggregatorContext(ctx);
         return input_impl_->GetNext(&set_stats_aggregator_ctx, out_tensors,
                                     end_of_sequence);
       }
@@ -123,6 +118,25 @@ class SetStatsAggregatorDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Returns a copy of `ctx` that reports to the stats aggregator of the
+      // dataset.
+      IteratorContext MakeStatsAggregatorContext(IteratorContext* ctx) {
+        StatsAggregatorResource* stats_aggregator_resource =
+            dataset()->stats_aggregator_resource_;
+        IteratorContext::Params params;
+        params.env = ctx->env();
+        params.runner = *(ctx->runner());
+        params.runner_overridden = ctx->runner_overridden();
+        params.stats_aggregator_getter = [stats_aggregator_resource]() {
+          return stats_aggregator_resource->stats_aggregator();
+        };
+        params.lib = ctx->lib();
+        params.function_library = ctx->function_library();
+        params.allocator_getter = ctx->allocator_getter();
+        params.model = ctx->model();
+        return IteratorContext(std::move(params));
+      }
+
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     };
@@ -253,6 +253,7 @@ class AssignVariableOp : public OpKernel {
         value.shape(), DEVICE_MEMORY, attr);
     mutex_lock ml(*variable->mu());
     variable->is_initialized = true;
+    variable->MarkAllRowsDirty();
     if (input_alias) {
       *variable->tensor() = *input_alias;
       return;
@@ -325,6 +326,7 @@ class AssignVariableOp<Device, Variant> : public OpKernel {
 
     mutex_lock ml(*variable->mu());
     variable->is_initialized = true;
+    variable->MarkAllRowsDirty();
     *variable->tensor() = Tensor(DT_VARIANT, value.shape());
 
     if (input_alias) {
@@ -399,6 +401,7 @@ class AssignUpdateVariableOp : public OpKernel {
     Tensor* var_tensor = variable->tensor();
     OP_REQUIRES_OK(context,
                    PrepareToUpdateVariable<Device, T>(context, var_tensor));
+    variable->MarkAllRowsDirty();
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
                    value.flat<T>());
@@ -649,6 +652,12 @@ class ResourceScatterUpdateOp : public OpKernel {
                         params->dim_size(0), ")"));
       }
     }
+    if (std::is_same<Device, Eigen::ThreadPoolDevice>::value) {
+      v->MarkRowsDirty(indices.flat<Index>().data(), N);
+    } else {
+      // The indices are in device memory.
+      v->MarkAllRowsDirty();
+    }
   }
 };
 
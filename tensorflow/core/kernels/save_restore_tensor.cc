@@ -14,20 +14,24 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <memory>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/delta_bundle.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -229,7 +233,7 @@ void RestoreTensor(OpKernelContext* context,
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes) {
+                        gtl::ArraySlice<DataType> dtypes, int num_readers) {
   const string& prefix_string = prefix.scalar<string>()();
 
   const auto& tensor_names_flat = tensor_names.flat<string>();
@@ -245,33 +249,47 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
   BundleReader reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(reader.status());
+  // A delta checkpoint is read through the chain of checkpoints it is based
+  // on, which applies the changes of each one in order.
+  std::unique_ptr<DeltaBundleReader> delta_reader;
+  if (reader.Contains(kDeltaBaseKey)) {
+    delta_reader.reset(new DeltaBundleReader(Env::Default(), prefix_string));
+    TF_RETURN_IF_ERROR(delta_reader->status());
+  }
 
+  // Allocates all outputs first, so that the lookups can run concurrently.
   // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
+  std::vector<BundleReadItem> items(sorted_name_idx.size());
   TensorShape restored_full_shape;
   Tensor* restored_tensor = nullptr;
-  for (auto i : sorted_name_idx) {
+  for (size_t j = 0; j < sorted_name_idx.size(); ++j) {
+    const size_t i = sorted_name_idx[j];
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
+    BundleReadItem& item = items[j];
+    item.key = tensor_name;
 
-    TF_RETURN_IF_ERROR(
-        reader.LookupTensorShape(tensor_name, &restored_full_shape));
+    if (delta_reader != nullptr) {
+      DataType restored_dtype;
+      TF_RETURN_IF_ERROR(delta_reader->LookupDtypeAndShape(
+          tensor_name, &restored_dtype, &restored_full_shape));
+    } else {
+      TF_RETURN_IF_ERROR(
+          reader.LookupTensorShape(tensor_name, &restored_full_shape));
+    }
 
     if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
-      TensorSlice parsed_slice;
       TensorShape parsed_slice_shape;
 
       TF_RETURN_IF_ERROR(
           checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
-                                         &parsed_slice, &parsed_slice_shape));
+                                         &item.slice, &parsed_slice_shape));
       if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
         return errors::InvalidArgument(
             "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
@@ -282,8 +300,7 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
       TF_RETURN_IF_ERROR(
           context->allocate_output(i, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
+      item.is_slice = true;
     }
     if (dtypes[i] != restored_tensor->dtype()) {
       return errors::InvalidArgument(
@@ -291,8 +308,38 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
           DataTypeString(dtypes[i]), " does not equal restored dtype ",
           DataTypeString(restored_tensor->dtype()));
     }
+    item.tensor = restored_tensor;
+  }
+
+  if (delta_reader != nullptr) {
+    for (const BundleReadItem& item : items) {
+      if (item.is_slice) {
+        TF_RETURN_IF_ERROR(
+            delta_reader->LookupSlice(item.key, item.slice, item.tensor));
+      } else {
+        TF_RETURN_IF_ERROR(delta_reader->Lookup(item.key, item.tensor));
+      }
+    }
+    return Status::OK();
+  }
+  if (num_readers <= 1) {
+    for (const BundleReadItem& item : items) {
+      if (item.is_slice) {
+        TF_RETURN_IF_ERROR(
+            reader.LookupSlice(item.key, item.slice, item.tensor));
+      } else {
+        TF_RETURN_IF_ERROR(reader.Lookup(item.key, item.tensor));
+      }
+    }
+    return Status::OK();
   }
-  return Status::OK();
+  thread::ThreadPool* workers =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  return ReadBundleParallel(
+      Env::Default(), prefix_string, items, num_readers,
+      [workers](std::function<void()> fn) {
+        workers->Schedule(std::move(fn));
+      });
 }
 
 }  // namespace tensorflow
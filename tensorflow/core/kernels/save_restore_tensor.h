@@ -57,8 +57,10 @@ void RestoreTensor(OpKernelContext* context,
 
 // Invokes the V2 checkpoint read path to read tensors.
 //
-// "context" is only used for allocating outputs.  In particular, the inputs are
-// explicitly provided and not accessed via the "input(i)" methods.
+// "context" is only used for allocating outputs, and for its CPU worker
+// threads.  In particular, the inputs are explicitly provided and not accessed
+// via the "input(i)" methods.  If "num_readers" > 1, the tensors are read
+// concurrently by up to "num_readers" readers.
 // REQUIRES:
 //   * "prefix" has 1 element, DT_STRING.
 //   * "tensor_names" and "shape_and_slices" shaped {N}, both DT_STRING.
@@ -66,7 +68,7 @@ void RestoreTensor(OpKernelContext* context,
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes);
+                        gtl::ArraySlice<DataType> dtypes, int num_readers = 1);
 
 }  // namespace tensorflow
 
@@ -18,18 +18,26 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
+#include "tensorflow/core/util/tensor_bundle/delta_bundle.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 
@@ -85,12 +93,70 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Returns the number of threads SaveV2 and RestoreV2 use to write and read a
+// checkpoint, from the environment variable TF_CHECKPOINT_NUM_THREADS.  With
+// the default of 1, SaveV2 writes a single data file per call, as before.
+Status GetCheckpointNumThreads(int* num_threads) {
+  int64 value;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_CHECKPOINT_NUM_THREADS",
+                                         /*default_val=*/1, &value));
+  if (value < 1) {
+    return errors::InvalidArgument(
+        "TF_CHECKPOINT_NUM_THREADS must be positive, got ", value);
+  }
+  *num_threads = static_cast<int>(value);
+  return Status::OK();
+}
+
+// Returns the tensors to save, which follow the prefix, tensor names and
+// shape_and_slices inputs of a SaveV2 or SaveV2Async op.
+Status GetWriteItems(OpKernelContext* context, const Tensor& tensor_names,
+                     const Tensor& shape_and_slices,
+                     std::vector<BundleWriteItem>* items) {
+  const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+  const int num_tensors = static_cast<int>(tensor_names.NumElements());
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+
+  items->resize(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    const string& tensor_name = tensor_names_flat(i);
+    const Tensor& tensor = context->input(i + kFixedInputs);
+    BundleWriteItem& item = (*items)[i];
+    item.key = tensor_name;
+    item.tensor = &tensor;
+
+    if (!shape_and_slices_flat(i).empty()) {
+      const string& shape_spec = shape_and_slices_flat(i);
+      TensorShape shape;
+      TensorSlice slice(tensor.dims());
+      TensorShape slice_shape;
+
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(shape_spec, &shape,
+                                                        &slice, &slice_shape));
+      if (!slice_shape.IsSameSize(tensor.shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice specification does not match the shape "
+            "of the tensor to  save: ",
+            shape_spec, ", tensor: ", tensor.shape().DebugString());
+      }
+
+      item.is_slice = true;
+      item.full_shape = shape;
+      item.slice = slice;
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetCheckpointNumThreads(&num_threads_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -99,51 +165,154 @@ class SaveV2 : public OpKernel {
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
                    shape_and_slices);
 
-    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
-    const int num_tensors = static_cast<int>(tensor_names.NumElements());
     const string& prefix_string = prefix.scalar<string>()();
-    const auto& tensor_names_flat = tensor_names.flat<string>();
-    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string
+            << ", num_threads: " << num_threads_;
 
-    for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
+    std::vector<BundleWriteItem> items;
+    OP_REQUIRES_OK(context, GetWriteItems(context, tensor_names,
+                                          shape_and_slices, &items));
+    thread::ThreadPool* workers =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    OP_REQUIRES_OK(context,
+                   WriteBundleParallel(Env::Default(), prefix_string, items,
+                                       num_threads_,
+                                       [workers](std::function<void()> fn) {
+                                         workers->Schedule(std::move(fn));
+                                       }));
+  }
 
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
+ private:
+  // The number of data shards, and threads, to write the checkpoint with.
+  int num_threads_;
+};
+REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
-    }
-    OP_REQUIRES_OK(context, writer.Finish());
+namespace {
+
+// The background writer shared by the SaveV2Async and WaitForSaveV2Async ops
+// with the same container and shared_name.
+class AsyncCheckpointWriter : public ResourceBase {
+ public:
+  explicit AsyncCheckpointWriter(const AsyncBundleWriter::Options& options)
+      : writer_(Env::Default(), options) {}
+
+  AsyncBundleWriter* writer() { return &writer_; }
+
+  string DebugString() override { return "AsyncCheckpointWriter"; }
+
+ private:
+  AsyncBundleWriter writer_;
+};
+
+// Reads the container and shared_name attrs of the SaveV2Async and
+// WaitForSaveV2Async ops.
+Status GetAsyncWriterName(OpKernelConstruction* context, string* container,
+                          string* name) {
+  TF_RETURN_IF_ERROR(context->GetAttr("container", container));
+  TF_RETURN_IF_ERROR(context->GetAttr("shared_name", name));
+  if (name->empty()) *name = "_async_checkpoint_writer";
+  return Status::OK();
+}
+
+}  // namespace
+
+// Copies a list of named tensors and saves them in the background.
+class SaveV2Async : public OpKernel {
+ public:
+  explicit SaveV2Async(OpKernelConstruction* context) : OpKernel(context) {
+    int64 max_staging_bytes;
+    OP_REQUIRES_OK(context, context->GetAttr("num_threads",
+                                             &writer_options_.num_threads));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("max_staging_bytes", &max_staging_bytes));
+    writer_options_.max_staging_bytes = max_staging_bytes;
+    OP_REQUIRES_OK(context, GetAsyncWriterName(context, &container_, &name_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    const Tensor& shape_and_slices = context->input(2);
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    std::vector<BundleWriteItem> items;
+    OP_REQUIRES_OK(context, GetWriteItems(context, tensor_names,
+                                          shape_and_slices, &items));
+
+    ResourceMgr* rm = context->resource_manager();
+    const string& container =
+        container_.empty() ? rm->default_container() : container_;
+    const AsyncBundleWriter::Options& options = writer_options_;
+    AsyncCheckpointWriter* writer;
+    OP_REQUIRES_OK(context, rm->LookupOrCreate<AsyncCheckpointWriter>(
+                                container, name_, &writer,
+                                [&options](AsyncCheckpointWriter** ret) {
+                                  *ret = new AsyncCheckpointWriter(options);
+                                  return Status::OK();
+                                }));
+    core::ScopedUnref unref(writer);
+
+    Tensor* save_id;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &save_id));
+    save_id->scalar<int64>()() =
+        writer->writer()->Write(prefix.scalar<string>()(), items);
   }
+
+ private:
+  AsyncBundleWriter::Options writer_options_;
+  string container_;
+  string name_;
 };
-REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
+REGISTER_KERNEL_BUILDER(Name("SaveV2Async").Device(DEVICE_CPU), SaveV2Async);
+
+// Waits for a save started by SaveV2Async, without blocking a thread.
+class WaitForSaveV2Async : public AsyncOpKernel {
+ public:
+  explicit WaitForSaveV2Async(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, GetAsyncWriterName(context, &container_, &name_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& save_id = context->input(0);
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsScalar(save_id.shape()),
+                      errors::InvalidArgument("save_id must be a scalar, got ",
+                                              save_id.shape().DebugString()),
+                      done);
+    ResourceMgr* rm = context->resource_manager();
+    AsyncCheckpointWriter* writer;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        rm->Lookup(container_.empty() ? rm->default_container() : container_,
+                   name_, &writer),
+        done);
+    writer->writer()->WaitAsync(
+        save_id.scalar<int64>()(),
+        [context, writer, done](const Status& status) {
+          context->SetStatus(status);
+          writer->Unref();
+          done();
+        });
+  }
+
+ private:
+  string container_;
+  string name_;
+};
+REGISTER_KERNEL_BUILDER(Name("WaitForSaveV2Async").Device(DEVICE_CPU),
+                        WaitForSaveV2Async);
 
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
   explicit RestoreV2(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+    OP_REQUIRES_OK(context, GetCheckpointNumThreads(&num_threads_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -181,15 +350,174 @@ class RestoreV2 : public OpKernel {
     }
     // If found, invokes the V2 reader.
     OP_REQUIRES_OK(context, RestoreTensorsV2(context, prefix, tensor_names,
-                                             shape_and_slices, dtypes_));
+                                             shape_and_slices, dtypes_,
+                                             num_threads_));
   }
 
  private:
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
+  // The number of threads to read the checkpoint with.
+  int num_threads_;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
+// Saves resource variables, or the rows of them that changed since the
+// previous call, as a delta of the checkpoint written by that call.
+class SaveDeltaV2 : public OpKernel {
+ public:
+  explicit SaveDeltaV2(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& base_prefix = context->input(1);
+    const Tensor& tensor_names = context->input(2);
+    const Tensor& shape_and_slices = context->input(3);
+    const int kFixedInputs = 4;
+    const int num_tensors = context->num_inputs() - kFixedInputs;
+    OP_REQUIRES(context,
+                prefix.NumElements() == 1 && base_prefix.NumElements() == 1,
+                errors::InvalidArgument(
+                    "Inputs prefix and base_prefix should have a single "
+                    "element each, got ",
+                    prefix.NumElements(), " and ", base_prefix.NumElements(),
+                    " instead."));
+    OP_REQUIRES(context,
+                tensor_names.NumElements() == num_tensors &&
+                    shape_and_slices.NumElements() == num_tensors,
+                errors::InvalidArgument(
+                    "Expected ", num_tensors,
+                    " elements in tensor_names and shape_and_slices, got ",
+                    tensor_names.NumElements(), " and ",
+                    shape_and_slices.NumElements()));
+    const auto& tensor_names_flat = tensor_names.flat<string>();
+
+    std::vector<VariableSnapshot> snapshots(num_tensors);
+    auto unref = gtl::MakeCleanup([&snapshots]() {
+      for (VariableSnapshot& snapshot : snapshots) {
+        if (snapshot.var != nullptr) snapshot.var->Unref();
+      }
+    });
+    for (int i = 0; i < num_tensors; ++i) {
+      OP_REQUIRES_OK(context,
+                     LookupResource(context,
+                                    HandleFromInput(context, i + kFixedInputs),
+                                    &snapshots[i].var));
+    }
+
+    // Takes the dirty rows of each variable together with its value, so that
+    // later updates are saved by the next call.
+    Status status;
+    for (int i = 0; i < num_tensors && status.ok(); ++i) {
+      VariableSnapshot& snapshot = snapshots[i];
+      mutex_lock ml(*snapshot.var->mu());
+      if (!snapshot.var->is_initialized) {
+        status = errors::FailedPrecondition(
+            "Attempting to save uninitialized variable ",
+            tensor_names_flat(i));
+        break;
+      }
+      snapshot.tensor = *snapshot.var->tensor();
+      snapshot.tracked =
+          snapshot.var->TakeDirtyRows(&snapshot.all_rows, &snapshot.rows);
+      if (!snapshot.tracked) snapshot.var->StartTrackingDirtyRows();
+      snapshot.taken = true;
+    }
+    if (status.ok()) {
+      status = WriteDelta(prefix.scalar<string>()(),
+                          base_prefix.scalar<string>()(), tensor_names,
+                          shape_and_slices, snapshots);
+    }
+    if (!status.ok()) {
+      // The rows were not saved, so the next call must save them.
+      for (VariableSnapshot& snapshot : snapshots) {
+        if (snapshot.taken) {
+          snapshot.var->RestoreDirtyRows(
+              snapshot.all_rows || !snapshot.tracked, snapshot.rows);
+        }
+      }
+    }
+    OP_REQUIRES_OK(context, status);
+  }
+
+ private:
+  struct VariableSnapshot {
+    Var* var = nullptr;
+    Tensor tensor;
+    bool taken = false;
+    // See Var::TakeDirtyRows().
+    bool tracked = false;
+    bool all_rows = false;
+    std::vector<int64> rows;
+  };
+
+  static Status WriteDelta(const string& prefix, const string& base_prefix,
+                           const Tensor& tensor_names,
+                           const Tensor& shape_and_slices,
+                           const std::vector<VariableSnapshot>& snapshots) {
+    const auto& tensor_names_flat = tensor_names.flat<string>();
+    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+    BundleWriter writer(Env::Default(), prefix);
+    TF_RETURN_IF_ERROR(writer.status());
+    VLOG(1) << "BundleWriter, prefix: " << prefix
+            << ", base_prefix: " << base_prefix;
+    if (!base_prefix.empty()) {
+      TF_RETURN_IF_ERROR(AddDeltaBase(&writer, base_prefix));
+    }
+
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+      const VariableSnapshot& snapshot = snapshots[i];
+      const string& tensor_name = tensor_names_flat(i);
+      const Tensor& tensor = snapshot.tensor;
+      // A delta leaves out the variables unchanged since the previous call,
+      // but a bundle without a base must hold all of them.
+      if (!base_prefix.empty() && snapshot.tracked && !snapshot.all_rows &&
+          snapshot.rows.empty()) {
+        continue;
+      }
+
+      TensorShape shape = tensor.shape();
+      TensorSlice slice(tensor.dims());
+      const string& shape_spec = shape_and_slices_flat(i);
+      if (!shape_spec.empty()) {
+        TensorShape slice_shape;
+        TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+            shape_spec, &shape, &slice, &slice_shape));
+        if (!slice_shape.IsSameSize(tensor.shape())) {
+          return errors::InvalidArgument(
+              "Slice in shape_and_slice specification does not match the "
+              "shape of the variable to save: ",
+              shape_spec, ", variable: ", tensor.shape().DebugString());
+        }
+      }
+
+      std::vector<int64> rows;
+      bool save_in_full = base_prefix.empty() || !snapshot.tracked ||
+                          snapshot.all_rows || tensor.dims() == 0 ||
+                          !DataTypeCanUseMemcpy(tensor.dtype());
+      if (!save_in_full) {
+        for (int64 row : snapshot.rows) {
+          if (row >= 0 && row < tensor.dim_size(0)) rows.push_back(row);
+        }
+        // Once most rows changed, saving them all is about as large, and
+        // keeps the restore from having to merge.
+        save_in_full =
+            static_cast<int64>(rows.size()) * 2 > tensor.dim_size(0);
+      }
+      if (!save_in_full) {
+        TF_RETURN_IF_ERROR(
+            AddDeltaRows(&writer, tensor_name, shape, slice, tensor, rows));
+      } else if (shape_spec.empty()) {
+        TF_RETURN_IF_ERROR(writer.Add(tensor_name, tensor));
+      } else {
+        TF_RETURN_IF_ERROR(writer.AddSlice(tensor_name, shape, slice, tensor));
+      }
+    }
+    return writer.Finish();
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("SaveDeltaV2").Device(DEVICE_CPU), SaveDeltaV2);
+
 // The final step in saving sharded V2 checkpoints: merges metadata files.
 class MergeV2Checkpoints : public OpKernel {
  public:
@@ -173,6 +173,7 @@ class ScatterNdUpdateOp : public OpKernel {
       OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
       Tensor* t = v->tensor();
       OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(c, t));
+      v->MarkAllRowsDirty();
       params = *t;
       params_shape = params.shape();
     } else if (IsRefType(c->input_dtype(0))) {
@@ -72,4 +72,20 @@ void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
   }
 }
 
+void MarkVariableRowsDirty(OpKernelContext* ctx,
+                           const std::vector<int>& input_ids,
+                           const Tensor& indices) {
+  for (int input : input_ids) {
+    if (ctx->input_dtype(input) != DT_RESOURCE) continue;
+    Var* var;
+    if (!LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) continue;
+    core::ScopedUnref unref_var(var);
+    if (indices.dtype() == DT_INT32) {
+      var->MarkRowsDirty(indices.flat<int32>().data(), indices.NumElements());
+    } else {
+      var->MarkRowsDirty(indices.flat<int64>().data(), indices.NumElements());
+    }
+  }
+}
+
 }  // end namespace tensorflow
@@ -31,6 +31,14 @@ std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
+// Records that the rows "indices" of the resource variables passed as inputs
+// "input_ids" were updated, for incremental checkpoints (see
+// Var::StartTrackingDirtyRows()).  Does nothing for reference variables.
+// "indices" must be an int32 or int64 tensor in host memory.
+void MarkVariableRowsDirty(OpKernelContext* ctx,
+                           const std::vector<int>& input_ids,
+                           const Tensor& indices);
+
 // This is for use with ResourceVariables to ensure *tensor has a
 // reference count of 1 before you update it.
 // REQUIRES: If you pass in variable->tensor(), *variable->mu() must be held.
@@ -72,7 +80,9 @@ Status PrepareToUpdateVariable(OpKernelContext* ctx, Tensor* tensor) {
 // differences between reference and resource variables.  For resource
 // variables, we ensure `*out` has a reference count of 1 (using
 // PrepareToUpdateVariable() to copy if necessary) unless
-// sparse && !lock_held, in which case it never copies.
+// sparse && !lock_held, in which case it never copies.  Unless sparse, all
+// rows of a resource variable are marked dirty; sparse updates must call
+// MarkVariableRowsDirty() instead.
 template <typename Device, typename T>
 Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
                                   bool lock_held, bool sparse, Tensor* out) {
@@ -80,6 +90,7 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     Var* var;
     TF_RETURN_IF_ERROR(LookupResource(ctx, HandleFromInput(ctx, input), &var));
     core::ScopedUnref unref_var(var);
+    if (!sparse) var->MarkAllRowsDirty();
     if (lock_held) {
       TF_RETURN_IF_ERROR(
           PrepareToUpdateVariable<Device, T>(ctx, var->tensor()));
@@ -826,6 +826,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1046,6 +1047,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1374,6 +1376,7 @@ class SparseApplyAdagradOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1554,6 +1557,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1850,6 +1854,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2246,6 +2251,7 @@ class SparseApplyFtrlOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2491,6 +2497,7 @@ class SparseApplyMomentumOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -3273,6 +3280,7 @@ class SparseApplyRMSPropOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -3414,6 +3422,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
       }
     }
 
+    MarkVariableRowsDirty(ctx, {0, 1, 2, 3}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -20,12 +20,15 @@ limitations under the License.
 
 #include <stdint.h>
 #include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace tensorflow {
 namespace crc32c {
 
 extern bool CanAccelerate();
 extern uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size);
+extern bool CanInterleave();
+extern uint32_t InterleavedExtend(uint32_t crc, const char *buf, size_t size);
 
 static const uint32 table0_[256] = {
     0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
@@ -209,10 +212,24 @@ static inline uint32_t LE_LOAD32(const uint8_t *p) {
   return core::DecodeFixed32(reinterpret_cast<const char *>(p));
 }
 
+typedef uint32_t (*ExtendFunction)(uint32_t crc, const char *buf,
+                                    size_t size);
+
+// Returns the fastest accelerated implementation the CPU supports, or nullptr
+// if the portable one below must be used.
+static ExtendFunction GetAcceleratedExtend() {
+  if (!CanAccelerate()) return nullptr;
+  if (CanInterleave() &&
+      port::TestCPUFeature(port::CPUFeature::PCLMULQDQ)) {
+    return InterleavedExtend;
+  }
+  return AcceleratedExtend;
+}
+
 uint32 Extend(uint32 crc, const char *buf, size_t size) {
-  static bool can_accelerate = CanAccelerate();
-  if (can_accelerate) {
-    return AcceleratedExtend(crc, buf, size);
+  static const ExtendFunction accelerated_extend = GetAcceleratedExtend();
+  if (accelerated_extend != nullptr) {
+    return accelerated_extend(crc, buf, size);
   }
 
   const uint8 *p = reinterpret_cast<const uint8 *>(buf);
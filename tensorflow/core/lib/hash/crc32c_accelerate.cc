@@ -41,6 +41,14 @@ limitations under the License.
 #include <nmmintrin.h>
 #endif
 
+// See if the PCLMULQDQ carry-less multiplication instruction is available, to
+// combine the checksums of streams computed in parallel.
+#undef USE_PCLMUL_CRC32C
+#if defined(USE_SSE_CRC32C) && defined(__PCLMUL__)
+#define USE_PCLMUL_CRC32C 1
+#include <wmmintrin.h>
+#endif
+
 namespace tensorflow {
 namespace crc32c {
 
@@ -95,5 +103,114 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #endif
 
+#ifndef USE_PCLMUL_CRC32C
+
+bool CanInterleave() { return false; }
+uint32_t InterleavedExtend(uint32_t crc, const char *buf, size_t size) {
+  // Should not be called.
+  return 0;
+}
+
+#else
+
+// The serial version above is bound by the latency of the crc32 instruction,
+// which is three times its throughput.  This version checksums three
+// consecutive blocks of the input in parallel instead, and combines their
+// checksums with carry-less multiplications.
+
+// InterleavedExtend() is compiled in, but requires a CPU with SSE4.2 and
+// PCLMULQDQ, which Extend() checks for.
+bool CanInterleave() { return true; }
+
+namespace {
+
+// The sizes of the blocks checksummed in parallel: long blocks for large
+// inputs, and short ones for the rest.  Multiples of 8 bytes.
+const size_t kLongBlock = 8192;
+const size_t kShortBlock = 256;
+
+// x^(8n - 33) mod P, bit-reflected, for n = 1 and 2 blocks.  See
+// ExtendByZeros().
+const uint64_t kLongShift1 = 0x54a86326;
+const uint64_t kLongShift2 = 0x1dc403cc;
+const uint64_t kShortShift1 = 0xb9e02b86;
+const uint64_t kShortShift2 = 0xdd7e3b0c;
+
+inline uint64_t Load64(const uint8_t *p) {
+  return *reinterpret_cast<const uint64_t *>(p);
+}
+
+// Returns the crc32c register "crc" extended by n zero bytes, given
+// shift = x^(8n - 33) mod P.  The carry-less product of the bit-reflected
+// "crc" and "shift" is crc * shift * x; the crc32 instruction multiplies it by
+// x^32 and reduces it modulo P.
+inline __m128i MultiplyByShift(uint64_t crc, uint64_t shift) {
+  return _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc),
+                              _mm_cvtsi64_si128(shift), 0x00);
+}
+
+// Extends the crc32c register "crc" by three consecutive blocks of "block"
+// bytes at "p".
+inline uint64_t ExtendThreeBlocks(uint64_t crc, const uint8_t *p,
+                                  size_t block, uint64_t shift1,
+                                  uint64_t shift2) {
+  uint64_t crc1 = 0;
+  uint64_t crc2 = 0;
+  const uint8_t *end = p + block;
+  for (; p < end; p += 8) {
+    crc = _mm_crc32_u64(crc, Load64(p));
+    crc1 = _mm_crc32_u64(crc1, Load64(p + block));
+    crc2 = _mm_crc32_u64(crc2, Load64(p + 2 * block));
+  }
+  // The checksum is linear: extends "crc" by two blocks and "crc1" by one,
+  // with a single reduction.
+  const __m128i product = _mm_xor_si128(MultiplyByShift(crc, shift2),
+                                        MultiplyByShift(crc1, shift1));
+  return _mm_crc32_u64(0, _mm_cvtsi128_si64(product)) ^ crc2;
+}
+
+}  // namespace
+
+uint32_t InterleavedExtend(uint32_t crc, const char *buf, size_t size) {
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+  const uint8_t *e = p + size;
+  uint32_t l = crc ^ 0xffffffffu;
+
+  // Advance p until aligned to 8-bytes, as AcceleratedExtend() does.
+  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
+  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 7) >> 3) << 3);
+  if (x <= e) {
+    while (p != x) {
+      l = _mm_crc32_u8(l, *p);
+      p++;
+    }
+  }
+
+  uint64_t l64 = l;
+  while (static_cast<size_t>(e - p) >= 3 * kLongBlock) {
+    l64 = ExtendThreeBlocks(l64, p, kLongBlock, kLongShift1, kLongShift2);
+    p += 3 * kLongBlock;
+  }
+  while (static_cast<size_t>(e - p) >= 3 * kShortBlock) {
+    l64 = ExtendThreeBlocks(l64, p, kShortBlock, kShortShift1, kShortShift2);
+    p += 3 * kShortBlock;
+  }
+
+  // Process the rest serially, 8 bytes at a time, then one at a time.
+  while ((e - p) >= 8) {
+    l64 = _mm_crc32_u64(l64, Load64(p));
+    p += 8;
+  }
+  l = l64;
+  while (p < e) {
+    l = _mm_crc32_u8(l, *p);
+    p++;
+  }
+
+  return l ^ 0xffffffffu;
+}
+
+#endif
+
 }  // namespace crc32c
 }  // namespace tensorflow
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/lib/hash/crc32c.h"
+
+#include <algorithm>
+#include <string>
+
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -62,6 +66,28 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+TEST(CRC, LargeBuffers) {
+  // Large buffers are checksummed in parallel blocks where supported; small
+  // pieces of them are not.
+  std::string input(100000, 'x');
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  for (size_t size : {767, 768, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 800,
+                      100000 - 1}) {
+    for (size_t offset : {0, 1, 5}) {
+      const size_t n = std::min(size, input.size() - offset);
+      uint32 expected = 0;
+      for (size_t i = 0; i < n; i += 100) {
+        expected = Extend(expected, input.data() + offset + i,
+                          std::min<size_t>(100, n - i));
+      }
+      ASSERT_EQ(expected, Value(input.data() + offset, n))
+          << "size " << n << ", offset " << offset;
+    }
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
@@ -79,7 +105,7 @@ static void BM_CRC(int iters, int len) {
   testing::BytesProcessed(static_cast<int64>(iters) * len);
   VLOG(1) << h;
 }
-BENCHMARK(BM_CRC)->Range(1, 256 * 1024);
+BENCHMARK(BM_CRC)->Range(1, 256 * 1024)->Arg(16 << 20);
 
 }  // namespace crc32c
 }  // namespace tensorflow
@@ -15,33 +15,84 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 namespace io {
 
-InputBuffer::InputBuffer(RandomAccessFile* file, size_t buffer_bytes)
+struct InputBuffer::Readahead {
+  explicit Readahead(size_t size) : buf(new char[size]) {}
+  ~Readahead() {
+    if (done != nullptr) done->WaitForNotification();
+    delete[] buf;
+  }
+
+  char* buf;
+  RandomAccessFile::ReadRequest request;
+  // Set while a read into "buf" is outstanding or not consumed yet.
+  std::unique_ptr<Notification> done;
+};
+
+InputBuffer::InputBuffer(RandomAccessFile* file, size_t buffer_bytes,
+                         bool readahead)
     : file_(file),
       file_pos_(0),
       size_(buffer_bytes),
       buf_(new char[size_]),
       pos_(buf_),
-      limit_(buf_) {}
+      limit_(buf_) {
+  if (readahead && file_->SupportsAsyncRead()) {
+    readahead_.reset(new Readahead(size_));
+  }
+}
 
-InputBuffer::~InputBuffer() { delete[] buf_; }
+InputBuffer::~InputBuffer() {
+  readahead_.reset();
+  delete[] buf_;
+}
 
 Status InputBuffer::FillBuffer() {
   StringPiece data;
-  Status s = file_->Read(file_pos_, size_, &data, buf_);
+  Status s;
+  bool read_ahead = false;
+  if (readahead_ != nullptr && readahead_->done != nullptr) {
+    readahead_->done->WaitForNotification();
+    readahead_->done.reset();
+    // The read is dropped if Seek() moved away from it.
+    if (readahead_->request.offset == static_cast<uint64>(file_pos_)) {
+      std::swap(buf_, readahead_->buf);
+      data = readahead_->request.result;
+      s = readahead_->request.status;
+      read_ahead = true;
+    }
+  }
+  if (!read_ahead) {
+    s = file_->Read(file_pos_, size_, &data, buf_);
+  }
   if (data.data() != buf_) {
     memmove(buf_, data.data(), data.size());
   }
   pos_ = buf_;
   limit_ = pos_ + data.size();
   file_pos_ += data.size();
+  if (readahead_ != nullptr && s.ok()) {
+    StartReadahead();
+  }
   return s;
 }
 
+void InputBuffer::StartReadahead() {
+  RandomAccessFile::ReadRequest& request = readahead_->request;
+  request = RandomAccessFile::ReadRequest();
+  request.offset = file_pos_;
+  request.n = size_;
+  request.scratch = readahead_->buf;
+  readahead_->done.reset(new Notification);
+  Notification* done = readahead_->done.get();
+  file_->ReadAsync(&request, 1, [done]() { done->Notify(); });
+}
+
 Status InputBuffer::ReadLine(string* result) {
   result->clear();
   Status s;
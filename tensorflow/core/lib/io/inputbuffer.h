@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_INPUTBUFFER_H_
 #define TENSORFLOW_LIB_IO_INPUTBUFFER_H_
 
+#include <memory>
 #include <string>
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -33,7 +34,12 @@ class InputBuffer {
  public:
   // Create an InputBuffer for "file" with a buffer size of
   // "buffer_bytes" bytes.  'file' must outlive *this.
-  InputBuffer(RandomAccessFile* file, size_t buffer_bytes);
+  //
+  // If "readahead" is true and "file" supports asynchronous reads (see
+  // RandomAccessFile::SupportsAsyncRead()), the next "buffer_bytes" bytes of
+  // the file are read into a second buffer while the first one is consumed.
+  InputBuffer(RandomAccessFile* file, size_t buffer_bytes,
+              bool readahead = false);
   ~InputBuffer();
 
   // Read one text line of data into "*result" until end-of-file or a
@@ -80,8 +86,14 @@ class InputBuffer {
   RandomAccessFile* file() const { return file_; }
 
  private:
+  struct Readahead;
+
   Status FillBuffer();
 
+  // Starts reading the "size_" bytes at "file_pos_" into the readahead
+  // buffer.
+  void StartReadahead();
+
   // Internal slow-path routine used by ReadVarint32().
   Status ReadVarint32Fallback(uint32* result);
 
@@ -101,6 +113,8 @@ class InputBuffer {
   // [pos_,limit_) hold the "limit_ - pos_" bytes just before "file_pos_"
   char* pos_;    // Current position in "buf"
   char* limit_;  // Just past end of valid data in "buf"
+  // Set iff reading ahead.
+  std::unique_ptr<Readahead> readahead_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(InputBuffer);
 };
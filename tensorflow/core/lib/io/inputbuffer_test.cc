@@ -292,6 +292,43 @@ TEST(InputBuffer, Seek) {
   }
 }
 
+TEST(InputBuffer, Readahead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/inputbuffer_test";
+  string contents;
+  for (int i = 0; i < 1000; ++i) {
+    strings::StrAppend(&contents, "line ", i, "\n");
+  }
+  TF_ASSERT_OK(WriteStringToFile(env, fname, contents));
+
+  for (auto buf_size : BufferSizes()) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+    io::InputBuffer in(file.get(), buf_size, /*readahead=*/true);
+    string line;
+    for (int i = 0; i < 500; ++i) {
+      TF_CHECK_OK(in.ReadLine(&line));
+      EXPECT_EQ(strings::StrCat("line ", i), line);
+    }
+
+    // Seeking drops the read ahead of the old position.
+    TF_CHECK_OK(in.Seek(0));
+    TF_CHECK_OK(in.ReadLine(&line));
+    EXPECT_EQ("line 0", line);
+    TF_CHECK_OK(in.Seek(contents.find("line 990")));
+    for (int i = 990; i < 1000; ++i) {
+      TF_CHECK_OK(in.ReadLine(&line));
+      EXPECT_EQ(strings::StrCat("line ", i), line);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadLine(&line)));
+    EXPECT_EQ(static_cast<int64>(contents.size()), in.Tell());
+
+    // Destroyed with a read in flight.
+    io::InputBuffer in2(file.get(), buf_size, /*readahead=*/true);
+    TF_CHECK_OK(in2.ReadLine(&line));
+  }
+}
+
 TEST(InputBuffer, ReadVarint32) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/inputbuffer_test";
@@ -16,9 +16,11 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 
 #include <limits.h>
+#include <string.h>
 
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
@@ -152,5 +154,217 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+namespace {
+
+constexpr size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+constexpr size_t kFooterSize = sizeof(uint32);
+
+// The number of bytes of record data whose checksums are verified by one
+// closure on the compute runner.
+constexpr size_t kMinVerifyShardBytes = 256 << 10;
+
+}  // namespace
+
+struct ParallelRecordReader::Block {
+  uint64 offset;
+  string data;
+  Status status;
+  Notification done;
+  // Used if the file supports asynchronous reads.
+  RandomAccessFile::ReadRequest request;
+
+  // Moves the result of the read into "data".
+  void Finish(StringPiece result) {
+    if (result.data() != data.data()) {
+      memmove(&data[0], result.data(), result.size());
+    }
+    data.resize(result.size());
+    done.Notify();
+  }
+};
+
+ParallelRecordReader::ParallelRecordReader(RandomAccessFile* file,
+                                           const Options& options,
+                                           Runner io_runner,
+                                           Runner compute_runner)
+    : file_(file),
+      options_(options),
+      io_runner_(std::move(io_runner)),
+      compute_runner_(std::move(compute_runner)) {
+  CHECK_GT(options_.block_size, 0);
+  CHECK_GT(options_.num_readahead_blocks, 0);
+}
+
+ParallelRecordReader::~ParallelRecordReader() { CancelReads(); }
+
+Status ParallelRecordReader::ReadRecord(string* record) {
+  while (records_.empty()) {
+    TF_RETURN_IF_ERROR(ReadBlock());
+  }
+  Record& next = records_.front();
+  record->swap(next.data);
+  offset_ = next.end_offset;
+  records_.pop_front();
+  return Status::OK();
+}
+
+Status ParallelRecordReader::SeekOffset(uint64 offset) {
+  CancelReads();
+  records_.clear();
+  buffer_.clear();
+  buffer_offset_ = offset;
+  next_read_offset_ = offset;
+  offset_ = offset;
+  eof_ = false;
+  return Status::OK();
+}
+
+void ParallelRecordReader::ScheduleReads() {
+  while (!eof_ &&
+         blocks_.size() < static_cast<size_t>(options_.num_readahead_blocks)) {
+    std::shared_ptr<Block> block = std::make_shared<Block>();
+    block->offset = next_read_offset_;
+    next_read_offset_ += options_.block_size;
+    blocks_.push_back(block);
+    RandomAccessFile* file = file_;
+    const size_t n = options_.block_size;
+    if (file->SupportsAsyncRead()) {
+      // The file system overlaps the reads without holding an io_runner
+      // thread for each.
+      block->data.resize(n);
+      block->request.offset = block->offset;
+      block->request.n = n;
+      block->request.scratch = &block->data[0];
+      file->ReadAsync(&block->request, 1, [block]() {
+        block->status = block->request.status;
+        block->Finish(block->request.result);
+      });
+      continue;
+    }
+    io_runner_([file, n, block]() {
+      block->data.resize(n);
+      StringPiece result;
+      block->status = file->Read(block->offset, n, &result, &block->data[0]);
+      block->Finish(result);
+    });
+  }
+}
+
+Status ParallelRecordReader::ReadBlock() {
+  ScheduleReads();
+  if (blocks_.empty()) {
+    if (!buffer_.empty()) {
+      return errors::DataLoss("truncated record at ", buffer_offset_);
+    }
+    return errors::OutOfRange("eof");
+  }
+  std::shared_ptr<Block> block = blocks_.front();
+  blocks_.pop_front();
+  block->done.WaitForNotification();
+  if (!block->status.ok() && !errors::IsOutOfRange(block->status)) {
+    // Retry the block on the next call.
+    const Status s = block->status;
+    CancelReads();
+    next_read_offset_ = block->offset;
+    return s;
+  }
+  if (block->data.size() < options_.block_size) {
+    // A short read means that the block extends past the end of the file, and
+    // so do the reads after it.
+    eof_ = true;
+    CancelReads();
+  }
+  buffer_.append(block->data);
+  ScheduleReads();
+
+  // Parse the complete records in the buffer.
+  std::vector<Record> records;
+  size_t pos = 0;
+  while (buffer_.size() - pos >= kHeaderSize) {
+    const char* header = buffer_.data() + pos;
+    const uint64 length = core::DecodeFixed64(header);
+    const uint32 masked_crc = core::DecodeFixed32(header + sizeof(uint64));
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(header, sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", buffer_offset_ + pos);
+    }
+    if (length > buffer_.size() - pos - kHeaderSize ||
+        buffer_.size() - pos - kHeaderSize - length < kFooterSize) {
+      break;
+    }
+    Record record;
+    record.data.assign(header + kHeaderSize, length);
+    record.masked_crc = core::DecodeFixed32(header + kHeaderSize + length);
+    pos += kHeaderSize + length + kFooterSize;
+    record.end_offset = buffer_offset_ + pos;
+    records.push_back(std::move(record));
+  }
+  buffer_.erase(0, pos);
+  buffer_offset_ += pos;
+
+  TF_RETURN_IF_ERROR(VerifyRecords(records));
+  for (Record& record : records) {
+    records_.push_back(std::move(record));
+  }
+  return Status::OK();
+}
+
+Status ParallelRecordReader::VerifyRecords(const std::vector<Record>& records) {
+  // Splits the records into shards of at least `kMinVerifyShardBytes`.
+  std::vector<std::pair<size_t, size_t>> shards;
+  size_t shard_begin = 0;
+  size_t shard_bytes = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    shard_bytes += records[i].data.size();
+    if (shard_bytes >= kMinVerifyShardBytes || i + 1 == records.size()) {
+      shards.emplace_back(shard_begin, i + 1);
+      shard_begin = i + 1;
+      shard_bytes = 0;
+    }
+  }
+  auto verify = [&records](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Record& record = records[i];
+      if (crc32c::Unmask(record.masked_crc) !=
+          crc32c::Value(record.data.data(), record.data.size())) {
+        return errors::DataLoss("corrupted record at ",
+                                record.end_offset - kFooterSize -
+                                    record.data.size() - kHeaderSize);
+      }
+    }
+    return Status::OK();
+  };
+  if (shards.size() <= 1) {
+    return shards.empty() ? Status::OK()
+                          : verify(shards[0].first, shards[0].second);
+  }
+  // Verify the first shard on this thread, and the others in parallel.
+  std::vector<Status> statuses(shards.size());
+  std::vector<Notification> done(shards.size());
+  for (size_t i = 1; i < shards.size(); ++i) {
+    compute_runner_([&verify, &shards, &statuses, &done, i]() {
+      statuses[i] = verify(shards[i].first, shards[i].second);
+      done[i].Notify();
+    });
+  }
+  statuses[0] = verify(shards[0].first, shards[0].second);
+  for (size_t i = 1; i < shards.size(); ++i) {
+    done[i].WaitForNotification();
+  }
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+void ParallelRecordReader::CancelReads() {
+  for (const auto& block : blocks_) {
+    block->done.WaitForNotification();
+  }
+  if (!blocks_.empty()) {
+    next_read_offset_ = blocks_.front()->offset;
+  }
+  blocks_.clear();
+}
+
 }  // namespace io
 }  // namespace tensorflow
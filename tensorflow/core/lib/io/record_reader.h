@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_LIB_IO_RECORD_READER_H_
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -55,6 +60,10 @@ class RecordReaderOptions {
 //
 // If using compression or buffering, consider using SequentialRecordReader.
 //
+// Reads are synchronous, since they go through an InputStreamInterface, which
+// has no asynchronous reads. To overlap reads with processing, including
+// through RandomAccessFile::ReadAsync(), use ParallelRecordReader.
+//
 // Note: this class is not thread safe; external synchronization required.
 class RecordReader {
  public:
@@ -119,6 +128,81 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// Reads uncompressed TFRecord files sequentially, with readahead.
+//
+// The file is read in blocks of `block_size` bytes, and up to
+// `num_readahead_blocks` reads are outstanding at once on `io_runner`, which
+// should run closures on threads that may block, or through
+// RandomAccessFile::ReadAsync() if the file supports it. The data checksums
+// of the records in each block are verified in parallel on `compute_runner`.
+// Records are returned in file order.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ParallelRecordReader {
+ public:
+  typedef std::function<void(std::function<void()>)> Runner;
+
+  struct Options {
+    size_t block_size = 1 << 20;
+    int num_readahead_blocks = 4;
+  };
+
+  // Create a reader that will return log records from "*file".
+  // "*file" must remain live while this Reader is in use.
+  ParallelRecordReader(RandomAccessFile* file, const Options& options,
+                       Runner io_runner, Runner compute_runner);
+
+  // Waits for the outstanding reads.
+  ~ParallelRecordReader();
+
+  // Reads the next record in the file into *record. Returns OK on success,
+  // OUT_OF_RANGE for end of file, or something else for an error.
+  Status ReadRecord(string* record);
+
+  // Returns the offset in the file of the next record.
+  uint64 TellOffset() const { return offset_; }
+
+  // Discards the readahead, and continues reading at `offset`, which must be
+  // the offset of a record.
+  Status SeekOffset(uint64 offset);
+
+ private:
+  struct Block;
+  struct Record {
+    string data;
+    uint32 masked_crc;
+    // The offset of the next record.
+    uint64 end_offset;
+  };
+
+  // Issues reads until `num_readahead_blocks` are outstanding.
+  void ScheduleReads();
+  // Waits for the next block, and parses and verifies its records.
+  Status ReadBlock();
+  // Verifies the checksums of `records`, in parallel if they are large.
+  Status VerifyRecords(const std::vector<Record>& records);
+  // Waits for and drops the outstanding reads.
+  void CancelReads();
+
+  RandomAccessFile* const file_;
+  const Options options_;
+  const Runner io_runner_;
+  const Runner compute_runner_;
+
+  // The blocks that have been scheduled, in file order.
+  std::deque<std::shared_ptr<Block>> blocks_;
+  uint64 next_read_offset_ = 0;
+  bool eof_ = false;
+  // The bytes after the last parsed record, starting at `buffer_offset_`.
+  string buffer_;
+  uint64 buffer_offset_ = 0;
+  // Verified records that have not been returned yet.
+  std::deque<Record> records_;
+  uint64 offset_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ParallelRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -18,14 +18,17 @@ limitations under the License.
 
 #include <zlib.h>
 #include <vector>
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -189,4 +192,188 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+namespace {
+
+// Writes `num_records` records of various sizes to `fname`, and returns them.
+std::vector<string> WriteRecords(const string& fname, int num_records) {
+  std::vector<string> records;
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  io::RecordWriter writer(file.get());
+  for (int i = 0; i < num_records; ++i) {
+    records.push_back(string((i * 37) % 1000, 'a' + i % 26));
+    TF_CHECK_OK(writer.WriteRecord(records.back()));
+  }
+  TF_CHECK_OK(writer.Flush());
+  TF_CHECK_OK(file->Close());
+  return records;
+}
+
+io::ParallelRecordReader::Runner PoolRunner(thread::ThreadPool* pool) {
+  return [pool](std::function<void()> fn) { pool->Schedule(std::move(fn)); };
+}
+
+}  // namespace
+
+TEST(ParallelRecordReaderTest, ReadsRecordsInOrder) {
+  const string fname = testing::TmpDir() + "/parallel_record_reader_test";
+  const std::vector<string> records = WriteRecords(fname, 500);
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+
+  // Blocks smaller than a header, smaller than a record, and larger than the
+  // file.
+  for (size_t block_size : {5, 100, 4096, 1 << 20}) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+    io::ParallelRecordReader::Options options;
+    options.block_size = block_size;
+    options.num_readahead_blocks = 3;
+    io::ParallelRecordReader reader(file.get(), options, PoolRunner(&pool),
+                                    PoolRunner(&pool));
+    string record;
+    for (const string& expected : records) {
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(expected, record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+    EXPECT_EQ(GetFileSize(fname), reader.TellOffset());
+  }
+}
+
+TEST(ParallelRecordReaderTest, SeekOffset) {
+  const string fname = testing::TmpDir() + "/parallel_record_reader_seek_test";
+  const std::vector<string> records = WriteRecords(fname, 100);
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  io::ParallelRecordReader::Options options;
+  options.block_size = 512;
+  io::ParallelRecordReader reader(file.get(), options, PoolRunner(&pool),
+                                  PoolRunner(&pool));
+  string record;
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+  }
+  const uint64 offset = reader.TellOffset();
+  for (int i = 10; i < 50; ++i) {
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+  }
+  TF_ASSERT_OK(reader.SeekOffset(offset));
+  for (int i = 10; i < 100; ++i) {
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(records[i], record);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+}
+
+TEST(ParallelRecordReaderTest, CorruptAndTruncatedRecords) {
+  const string fname = testing::TmpDir() + "/parallel_record_reader_bad_test";
+  WriteRecords(fname, 100);
+  string contents;
+  TF_CHECK_OK(ReadFileToString(Env::Default(), fname, &contents));
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  io::ParallelRecordReader::Options options;
+  options.block_size = 256;
+
+  auto read_all = [&](const string& data) {
+    TF_CHECK_OK(WriteStringToFile(Env::Default(), fname, data));
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+    io::ParallelRecordReader reader(file.get(), options, PoolRunner(&pool),
+                                    PoolRunner(&pool));
+    string record;
+    Status s;
+    while (s.ok()) {
+      s = reader.ReadRecord(&record);
+    }
+    return s;
+  };
+
+  // Flip a byte in the data of the last record.
+  string corrupt = contents;
+  corrupt[corrupt.size() - 10] ^= 1;
+  EXPECT_TRUE(errors::IsDataLoss(read_all(corrupt)));
+  // Flip a byte in the length of the first record.
+  corrupt = contents;
+  corrupt[0] ^= 1;
+  EXPECT_TRUE(errors::IsDataLoss(read_all(corrupt)));
+  // Truncate the last record.
+  EXPECT_TRUE(
+      errors::IsDataLoss(read_all(contents.substr(0, contents.size() - 3))));
+  EXPECT_TRUE(errors::IsOutOfRange(read_all(contents)));
+}
+
+namespace {
+
+// A file whose reads take at least `latency_micros`, to stand in for a
+// high-latency file system.
+class SlowRandomAccessFile : public RandomAccessFile {
+ public:
+  SlowRandomAccessFile(RandomAccessFile* file, int64 latency_micros)
+      : file_(file), latency_micros_(latency_micros) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    Env::Default()->SleepForMicroseconds(latency_micros_);
+    return file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  RandomAccessFile* const file_;
+  const int64 latency_micros_;
+};
+
+}  // namespace
+
+// Reads a 64MB file of 100KB records, where each read has 2ms of latency,
+// with `SequentialRecordReader` (num_readahead_blocks == 0) or with
+// `ParallelRecordReader`.
+static void BM_ReadSlowFile(int iters, int num_readahead_blocks) {
+  testing::StopTiming();
+  const string fname = testing::TmpDir() + "/record_reader_benchmark";
+  const int kNumRecords = 640;
+  const size_t kBlockSize = 1 << 20;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    const string record(100 << 10, 'x');
+    for (int i = 0; i < kNumRecords; ++i) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(file->Close());
+  }
+  std::unique_ptr<RandomAccessFile> base_file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &base_file));
+  SlowRandomAccessFile file(base_file.get(), 2000);
+  thread::ThreadPool io_pool(Env::Default(), "io", 16);
+  thread::ThreadPool compute_pool(Env::Default(), "compute",
+                                  port::NumSchedulableCPUs());
+  testing::StartTiming();
+  string record;
+  for (int i = 0; i < iters; ++i) {
+    if (num_readahead_blocks == 0) {
+      io::RecordReaderOptions options;
+      options.buffer_size = kBlockSize;
+      io::SequentialRecordReader reader(&file, options);
+      for (int j = 0; j < kNumRecords; ++j) {
+        TF_CHECK_OK(reader.ReadRecord(&record));
+      }
+    } else {
+      io::ParallelRecordReader::Options options;
+      options.block_size = kBlockSize;
+      options.num_readahead_blocks = num_readahead_blocks;
+      io::ParallelRecordReader reader(&file, options, PoolRunner(&io_pool),
+                                      PoolRunner(&compute_pool));
+      for (int j = 0; j < kNumRecords; ++j) {
+        TF_CHECK_OK(reader.ReadRecord(&record));
+      }
+    }
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumRecords);
+  testing::BytesProcessed(static_cast<int64>(iters) * GetFileSize(fname));
+}
+BENCHMARK(BM_ReadSlowFile)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace tensorflow
@@ -28,6 +28,9 @@ REGISTER_OP("CollectiveReduce")
     .Attr("merge_op: {'Min', 'Max', 'Mul', 'Add'}")
     .Attr("final_op: {'Id', 'Div'}")
     .Attr("subdiv_offsets: list(int)")
+    .Attr(
+        "collective_name: {'auto', 'RingReduce', 'HalvingDoublingReduce', "
+        "'HierarchicalReduce'} = 'auto'")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
@@ -52,4 +55,50 @@ REGISTER_OP("CollectiveBcastRecv")
     .SetIsStateful()
     .SetShapeFn(shape_inference::ExplicitShape);
 
+REGISTER_OP("CollectiveGather")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: {float, float64, int32, int64}")
+    .Attr("group_size: int")
+    .Attr("group_key: int")
+    .Attr("instance_key: int")
+    .SetIsStateful()
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &input));
+      int64 group_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("group_size", &group_size));
+      shape_inference::DimensionHandle output_dim0;
+      TF_RETURN_IF_ERROR(
+          c->Multiply(c->Dim(input, 0), group_size, &output_dim0));
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(input, 0, output_dim0, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
+REGISTER_OP("CollectiveReduceScatter")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: {float, float64, int32, int64}")
+    .Attr("group_size: int")
+    .Attr("group_key: int")
+    .Attr("instance_key: int")
+    .Attr("merge_op: {'Min', 'Max', 'Mul', 'Add'}")
+    .Attr("final_op: {'Id', 'Div'}")
+    .SetIsStateful()
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &input));
+      int64 group_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("group_size", &group_size));
+      shape_inference::DimensionHandle output_dim0;
+      TF_RETURN_IF_ERROR(c->Divide(c->Dim(input, 0), group_size,
+                                   true /* evenly_divisible */, &output_dim0));
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(input, 0, output_dim0, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
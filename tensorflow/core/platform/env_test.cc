@@ -19,14 +19,18 @@ limitations under the License.
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/null_file_system.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -84,6 +88,38 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadAsync) {
+  const string filename = io::JoinPath(BaseDir(), "read_async");
+  const string input = CreateTestFile(env_, filename, 100000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_ASSERT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // Many small reads, one across EOF and one past it.
+  const int kNumRequests = 1000;
+  std::vector<RandomAccessFile::ReadRequest> requests(kNumRequests + 2);
+  std::vector<char> scratch(requests.size() * 100);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    requests[i].offset = (i * 9973) % (input.size() - 100);
+    requests[i].n = 100;
+    requests[i].scratch = &scratch[i * 100];
+  }
+  requests[kNumRequests].offset = input.size() - 50;
+  requests[kNumRequests + 1].offset = input.size() + 10;
+  Notification done;
+  f->ReadAsync(requests.data(), requests.size(), [&done]() { done.Notify(); });
+  done.WaitForNotification();
+
+  for (int i = 0; i < kNumRequests; ++i) {
+    const auto& request = requests[i];
+    TF_EXPECT_OK(request.status);
+    EXPECT_EQ(input.substr(request.offset, 100), request.result);
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, requests[kNumRequests].status.code());
+  EXPECT_EQ(input.substr(input.size() - 50), requests[kNumRequests].result);
+  EXPECT_EQ(error::OUT_OF_RANGE, requests[kNumRequests + 1].status.code());
+  EXPECT_TRUE(requests[kNumRequests + 1].result.empty());
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1}) {
@@ -377,4 +413,61 @@ TEST_F(DefaultEnvTest, CreateUniqueFileName) {
   EXPECT_TRUE(str_util::EndsWith(filename, suffix));
 }
 
+// Reads 4KB blocks at random offsets of a 64MB file, in batches of
+// "batch_size", either with ReadAsync() from this thread or with blocking
+// Read() calls on a pool of "batch_size" threads.
+static void BM_RandomReads(int iters, bool async, int batch_size) {
+  testing::StopTiming();
+  Env* env = Env::Default();
+  const string filename = io::JoinPath(testing::TmpDir(), "bm_random_reads");
+  const size_t kFileSize = 64 << 20;
+  const size_t kBlockSize = 4096;
+  TF_CHECK_OK(WriteStringToFile(env, filename, string(kFileSize, 'x')));
+  std::unique_ptr<RandomAccessFile> f;
+  TF_CHECK_OK(env->NewRandomAccessFile(filename, &f));
+  std::vector<RandomAccessFile::ReadRequest> requests(batch_size);
+  std::vector<char> scratch(batch_size * kBlockSize);
+  thread::ThreadPool pool(env, "bm_random_reads", batch_size);
+  uint64 offset = 0;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < batch_size; ++j) {
+      offset = (offset + 7919 * kBlockSize) % (kFileSize - kBlockSize);
+      requests[j] = RandomAccessFile::ReadRequest();
+      requests[j].offset = offset;
+      requests[j].n = kBlockSize;
+      requests[j].scratch = &scratch[j * kBlockSize];
+    }
+    if (async) {
+      Notification done;
+      f->ReadAsync(requests.data(), batch_size, [&done]() { done.Notify(); });
+      done.WaitForNotification();
+    } else {
+      BlockingCounter counter(batch_size);
+      for (auto& request : requests) {
+        pool.Schedule([&f, &request, &counter]() {
+          request.status = f->Read(request.offset, request.n, &request.result,
+                                   request.scratch);
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+    }
+  }
+  testing::StopTiming();
+  for (const auto& request : requests) TF_CHECK_OK(request.status);
+  testing::BytesProcessed(static_cast<int64>(iters) * batch_size * kBlockSize);
+  TF_CHECK_OK(env->DeleteFile(filename));
+}
+
+static void BM_RandomReadsBlocking(int iters, int batch_size) {
+  BM_RandomReads(iters, false, batch_size);
+}
+BENCHMARK(BM_RandomReadsBlocking)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_RandomReadsAsync(int iters, int batch_size) {
+  BM_RandomReads(iters, true, batch_size);
+}
+BENCHMARK(BM_RandomReadsAsync)->Arg(1)->Arg(16)->Arg(64);
+
 }  // namespace tensorflow
@@ -51,6 +51,16 @@ void FileSystem::FlushCaches() {}
 
 RandomAccessFile::~RandomAccessFile() {}
 
+void RandomAccessFile::ReadAsync(ReadRequest* requests, size_t num_requests,
+                                 std::function<void()> done) const {
+  for (size_t i = 0; i < num_requests; ++i) {
+    ReadRequest& request = requests[i];
+    request.status =
+        Read(request.offset, request.n, &request.result, request.scratch);
+  }
+  done();
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
@@ -238,6 +238,32 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief A read of up to `n` bytes at `offset` into `scratch[0..n-1]`,
+  /// for `ReadAsync()`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    char* scratch = nullptr;
+    /// Set once the read is done, as by `Read()`.
+    StringPiece result;
+    Status status;
+  };
+
+  /// \brief Reads `requests[0..num_requests-1]` as `Read()` would, and calls
+  /// `done` once all of them are done, possibly from another thread.
+  ///
+  /// The requests and their `scratch` buffers must stay live until `done` is
+  /// called.  The default implementation calls `Read()` for each request on
+  /// the calling thread; see `SupportsAsyncRead()`.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadAsync(ReadRequest* requests, size_t num_requests,
+                         std::function<void()> done) const;
+
+  /// \brief Returns true if `ReadAsync()` returns before the reads are done,
+  /// rather than reading on the calling thread.
+  virtual bool SupportsAsyncRead() const { return false; }
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
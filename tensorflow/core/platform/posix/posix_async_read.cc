@@ -0,0 +1,378 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/posix/posix_async_read.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/error_codes.pb.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/posix/error.h"
+
+// See if the io_uring interface of Linux 5.1 and later can be compiled in.
+// Whether the running kernel supports it is checked at runtime.
+#undef TF_USE_IO_URING
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define TF_USE_IO_URING 1
+#endif
+#endif
+#endif
+
+namespace tensorflow {
+
+Status PosixPread(int fd, const string& filename, uint64 offset, size_t n,
+                  StringPiece* result, char* scratch) {
+  Status s;
+  char* dst = scratch;
+  while (n > 0 && s.ok()) {
+    ssize_t r = pread(fd, dst, n, static_cast<off_t>(offset));
+    if (r > 0) {
+      dst += r;
+      n -= r;
+      offset += r;
+    } else if (r == 0) {
+      s = Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    } else if (errno == EINTR || errno == EAGAIN) {
+      // Retry
+    } else {
+      s = IOError(filename, errno);
+    }
+  }
+  *result = StringPiece(scratch, dst - scratch);
+  return s;
+}
+
+namespace {
+
+// The reads of one call to PosixAsyncReader::Read().
+class ReadBatch {
+ public:
+  ReadBatch(size_t num_requests, std::function<void()> done)
+      : pending_(num_requests), done_(std::move(done)) {}
+
+  // Called once per request.  Calls "done" and deletes the batch after the
+  // last one.
+  void RequestDone() {
+    if (pending_.fetch_sub(1) == 1) {
+      std::function<void()> done = std::move(done_);
+      delete this;
+      done();
+    }
+  }
+
+ private:
+  std::atomic<size_t> pending_;
+  std::function<void()> done_;
+};
+
+// Issues pread() calls on a pool of threads.
+class ThreadPoolAsyncReader : public PosixAsyncReader {
+ public:
+  ThreadPoolAsyncReader()
+      : thread_pool_(Env::Default(), "posix_async_read", kNumThreads) {}
+
+  void Read(int fd, const string& filename,
+            RandomAccessFile::ReadRequest* requests, size_t num_requests,
+            std::function<void()> done) override {
+    if (num_requests == 0) {
+      done();
+      return;
+    }
+    ReadBatch* batch = new ReadBatch(num_requests, std::move(done));
+    const string* filename_ptr = &filename;
+    for (size_t i = 0; i < num_requests; ++i) {
+      RandomAccessFile::ReadRequest* request = &requests[i];
+      thread_pool_.Schedule([fd, filename_ptr, request, batch]() {
+        request->status =
+            PosixPread(fd, *filename_ptr, request->offset, request->n,
+                       &request->result, request->scratch);
+        batch->RequestDone();
+      });
+    }
+  }
+
+  const char* backend() const override { return "thread_pool"; }
+
+ private:
+  static const int kNumThreads = 16;
+
+  thread::ThreadPool thread_pool_;
+};
+
+#ifdef TF_USE_IO_URING
+
+// Submits reads to an io_uring submission queue, and reaps them from its
+// completion queue on a dedicated thread.
+class IoUringAsyncReader : public PosixAsyncReader {
+ public:
+  // Returns nullptr if the kernel does not support io_uring.
+  static IoUringAsyncReader* Create() {
+    std::unique_ptr<IoUringAsyncReader> reader(new IoUringAsyncReader);
+    if (!reader->Init()) return nullptr;
+    IoUringAsyncReader* reader_ptr = reader.get();
+    reader->completion_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "io_uring_completions",
+        [reader_ptr]() { reader_ptr->CompletionLoop(); }));
+    return reader.release();
+  }
+
+  // Only called if Init() fails: the reader returned by Create() is never
+  // destroyed, as its completion thread runs forever.
+  ~IoUringAsyncReader() override {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr) munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+  }
+
+  void Read(int fd, const string& filename,
+            RandomAccessFile::ReadRequest* requests, size_t num_requests,
+            std::function<void()> done) override {
+    if (num_requests == 0) {
+      done();
+      return;
+    }
+    ReadBatch* batch = new ReadBatch(num_requests, std::move(done));
+    mutex_lock l(mu_);
+    unsigned to_submit = 0;
+    for (size_t i = 0; i < num_requests; ++i) {
+      Op* op = new Op;
+      op->fd = fd;
+      op->filename = &filename;
+      op->request = &requests[i];
+      op->batch = batch;
+      // Bounds the number of outstanding reads by the size of the submission
+      // queue, which keeps the completion queue from overflowing.
+      while (num_outstanding_ >= num_entries_) {
+        Enter(&to_submit);
+        space_cv_.wait(l);
+      }
+      ++num_outstanding_;
+      Prepare(op);
+      ++to_submit;
+    }
+    Enter(&to_submit);
+  }
+
+  const char* backend() const override { return "io_uring"; }
+
+ private:
+  // An outstanding read.
+  struct Op {
+    int fd;
+    const string* filename;
+    RandomAccessFile::ReadRequest* request;
+    ReadBatch* batch;
+    size_t bytes_read = 0;
+    struct iovec iov;
+  };
+
+  IoUringAsyncReader() {}
+
+  bool Init() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, kRingEntries, &params);
+    if (ring_fd_ < 0) {
+      VLOG(1) << "io_uring is not available: " << strerror(errno);
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = Map(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_ = static_cast<struct io_uring_sqe*>(Map(sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+      return false;
+    }
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    num_entries_ = params.sq_entries;
+    return true;
+  }
+
+  // Maps the part of the ring at "offset" into memory, or returns nullptr.
+  void* Map(size_t size, off_t offset) {
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    if (ptr == MAP_FAILED) {
+      LOG(WARNING) << "Failed to map io_uring: " << strerror(errno);
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  // Adds the remaining part of the read "op" to the submission queue.  Only
+  // threads holding "mu_" write to the submission queue, and they submit the
+  // entries they add before releasing it.
+  void Prepare(Op* op) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    op->iov.iov_base = op->request->scratch + op->bytes_read;
+    op->iov.iov_len = op->request->n - op->bytes_read;
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = op->fd;
+    sqe->off = op->request->offset + op->bytes_read;
+    sqe->addr = reinterpret_cast<uint64>(&op->iov);
+    sqe->len = 1;
+    sqe->user_data = reinterpret_cast<uint64>(op);
+    sq_array_[index] = index;
+    // Publishes the entry to the kernel.
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  // Submits the "*to_submit" prepared entries.
+  void Enter(unsigned* to_submit) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (*to_submit > 0) {
+      const int ret =
+          syscall(__NR_io_uring_enter, ring_fd_, *to_submit, 0, 0, nullptr, 0);
+      if (ret >= 0) {
+        *to_submit -= ret;
+      } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG(FATAL) << "io_uring_enter failed: " << strerror(errno);
+      }
+    }
+  }
+
+  void CompletionLoop() {
+    std::vector<std::pair<Op*, int>> completions;
+    while (true) {
+      const int ret = syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                              IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (ret < 0 && errno != EINTR) {
+        LOG(FATAL) << "io_uring_enter failed: " << strerror(errno);
+      }
+      // Only this thread reads the completion queue.
+      unsigned head = *cq_head_;
+      const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const struct io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+        completions.emplace_back(reinterpret_cast<Op*>(cqe->user_data),
+                                 cqe->res);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      for (const auto& completion : completions) {
+        Complete(completion.first, completion.second);
+      }
+      completions.clear();
+    }
+  }
+
+  // Handles the result "res" of the read "op": a number of bytes read, or a
+  // negated errno.
+  void Complete(Op* op, int res) {
+    RandomAccessFile::ReadRequest* request = op->request;
+    Status status;
+    if (res > 0) {
+      op->bytes_read += res;
+    } else if (res == 0) {
+      status = Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    } else if (res != -EINTR && res != -EAGAIN) {
+      status = IOError(*op->filename, -res);
+    }
+    if (status.ok() && op->bytes_read < request->n) {
+      // Reads the rest, as pread() is retried by PosixPread().
+      mutex_lock l(mu_);
+      unsigned to_submit = 1;
+      Prepare(op);
+      Enter(&to_submit);
+      return;
+    }
+    request->result = StringPiece(request->scratch, op->bytes_read);
+    request->status = status;
+    ReadBatch* batch = op->batch;
+    delete op;
+    {
+      mutex_lock l(mu_);
+      --num_outstanding_;
+    }
+    space_cv_.notify_one();
+    batch->RequestDone();
+  }
+
+  static const unsigned kRingEntries = 256;
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe* cqes_ = nullptr;
+  unsigned num_entries_ = 0;
+
+  mutex mu_;
+  condition_variable space_cv_;
+  unsigned num_outstanding_ GUARDED_BY(mu_) = 0;
+
+  std::unique_ptr<Thread> completion_thread_;
+};
+
+#endif  // TF_USE_IO_URING
+
+PosixAsyncReader* CreateAsyncReader() {
+#ifdef TF_USE_IO_URING
+  const char* disable = getenv("TF_DISABLE_IO_URING");
+  if (disable == nullptr || strcmp(disable, "1") != 0) {
+    PosixAsyncReader* reader = IoUringAsyncReader::Create();
+    if (reader != nullptr) return reader;
+  }
+#endif  // TF_USE_IO_URING
+  return new ThreadPoolAsyncReader;
+}
+
+}  // namespace
+
+PosixAsyncReader* PosixAsyncReader::Global() {
+  static PosixAsyncReader* reader = CreateAsyncReader();
+  return reader;
+}
+
+}  // namespace tensorflow
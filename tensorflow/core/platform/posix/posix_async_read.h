@@ -0,0 +1,60 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_POSIX_POSIX_ASYNC_READ_H_
+#define TENSORFLOW_CORE_PLATFORM_POSIX_POSIX_ASYNC_READ_H_
+
+#include <functional>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Reads up to "n" bytes at "offset" from "fd" with pread(), as
+// RandomAccessFile::Read() does.  "filename" is used in error messages.
+Status PosixPread(int fd, const string& filename, uint64 offset, size_t n,
+                  StringPiece* result, char* scratch);
+
+// Serves RandomAccessFile::ReadAsync() for POSIX files.
+//
+// On Linux kernels that support io_uring, the reads of a batch are submitted
+// to a ring with a single system call, and a single thread reaps their
+// completions, so outstanding reads do not hold a thread each.  Elsewhere, or
+// if the environment variable TF_DISABLE_IO_URING is set to 1, the reads are
+// issued with pread() on a shared pool of threads.
+class PosixAsyncReader {
+ public:
+  // Returns the process-wide reader.
+  static PosixAsyncReader* Global();
+
+  virtual ~PosixAsyncReader() {}
+
+  // Reads "requests[0..num_requests-1]" from "fd" and calls "done" once all
+  // of them are done, on one of the reader's threads, where it should not
+  // block.  "fd" and "filename" must stay live until then.
+  virtual void Read(int fd, const string& filename,
+                    RandomAccessFile::ReadRequest* requests,
+                    size_t num_requests, std::function<void()> done) = 0;
+
+  // Either "io_uring" or "thread_pool".
+  virtual const char* backend() const = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_POSIX_POSIX_ASYNC_READ_H_
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/posix/error.h"
+#include "tensorflow/core/platform/posix/posix_async_read.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -54,25 +55,16 @@ class PosixRandomAccessFile : public RandomAccessFile {
 
   Status Read(uint64 offset, size_t n, StringPiece* result,
               char* scratch) const override {
-    Status s;
-    char* dst = scratch;
-    while (n > 0 && s.ok()) {
-      ssize_t r = pread(fd_, dst, n, static_cast<off_t>(offset));
-      if (r > 0) {
-        dst += r;
-        n -= r;
-        offset += r;
-      } else if (r == 0) {
-        s = Status(error::OUT_OF_RANGE, "Read less bytes than requested");
-      } else if (errno == EINTR || errno == EAGAIN) {
-        // Retry
-      } else {
-        s = IOError(filename_, errno);
-      }
-    }
-    *result = StringPiece(scratch, dst - scratch);
-    return s;
+    return PosixPread(fd_, filename_, offset, n, result, scratch);
   }
+
+  void ReadAsync(ReadRequest* requests, size_t num_requests,
+                 std::function<void()> done) const override {
+    PosixAsyncReader::Global()->Read(fd_, filename_, requests, num_requests,
+                                     std::move(done));
+  }
+
+  bool SupportsAsyncRead() const override { return true; }
 };
 
 class PosixWritableFile : public WritableFile {
@@ -0,0 +1,154 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+
+namespace tensorflow {
+
+struct AsyncBundleWriter::PendingWrite {
+  int64 id;
+  string prefix;
+  int64 bytes = 0;
+  std::vector<Tensor> tensors;  // The staging copies.
+  std::vector<BundleWriteItem> items;  // Pointing into "tensors".
+};
+
+AsyncBundleWriter::AsyncBundleWriter(Env* env, const Options& options)
+    : env_(env),
+      options_(options),
+      thread_pool_(new thread::ThreadPool(env, "async_bundle_writer",
+                                          std::max(1, options.num_threads))) {}
+
+AsyncBundleWriter::~AsyncBundleWriter() { thread_pool_.reset(); }
+
+int64 AsyncBundleWriter::Write(StringPiece prefix,
+                               gtl::ArraySlice<BundleWriteItem> items) {
+  std::unique_ptr<PendingWrite> write(new PendingWrite);
+  write->prefix = std::string(prefix);
+  for (const BundleWriteItem& item : items) {
+    write->bytes += item.tensor->TotalBytes();
+  }
+  {
+    mutex_lock l(mu_);
+    while (options_.max_staging_bytes > 0 && staging_bytes_ > 0 &&
+           staging_bytes_ + write->bytes > options_.max_staging_bytes) {
+      staging_cv_.wait(l);
+    }
+    staging_bytes_ += write->bytes;
+    write->id = next_id_++;
+    unfinished_.insert(write->id);
+  }
+
+  // Copies outside of the lock, so that concurrent callers copy in parallel.
+  write->tensors.reserve(items.size());
+  write->items.assign(items.begin(), items.end());
+  for (BundleWriteItem& item : write->items) {
+    write->tensors.push_back(tensor::DeepCopy(*item.tensor));
+    item.tensor = &write->tensors.back();
+  }
+  const int64 id = write->id;
+  PendingWrite* raw_write = write.release();
+  thread_pool_->Schedule([this, raw_write]() {
+    DoWrite(std::unique_ptr<PendingWrite>(raw_write));
+  });
+  return id;
+}
+
+void AsyncBundleWriter::DoWrite(std::unique_ptr<PendingWrite> write) {
+  const Status status = WriteBundleParallel(
+      env_, write->prefix, write->items, /*num_shards=*/1,
+      [](std::function<void()> fn) { fn(); });
+  if (!status.ok()) {
+    LOG(WARNING) << "Asynchronous write of " << write->prefix
+                 << " failed: " << status;
+  }
+  const int64 id = write->id;
+  const int64 bytes = write->bytes;
+  write.reset();  // Releases the staging tensors.
+
+  std::function<void(const Status&)> done;
+  {
+    mutex_lock l(mu_);
+    staging_bytes_ -= bytes;
+    unfinished_.erase(id);
+    auto it = waiters_.find(id);
+    if (it == waiters_.end()) {
+      results_[id] = status;
+      if (options_.max_retained_results > 0 &&
+          results_.size() >
+              static_cast<size_t>(options_.max_retained_results)) {
+        results_.erase(results_.begin());
+      }
+    } else {
+      done = std::move(it->second);
+      waiters_.erase(it);
+    }
+  }
+  staging_cv_.notify_all();
+  if (done) done(status);
+}
+
+void AsyncBundleWriter::WaitAsync(int64 id,
+                                  std::function<void(const Status&)> done) {
+  Status status;
+  {
+    mutex_lock l(mu_);
+    if (unfinished_.count(id) > 0) {
+      if (waiters_.count(id) > 0) {
+        status = errors::InvalidArgument("Write ", id,
+                                         " is already being waited for");
+      } else {
+        waiters_[id] = std::move(done);
+        return;
+      }
+    } else {
+      auto it = results_.find(id);
+      if (it == results_.end()) {
+        status = errors::InvalidArgument(
+            "Unknown write ", id,
+            ", or its result was already returned or no longer retained");
+      } else {
+        status = it->second;
+        results_.erase(it);
+      }
+    }
+  }
+  done(status);
+}
+
+Status AsyncBundleWriter::Wait(int64 id) {
+  Notification n;
+  Status status;
+  WaitAsync(id, [&n, &status](const Status& s) {
+    status = s;
+    n.Notify();
+  });
+  n.WaitForNotification();
+  return status;
+}
+
+int64 AsyncBundleWriter::staging_bytes() const {
+  mutex_lock l(mu_);
+  return staging_bytes_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,119 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes tensor bundles in the background.
+//
+// AsyncBundleWriter::Write() copies the tensors to save into staging tensors
+// and returns, while serialization, checksumming and file I/O of the bundle
+// happen on a thread pool owned by the writer.  The staging memory held by
+// pending writes is bounded: Write() blocks until earlier writes release
+// enough of it.
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+// Thread-safe.
+class AsyncBundleWriter {
+ public:
+  struct Options {
+    Options() {}
+    // The number of bundles written concurrently.  Writes to the same prefix
+    // must be waited for in between unless "num_threads" is 1, in which case
+    // writes happen in the order of the calls to Write().
+    int num_threads{1};
+    // The maximum number of bytes of staging tensors held by pending writes,
+    // or 0 for no limit.  A single write larger than the limit proceeds once
+    // no other write is pending.
+    int64 max_staging_bytes{0};
+    // The maximum number of results of finished writes kept until they are
+    // waited for, or 0 for no limit.  Beyond it the oldest results are
+    // dropped, so that writes that are never waited for do not accumulate.
+    int max_retained_results{1024};
+  };
+
+  AsyncBundleWriter(Env* env, const Options& options = Options());
+
+  // Waits for all pending writes.
+  ~AsyncBundleWriter();
+
+  // Copies the tensors of "items" and schedules writing them to the bundle
+  // at "prefix", as WriteBundleParallel() with a single shard would.  Blocks
+  // while the staging memory is exhausted.  Returns the id of the write, to
+  // pass to "Wait()" or "WaitAsync()" exactly once.
+  int64 Write(StringPiece prefix, gtl::ArraySlice<BundleWriteItem> items);
+
+  // Calls "done" with the result of the write "id" once it is finished,
+  // possibly from the calling thread.  Calls it with an InvalidArgument error
+  // if the result was already returned, or was dropped because more than
+  // "Options::max_retained_results" later writes finished before this call.
+  // Failed writes are logged when they finish, so a dropped failure is not
+  // silent.
+  void WaitAsync(int64 id, std::function<void(const Status&)> done);
+
+  // Blocks until the write "id" is finished and returns its result.
+  Status Wait(int64 id);
+
+  // The number of bytes of staging tensors currently held.
+  int64 staging_bytes() const;
+
+ private:
+  struct PendingWrite;
+
+  // Writes the bundle of "write" and reports the result.
+  void DoWrite(std::unique_ptr<PendingWrite> write);
+
+  Env* const env_;
+  const Options options_;
+
+  mutable mutex mu_;
+  condition_variable staging_cv_;
+  int64 next_id_ GUARDED_BY(mu_) = 0;
+  int64 staging_bytes_ GUARDED_BY(mu_) = 0;
+  std::unordered_set<int64> unfinished_ GUARDED_BY(mu_);
+  // The results of finished writes that were not waited for yet, by id so
+  // that the oldest can be dropped.
+  std::map<int64, Status> results_ GUARDED_BY(mu_);
+  // The callbacks waiting for unfinished writes.
+  std::unordered_map<int64, std::function<void(const Status&)>> waiters_
+      GUARDED_BY(mu_);
+
+  // Destroyed first, which waits for the scheduled writes.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncBundleWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
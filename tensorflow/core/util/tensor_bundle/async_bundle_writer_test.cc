@@ -0,0 +1,196 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& prefix) {
+  return io::JoinPath(testing::TmpDir(), prefix);
+}
+
+BundleWriteItem Item(const string& key, const Tensor* tensor) {
+  BundleWriteItem item;
+  item.key = key;
+  item.tensor = tensor;
+  return item;
+}
+
+template <typename T>
+void ExpectStored(const string& prefix, const string& key,
+                  const Tensor& expected) {
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val(expected.dtype(), expected.shape());
+  TF_ASSERT_OK(reader.Lookup(key, &val));
+  test::ExpectTensorEqual<T>(expected, val);
+}
+
+TEST(AsyncBundleWriterTest, WritesSnapshot) {
+  AsyncBundleWriter writer(Env::Default());
+  Tensor a = test::AsTensor<float>({1, 2, 3});
+  Tensor s = test::AsTensor<string>({"x", "y"});
+  TensorSlice slice;
+  TF_ASSERT_OK(TensorSlice::Parse("1,3", &slice));
+  BundleWriteItem sliced = Item("sliced", &a);
+  sliced.is_slice = true;
+  sliced.full_shape = TensorShape({4});
+  sliced.slice = slice;
+  const int64 id = writer.Write(Prefix("snapshot"),
+                                {Item("a", &a), Item("s", &s), sliced});
+
+  // Updates after Write() returns are not saved.
+  a.flat<float>().setConstant(0);
+  s.flat<string>()(0) = "z";
+  TF_ASSERT_OK(writer.Wait(id));
+  EXPECT_EQ(0, writer.staging_bytes());
+  ExpectStored<float>(Prefix("snapshot"), "a",
+                      test::AsTensor<float>({1, 2, 3}));
+  ExpectStored<string>(Prefix("snapshot"), "s",
+                       test::AsTensor<string>({"x", "y"}));
+
+  // The result of a write is returned once.
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Wait(id)));
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Wait(id + 1)));
+}
+
+TEST(AsyncBundleWriterTest, WaitAsync) {
+  AsyncBundleWriter writer(Env::Default());
+  Tensor a = test::AsTensor<int64>({1, 2});
+  const int64 first = writer.Write(Prefix("wait_async_1"), {Item("a", &a)});
+  const int64 second = writer.Write(Prefix("wait_async_2"), {Item("a", &a)});
+  EXPECT_NE(first, second);
+
+  Notification n;
+  Status status;
+  writer.WaitAsync(second, [&n, &status](const Status& s) {
+    status = s;
+    n.Notify();
+  });
+  n.WaitForNotification();
+  TF_ASSERT_OK(status);
+  TF_ASSERT_OK(writer.Wait(first));
+  ExpectStored<int64>(Prefix("wait_async_1"), "a", a);
+  ExpectStored<int64>(Prefix("wait_async_2"), "a", a);
+}
+
+TEST(AsyncBundleWriterTest, BoundedStaging) {
+  AsyncBundleWriter::Options options;
+  options.max_staging_bytes = 4 * sizeof(float);
+  AsyncBundleWriter writer(Env::Default(), options);
+  Tensor a = test::AsTensor<float>({1, 2, 3, 4});
+  Tensor big = test::AsTensor<float>({1, 2, 3, 4, 5, 6});
+  std::vector<int64> ids;
+  for (int i = 0; i < 4; ++i) {
+    ids.push_back(writer.Write(Prefix(strings::StrCat("bounded_", i)),
+                               {Item("a", &a)}));
+    EXPECT_LE(writer.staging_bytes(), options.max_staging_bytes);
+  }
+  // A write larger than the limit waits for the others.
+  ids.push_back(writer.Write(Prefix("bounded_big"), {Item("big", &big)}));
+  for (int64 id : ids) {
+    TF_ASSERT_OK(writer.Wait(id));
+  }
+  EXPECT_EQ(0, writer.staging_bytes());
+  ExpectStored<float>(Prefix("bounded_3"), "a", a);
+  ExpectStored<float>(Prefix("bounded_big"), "big", big);
+}
+
+TEST(AsyncBundleWriterTest, Error) {
+  Env* env = Env::Default();
+  TF_ASSERT_OK(WriteStringToFile(env, Prefix("not_a_directory"), "data"));
+  AsyncBundleWriter writer(env);
+  Tensor a = test::AsTensor<float>({1});
+  const int64 id = writer.Write(io::JoinPath(Prefix("not_a_directory"), "ckpt"),
+                                {Item("a", &a)});
+  EXPECT_FALSE(writer.Wait(id).ok());
+  EXPECT_EQ(0, writer.staging_bytes());
+}
+
+TEST(AsyncBundleWriterTest, RetainedResults) {
+  AsyncBundleWriter::Options options;
+  options.max_retained_results = 2;
+  AsyncBundleWriter writer(Env::Default(), options);
+  Tensor a = test::AsTensor<float>({1});
+  std::vector<int64> ids;
+  for (int i = 0; i < 4; ++i) {
+    ids.push_back(
+        writer.Write(Prefix(strings::StrCat("retained_", i)), {Item("a", &a)}));
+  }
+  // Waits for all the writes to finish without consuming their results.
+  while (writer.staging_bytes() > 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  // Only the results of the last two writes are kept.
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Wait(ids[0])));
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.Wait(ids[1])));
+  TF_EXPECT_OK(writer.Wait(ids[2]));
+  TF_EXPECT_OK(writer.Wait(ids[3]));
+  ExpectStored<float>(Prefix("retained_0"), "a", a);
+}
+
+TEST(AsyncBundleWriterTest, DestructorWaits) {
+  Tensor a = test::AsTensor<float>({1, 2});
+  {
+    AsyncBundleWriter writer(Env::Default());
+    writer.Write(Prefix("destructor"), {Item("a", &a)});
+  }
+  ExpectStored<float>(Prefix("destructor"), "a", a);
+}
+
+// Saves a 64MB tensor, timing only the part that blocks the caller: the full
+// write, or the copy made by AsyncBundleWriter::Write().
+static void BM_SaveBlocking(int iters, bool async) {
+  testing::StopTiming();
+  const int64 kTensorSize = 16 << 20;
+  Tensor t(DT_FLOAT, TensorShape({kTensorSize}));
+  t.flat<float>().setConstant(1.0f);
+  const std::vector<BundleWriteItem> items = {Item("big", &t)};
+  const string prefix = Prefix("bench_save");
+  AsyncBundleWriter writer(Env::Default());
+  testing::BytesProcessed(static_cast<int64>(iters) * t.TotalBytes());
+  for (int i = 0; i < iters; ++i) {
+    testing::StartTiming();
+    if (async) {
+      const int64 id = writer.Write(prefix, items);
+      testing::StopTiming();
+      TF_CHECK_OK(writer.Wait(id));
+    } else {
+      TF_CHECK_OK(WriteBundleParallel(Env::Default(), prefix, items, 1,
+                                      [](std::function<void()> fn) { fn(); }));
+      testing::StopTiming();
+    }
+  }
+}
+
+static void BM_SaveSync(int iters) { BM_SaveBlocking(iters, false); }
+BENCHMARK(BM_SaveSync);
+
+static void BM_SaveAsync(int iters) { BM_SaveBlocking(iters, true); }
+BENCHMARK(BM_SaveAsync);
+
+}  // namespace
+}  // namespace tensorflow
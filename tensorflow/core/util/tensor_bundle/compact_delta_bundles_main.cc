@@ -0,0 +1,42 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Folds a chain of delta checkpoints into a regular checkpoint, so that the
+// bundles of the chain can be deleted.
+
+#include <stdio.h>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/tensor_bundle/delta_bundle.h"
+
+int main(int argc, char* argv[]) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc != 3) {
+    printf("Usage: %s <delta checkpoint prefix> <output checkpoint prefix>\n",
+           argv[0]);
+    return 1;
+  }
+  tensorflow::Env* env = tensorflow::Env::Default();
+  tensorflow::DeltaBundleReader reader(env, argv[1]);
+  TF_QCHECK_OK(reader.status());
+  printf("Compacting %zu checkpoints:\n", reader.prefixes().size());
+  for (const tensorflow::string& prefix : reader.prefixes()) {
+    printf("  %s\n", prefix.c_str());
+  }
+  TF_QCHECK_OK(tensorflow::CompactDeltaBundles(env, argv[1], argv[2]));
+  printf("Wrote %s\n", argv[2]);
+  return 0;
+}
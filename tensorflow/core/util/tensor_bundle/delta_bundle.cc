@@ -0,0 +1,286 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/delta_bundle.h"
+
+#include <algorithm>
+#include <set>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/util/tensor_slice_util.h"
+
+namespace tensorflow {
+
+const char* const kDeltaBaseKey = "_DELTA_BASE_PREFIX";
+
+namespace {
+
+// Copies the intersection of the slice "src_slice" of a tensor of shape
+// "full_shape", held by "src", into "dst", which holds the slice "dst_slice".
+Status CopySliceData(const TensorShape& full_shape,
+                     const TensorSlice& src_slice, const TensorSlice& dst_slice,
+                     const Tensor& src, Tensor* dst) {
+  switch (dst->dtype()) {
+#define HANDLE_COPY(T)                                                         \
+  case DataTypeToEnum<T>::value:                                               \
+    CopyDataFromTensorSliceToTensorSlice(full_shape, src_slice, dst_slice,     \
+                                         src.flat<T>().data(),                 \
+                                         dst->flat<T>().data());               \
+    break;
+
+    HANDLE_COPY(float)
+    HANDLE_COPY(double)
+    HANDLE_COPY(int32)
+    HANDLE_COPY(uint8)
+    HANDLE_COPY(int16)
+    HANDLE_COPY(int8)
+    HANDLE_COPY(complex64)
+    HANDLE_COPY(complex128)
+    HANDLE_COPY(int64)
+    HANDLE_COPY(bool)
+    HANDLE_COPY(qint32)
+    HANDLE_COPY(quint8)
+    HANDLE_COPY(qint8)
+    default:
+      return errors::InvalidArgument("Dtype ", DataTypeString(dst->dtype()),
+                                     " not supported in delta bundles.");
+  }
+#undef HANDLE_COPY
+  return Status::OK();
+}
+
+}  // namespace
+
+Status AddDeltaBase(BundleWriter* writer, StringPiece base_prefix) {
+  Tensor base(DT_STRING, TensorShape({}));
+  base.scalar<string>()() = std::string(base_prefix);
+  return writer->Add(kDeltaBaseKey, base);
+}
+
+Status AddDeltaRows(BundleWriter* writer, StringPiece key,
+                    const TensorShape& full_shape, const TensorSlice& slice,
+                    const Tensor& val, gtl::ArraySlice<int64> rows) {
+  TensorShape slice_shape;
+  TF_RETURN_IF_ERROR(slice.SliceTensorShape(full_shape, &slice_shape));
+  if (val.dims() == 0 || !slice_shape.IsSameSize(val.shape())) {
+    return errors::InvalidArgument(
+        "Cannot add rows of a tensor of shape ", val.shape().DebugString(),
+        " as a slice of shape ", slice_shape.DebugString(), " for key ", key);
+  }
+  const int64 slice_start = slice.IsFullAt(0) ? 0 : slice.start(0);
+  size_t i = 0;
+  while (i < rows.size()) {
+    // Extends the run over consecutive, and repeated, rows.
+    const int64 begin = rows[i];
+    int64 end = begin + 1;
+    for (++i; i < rows.size() && rows[i] <= end; ++i) {
+      end = std::max(end, rows[i] + 1);
+    }
+    if (begin < 0 || end > val.dim_size(0)) {
+      return errors::InvalidArgument("Rows [", begin, ", ", end,
+                                     ") out of range for key ", key,
+                                     " with shape ",
+                                     val.shape().DebugString());
+    }
+    TensorSlice run_slice = slice;
+    run_slice.set_start(0, slice_start + begin);
+    run_slice.set_length(0, end - begin);
+    TF_RETURN_IF_ERROR(
+        writer->AddSlice(key, full_shape, run_slice, val.Slice(begin, end)));
+  }
+  return Status::OK();
+}
+
+DeltaBundleReader::DeltaBundleReader(Env* env, StringPiece prefix) {
+  string current = std::string(prefix);
+  while (true) {
+    if (std::find(prefixes_.begin(), prefixes_.end(), current) !=
+        prefixes_.end()) {
+      status_ = errors::DataLoss("Delta bundle ", prefix,
+                                 " is based on itself, through ", current);
+      return;
+    }
+    std::unique_ptr<BundleReader> reader(new BundleReader(env, current));
+    status_ = reader->status();
+    if (!status_.ok()) return;
+    prefixes_.push_back(current);
+    const bool is_delta = reader->Contains(kDeltaBaseKey);
+    Tensor base(DT_STRING, TensorShape({}));
+    if (is_delta) {
+      status_ = reader->Lookup(kDeltaBaseKey, &base);
+      if (!status_.ok()) return;
+    }
+    readers_.push_back(std::move(reader));
+    if (!is_delta) break;
+
+    const string& base_prefix = base.scalar<string>()();
+    current = io::IsAbsolutePath(base_prefix)
+                  ? base_prefix
+                  : io::JoinPath(io::Dirname(current), base_prefix);
+  }
+  std::reverse(prefixes_.begin(), prefixes_.end());
+  std::reverse(readers_.begin(), readers_.end());
+}
+
+bool DeltaBundleReader::IsDeltaBundle(Env* env, StringPiece prefix) {
+  BundleReader reader(env, prefix);
+  return reader.status().ok() && reader.Contains(kDeltaBaseKey);
+}
+
+Status DeltaBundleReader::ListKeys(std::vector<string>* keys) {
+  std::set<string> all_keys;
+  for (const auto& reader : readers_) {
+    reader->Seek(kHeaderEntryKey);
+    for (reader->Next(); reader->Valid(); reader->Next()) {
+      const StringPiece key = reader->key();
+      // The keys of stored slices start with a zero byte (see
+      // checkpoint::EncodeTensorNameSlice()).
+      if (key == kDeltaBaseKey || (!key.empty() && key[0] == '\0')) continue;
+      all_keys.insert(std::string(key));
+    }
+  }
+  keys->assign(all_keys.begin(), all_keys.end());
+  return Status::OK();
+}
+
+Status DeltaBundleReader::LookupDtypeAndShape(StringPiece key, DataType* dtype,
+                                              TensorShape* shape) {
+  for (auto it = readers_.rbegin(); it != readers_.rend(); ++it) {
+    if ((*it)->Contains(key)) {
+      return (*it)->LookupDtypeAndShape(key, dtype, shape);
+    }
+  }
+  return errors::NotFound("Key ", key, " not found in checkpoint");
+}
+
+Status DeltaBundleReader::LookupTensorSlices(StringPiece key,
+                                             std::vector<TensorSlice>* slices) {
+  for (const auto& reader : readers_) {
+    if (reader->Contains(key)) {
+      return reader->LookupTensorSlices(key, slices);
+    }
+  }
+  return errors::NotFound("Key ", key, " not found in checkpoint");
+}
+
+Status DeltaBundleReader::Lookup(StringPiece key, Tensor* val) {
+  return LookupSlice(key, TensorSlice(val->dims()), val);
+}
+
+Status DeltaBundleReader::LookupSlice(StringPiece key,
+                                      const TensorSlice& slice_spec,
+                                      Tensor* val) {
+  bool found = false;
+  for (const auto& reader : readers_) {
+    if (!reader->Contains(key)) continue;
+    if (found) {
+      TF_RETURN_IF_ERROR(ApplyDelta(reader.get(), key, slice_spec, val));
+    } else if (slice_spec.IsFull()) {
+      TF_RETURN_IF_ERROR(reader->Lookup(key, val));
+    } else {
+      TF_RETURN_IF_ERROR(reader->LookupSlice(key, slice_spec, val));
+    }
+    found = true;
+  }
+  if (!found) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
+  return Status::OK();
+}
+
+Status DeltaBundleReader::ApplyDelta(BundleReader* reader, StringPiece key,
+                                     const TensorSlice& slice_spec,
+                                     Tensor* val) {
+  DataType dtype;
+  TensorShape full_shape;
+  TF_RETURN_IF_ERROR(reader->LookupDtypeAndShape(key, &dtype, &full_shape));
+  TensorShape spec_shape;
+  TF_RETURN_IF_ERROR(slice_spec.SliceTensorShape(full_shape, &spec_shape));
+  if (dtype != val->dtype() || !spec_shape.IsSameSize(val->shape())) {
+    return errors::DataLoss(
+        "Delta for key ", key, " has dtype ", DataTypeString(dtype),
+        " and shape ", full_shape.DebugString(), ", which does not match ",
+        DataTypeString(val->dtype()), " ", val->shape().DebugString(),
+        " for slice ", slice_spec.DebugString());
+  }
+
+  std::vector<TensorSlice> stored_slices;
+  TF_RETURN_IF_ERROR(reader->LookupTensorSlices(key, &stored_slices));
+  if (stored_slices.empty()) {
+    // The delta holds the full tensor.
+    stored_slices.push_back(TensorSlice(full_shape.dims()));
+  }
+  for (const TensorSlice& stored_slice : stored_slices) {
+    TensorSlice intersection;
+    if (!stored_slice.Intersect(slice_spec, &intersection)) continue;
+    if (intersection == slice_spec) {
+      // The stored slice covers all of "slice_spec", e.g. because the delta
+      // holds the full tensor.
+      TF_RETURN_IF_ERROR(reader->LookupSlice(key, slice_spec, val));
+      continue;
+    }
+    TensorShape intersection_shape;
+    TF_RETURN_IF_ERROR(
+        intersection.SliceTensorShape(full_shape, &intersection_shape));
+    Tensor part(dtype, intersection_shape);
+    TF_RETURN_IF_ERROR(reader->LookupSlice(key, intersection, &part));
+    TF_RETURN_IF_ERROR(
+        CopySliceData(full_shape, intersection, slice_spec, part, val));
+  }
+  return Status::OK();
+}
+
+Status CompactDeltaBundles(Env* env, StringPiece prefix,
+                           StringPiece output_prefix) {
+  DeltaBundleReader reader(env, prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  const std::vector<string>& prefixes = reader.prefixes();
+  if (std::find(prefixes.begin(), prefixes.end(), output_prefix) !=
+      prefixes.end()) {
+    return errors::InvalidArgument("Cannot compact ", prefix,
+                                   " into one of its own bundles: ",
+                                   output_prefix);
+  }
+  std::vector<string> keys;
+  TF_RETURN_IF_ERROR(reader.ListKeys(&keys));
+
+  BundleWriter writer(env, output_prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (const string& key : keys) {
+    DataType dtype;
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(key, &dtype, &shape));
+    std::vector<TensorSlice> slices;
+    TF_RETURN_IF_ERROR(reader.LookupTensorSlices(key, &slices));
+    if (slices.empty()) {
+      Tensor val(dtype, shape);
+      TF_RETURN_IF_ERROR(reader.Lookup(key, &val));
+      TF_RETURN_IF_ERROR(writer.Add(key, val));
+      continue;
+    }
+    for (const TensorSlice& slice : slices) {
+      TensorShape slice_shape;
+      TF_RETURN_IF_ERROR(slice.SliceTensorShape(shape, &slice_shape));
+      Tensor val(dtype, slice_shape);
+      TF_RETURN_IF_ERROR(reader.LookupSlice(key, slice, &val));
+      TF_RETURN_IF_ERROR(writer.AddSlice(key, shape, slice, val));
+    }
+  }
+  return writer.Finish();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,130 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Incremental ("delta") checkpoints on top of the tensor bundle format.
+//
+// A delta bundle is a regular tensor bundle that holds only the parts of
+// tensors that changed since the bundle it is based on.  It stores, under
+// the key kDeltaBaseKey, the prefix of that base bundle as a string scalar.
+// The base may be a delta bundle itself, so that a chain of delta bundles
+// ends in a regular bundle.
+//
+// Changed parts are stored as slices of the full tensors, usually runs of
+// consecutive rows (see AddDeltaRows()).  A tensor that is missing from a
+// delta bundle is unchanged from its base.  A DeltaBundleReader applies the
+// deltas of a chain in order, and CompactDeltaBundles() folds a chain back
+// into a regular bundle.
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_BUNDLE_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_BUNDLE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+// The key under which a delta bundle stores the prefix of its base bundle.
+extern const char* const kDeltaBaseKey;
+
+// Marks the bundle being written by "writer" as a delta on top of the bundle
+// at "base_prefix".  A relative "base_prefix" is relative to the directory of
+// the delta bundle.
+Status AddDeltaBase(BundleWriter* writer, StringPiece base_prefix);
+
+// Adds the rows "rows" of "val" to the delta bundle being written by
+// "writer", under key "key".  "val" is the slice "slice" of a tensor of shape
+// "full_shape", as for BundleWriter::AddSlice(); "rows" are sorted indices
+// into dimension 0 of "val".  Each run of consecutive rows is stored as one
+// slice, without copying "val".
+Status AddDeltaRows(BundleWriter* writer, StringPiece key,
+                    const TensorShape& full_shape, const TensorSlice& slice,
+                    const Tensor& val, gtl::ArraySlice<int64> rows);
+
+// Reads tensors from a chain of delta bundles, or from a regular bundle.
+//
+// All threads accessing the same DeltaBundleReader must synchronize.
+class DeltaBundleReader {
+ public:
+  // Opens the bundle at "prefix" and, if it is a delta bundle, the bundles
+  // it is based on.  "status()" must be checked.
+  DeltaBundleReader(Env* env, StringPiece prefix);
+
+  Status status() const { return status_; }
+
+  // Returns true iff the bundle at "prefix" is a delta bundle.
+  static bool IsDeltaBundle(Env* env, StringPiece prefix);
+
+  // The prefixes of the bundles in the chain, the regular bundle first.
+  const std::vector<string>& prefixes() const { return prefixes_; }
+
+  // Returns the keys of the tensors stored in any bundle of the chain, in
+  // sorted order.
+  // REQUIRES: status().ok()
+  Status ListKeys(std::vector<string>* keys) TF_MUST_USE_RESULT;
+
+  // Looks up the dtype and the shape of the tensor keyed by "key", as stored
+  // in the newest bundle that contains it.
+  // REQUIRES: status().ok()
+  Status LookupDtypeAndShape(StringPiece key, DataType* dtype,
+                             TensorShape* shape) TF_MUST_USE_RESULT;
+
+  // Looks up the slices of the tensor keyed by "key" in the oldest bundle
+  // that contains it, which determines how it is partitioned.
+  // REQUIRES: status().ok()
+  Status LookupTensorSlices(StringPiece key, std::vector<TensorSlice>* slices)
+      TF_MUST_USE_RESULT;
+
+  // Like BundleReader::Lookup() and BundleReader::LookupSlice(): reads the
+  // tensor keyed by "key", or its slice "slice_spec", from the oldest bundle
+  // that contains it, then applies the changes stored in newer bundles.
+  // REQUIRES: status().ok()
+  Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+  Status LookupSlice(StringPiece key, const TensorSlice& slice_spec,
+                     Tensor* val) TF_MUST_USE_RESULT;
+
+ private:
+  // Copies the parts of "slice_spec" of the tensor keyed by "key" that are
+  // stored in the delta bundle read by "reader" into "val".
+  static Status ApplyDelta(BundleReader* reader, StringPiece key,
+                           const TensorSlice& slice_spec, Tensor* val);
+
+  Status status_;
+  std::vector<string> prefixes_;
+  std::vector<std::unique_ptr<BundleReader>> readers_;  // Oldest first.
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeltaBundleReader);
+};
+
+// Writes the tensors of the chain of delta bundles at "prefix" to a regular
+// bundle at "output_prefix", keeping the partitioning of the oldest bundle
+// that contains each tensor.  Reads and writes one tensor, or one slice of a
+// partitioned tensor, at a time.  The input bundles are left in place.
+Status CompactDeltaBundles(Env* env, StringPiece prefix,
+                           StringPiece output_prefix);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_BUNDLE_H_
@@ -0,0 +1,241 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/delta_bundle.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& prefix) {
+  return io::JoinPath(testing::TmpDir(), prefix);
+}
+
+// Returns a 6x2 tensor whose row i is {10 * i + v, 10 * i + v}.
+Tensor Rows(float v) {
+  Tensor t(DT_FLOAT, TensorShape({6, 2}));
+  for (int i = 0; i < 6; ++i) {
+    t.matrix<float>()(i, 0) = t.matrix<float>()(i, 1) = 10 * i + v;
+  }
+  return t;
+}
+
+// Sets row "i" of "t" to "v".
+void SetRow(Tensor* t, int i, float v) {
+  t->matrix<float>()(i, 0) = t->matrix<float>()(i, 1) = v;
+}
+
+// Writes a base bundle and two deltas on top of it:
+//   "emb": a 6x2 tensor, of which the deltas change rows {1, 2, 5} and {2}.
+//   "part": a 6x2 tensor, stored as slices of rows [0, 3) and [3, 6); the
+//     first delta changes row 4.
+//   "step": a scalar, rewritten by every delta.
+//   "new": a tensor added by the second delta.
+void WriteChain(const string& name, Tensor* emb, Tensor* part) {
+  Env* env = Env::Default();
+  *emb = Rows(0);
+  *part = Rows(0.5);
+  const TensorShape full_shape({6, 2});
+  TensorSlice first, second;
+  TF_ASSERT_OK(TensorSlice::Parse("0,3:-", &first));
+  TF_ASSERT_OK(TensorSlice::Parse("3,3:-", &second));
+  {
+    BundleWriter writer(env, Prefix(name + "_base"));
+    TF_ASSERT_OK(writer.Add("emb", *emb));
+    TF_ASSERT_OK(writer.AddSlice("part", full_shape, first, part->Slice(0, 3)));
+    TF_ASSERT_OK(
+        writer.AddSlice("part", full_shape, second, part->Slice(3, 6)));
+    TF_ASSERT_OK(writer.Add("step", test::AsScalar<int64>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    SetRow(emb, 1, 100);
+    SetRow(emb, 2, 200);
+    SetRow(emb, 5, 500);
+    SetRow(part, 4, 400);
+    // The base is given relative to the directory of the delta.
+    BundleWriter writer(env, Prefix(name + "_delta1"));
+    TF_ASSERT_OK(AddDeltaBase(&writer, name + "_base"));
+    TF_ASSERT_OK(AddDeltaRows(&writer, "emb", full_shape,
+                              TensorSlice(2), *emb, {1, 2, 5}));
+    TF_ASSERT_OK(AddDeltaRows(&writer, "part", full_shape, second,
+                              part->Slice(3, 6), {1}));
+    TF_ASSERT_OK(writer.Add("step", test::AsScalar<int64>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    SetRow(emb, 2, 201);
+    BundleWriter writer(env, Prefix(name + "_delta2"));
+    TF_ASSERT_OK(AddDeltaBase(&writer, Prefix(name + "_delta1")));
+    TF_ASSERT_OK(AddDeltaRows(&writer, "emb", full_shape,
+                              TensorSlice(2), *emb, {2, 2}));
+    TF_ASSERT_OK(writer.Add("step", test::AsScalar<int64>(2)));
+    TF_ASSERT_OK(writer.Add("new", test::AsTensor<int32>({1, 2, 3})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+}
+
+TEST(DeltaBundleTest, Chain) {
+  Tensor emb, part;
+  WriteChain("chain", &emb, &part);
+  Env* env = Env::Default();
+  EXPECT_FALSE(DeltaBundleReader::IsDeltaBundle(env, Prefix("chain_base")));
+  EXPECT_TRUE(DeltaBundleReader::IsDeltaBundle(env, Prefix("chain_delta2")));
+
+  DeltaBundleReader reader(env, Prefix("chain_delta2"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(std::vector<string>({Prefix("chain_base"), Prefix("chain_delta1"),
+                                 Prefix("chain_delta2")}),
+            reader.prefixes());
+  std::vector<string> keys;
+  TF_ASSERT_OK(reader.ListKeys(&keys));
+  EXPECT_EQ(std::vector<string>({"emb", "new", "part", "step"}), keys);
+
+  Tensor val(DT_FLOAT, TensorShape({6, 2}));
+  TF_ASSERT_OK(reader.Lookup("emb", &val));
+  test::ExpectTensorEqual<float>(emb, val);
+  TF_ASSERT_OK(reader.Lookup("part", &val));
+  test::ExpectTensorEqual<float>(part, val);
+  Tensor step(DT_INT64, TensorShape({}));
+  TF_ASSERT_OK(reader.Lookup("step", &step));
+  test::ExpectTensorEqual<int64>(test::AsScalar<int64>(2), step);
+  Tensor new_val(DT_INT32, TensorShape({3}));
+  TF_ASSERT_OK(reader.Lookup("new", &new_val));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({1, 2, 3}), new_val);
+  EXPECT_TRUE(errors::IsNotFound(reader.Lookup("missing", &val)));
+
+  // Slices that span the stored deltas.
+  TensorSlice slice;
+  TF_ASSERT_OK(TensorSlice::Parse("2,3:-", &slice));
+  Tensor sliced(DT_FLOAT, TensorShape({3, 2}));
+  TF_ASSERT_OK(reader.LookupSlice("emb", slice, &sliced));
+  test::ExpectTensorEqual<float>(emb.Slice(2, 5), sliced);
+  TF_ASSERT_OK(reader.LookupSlice("part", slice, &sliced));
+  test::ExpectTensorEqual<float>(part.Slice(2, 5), sliced);
+
+  // An intermediate delta only sees the changes up to itself.
+  DeltaBundleReader reader1(env, Prefix("chain_delta1"));
+  TF_ASSERT_OK(reader1.status());
+  TF_ASSERT_OK(reader1.Lookup("emb", &val));
+  SetRow(&emb, 2, 200);
+  test::ExpectTensorEqual<float>(emb, val);
+}
+
+TEST(DeltaBundleTest, Compact) {
+  Tensor emb, part;
+  WriteChain("compact", &emb, &part);
+  Env* env = Env::Default();
+  TF_ASSERT_OK(CompactDeltaBundles(env, Prefix("compact_delta2"),
+                                   Prefix("compacted")));
+  EXPECT_TRUE(errors::IsInvalidArgument(CompactDeltaBundles(
+      env, Prefix("compact_delta2"), Prefix("compact_delta1"))));
+
+  // The result is a regular bundle, with "part" still partitioned.
+  EXPECT_FALSE(DeltaBundleReader::IsDeltaBundle(env, Prefix("compacted")));
+  BundleReader reader(env, Prefix("compacted"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val(DT_FLOAT, TensorShape({6, 2}));
+  TF_ASSERT_OK(reader.Lookup("emb", &val));
+  test::ExpectTensorEqual<float>(emb, val);
+  TF_ASSERT_OK(reader.Lookup("part", &val));
+  test::ExpectTensorEqual<float>(part, val);
+  std::vector<TensorSlice> slices;
+  TF_ASSERT_OK(reader.LookupTensorSlices("part", &slices));
+  EXPECT_EQ(2, slices.size());
+  Tensor step(DT_INT64, TensorShape({}));
+  TF_ASSERT_OK(reader.Lookup("step", &step));
+  test::ExpectTensorEqual<int64>(test::AsScalar<int64>(2), step);
+  EXPECT_FALSE(reader.Contains(kDeltaBaseKey));
+}
+
+TEST(DeltaBundleTest, BrokenChain) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("orphan"));
+    TF_ASSERT_OK(AddDeltaBase(&writer, Prefix("does_not_exist")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  EXPECT_TRUE(errors::IsNotFound(
+      DeltaBundleReader(env, Prefix("orphan")).status()));
+  {
+    BundleWriter writer(env, Prefix("cycle"));
+    TF_ASSERT_OK(AddDeltaBase(&writer, Prefix("cycle")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  EXPECT_TRUE(
+      errors::IsDataLoss(DeltaBundleReader(env, Prefix("cycle")).status()));
+}
+
+TEST(DeltaBundleTest, AddDeltaRowsOutOfRange) {
+  BundleWriter writer(Env::Default(), Prefix("out_of_range"));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      AddDeltaRows(&writer, "emb", TensorShape({6, 2}), TensorSlice(2),
+                   Rows(0), {3, 6})));
+}
+
+// Saves an embedding of 100k rows of 64 floats, of which "dirty_per_mille"
+// rows out of 1000 changed, either fully or as a delta.  Reports the bytes
+// written per iteration as the label.
+static void BM_SaveEmbedding(int iters, bool delta, int dirty_per_mille) {
+  testing::StopTiming();
+  const int64 kRows = 100000;
+  Tensor emb(DT_FLOAT, TensorShape({kRows, 64}));
+  emb.flat<float>().setConstant(1.0f);
+  std::vector<int64> rows;
+  for (int64 i = 0; i < kRows; i += 1000 / dirty_per_mille) {
+    rows.push_back(i);
+  }
+  Env* env = Env::Default();
+  const string prefix = Prefix("bench_embedding");
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    BundleWriter writer(env, prefix);
+    if (delta) {
+      TF_CHECK_OK(AddDeltaBase(&writer, "base"));
+      TF_CHECK_OK(AddDeltaRows(&writer, "emb", emb.shape(), TensorSlice(2),
+                               emb, rows));
+    } else {
+      TF_CHECK_OK(writer.Add("emb", emb));
+    }
+    TF_CHECK_OK(writer.Finish());
+  }
+  testing::StopTiming();
+  uint64 data_size, meta_size;
+  TF_CHECK_OK(env->GetFileSize(DataFilename(prefix, 0, 1), &data_size));
+  TF_CHECK_OK(env->GetFileSize(MetaFilename(prefix), &meta_size));
+  testing::BytesProcessed(static_cast<int64>(iters) * (data_size + meta_size));
+  testing::SetLabel(strings::StrCat(data_size + meta_size, " bytes written"));
+}
+
+static void BM_SaveEmbeddingFull(int iters, int dirty_per_mille) {
+  BM_SaveEmbedding(iters, false, dirty_per_mille);
+}
+BENCHMARK(BM_SaveEmbeddingFull)->Arg(1)->Arg(10)->Arg(100);
+
+static void BM_SaveEmbeddingDelta(int iters, int dirty_per_mille) {
+  BM_SaveEmbedding(iters, true, dirty_per_mille);
+}
+BENCHMARK(BM_SaveEmbeddingDelta)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace tensorflow
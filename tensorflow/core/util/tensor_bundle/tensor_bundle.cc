@@ -19,8 +19,10 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <numeric>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb_text.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -693,11 +696,151 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
   return status;
 }
 
+namespace {
+
+// Runs "fns" concurrently, the last one on the calling thread and the others
+// on "runner", and returns the first error.
+Status RunConcurrently(
+    const std::vector<std::function<Status()>>& fns,
+    const std::function<void(std::function<void()>)>& runner) {
+  std::vector<Status> statuses(fns.size());
+  BlockingCounter counter(fns.size() - 1);
+  for (size_t i = 0; i + 1 < fns.size(); ++i) {
+    runner([&fns, &statuses, &counter, i]() {
+      statuses[i] = fns[i]();
+      counter.DecrementCount();
+    });
+  }
+  statuses.back() = fns.back()();
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
+Status WriteBundle(Env* env, StringPiece prefix,
+                   gtl::ArraySlice<BundleWriteItem> items,
+                   const std::vector<size_t>& indices) {
+  BundleWriter writer(env, prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (size_t i : indices) {
+    const BundleWriteItem& item = items[i];
+    if (item.is_slice) {
+      TF_RETURN_IF_ERROR(writer.AddSlice(item.key, item.full_shape, item.slice,
+                                         *item.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(item.key, *item.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+Status ReadBundle(Env* env, StringPiece prefix,
+                  gtl::ArraySlice<BundleReadItem> items) {
+  BundleReader reader(env, prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  for (const BundleReadItem& item : items) {
+    if (item.is_slice) {
+      TF_RETURN_IF_ERROR(reader.LookupSlice(item.key, item.slice, item.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(reader.Lookup(item.key, item.tensor));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status WriteBundleParallel(
+    Env* env, StringPiece prefix, gtl::ArraySlice<BundleWriteItem> items,
+    int num_shards, const std::function<void(std::function<void()>)>& runner) {
+  num_shards = std::max<int>(1, std::min<size_t>(num_shards, items.size()));
+  if (num_shards == 1) {
+    std::vector<size_t> indices(items.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    return WriteBundle(env, prefix, items, indices);
+  }
+
+  // Assigns each item to the shard with the fewest bytes so far, largest
+  // items first.
+  std::vector<size_t> order(items.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&items](size_t a, size_t b) {
+    return items[a].tensor->TotalBytes() > items[b].tensor->TotalBytes();
+  });
+  std::vector<std::vector<size_t>> shards(num_shards);
+  std::vector<int64> shard_bytes(num_shards, 0);
+  for (size_t i : order) {
+    const size_t shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shards[shard].push_back(i);
+    shard_bytes[shard] += items[i].tensor->TotalBytes();
+  }
+
+  std::vector<string> shard_prefixes;
+  std::vector<std::function<Status()>> fns;
+  for (int shard = 0; shard < num_shards; ++shard) {
+    shard_prefixes.push_back(
+        strings::StrCat(prefix, "_temp_shard_", shard, "_of_", num_shards));
+    fns.push_back([env, &shard_prefixes, &items, &shards, shard]() {
+      return WriteBundle(env, shard_prefixes[shard], items, shards[shard]);
+    });
+  }
+  Status status = RunConcurrently(fns, runner);
+  if (status.ok()) {
+    status = MergeBundles(env, shard_prefixes, prefix);
+  }
+  if (!status.ok()) {
+    // Cleanup: best effort based and ignores errors.
+    for (const string& shard_prefix : shard_prefixes) {
+      env->DeleteFile(MetaFilename(shard_prefix)).IgnoreError();
+      env->DeleteFile(DataFilename(shard_prefix, 0, 1)).IgnoreError();
+    }
+  }
+  return status;
+}
+
+Status ReadBundleParallel(
+    Env* env, StringPiece prefix, gtl::ArraySlice<BundleReadItem> items,
+    int num_readers, const std::function<void(std::function<void()>)>& runner) {
+  num_readers = std::max<int>(1, std::min<size_t>(num_readers, items.size()));
+  if (num_readers == 1) {
+    return ReadBundle(env, prefix, items);
+  }
+
+  // Splits the items into contiguous ranges of about the same number of
+  // bytes.
+  int64 total_bytes = 0;
+  for (const BundleReadItem& item : items) {
+    total_bytes += item.tensor->TotalBytes();
+  }
+  std::vector<std::function<Status()>> fns;
+  size_t begin = 0;
+  int64 bytes = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    bytes += items[i].tensor->TotalBytes();
+    const int64 range_end_bytes =
+        total_bytes * static_cast<int64>(fns.size() + 1) / num_readers;
+    if ((bytes >= range_end_bytes && fns.size() + 1 < num_readers) ||
+        i + 1 == items.size()) {
+      gtl::ArraySlice<BundleReadItem> range(items, begin, i + 1 - begin);
+      fns.push_back(
+          [env, prefix, range]() { return ReadBundle(env, prefix, range); });
+      begin = i + 1;
+    }
+  }
+  return RunConcurrently(fns, runner);
+}
+
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(std::string(prefix)),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       iter_(nullptr) {
@@ -741,6 +884,8 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
 }
 
 BundleReader::~BundleReader() {
+  // The background verifications refer to this reader.
+  WaitForMappedChecksums().IgnoreError();
   delete metadata_;
   delete iter_;
   delete table_;
@@ -754,6 +899,137 @@ BundleReader::~BundleReader() {
   gtl::STLDeleteValues(&tensor_slices_);
 }
 
+// The buffer of a single tensor, as a view into a memory-mapped data file
+// that it keeps alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t len)
+      : region_(std::move(region)), data_(const_cast<char*>(data)), len_(len) {}
+
+  void* data() const override { return data_; }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("MappedBundle");
+  }
+
+  // The mapping is read-only, so it must not be forwarded to an op output.
+  bool OwnsMemory() const override { return false; }
+
+  Tensor MakeTensor(DataType dtype, const TensorShape& shape) {
+    CHECK_EQ(len_, shape.num_elements() * DataTypeSize(dtype));
+    return Tensor(dtype, shape, this);
+  }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  char* const data_;
+  const size_t len_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedTensorBuffer);
+};
+
+namespace {
+
+Status ChecksumMismatchError(StringPiece key, uint32 expected,
+                             uint32 actual) {
+  return errors::DataLoss("Checksum does not match for key ", key,
+                          ": stored ", strings::Printf("%08u", expected),
+                          " vs. calculated on the mapped bytes ", actual);
+}
+
+}  // namespace
+
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape shape(entry.shape());
+
+  // Falls back to reading a copy of the tensor.
+  auto lookup_copy = [this, key, &entry, &shape, val]() {
+    Tensor ret(entry.dtype(), shape);
+    TF_RETURN_IF_ERROR(Lookup(key, &ret));
+    *val = ret;
+    return Status::OK();
+  };
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || entry.slices_size() > 0 ||
+      shape.num_elements() == 0) {
+    return lookup_copy();
+  }
+  const size_t expected_size =
+      shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+
+  // Maps the data file if it has not been mapped.
+  std::shared_ptr<ReadOnlyMemoryRegion>& region =
+      mapped_data_[entry.shard_id()];
+  if (region == nullptr) {
+    std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+    Status status = env_->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix_, entry.shard_id(), num_shards_), &new_region);
+    if (errors::IsUnimplemented(status)) {
+      // The file system does not support mapping files.
+      return lookup_copy();
+    }
+    TF_RETURN_IF_ERROR(status);
+    region = std::move(new_region);
+  }
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("Bundle entry out of bounds: key ", key,
+                            "; offset ", entry.offset(), ", size ",
+                            entry.size(), ", but data file size is ",
+                            region->length());
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment != 0) {
+    return lookup_copy();
+  }
+
+  const uint32 expected_crc32c = crc32c::Unmask(entry.crc32c());
+  if (options_.verify_mapped_checksums_in_background) {
+    {
+      mutex_lock l(checksum_mu_);
+      ++num_pending_checksums_;
+    }
+    const string key_copy = std::string(key);
+    const size_t size = entry.size();
+    env_->SchedClosure([this, key_copy, data, size, expected_crc32c]() {
+      const uint32 actual_crc32c = crc32c::Value(data, size);
+      mutex_lock l(checksum_mu_);
+      if (actual_crc32c != expected_crc32c && checksum_status_.ok()) {
+        checksum_status_ =
+            ChecksumMismatchError(key_copy, expected_crc32c, actual_crc32c);
+      }
+      if (--num_pending_checksums_ == 0) checksum_cv_.notify_all();
+    });
+  } else {
+    const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+    if (actual_crc32c != expected_crc32c) {
+      return ChecksumMismatchError(key, expected_crc32c, actual_crc32c);
+    }
+  }
+
+  MappedTensorBuffer* buf = new MappedTensorBuffer(region, data, entry.size());
+  *val = buf->MakeTensor(entry.dtype(), shape);
+  buf->Unref();
+  return Status::OK();
+}
+
+Status BundleReader::WaitForMappedChecksums() {
+  mutex_lock l(checksum_mu_);
+  while (num_pending_checksums_ > 0) {
+    checksum_cv_.wait(l);
+  }
+  return checksum_status_;
+}
+
 Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
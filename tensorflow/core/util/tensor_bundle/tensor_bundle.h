@@ -63,7 +63,9 @@ limitations under the License.
 
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -77,6 +79,8 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
@@ -175,13 +179,60 @@ class BundleWriter {
 Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
                     StringPiece merged_prefix);
 
+// A tensor, or a slice of a tensor, to be written by `WriteBundleParallel()`.
+struct BundleWriteItem {
+  string key;
+  const Tensor* tensor = nullptr;  // Not owned.
+  // If true, "tensor" is the slice "slice" of a tensor of shape "full_shape",
+  // and is added with "BundleWriter::AddSlice()".
+  bool is_slice = false;
+  TensorShape full_shape;
+  TensorSlice slice;
+};
+
+// Writes "items" to the bundle at "prefix", as a single BundleWriter would.
+// If "num_shards" > 1, the items are split into up to "num_shards" data
+// shards of similar size, which are written concurrently by closures passed
+// to "runner" and then merged with "MergeBundles()".  The closures block on
+// file I/O, and this function blocks until all of them are done.
+Status WriteBundleParallel(
+    Env* env, StringPiece prefix, gtl::ArraySlice<BundleWriteItem> items,
+    int num_shards, const std::function<void(std::function<void()>)>& runner);
+
+// A tensor, or a slice of a tensor, to be read by `ReadBundleParallel()`.
+struct BundleReadItem {
+  string key;
+  // Must have the dtype and shape of the stored tensor or slice.
+  Tensor* tensor = nullptr;  // Not owned.
+  // If true, reads the slice "slice" of the tensor with key "key".
+  bool is_slice = false;
+  TensorSlice slice;
+};
+
+// Reads "items" from the bundle at "prefix".  If "num_readers" > 1, the items
+// are split into up to "num_readers" contiguous ranges of similar size, which
+// are read concurrently by closures passed to "runner", each with its own
+// BundleReader.  Items should be sorted by key, so that each reader visits a
+// contiguous part of the metadata table.
+Status ReadBundleParallel(
+    Env* env, StringPiece prefix, gtl::ArraySlice<BundleReadItem> items,
+    int num_readers, const std::function<void(std::function<void()>)>& runner);
+
 // On construction, silently attempts to read the metadata associated with
 // "prefix".  If caller intends to call any function afterwards, "status()"
 // must be checked.
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, "LookupMapped()" returns before verifying the crc32c checksum
+    // of a mapped tensor, and verifies it on a background thread instead.
+    // "WaitForMappedChecksums()" returns the result.
+    bool verify_mapped_checksums_in_background{false};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -218,6 +269,27 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like "Lookup()", but avoids copying the tensor contents where possible.
+  // The data file holding the tensor is memory-mapped on first use.  If the
+  // tensor has a dtype that can be memcpy'd, is not a partitioned tensor, and
+  // is stored at an offset aligned to Allocator::kAllocatorAlignment (see
+  // BundleWriter::Options::data_alignment), "val" is set to a tensor whose
+  // buffer aliases the mapping.  Otherwise "val" is set to a newly allocated
+  // tensor, filled as by "Lookup()".
+  //
+  // Unlike "Lookup()", "val" need not have the shape and dtype of the stored
+  // tensor.  Mapped tensors keep the mapping alive, and so may outlive the
+  // reader, but they are read-only: their buffers must not be written to.
+  //
+  // Validates the stored crc32c checksum against the mapped bytes, unless
+  // "Options::verify_mapped_checksums_in_background" is set.
+  // REQUIRES: status().ok()
+  Status LookupMapped(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
+  // Waits for the checksum verifications scheduled by "LookupMapped()" to
+  // finish, and returns a DataLoss error if any of them failed.
+  Status WaitForMappedChecksums() TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -284,6 +356,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -291,6 +364,16 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The memory-mapped data files, shared with the tensors returned by
+  // "LookupMapped()".  Populated on-demand.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+
+  // Checksum verifications scheduled by "LookupMapped()" in the background.
+  mutex checksum_mu_;
+  condition_variable checksum_cv_;
+  int64 num_pending_checksums_ GUARDED_BY(checksum_mu_) = 0;
+  Status checksum_status_ GUARDED_BY(checksum_mu_);
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -18,12 +18,14 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -772,6 +774,206 @@ TEST(TensorBundleTest, VersionTest) {
   }
 }
 
+TEST(TensorBundleTest, WriteBundleParallel) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  auto runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  const Tensor full = test::AsTensor<float>({0, 1, 2, 3, 4, 5}, {6});
+  const Tensor first = test::AsTensor<float>({0, 1, 2}, {3});
+  const Tensor second = test::AsTensor<float>({3, 4, 5}, {3});
+  const int kNumTensors = 5;
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < kNumTensors; ++i) {
+    tensors.push_back(Constant(i, TensorShape({i + 1, 3})));
+  }
+
+  for (int num_shards : {1, 3, 10}) {
+    const string prefix = Prefix(strings::StrCat("parallel_", num_shards));
+    std::vector<BundleWriteItem> items(kNumTensors + 2);
+    for (int i = 0; i < kNumTensors; ++i) {
+      items[i].key = strings::StrCat("foo_", i);
+      items[i].tensor = &tensors[i];
+    }
+    // Two slices of the same tensor, which may go to different shards.
+    BundleWriteItem* part = &items[kNumTensors];
+    part[0].key = "part";
+    part[0].tensor = &first;
+    part[0].is_slice = true;
+    part[0].full_shape = TensorShape({6});
+    TF_ASSERT_OK(TensorSlice::Parse("0,3", &part[0].slice));
+    part[1] = part[0];
+    part[1].tensor = &second;
+    TF_ASSERT_OK(TensorSlice::Parse("3,3", &part[1].slice));
+    TF_ASSERT_OK(WriteBundleParallel(Env::Default(), prefix, items,
+                                     num_shards, runner));
+
+    BundleReader reader(Env::Default(), prefix);
+    TF_ASSERT_OK(reader.status());
+    for (int i = 0; i < kNumTensors; ++i) {
+      Expect<int>(&reader, strings::StrCat("foo_", i), tensors[i]);
+    }
+    Expect<float>(&reader, "part", full);
+
+    // Only the merged bundle is left behind.
+    std::vector<string> paths;
+    TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+        strings::StrCat(prefix, "_temp_shard_*"), &paths));
+    EXPECT_TRUE(paths.empty());
+  }
+}
+
+TEST(TensorBundleTest, ReadBundleParallel) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  auto runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  const int kNumTensors = 20;
+  {
+    BundleWriter writer(Env::Default(), Prefix("read_parallel"));
+    for (int i = 0; i < kNumTensors; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("foo_", i),
+                              Constant(i, TensorShape({i % 4, 3}))));
+    }
+    TF_EXPECT_OK(writer.AddSlice(
+        "part", TensorShape({6}), TensorSlice({{0, 6}}),
+        test::AsTensor<float>({0, 1, 2, 3, 4, 5}, {6})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  for (int num_readers : {1, 4, 100}) {
+    std::vector<Tensor> tensors;
+    for (int i = 0; i < kNumTensors; ++i) {
+      tensors.emplace_back(DT_INT32, TensorShape({i % 4, 3}));
+    }
+    Tensor slice(DT_FLOAT, TensorShape({2}));
+    std::vector<BundleReadItem> items(kNumTensors + 1);
+    for (int i = 0; i < kNumTensors; ++i) {
+      items[i].key = strings::StrCat("foo_", i);
+      items[i].tensor = &tensors[i];
+    }
+    items[kNumTensors].key = "part";
+    items[kNumTensors].tensor = &slice;
+    items[kNumTensors].is_slice = true;
+    TF_ASSERT_OK(TensorSlice::Parse("2,2", &items[kNumTensors].slice));
+    TF_ASSERT_OK(ReadBundleParallel(Env::Default(), Prefix("read_parallel"),
+                                    items, num_readers, runner));
+    for (int i = 0; i < kNumTensors; ++i) {
+      test::ExpectTensorEqual<int>(tensors[i],
+                                   Constant(i, TensorShape({i % 4, 3})));
+    }
+    test::ExpectTensorEqual<float>(slice, test::AsTensor<float>({2, 3}, {2}));
+
+    // A missing key fails the whole read.
+    items[0].key = "missing";
+    EXPECT_TRUE(errors::IsNotFound(ReadBundleParallel(
+        Env::Default(), Prefix("read_parallel"), items, num_readers,
+        runner)));
+  }
+}
+
+// Returns the name of the allocator that "t" reports for its buffer.
+string AllocatorName(const Tensor& t) {
+  TensorDescription desc;
+  t.FillDescription(&desc);
+  return desc.allocation_description().allocator_name();
+}
+
+TEST(TensorBundleTest, LookupMapped) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(env, Prefix("mapped"), opts);
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("int", Constant(7, TensorShape({100}))));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<string>("foo")));
+    TF_EXPECT_OK(writer.Add("empty", Constant(1.0, TensorShape({0, 3}))));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice({{0, 4}}),
+                                 test::AsTensor<int64>({1, 2, 3, 4}, {4})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  for (bool background : {false, true}) {
+    BundleReader::Options options;
+    options.verify_mapped_checksums_in_background = background;
+    Tensor floats, ints, strings, empty, part;
+    {
+      BundleReader reader(env, Prefix("mapped"), options);
+      TF_ASSERT_OK(reader.status());
+      TF_ASSERT_OK(reader.LookupMapped("float", &floats));
+      TF_ASSERT_OK(reader.LookupMapped("int", &ints));
+      // These are copied.
+      TF_ASSERT_OK(reader.LookupMapped("string", &strings));
+      TF_ASSERT_OK(reader.LookupMapped("empty", &empty));
+      TF_ASSERT_OK(reader.LookupMapped("part", &part));
+      EXPECT_TRUE(errors::IsNotFound(reader.LookupMapped("missing", &part)));
+      TF_EXPECT_OK(reader.WaitForMappedChecksums());
+    }
+    EXPECT_EQ("MappedBundle", AllocatorName(floats));
+    EXPECT_EQ("MappedBundle", AllocatorName(ints));
+    EXPECT_NE("MappedBundle", AllocatorName(strings));
+    // The mapped tensors outlive the reader.
+    test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(1.5));
+    test::ExpectTensorEqual<int>(ints, Constant(7, TensorShape({100})));
+    test::ExpectTensorEqual<string>(strings, Constant_2x3<string>("foo"));
+    test::ExpectTensorEqual<double>(empty, Constant(1.0, TensorShape({0, 3})));
+    test::ExpectTensorEqual<int64>(part,
+                                   test::AsTensor<int64>({1, 2, 3, 4}, {4}));
+  }
+}
+
+TEST(TensorBundleTest, LookupMappedUnaligned) {
+  Env* env = Env::Default();
+  {
+    // Densely packed, so that the second tensor is not aligned.
+    BundleWriter writer(env, Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2.0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(env, Prefix("unaligned"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.LookupMapped("b", &val));
+  EXPECT_NE("MappedBundle", AllocatorName(val));
+  test::ExpectTensorEqual<float>(val, Constant_2x3<float>(2.0));
+}
+
+TEST(TensorBundleTest, LookupMappedChecksum) {
+  Env* env = Env::Default();
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(env, Prefix("mapped_checksum"), opts);
+    TF_EXPECT_OK(writer.Add("key", Constant_2x3<float>(1.0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Flips a byte of the tensor contents.
+  const string data_path = DataFilename(Prefix("mapped_checksum"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, data_path, &data));
+  data[0] = ~data[0];
+  TF_ASSERT_OK(WriteStringToFile(env, data_path, data));
+
+  {
+    BundleReader reader(env, Prefix("mapped_checksum"));
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    EXPECT_TRUE(errors::IsDataLoss(reader.LookupMapped("key", &val)));
+  }
+  {
+    BundleReader::Options options;
+    options.verify_mapped_checksums_in_background = true;
+    BundleReader reader(env, Prefix("mapped_checksum"), options);
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    TF_EXPECT_OK(reader.LookupMapped("key", &val));
+    EXPECT_TRUE(errors::IsDataLoss(reader.WaitForMappedChecksums()));
+  }
+}
+
 class TensorBundleAlignmentTest : public ::testing::Test {
  protected:
   template <typename T>
@@ -859,4 +1061,86 @@ BM_BundleAlignment(4096, 512);
 BM_BundleAlignment(4096, 4096);
 BM_BundleAlignment(4096, 1048576);
 
+// Writes and reads 64 tensors of 4MB each with "num_threads" threads.
+static void BM_BundleParallel(int iters, bool read, int num_threads) {
+  testing::StopTiming();
+  const int kNumTensors = 64;
+  const int64 kTensorSize = 1 << 20;
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  auto runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  std::vector<Tensor> tensors;
+  std::vector<BundleWriteItem> write_items(kNumTensors);
+  std::vector<BundleReadItem> read_items(kNumTensors);
+  for (int i = 0; i < kNumTensors; ++i) {
+    tensors.push_back(Constant(static_cast<float>(i),
+                               TensorShape({kTensorSize})));
+    write_items[i].key = read_items[i].key = strings::StrCat("foo_", i);
+    write_items[i].tensor = read_items[i].tensor = &tensors[i];
+  }
+  const string prefix = Prefix("bench_parallel");
+  if (read) {
+    TF_CHECK_OK(WriteBundleParallel(Env::Default(), prefix, write_items,
+                                    num_threads, runner));
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumTensors *
+                          kTensorSize * sizeof(float));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (read) {
+      TF_CHECK_OK(ReadBundleParallel(Env::Default(), prefix, read_items,
+                                     num_threads, runner));
+    } else {
+      TF_CHECK_OK(WriteBundleParallel(Env::Default(), prefix, write_items,
+                                      num_threads, runner));
+    }
+  }
+  testing::StopTiming();
+}
+
+static void BM_WriteBundleParallel(int iters, int num_threads) {
+  BM_BundleParallel(iters, false, num_threads);
+}
+BENCHMARK(BM_WriteBundleParallel)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_ReadBundleParallel(int iters, int num_threads) {
+  BM_BundleParallel(iters, true, num_threads);
+}
+BENCHMARK(BM_ReadBundleParallel)->Arg(1)->Arg(4)->Arg(16);
+
+// Looks up a 64MB tensor by copying it, or by mapping its data file.
+static void BM_BundleLookup(int iters, bool mapped) {
+  testing::StopTiming();
+  const int64 kTensorSize = 16 << 20;
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), Prefix("bench_lookup"), opts);
+    TF_CHECK_OK(writer.Add("big", Constant(1.0f, TensorShape({kTensorSize}))));
+    TF_CHECK_OK(writer.Finish());
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * kTensorSize *
+                          sizeof(float));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    BundleReader reader(Env::Default(), Prefix("bench_lookup"));
+    TF_CHECK_OK(reader.status());
+    Tensor t;
+    if (mapped) {
+      TF_CHECK_OK(reader.LookupMapped("big", &t));
+    } else {
+      t = Tensor(DT_FLOAT, TensorShape({kTensorSize}));
+      TF_CHECK_OK(reader.Lookup("big", &t));
+    }
+  }
+  testing::StopTiming();
+}
+
+static void BM_BundleLookupCopy(int iters) { BM_BundleLookup(iters, false); }
+BENCHMARK(BM_BundleLookupCopy);
+
+static void BM_BundleLookupMapped(int iters) { BM_BundleLookup(iters, true); }
+BENCHMARK(BM_BundleLookupMapped);
+
 }  // namespace tensorflow
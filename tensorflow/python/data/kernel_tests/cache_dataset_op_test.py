@@ -312,6 +312,43 @@ class MemoryCacheDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(itr.get_next())
 
+  def testCompressedCache(self):
+    for compression in ["ZLIB", "SNAPPY"]:
+      # Each element has 256KB, so that the cache has several blocks.
+      dataset = dataset_ops.Dataset.range(40).map(
+          lambda x: (x, array_ops.fill([256, 256], x)))
+      dataset = dataset.cache(compression=compression).repeat(2)
+      get_next = dataset.make_one_shot_iterator().get_next()
+
+      with self.test_session() as sess:
+        try:
+          for _ in range(2):
+            for i in range(40):
+              index, image = sess.run(get_next)
+              self.assertEqual(i, index)
+              self.assertAllEqual(np.full([256, 256], i), image)
+        except errors.UnimplementedError:
+          # Snappy is not available in all builds.
+          self.assertEqual("SNAPPY", compression)
+          continue
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testCompressedFileCacheIsInvalid(self):
+    dataset = dataset_ops.Dataset.range(10).cache(
+        path.join(self.get_temp_dir(), "cache"), compression="ZLIB")
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+
+  def testInvalidCompression(self):
+    dataset = dataset_ops.Dataset.range(10).cache(compression="GZIP")
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+
 
 if __name__ == "__main__":
   test.main()
@@ -781,6 +781,19 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(next_element)
 
+  def testReadWithReadahead(self):
+    for buffer_size in [1, 10, 2**20]:
+      d = readers.TFRecordDataset(
+          self.test_filenames, buffer_size=buffer_size, num_readahead_blocks=3)
+      iterator = d.make_one_shot_iterator()
+      next_element = iterator.get_next()
+      with self.test_session() as sess:
+        for j in range(self._num_files):
+          for i in range(self._num_records):
+            self.assertAllEqual(self._record(j, i), sess.run(next_element))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(next_element)
+
   def testReadFromDatasetOfFiles(self):
     files = dataset_ops.Dataset.from_tensor_slices(self.test_filenames)
     d = readers.TFRecordDataset(files)
@@ -697,18 +697,23 @@ class Dataset(object):
     """
     return ShuffleDataset(self, buffer_size, seed, reshuffle_each_iteration)
 
-  def cache(self, filename=""):
+  def cache(self, filename="", compression=None):
     """Caches the elements in this dataset.
 
     Args:
       filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
         directory on the filesystem to use for caching tensors in this Dataset.
         If a filename is not provided, the dataset will be cached in memory.
+      compression: (Optional.) When caching in memory, one of `"SNAPPY"` or
+        `"ZLIB"`. The cached elements are then serialized and compressed in
+        blocks of a few megabytes, and decompressed in parallel when they are
+        read, so that a larger dataset fits in memory. Defaults to no
+        compression. Must be `None` if `filename` is provided.
 
     Returns:
       Dataset: A `Dataset`.
     """
-    return CacheDataset(self, filename)
+    return CacheDataset(self, filename, compression)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -977,7 +982,9 @@ class Dataset(object):
        `self.output_types`) to another nested structure of tensors.
       num_parallel_calls: (Optional.) A `tf.int32` scalar `tf.Tensor`,
         representing the number elements to process in parallel. If not
-        specified, elements will be processed sequentially.
+        specified, elements will be processed sequentially. If -1, the number
+        is tuned dynamically together with the other parallel stages of the
+        input pipeline.
 
     Returns:
       Dataset: A `Dataset`.
@@ -1784,17 +1791,19 @@ class RangeDataset(Dataset):
 class CacheDataset(Dataset):
   """A `Dataset` that caches elements of its input."""
 
-  def __init__(self, input_dataset, filename):
+  def __init__(self, input_dataset, filename, compression=None):
     """See `Dataset.cache()` for details."""
     super(CacheDataset, self).__init__()
     self._input_dataset = input_dataset
     self._filename = ops.convert_to_tensor(
         filename, dtype=dtypes.string, name="filename")
+    self._compression = compression or ""
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.cache_dataset(
         self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
         filename=self._filename,
+        compression=self._compression,
         **flat_structure(self))
 
   @property
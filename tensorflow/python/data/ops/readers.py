@@ -77,7 +77,8 @@ class TextLineDataset(dataset_ops.Dataset):
 class _TFRecordDataset(dataset_ops.Dataset):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self, filenames, compression_type=None, buffer_size=None,
+               num_readahead_blocks=None):
     """Creates a `TFRecordDataset`.
 
     Args:
@@ -86,6 +87,9 @@ class _TFRecordDataset(dataset_ops.Dataset):
         `""` (no compression), `"ZLIB"`, or `"GZIP"`.
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      num_readahead_blocks: (Optional.) A Python integer. If positive, each
+        uncompressed file is read in blocks of `buffer_size` bytes, with up to
+        this many reads outstanding at once.
     """
     super(_TFRecordDataset, self).__init__()
     # Force the type to string even if filenames is an empty list.
@@ -100,10 +104,12 @@ class _TFRecordDataset(dataset_ops.Dataset):
         "buffer_size",
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
+    self._num_readahead_blocks = num_readahead_blocks or 0
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.tf_record_dataset(
-        self._filenames, self._compression_type, self._buffer_size)
+        self._filenames, self._compression_type, self._buffer_size,
+        num_readahead_blocks=self._num_readahead_blocks)
 
   @property
   def output_classes(self):
@@ -122,7 +128,8 @@ class ParallelInterleaveDataset(dataset_ops.InterleaveDataset):
   """A `Dataset` that maps a function over its input and flattens the result."""
 
   def __init__(self, input_dataset, map_func, cycle_length, block_length,
-               sloppy, buffer_output_elements, prefetch_input_elements):
+               sloppy, buffer_output_elements, prefetch_input_elements,
+               max_buffer_output_elements=None):
     """See `tf.contrib.data.parallel_interleave()` for details."""
     super(ParallelInterleaveDataset, self).__init__(input_dataset, map_func,
                                                     cycle_length, block_length)
@@ -136,6 +143,7 @@ class ParallelInterleaveDataset(dataset_ops.InterleaveDataset):
         "prefetch_input_elements",
         prefetch_input_elements,
         argument_default=2 * cycle_length)
+    self._max_buffer_output_elements = max_buffer_output_elements or 0
 
   def _as_variant_tensor(self):
     # pylint: disable=protected-access
@@ -148,6 +156,7 @@ class ParallelInterleaveDataset(dataset_ops.InterleaveDataset):
         self._buffer_output_elements,
         self._prefetch_input_elements,
         f=self._map_func,
+        max_buffer_output_elements=self._max_buffer_output_elements,
         **dataset_ops.flat_structure(self))
     # pylint: enable=protected-access
 
@@ -160,11 +169,11 @@ class TFRecordDataset(dataset_ops.Dataset):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
   def __init__(self, filenames, compression_type=None, buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None, num_readahead_blocks=None):
     """Creates a `TFRecordDataset` to read for one or more TFRecord files.
 
-    NOTE: The `num_parallel_reads` argument can be used to improve performance
-    when reading from a remote filesystem.
+    NOTE: The `num_parallel_reads` and `num_readahead_blocks` arguments can be
+    used to improve performance when reading from a remote filesystem.
 
     Args:
       filenames: A `tf.string` tensor or `tf.data.Dataset` containing one or
@@ -176,6 +185,11 @@ class TFRecordDataset(dataset_ops.Dataset):
       num_parallel_reads: (Optional.) A `tf.int64` scalar representing the
         number of files to read in parallel. Defaults to reading files
         sequentially.
+      num_readahead_blocks: (Optional.) A Python integer representing the
+        number of blocks of `buffer_size` bytes to read ahead in each
+        uncompressed file. The reads run in the background, and the record
+        checksums are verified in parallel, while the records are still
+        produced in order. Defaults to no readahead.
 
     Raises:
       TypeError: If any argument does not have the expected type.
@@ -199,9 +213,11 @@ class TFRecordDataset(dataset_ops.Dataset):
     self._compression_type = compression_type
     self._buffer_size = buffer_size
     self._num_parallel_reads = num_parallel_reads
+    self._num_readahead_blocks = num_readahead_blocks
 
     def read_one_file(filename):
-      return _TFRecordDataset(filename, compression_type, buffer_size)
+      return _TFRecordDataset(filename, compression_type, buffer_size,
+                              num_readahead_blocks)
 
     if num_parallel_reads is None:
       self._impl = filenames.flat_map(read_one_file)
@@ -215,11 +231,13 @@ class TFRecordDataset(dataset_ops.Dataset):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             num_readahead_blocks=None):
     return TFRecordDataset(filenames or self._filenames,
                            compression_type or self._compression_type,
                            buffer_size or self._buffer_size,
-                           num_parallel_reads or self._num_parallel_reads)
+                           num_parallel_reads or self._num_parallel_reads,
+                           num_readahead_blocks or self._num_readahead_blocks)
 
   def _as_variant_tensor(self):
     return self._impl._as_variant_tensor()  # pylint: disable=protected-access
@@ -17,11 +17,18 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
+import numpy as np
+
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.client import session
 from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_io_ops
+from tensorflow.python.ops import gen_resource_variable_ops
 from tensorflow.python.ops import io_ops
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.platform import test
 
 
@@ -56,5 +63,97 @@ class ShapeInferenceTest(test.TestCase):
     self.assertEqual([1, 4], op.get_shape())
 
 
+class SaveDeltaV2Test(test.TestCase):
+
+  def testRestoreDelta(self):
+    base = os.path.join(self.get_temp_dir(), "base")
+    delta = os.path.join(self.get_temp_dir(), "delta")
+    with self.test_session() as sess:
+      v = resource_variable_ops.ResourceVariable(array_ops.zeros([10, 2]))
+      w = resource_variable_ops.ResourceVariable(array_ops.ones([3]))
+      sess.run([v.initializer, w.initializer])
+      sess.run(
+          gen_io_ops.save_delta_v2(base, "", ["v", "w"], ["", ""],
+                                   [v.handle, w.handle]))
+      sess.run(
+          gen_resource_variable_ops.resource_scatter_update(
+              v.handle, [3], [[1., 2.]]))
+      sess.run(
+          gen_io_ops.save_delta_v2(delta, base, ["v", "w"], ["", ""],
+                                   [v.handle, w.handle]))
+
+      expected_v = np.zeros([10, 2])
+      expected_v[3] = [1., 2.]
+      restored = io_ops.restore_v2(delta, ["v", "w", "v"],
+                                   ["", "", "10 2 2,2:-"],
+                                   [dtypes.float32] * 3)
+      restored_v, restored_w, restored_slice = sess.run(restored)
+      self.assertAllEqual(expected_v, restored_v)
+      self.assertAllEqual(np.ones([3]), restored_w)
+      self.assertAllEqual(expected_v[2:4], restored_slice)
+
+  def testNewChainSavesUnchangedVariables(self):
+    base = os.path.join(self.get_temp_dir(), "chain_base")
+    delta = os.path.join(self.get_temp_dir(), "chain_delta")
+    new_base = os.path.join(self.get_temp_dir(), "chain_new_base")
+    with self.test_session() as sess:
+      v = resource_variable_ops.ResourceVariable(array_ops.zeros([10, 2]))
+      w = resource_variable_ops.ResourceVariable(array_ops.ones([3]))
+      sess.run([v.initializer, w.initializer])
+      sess.run(
+          gen_io_ops.save_delta_v2(base, "", ["v", "w"], ["", ""],
+                                   [v.handle, w.handle]))
+      sess.run(
+          gen_resource_variable_ops.resource_scatter_update(
+              v.handle, [3], [[1., 2.]]))
+      sess.run(
+          gen_io_ops.save_delta_v2(delta, base, ["v", "w"], ["", ""],
+                                   [v.handle, w.handle]))
+      # Nothing changed since the delta, but a save without a base starts a
+      # new chain and must hold every variable.
+      sess.run(
+          gen_io_ops.save_delta_v2(new_base, "", ["v", "w"], ["", ""],
+                                   [v.handle, w.handle]))
+
+      expected_v = np.zeros([10, 2])
+      expected_v[3] = [1., 2.]
+      restored = io_ops.restore_v2(new_base, ["v", "w"], ["", ""],
+                                   [dtypes.float32] * 2)
+      restored_v, restored_w = sess.run(restored)
+      self.assertAllEqual(expected_v, restored_v)
+      self.assertAllEqual(np.ones([3]), restored_w)
+
+  def testUninitializedVariable(self):
+    prefix = os.path.join(self.get_temp_dir(), "uninitialized")
+    with self.test_session() as sess:
+      v = resource_variable_ops.ResourceVariable(array_ops.zeros([2]))
+      with self.assertRaisesOpError("uninitialized"):
+        sess.run(gen_io_ops.save_delta_v2(prefix, "", ["v"], [""], [v.handle]))
+
+
+class SaveV2AsyncTest(test.TestCase):
+
+  def testSaveAndWait(self):
+    prefix = os.path.join(self.get_temp_dir(), "async")
+    with self.test_session() as sess:
+      v = resource_variable_ops.ResourceVariable([1., 2., 3.])
+      sess.run(v.initializer)
+      save_id = sess.run(
+          gen_io_ops.save_v2_async(prefix, ["v"], [""], [v.read_value()]))
+      # The save holds the value of the variable when it ran.
+      sess.run(v.assign([4., 5., 6.]))
+      sess.run(gen_io_ops.wait_for_save_v2_async(save_id))
+      restored = io_ops.restore_v2(prefix, ["v"], [""], [dtypes.float32])
+      self.assertAllEqual([1., 2., 3.], sess.run(restored[0]))
+
+      with self.assertRaisesOpError("already returned"):
+        sess.run(gen_io_ops.wait_for_save_v2_async(save_id))
+
+  def testWaitWithoutWriter(self):
+    with self.test_session() as sess:
+      with self.assertRaisesOpError("not found|does not exist"):
+        sess.run(gen_io_ops.wait_for_save_v2_async(0, shared_name="missing"))
+
+
 if __name__ == "__main__":
   test.main()
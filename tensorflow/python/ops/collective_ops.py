@@ -22,7 +22,7 @@ from tensorflow.python.ops import gen_collective_ops
 
 
 def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
-               subdiv_offsets=(0,)):
+               subdiv_offsets=(0,), collective_name='auto'):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -38,6 +38,10 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
     subdiv_offsets: a list of integer offsets into the tensor at which each
       independent subdivision should begin.  Use [0] if no subdivision should
       be done.
+    collective_name: string naming the reduction algorithm, one of
+      'RingReduce', 'HalvingDoublingReduce' or 'HierarchicalReduce'.  If
+      'auto' the runtime selects one based on the tensor size and the
+      device group.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -55,7 +59,75 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
                                               instance_key=instance_key,
                                               merge_op=merge_op,
                                               final_op=final_op,
-                                              subdiv_offsets=subdiv_offsets)
+                                              subdiv_offsets=subdiv_offsets,
+                                              collective_name=collective_name)
+
+
+def all_gather(t, group_size, group_key, instance_key):
+  """Accumulates tensors collectively, across devices, along first dimension.
+
+  Args:
+    t: the tensor to participate in the accumulation.  All members of the
+      group must provide tensors of the same shape and type.
+    group_size: the total number of tensors to be collectively accumulated.
+      Each must reside on a different device.
+    group_key: an integer identifying the group of devices.
+    instance_key: an integer identifying the participating group of Ops.
+
+  Returns:
+    An Op implementing the distributed operation.  Its value is the
+    concatenation along dimension 0 of the inputs of all group members,
+    in device order.
+
+  Raises:
+    ValueError: if any of the input parameter constraints are not met.
+  """
+  if not device.canonical_name(t.device):
+    raise ValueError('Device assignment required for collective ops')
+  if group_size <= 1:
+    raise ValueError('Parameter group_size to all_gather must be at least 2.')
+  return gen_collective_ops.collective_gather(t,
+                                              group_size=group_size,
+                                              group_key=group_key,
+                                              instance_key=instance_key)
+
+
+def reduce_scatter(t, group_size, group_key, instance_key, merge_op,
+                   final_op):
+  """Reduces tensors collectively, leaving each device with one slice.
+
+  Args:
+    t: the tensor to be reduced.  Its first dimension must be divisible by
+      group_size.
+    group_size: the total number of tensors to be collectively reduced.
+      Each must reside on a different device.
+    group_key: an integer identifying the group of devices.
+    instance_key: an integer identifying the participating group of Ops.
+    merge_op: string naming the binary Op to be applied to compute each
+      partial reduction.
+    final_op: string naming the unary Op to be applied to each fully
+      reduced value.  Can be 'Id' for no operation.
+
+  Returns:
+    An Op implementing the distributed operation.  On the i-th device of
+    the group its value is the i-th of group_size equal slices, along
+    dimension 0, of the full reduction.
+
+  Raises:
+    ValueError: if any of the input parameter constraints are not met.
+  """
+  if not device.canonical_name(t.device):
+    raise ValueError('Device assignment required for collective ops')
+  if group_size <= 1:
+    raise ValueError(
+        'Parameter group_size to reduce_scatter must be at least 2.')
+  return gen_collective_ops.collective_reduce_scatter(
+      t,
+      group_size=group_size,
+      group_key=group_key,
+      instance_key=instance_key,
+      merge_op=merge_op,
+      final_op=final_op)
 
 
 def broadcast_send(t, shape, dtype, group_size, group_key, instance_key):